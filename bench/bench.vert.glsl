@@ -0,0 +1,11 @@
+#version 430 core
+layout (location = 0) in vec3 position;
+
+uniform mat4 transform;
+uniform vec3 offset;
+uniform float scale;
+
+void main()
+{
+   gl_Position = transform * vec4(position * scale + offset, 1.0);
+}
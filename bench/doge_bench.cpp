@@ -0,0 +1,224 @@
+//
+//  Copyright 2018 Christopher Di Bella
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <doge/gl/shader_binary.hpp>
+#include <doge/gl/shader_source.hpp>
+#include <doge/gl/state_cache.hpp>
+#include <doge/gl/texture.hpp>
+#include <doge/gl/uniform.hpp>
+#include <doge/gl/vertex_array.hpp>
+#include <doge/glm/matrix.hpp>
+#include <doge/utility/screen_data.hpp>
+#include <fstream>
+#include <functional>
+#include <gl/gl_core.hpp>
+#include <GLFW/glfw3.h>
+#include <glm/glm.hpp>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace {
+   struct result {
+      std::string name;
+      std::size_t iterations;
+      double min_ns;
+      double median_ns;
+      double mean_ns;
+      double max_ns;
+   };
+
+   constexpr auto repetitions = 15;
+
+   // stops the optimiser from discarding work whose result is otherwise unused
+   template <typename T>
+   void keep(const T& t) noexcept
+   {
+      asm volatile("" : : "g"(&t) : "memory");
+   }
+
+   /**
+    * @brief Times `iterations` calls to `f`, `repetitions` times, and reports the time per call.
+    *
+    * GL work is only finished once `gl::Finish` returns, so it is called inside the timed region.
+    */
+   template <typename F>
+   result measure(std::string name, const std::size_t iterations, F f)
+   {
+      using clock = std::chrono::steady_clock;
+
+      f(); // warm up caches, and the driver
+      gl::Finish();
+
+      auto samples = std::vector<double>{};
+      for (auto i = 0; i != repetitions; ++i) {
+         const auto start = clock::now();
+         for (auto j = std::size_t{0}; j != iterations; ++j)
+            f();
+         gl::Finish();
+         const auto elapsed = std::chrono::duration<double, std::nano>{clock::now() - start};
+         samples.push_back(elapsed.count() / iterations);
+      }
+
+      std::sort(begin(samples), end(samples));
+      auto total = 0.0;
+      for (const auto i : samples)
+         total += i;
+      return {std::move(name), iterations, samples.front(), samples[samples.size() / 2],
+         total / samples.size(), samples.back()};
+   }
+
+   void write_json(std::ostream& out, const std::vector<result>& results)
+   {
+      out << "{\n"
+          << "  \"renderer\": \"" << gl::GetString(gl::RENDERER) << "\",\n"
+          << "  \"version\": \"" << gl::GetString(gl::VERSION) << "\",\n"
+          << "  \"benchmarks\": [";
+      for (auto i = begin(results); i != end(results); ++i) {
+         out << (i == begin(results) ? "\n" : ",\n")
+             << "    {\"name\": \"" << i->name << "\", \"iterations\": " << i->iterations
+             << ", \"min_ns\": " << i->min_ns << ", \"median_ns\": " << i->median_ns
+             << ", \"mean_ns\": " << i->mean_ns << ", \"max_ns\": " << i->max_ns << "}";
+      }
+      out << "\n  ]\n}\n";
+   }
+
+   const auto bench_shaders = std::vector{
+      std::make_pair(doge::shader_source::vertex, std::string{"bench.vert.glsl"}),
+      std::make_pair(doge::shader_source::fragment, std::string{"bench.frag.glsl"})};
+
+   auto cube = std::make_shared<std::vector<GLfloat>>(std::vector<GLfloat>{
+      -0.5f, -0.5f, -0.5f,   0.5f, -0.5f, -0.5f,   0.5f,  0.5f, -0.5f,
+       0.5f,  0.5f, -0.5f,  -0.5f,  0.5f, -0.5f,  -0.5f, -0.5f, -0.5f,
+      -0.5f, -0.5f,  0.5f,   0.5f, -0.5f,  0.5f,   0.5f,  0.5f,  0.5f,
+       0.5f,  0.5f,  0.5f,  -0.5f,  0.5f,  0.5f,  -0.5f, -0.5f,  0.5f
+   });
+
+   void draw_calls(std::vector<result>& results)
+   {
+      const auto program = doge::shader_binary{bench_shaders};
+      const auto vertices = doge::vertex{gl::ARRAY_BUFFER, gl::STATIC_DRAW, cube, 3, {3}};
+      program.use([&]{
+         vertices.bind([&]{
+            results.push_back(measure("vertex::draw", 10'000, [&]{
+               vertices.draw(doge::vertex::triangles, 0, 12);
+            }));
+            results.push_back(measure("vertex::draw_instanced x64", 1'000, [&]{
+               vertices.draw_instanced(doge::vertex::triangles, 0, 12, 64);
+            }));
+         });
+      });
+   }
+
+   void uniforms(std::vector<result>& results)
+   {
+      const auto program = doge::shader_binary{bench_shaders};
+      program.use([&]{
+         const auto location = doge::uniform(program, "offset");
+         results.push_back(measure("uniform location lookup", 100'000, [&]{
+            keep(doge::uniform(program, "offset"));
+         }));
+         results.push_back(measure("uniform GLfloat (by location)", 100'000, [&]{
+            gl::Uniform1f(location, 0.5f);
+         }));
+         results.push_back(measure("uniform GLfloat", 100'000, [&]{
+            doge::uniform(program, "scale", 0.5f);
+         }));
+         results.push_back(measure("uniform glm::vec3", 100'000, [&]{
+            doge::uniform(program, "offset", glm::vec3{0.25f});
+         }));
+         results.push_back(measure("uniform glm::vec4", 100'000, [&]{
+            doge::uniform(program, "colour", glm::vec4{1.0f});
+         }));
+         results.push_back(measure("uniform glm::mat4", 100'000, [&]{
+            doge::uniform(program, "transform", false, glm::mat4{1.0f});
+         }));
+      });
+   }
+
+   void compile_and_link(std::vector<result>& results)
+   {
+      results.push_back(measure("shader_binary compile+link", 10, []{
+         const auto program = doge::shader_binary{bench_shaders};
+         doge::delete_program(static_cast<GLuint>(program));
+      }));
+   }
+
+   void texture_upload(std::vector<result>& results)
+   {
+      results.push_back(measure("basic_texture load+upload", 10, []{
+         keep(doge::texture2d{"resources/container2.png",
+            {doge::texture_wrap_t::repeat, doge::texture_wrap_t::repeat},
+            doge::minmag_t::linear_mipmap_linear, doge::minmag_t::linear});
+      }));
+
+      const auto pixels = doge::decode_image("resources/container2.png");
+      results.push_back(measure("basic_texture upload", 10, [&]{
+         keep(doge::texture2d{pixels, {doge::texture_wrap_t::repeat, doge::texture_wrap_t::repeat},
+            doge::minmag_t::linear_mipmap_linear, doge::minmag_t::linear});
+      }));
+   }
+
+   void matrix_transforms(std::vector<result>& results)
+   {
+      auto angle = 0.0f;
+      results.push_back(measure("matrix translate|rotate|scale", 1'000'000, [&]{
+         angle += 0.001f;
+         keep(glm::mat4{1.0f}
+            | doge::translate(glm::vec3{1.0f, 2.0f, 3.0f})
+            | doge::rotate(doge::as_radians(angle), {0.5f, 1.0f, 0.5f})
+            | doge::scale(glm::vec3{0.2f}));
+      }));
+      results.push_back(measure("matrix invert|transpose", 1'000'000, [&]{
+         angle += 0.001f;
+         keep(glm::mat4{angle} | doge::invert | doge::transpose);
+      }));
+   }
+} // namespace <anonymous>
+
+/**
+ * Runs every benchmark on a hidden window, and writes the results as JSON to the file named by the
+ * first argument, or to standard output if there isn't one.
+ */
+int main(const int argc, const char* const argv[])
+{
+   // window hints can only be set once GLFW is initialised; screen_data's glfwInit is then a no-op
+   if (not glfwInit()) {
+      std::cerr << "Unable to initialise GLFW3\n";
+      return 1;
+   }
+   glfwWindowHint(GLFW_VISIBLE, GLFW_FALSE);
+   auto screen = doge::screen_data{};
+   glfwSwapInterval(0);
+
+   auto results = std::vector<result>{};
+   draw_calls(results);
+   uniforms(results);
+   compile_and_link(results);
+   texture_upload(results);
+   matrix_transforms(results);
+
+   if (argc > 1) {
+      auto out = std::ofstream{argv[1]};
+      write_json(out, results);
+   }
+   else {
+      write_json(std::cout, results);
+   }
+}
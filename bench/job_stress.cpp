@@ -0,0 +1,120 @@
+//
+//  Copyright 2018 Christopher Di Bella
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+#include <atomic>
+#include <cstddef>
+#include <doge/utility/job_system.hpp>
+#include <iostream>
+#include <numeric>
+#include <thread>
+#include <vector>
+
+namespace {
+   constexpr auto rounds = 200;
+
+   // spawns a binary tree of jobs, each of which waits on its children
+   void spawn(doge::job_system& jobs, const int depth, std::atomic<std::size_t>& leaves)
+   {
+      if (depth == 0) {
+         leaves.fetch_add(1, std::memory_order_relaxed);
+         return;
+      }
+
+      auto children = doge::job_counter{};
+      jobs.run([&]{ spawn(jobs, depth - 1, leaves); }, children);
+      jobs.run([&]{ spawn(jobs, depth - 1, leaves); }, children);
+      jobs.wait(children);
+   }
+
+   bool nested(doge::job_system& jobs)
+   {
+      constexpr auto depth = 10;
+      auto leaves = std::atomic<std::size_t>{0};
+      spawn(jobs, depth, leaves);
+      return leaves.load() == std::size_t{1} << depth;
+   }
+
+   // every grain writes its own elements, which are only read once parallel_for returns
+   bool grains(doge::job_system& jobs)
+   {
+      auto values = std::vector<std::size_t>(10'000);
+      jobs.parallel_for(0, values.size(), 64, [&values](const auto first, const auto last) {
+         for (auto i = first; i != last; ++i)
+            values[i] = i;
+      });
+
+      const auto n = values.size();
+      return std::accumulate(values.begin(), values.end(), std::size_t{0}) == n * (n - 1) / 2;
+   }
+
+   // a diamond, run several times, whose joins read what their predecessors wrote
+   bool graph(doge::job_system& jobs)
+   {
+      auto a = 0;
+      auto b = 0;
+      auto c = 0;
+      auto d = 0;
+      auto frame = doge::job_graph{};
+      const auto first = frame.add([&]{ a = 1; });
+      const auto left = frame.add([&]{ b = a + 1; });
+      const auto right = frame.add([&]{ c = a + 2; });
+      const auto last = frame.add([&]{ d = b + c; });
+      frame.precede(first, left);
+      frame.precede(first, right);
+      frame.precede(left, last);
+      frame.precede(right, last);
+
+      for (auto i = 0; i != 8; ++i) {
+         d = 0;
+         frame.run(jobs);
+         if (d != 5)
+            return false;
+      }
+      return true;
+   }
+} // namespace <anonymous>
+
+/**
+ * Runs nested jobs, parallel_for and job_graph from several threads that aren't workers at once,
+ * so that their shared queue is contended as well as the workers'. Build with
+ * `-fsanitize=thread` to check the job system for data races.
+ */
+int main()
+{
+   // more workers than most machines have cores, unpinned, so that they're preempted mid-job
+   auto jobs = doge::job_system{8, false};
+   auto failures = std::atomic<int>{0};
+
+   const auto drive = [&]{
+      for (auto i = 0; i != rounds; ++i) {
+         if (not nested(jobs) or not grains(jobs) or not graph(jobs))
+            failures.fetch_add(1, std::memory_order_relaxed);
+      }
+   };
+
+   auto drivers = std::vector<std::thread>{};
+   for (auto i = 0; i != 3; ++i)
+      drivers.emplace_back(drive);
+   drive();
+   for (auto& i : drivers)
+      i.join();
+
+   if (failures.load() != 0) {
+      std::cerr << failures.load() << " rounds computed the wrong result\n";
+      return 1;
+   }
+   std::cout << "job_stress: " << 4 * rounds << " rounds with " << jobs.concurrency()
+             << " threads\n";
+}
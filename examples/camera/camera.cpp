@@ -43,7 +43,7 @@ int main()
 
    auto camera = doge::camera{};
 
-   gl::Enable(gl::DEPTH_TEST);
+   doge::gl_state().enable(gl::DEPTH_TEST);
    doge::hid::mouse::sensitivity(0.4f);
    engine.play([&]{
       namespace hid = doge::hid;
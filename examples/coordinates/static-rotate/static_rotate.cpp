@@ -48,7 +48,7 @@ int main()
    Regular projection = glm::perspective(glm::radians(45.0f), engine.screen().aspect_ratio(), 0.1f,
       100.0f);
 
-   gl::Enable(gl::DEPTH_TEST);
+   doge::gl_state().enable(gl::DEPTH_TEST);
    engine.play([&]{
       doge::hid::on_key_press<doge::hid::keyboard>(GLFW_KEY_ESCAPE, [&engine]{ engine.close(); });
 
@@ -13,6 +13,7 @@
 // See the License for the specific language governing permissions and
 // limitations under the License.
 //
+#include <array>
 #include <gl/gl_core.hpp>
 #include <doge/engine.hpp>
 #include <doge/gl/vertex_array.hpp>
@@ -37,9 +38,9 @@ int main()
            std::make_pair(doge::shader_source::fragment, "yellow.glsl")}}
    };
 
-   auto vbo = std::vector<doge::vertex>{
-      {gl::ARRAY_BUFFER, gl::STATIC_DRAW, triangle[0], 3, {3}},
-      {gl::ARRAY_BUFFER, gl::STATIC_DRAW, triangle[1], 3, {3}}
+   auto vbo = std::array{
+      doge::vertex{gl::ARRAY_BUFFER, gl::STATIC_DRAW, triangle[0], 3, {3}},
+      doge::vertex{gl::ARRAY_BUFFER, gl::STATIC_DRAW, triangle[1], 3, {3}}
    };
 
    engine.play([&]{
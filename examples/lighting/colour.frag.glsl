@@ -1,11 +1,17 @@
 #version 430 core
+#include "clustered_lights.glsl"
+
 out vec4 frag_colour;
 
 in vec3 frag_position;
 in vec3 frag_normal;
 in vec2 frag_texture_coordinates;
 
-uniform vec3 view_position;
+layout (std140, binding = 0) uniform camera {
+   mat4 projection;
+   mat4 view;
+   vec3 view_position;
+};
 
 struct material_properties {
    sampler2D diffuse;
@@ -14,44 +20,24 @@ struct material_properties {
 };
 
 uniform material_properties material;
-
-struct light_properties {
-   vec3 ambience;
-   vec3 diffuse;
-   vec3 specular;
-   vec3 position;
-
-   float attenuation_constant;
-   float attenuation_linear;
-   float attenuation_quadratic;
-};
-
-uniform light_properties light;
+uniform vec3 ambience;
 
 void main()
 {
    const vec3 diffuse_factor = vec3(texture(material.diffuse, frag_texture_coordinates));
-
-   // ambient
-   const vec3 ambient = light.ambience * diffuse_factor;
-
-   // diffuse
+   const vec3 specular_factor = vec3(texture(material.specular, frag_texture_coordinates));
    const vec3 norm = normalize(frag_normal);
-   const vec3 light_dir = normalize(-light.position);
-   const float diff = max(dot(norm, light_dir), 0.0);
-   const vec3 diffuse = light.diffuse * diff * diffuse_factor;
-
-   // specular
    const vec3 view_dir = normalize(view_position - frag_position);
-   const vec3 reflect_dir = reflect(-light_dir, norm);
-   const float spec = pow(max(dot(view_dir, reflect_dir), 0.0), material.shininess);
-   const vec3 specular = light.specular * spec * vec3(texture(material.specular, frag_texture_coordinates));
 
+   // only the lights that can reach this fragment's cluster are visited
+   const float view_depth = -(view * vec4(frag_position, 1.0)).z;
+   const uint cluster = doge_cluster(gl_FragCoord.xy, view_depth);
 
-   // attenuation
-   const float distance = length(light.position - frag_position);
-   const float attenuation = 1.0 / (light.attenuation_constant + light.attenuation_linear * distance
-      + light.attenuation_quadratic * (distance * distance));
+   vec3 colour = ambience * diffuse_factor;
+   for (uint i = 0u; i < doge_cluster_light_count(cluster); ++i) {
+      colour += doge_shade(doge_cluster_light(cluster, i), frag_position, norm, view_dir,
+         diffuse_factor, specular_factor, material.shininess);
+   }
 
-   frag_colour = vec4((ambient + diffuse + specular) * attenuation, 1.0);
+   frag_colour = vec4(colour, 1.0);
 }
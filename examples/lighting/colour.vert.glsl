@@ -2,15 +2,18 @@
 layout (location = 0) in vec3 position;
 layout (location = 1) in vec3 vert_normal;
 layout (location = 2) in vec2 texture_coordinates;
+layout (location = 3) in mat4 model;
 
 out vec3 frag_position;
 out vec3 frag_normal;
 out vec2 frag_texture_coordinates;
 
 uniform vec3 light_position;
-uniform mat4 model;
-uniform mat4 view;
-uniform mat4 projection;
+layout (std140, binding = 0) uniform camera {
+   mat4 projection;
+   mat4 view;
+   vec3 view_position;
+};
 uniform mat4 normal_model;
 
 void main()
@@ -3,8 +3,11 @@
 layout (location = 0) in vec3 position;
 
 uniform mat4 model;
-uniform mat4 view;
-uniform mat4 projection;
+layout (std140, binding = 0) uniform camera {
+   mat4 projection;
+   mat4 view;
+   vec3 view_position;
+};
 
 void main()
 {
@@ -16,31 +16,63 @@
 #include "../static_objects.hpp"
 #include "doge/engine.hpp"
 #include "doge/entity/camera.hpp"
+#include "doge/gl/clustered_lighting.hpp"
 #include "doge/gl/shader_binary.hpp"
+#include "doge/gl/shader_cache.hpp"
 #include "doge/gl/shader_source.hpp"
 #include "doge/gl/uniform.hpp"
+#include "doge/gl/uniform_block.hpp"
 #include "doge/gl/vertex_array.hpp"
 #include "doge/glm/matrix.hpp"
 #include "doge/utility/utility.hpp"
 #include <glm/glm.hpp>
 #include <glm/gtc/matrix_transform.hpp>
+#include <cmath>
 #include <vector>
 
 #include <iostream>
 #include <experimental/ranges/algorithm>
 
+// shared by both programs through the uniform block at binding 0
+struct camera_data {
+   glm::mat4 projection;
+   glm::mat4 view;
+   glm::vec3 view_position;
+};
+
+template <>
+struct doge::block_members<camera_data> {
+   static constexpr auto value = std::make_tuple(&camera_data::projection, &camera_data::view,
+      &camera_data::view_position);
+};
+
 int main()
 {
    namespace ranges = std::experimental::ranges;
    using ranges::Regular;
 
    auto engine = doge::engine{};
+
+   // the light that the keys move, and a swarm of small coloured lights orbiting the cubes
+   constexpr auto swarm_size = std::size_t{1000};
+   auto point_lights = std::vector<doge::point_light>(swarm_size + 1);
+   for (auto i = std::size_t{1}; i < point_lights.size(); ++i) {
+      const auto hue = static_cast<float>(i) * 2.39996f;
+      point_lights[i].colour = glm::vec3{0.5f + 0.5f * std::cos(hue),
+         0.5f + 0.5f * std::cos(hue + 2.094f), 0.5f + 0.5f * std::cos(hue + 4.189f)};
+      point_lights[i].range = 2.5f;
+      point_lights[i].intensity = 2.0f;
+   }
+
+   auto shaders = doge::shader_cache{};
+   auto lights = doge::clustered_lighting{point_lights.size(), shaders};
    auto light_source_program = doge::shader_binary{{
       std::make_pair(doge::shader_source::vertex, "light_source.vert.glsl"),
       std::make_pair(doge::shader_source::fragment, "light_source.frag.glsl")}};
    auto cube_program = doge::shader_binary{{
       std::make_pair(doge::shader_source::vertex, "colour.vert.glsl"),
-      std::make_pair(doge::shader_source::fragment, "colour.frag.glsl")}};
+      std::make_pair(doge::shader_source::fragment, "colour.frag.glsl")}, shaders,
+      lights.defines()};
 
    auto cube = doge::vertex{gl::ARRAY_BUFFER, gl::STATIC_DRAW, cube_with_normal, 8, {3, 3, 2}};
    auto light_source = doge::vertex{gl::ARRAY_BUFFER, gl::STATIC_DRAW, cube_with_normal, 8, {3}};
@@ -51,24 +83,24 @@ int main()
       {doge::texture_wrap_t::repeat, doge::texture_wrap_t::repeat}, doge::minmag_t::linear,
       doge::minmag_t::linear, 1};
    auto camera = doge::camera{};
+   auto camera_block = doge::uniform_block<camera_data>{0};
+
+   // one model matrix per cube, uploaded as four vec4 attributes starting at location 3
+   auto cube_models = std::make_shared<std::vector<GLfloat>>(cube_positions.size() * 16);
+   const auto cube_model_stream = cube.instance_attributes(gl::DYNAMIC_DRAW, cube_models, 3,
+      {4, 4, 4, 4});
 
    cube_program.use([&cube_program]{
       doge::uniform(cube_program, "material.diffuse", 0);
       doge::uniform(cube_program, "material.specular", 1);
       doge::uniform(cube_program, "material.shininess", 32.0f);
-
-      const auto light_colour = glm::vec3{1.0f, 1.0f, 1.0f};
-      doge::uniform(cube_program, "light.ambience", light_colour * 0.2f);
-      doge::uniform(cube_program, "light.diffuse", light_colour * 0.5f);
-      doge::uniform(cube_program, "light.specular", light_colour);
-      doge::uniform(cube_program, "light.attenuation_constant", 1.0f);
-      doge::uniform(cube_program, "light.attenuation_linear", 0.09f);
-      doge::uniform(cube_program, "light.attenuation_quadratic", 0.032f);
+      doge::uniform(cube_program, "ambience", glm::vec3{0.05f});
    });
 
+   auto last_projection = glm::mat4{0.0f};
    auto light_position_xz = 0.0f;
    auto light_position_y = 0.0f;
-   gl::Enable(gl::DEPTH_TEST);
+   doge::gl_state().enable(gl::DEPTH_TEST);
    engine.play([&]{
       namespace hid = doge::hid;
       hid::on_key_press<hid::keyboard>(GLFW_KEY_ESCAPE, [&engine]{ engine.close(); });
@@ -124,40 +156,52 @@ int main()
          * glm::vec3{std::cos(light_position_xz), 1.0f, std::sin(light_position_xz)}
          * glm::vec3{1.0f, std::sin(light_position_y), 1.0f};
 
+      camera_block.set(camera_data{projection, view, camera.position()});
+      camera_block.upload();
+
+      // the clusters only depend on the projection, so they're rebuilt when it changes
+      if (projection != last_projection) {
+         lights.project(projection, 0.1f, 100.0f, engine.screen().width(),
+            engine.screen().height());
+         last_projection = projection;
+      }
+
+      point_lights[0] = doge::point_light{light_position, 15.0f, glm::vec3{1.0f}, 6.0f};
+      const auto time = static_cast<float>(glfwGetTime());
+      for (auto i = std::size_t{1}; i < point_lights.size(); ++i) {
+         const auto orbit = static_cast<float>(i) * 2.39996f + time * 0.2f;
+         const auto radius = 3.0f + 9.0f * static_cast<float>(i) / swarm_size;
+         point_lights[i].position = glm::vec3{radius * std::cos(orbit),
+            3.0f * std::sin(static_cast<float>(i) * 0.7f), -6.0f + radius * std::sin(orbit)};
+      }
+      lights.write(point_lights);
+      lights.bin(view);
+      lights.bind();
+
+      // staged uniforms are sent by use, and only when they've changed since the last frame
+      const auto model = glm::mat4{1.0f};
+      cube_program.set_uniform("normal_model", model | doge::invert | doge::transpose);
       cube_program.use([&]{
-         doge::uniform(cube_program, "light.position", light_position);
-         doge::uniform(cube_program, "projection", false, projection);
-         doge::uniform(cube_program, "view", false, view);
-
-         const auto model = glm::mat4{1.0f};
-         doge::uniform(cube_program, "model", false, model);
-         doge::uniform(cube_program, "view_position", camera.position());
-         doge::uniform(cube_program, "normal_model", false,
-              model
-            | doge::invert
-            | doge::transpose);
-
          diffuse_map.bind(gl::TEXTURE0);
          specular_map.bind(gl::TEXTURE1);
+         const auto rotation = doge::as_radians<float>(glfwGetTime() * -50.0);
+         for (auto i = decltype(cube_positions.size()){}; i != cube_positions.size(); ++i) {
+            const auto m = glm::mat4{1.0f}
+               | doge::translate(cube_positions[i])
+               | doge::rotate(rotation, {0.5f, 1.0f, 0.5f});
+            ranges::copy(glm::value_ptr(m), glm::value_ptr(m) + 16, cube_models->begin() + 16 * i);
+         }
+         cube.update_instances(cube_model_stream);
+
          cube.bind([&]{
-            for (const Regular& i : cube_positions) {
-               doge::uniform(cube_program, "model", false, 
-                 glm::mat4{1.0f}
-               | doge::translate(i)
-               | doge::rotate(doge::as_radians<float>(glfwGetTime() * -50.0), {0.5f, 1.0f, 0.5f}));
-               cube.draw(doge::vertex::triangles, 0, 36);
-            }
+            cube.draw_instanced(doge::vertex::triangles, 0, 36, cube_positions.size());
          });
       });
 
+      light_source_program.set_uniform("model", glm::mat4{1.0f}
+         | doge::translate(light_position)
+         | doge::scale(glm::vec3{0.2f}));
       light_source_program.use([&]{
-         doge::uniform(light_source_program, "projection", false, projection);
-         doge::uniform(light_source_program, "view", false, view);
-         doge::uniform(light_source_program, "model", false,
-              glm::mat4{1.0f}
-            | doge::translate(light_position)
-            | doge::scale(glm::vec3{0.2f}));
-
          light_source.bind([&]{
             light_source.draw(doge::vertex::triangles, 0, 36);
          });
@@ -207,12 +207,15 @@ inline Regular cube_positions = std::vector<glm::vec3>{
 
 inline auto make_awesomeface(const doge::shader_binary& program)
 {
-   auto tex = std::vector<doge::texture2d>{
-      {"resources/container.jpg", {doge::texture_wrap_t::repeat, doge::texture_wrap_t::repeat},
-         doge::minmag_t::linear, doge::minmag_t::linear, 0},
-      {"resources/awesomeface.png", {doge::texture_wrap_t::repeat, doge::texture_wrap_t::repeat},
-         doge::minmag_t::linear, doge::minmag_t::linear, 1}
-   };
+   // textures are move-only, so they can't be copied out of an initializer_list
+   const auto repeat = doge::texture2d::wrapping_t{doge::texture_wrap_t::repeat,
+      doge::texture_wrap_t::repeat};
+   auto tex = std::vector<doge::texture2d>{};
+   tex.reserve(2);
+   tex.emplace_back("resources/container.jpg", repeat, doge::minmag_t::linear,
+      doge::minmag_t::linear, 0);
+   tex.emplace_back("resources/awesomeface.png", repeat, doge::minmag_t::linear,
+      doge::minmag_t::linear, 1);
 
    program.use([&tex, &program]{
       for (ranges::Integral i = decltype(tex.size()){}; i != tex.size(); ++i) {
@@ -22,6 +22,7 @@
 #include "doge/gl/uniform.hpp"
 #include "doge/glm/matrix.hpp"
 #include "doge/hid.hpp"
+#include <array>
 #include <glm/glm.hpp>
 #include <glm/gtc/matrix_transform.hpp>
 #include <vector>
@@ -39,8 +40,9 @@ int main()
       std::make_pair(doge::shader_source::fragment, "transform.frag.glsl")}};
 
    auto tex = make_awesomeface(program);
-   auto vbo = std::vector(2, doge::vertex{gl::ARRAY_BUFFER, gl::STATIC_DRAW, rectangle,
-      {0, 1, 3, 1, 2, 3}, 5, {3, 2}});
+   auto vbo = std::array{
+      doge::vertex{gl::ARRAY_BUFFER, gl::STATIC_DRAW, rectangle, {0, 1, 3, 1, 2, 3}, 5, {3, 2}},
+      doge::vertex{gl::ARRAY_BUFFER, gl::STATIC_DRAW, rectangle, {0, 1, 3, 1, 2, 3}, 5, {3, 2}}};
 
    ranges::Regular transform = program.use([&tex, &program]{
       return doge::uniform(program, "transform");
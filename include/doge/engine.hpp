@@ -16,16 +16,38 @@
 #ifndef DOGE_ENGINE_HPP
 #define DOGE_ENGINE_HPP
 
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <doge/gl/gl_statistics.hpp>
 #include <doge/hid.hpp>
+#include <doge/utility/job_system.hpp>
+#include <doge/utility/profiler.hpp>
 #include <doge/utility/screen_data.hpp>
 #include <experimental/ranges/concepts>
 #include <experimental/ranges/functional>
 #include <gl/gl_core.hpp>
 #include <GLFW/glfw3.h>
+#include <gsl/gsl>
 
 namespace doge {
    namespace ranges = std::experimental::ranges;
 
+   /**
+    * @brief Settings for running the simulation at a fixed rate, independent of the frame rate.
+    */
+   struct fixed_timestep {
+      /** @brief The length of one simulation tick, in seconds. */
+      double tick = 1.0 / 120.0;
+
+      /**
+       * @brief The most ticks that are run before a frame is drawn. When a frame takes longer than
+       *        this, the remaining time is dropped rather than caught up, so that a slow frame
+       *        can't cause ever-slower frames.
+       */
+      int max_ticks = 8;
+   };
+
    class engine {
    public:
       engine()
@@ -34,23 +56,208 @@ namespace doge {
          doge::hid::mouse::init(screen_.window());
       }
 
+      /**
+       * @brief Opens a `width` by `height` window using `backend`, e.g. a hidden one for
+       *        rendering previews with `screen_data::backend_t::headless`.
+       */
+      engine(const screen_data::backend_t backend, const int width, const int height,
+         const int antialiasing = 4)
+         : screen_{backend, width, height, antialiasing, false}
+      {
+         doge::hid::keyboard::init(screen_.window());
+         doge::hid::mouse::init(screen_.window());
+      }
+
       template <ranges::Invocable F>
       void play(const F& logic)
       {
          while (screen_.open()) {
+            profiler_.begin_frame();
             compute_frame_displacement();
-            ranges::invoke(logic);
-            hid::mouse::update();
-            screen_.swap_buffers();
-            glfwPollEvents();
+            hid::hid::process_events();
+            {
+               auto scope = profiler_.scope("logic");
+               ranges::invoke(logic);
+            }
+            {
+               auto scope = profiler_.scope("input");
+               hid::mouse::update();
+            }
+            {
+               auto scope = profiler_.scope("swap_buffers");
+               screen_.swap_buffers();
+            }
+            end_frame();
          }
       }
 
+      /**
+       * @brief Runs `update` at the rate given by `step`, and `render` once per frame.
+       *
+       * `frame_displacement()` is the tick length while `update` runs, so movement is the same
+       * at any frame rate. `render` is passed how far the simulation is between the last tick
+       * and the next one, in [0, 1), for interpolating between the previous and current states.
+       */
+      template <ranges::Invocable Update, ranges::Invocable<float> Render>
+      void play(const fixed_timestep& step, const Update& update, const Render& render)
+      {
+         Expects(step.tick > 0.0);
+         Expects(step.max_ticks > 0);
+
+         frame_displacement_ = static_cast<float>(step.tick);
+         auto accumulator = 0.0;
+         auto previous = glfwGetTime();
+         while (screen_.open()) {
+            profiler_.begin_frame();
+            const auto now = glfwGetTime();
+            accumulator += now - previous;
+            previous = now;
+            hid::hid::process_events();
+            {
+               auto scope = profiler_.scope("logic");
+               auto ticks = 0;
+               for (; accumulator >= step.tick and ticks != step.max_ticks; ++ticks) {
+                  ranges::invoke(update);
+                  accumulator -= step.tick;
+               }
+
+               if (ticks == step.max_ticks)
+                  accumulator = std::fmod(accumulator, step.tick);
+            }
+            interpolation_ = static_cast<float>(accumulator / step.tick);
+            {
+               auto scope = profiler_.scope("render");
+               ranges::invoke(render, interpolation_);
+            }
+            {
+               auto scope = profiler_.scope("input");
+               hid::mouse::update();
+            }
+            {
+               auto scope = profiler_.scope("swap_buffers");
+               screen_.swap_buffers();
+            }
+            end_frame();
+         }
+      }
+
+      /**
+       * @brief Prepares each frame on the job system while the frame before it is submitted.
+       *
+       * `prepare(n)` runs as a job, and does the work that doesn't need the GL, such as updating
+       * transforms and animations, culling and recording draw packets, spreading it over
+       * `jobs()`. Meanwhile the main thread runs `submit(n - 1)`, which issues the GL calls for
+       * the frame that was prepared last time, and swaps buffers. Anything the two share should
+       * be double-buffered on `n % 2`, e.g. a pair of render_queues.
+       *
+       * Events are processed before `prepare` starts, and `hid::mouse::update` runs once both
+       * have finished, so input is stable while they run.
+       */
+      template <ranges::Invocable<std::uint64_t> Prepare, ranges::Invocable<std::uint64_t> Submit>
+      void play_pipelined(const Prepare& prepare, const Submit& submit)
+      {
+         for (auto frame = std::uint64_t{0}; screen_.open(); ++frame) {
+            profiler_.begin_frame();
+            compute_frame_displacement();
+            hid::hid::process_events();
+
+            auto prepared = job_counter{};
+            jobs_.run([&prepare, frame]{ ranges::invoke(prepare, frame); }, prepared);
+            if (frame > 0) {
+               auto scope = profiler_.scope("submit");
+               ranges::invoke(submit, frame - 1);
+            }
+            {
+               auto scope = profiler_.scope("swap_buffers");
+               screen_.swap_buffers();
+            }
+            {
+               // only the time that the main thread spends waiting, which is ideally none
+               auto scope = profiler_.scope("prepare");
+               jobs_.wait(prepared);
+            }
+            {
+               auto scope = profiler_.scope("input");
+               hid::mouse::update();
+            }
+            end_frame();
+         }
+      }
+
+      /**
+       * @brief Sets how many vertical blanks `swap_buffers` waits for: 0 disables vsync, 1
+       *        enables it.
+       */
+      void swap_interval(const int interval) noexcept
+      {
+         glfwSwapInterval(interval);
+      }
+
+      /**
+       * @brief Caps the frame rate. Time left over at the end of a frame is spent waiting for
+       *        events rather than spinning, so input that arrives early is still handled promptly.
+       *        Zero removes the cap.
+       */
+      void frame_limit(const double frames_per_second) noexcept
+      {
+         Expects(frames_per_second >= 0.0);
+         frame_period_ = frames_per_second > 0.0 ? 1.0 / frames_per_second : 0.0;
+      }
+
+      /**
+       * @brief How far the simulation is between ticks when the current frame is rendered. Always
+       *        zero outside of the fixed timestep `play`.
+       */
+      [[nodiscard]] static float interpolation() noexcept
+      {
+         return interpolation_;
+      }
+
       const screen_data& screen() const noexcept
       {
          return screen_;
       }
 
+      /**
+       * @brief The background thread for creating buffers, textures and programs; see
+       *        `screen_data::uploads`.
+       */
+      upload_context& uploads()
+      {
+         return screen_.uploads();
+      }
+
+      /**
+       * @brief The scheduler for spreading a frame's work over every core, e.g. with
+       *        `jobs().parallel_for`, or by passing it to `cull` and `scene_graph::update`.
+       */
+      job_system& jobs() noexcept
+      {
+         return jobs_;
+      }
+
+      /**
+       * @brief The profiler that times each frame. Logic may add its own scopes to it.
+       */
+      profiler& frame_profiler() noexcept
+      {
+         return profiler_;
+      }
+
+      const profiler& frame_profiler() const noexcept
+      {
+         return profiler_;
+      }
+
+      /**
+       * @brief What the GL was asked to do in the last whole frame, including the calls made by
+       *        the upload context meanwhile. Zero unless doge is built with `DOGE_GL_TRACE`.
+       */
+      const gl_statistics& frame_statistics() const noexcept
+      {
+         return frame_statistics_;
+      }
+
       void close() noexcept
       {
          screen_.close();
@@ -62,8 +269,34 @@ namespace doge {
       }
    private:
       screen_data screen_;
+      profiler profiler_;
+      job_system jobs_;
+      gl_statistics frame_statistics_;
       static inline float previous_frame_ = glfwGetTime();
       static inline float frame_displacement_ = 0.0f;
+      static inline float interpolation_ = 0.0f;
+      double frame_period_ = 0.0;
+      double next_frame_ = 0.0;
+
+      void pace_frame() noexcept
+      {
+         glfwPollEvents();
+         if (frame_period_ == 0.0)
+            return;
+
+         for (auto now = glfwGetTime(); now < next_frame_; now = glfwGetTime())
+            glfwWaitEventsTimeout(next_frame_ - now);
+
+         // a frame that overruns pushes the schedule back, rather than being followed by a burst
+         next_frame_ = std::max(next_frame_, glfwGetTime()) + frame_period_;
+      }
+
+      void end_frame() noexcept
+      {
+         pace_frame();
+         profiler_.end_frame();
+         frame_statistics_ = take_gl_statistics();
+      }
 
       static void compute_frame_displacement() noexcept
       {
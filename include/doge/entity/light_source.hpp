@@ -16,16 +16,20 @@
 #ifndef DOGE_ENTITY_LIGHT_SOURCE_HPP
 #define DOGE_ENTITY_LIGHT_SOURCE_HPP
 
+#include <doge/units/angle.hpp>
+#include <gl/gl_core.hpp>
+#include <glm/gtc/type_ptr.hpp>
 #include <glm/mat4x4.hpp>
+#include <glm/vec3.hpp>
 
 namespace doge {
-   namespace ranges = std::experimental::ranges;
-
-   using uniform = GLint;
+   // a location rather than doge::uniform, which names the functions that set uniforms
+   using uniform_location = GLint;
 
    class basic_light_source {
    public:
-      basic_light_source(const uniform projection, const uniform view, const uniform model)
+      basic_light_source(const uniform_location projection, const uniform_location view,
+         const uniform_location model)
          : projection_{projection},
            view_{view},
            model_{model}
@@ -33,39 +37,69 @@ namespace doge {
 
       void draw(const glm::mat4& p, const glm::mat4& v, const glm::mat4& m)
       {
-         ::doge::uniform(projection(), false, p);
-         ::doge::uniform(view(), false, v);
-         ::doge::uniform(model(), false, m);
+         gl::UniformMatrix4fv(projection(), 1, false, glm::value_ptr(p));
+         gl::UniformMatrix4fv(view(), 1, false, glm::value_ptr(v));
+         gl::UniformMatrix4fv(model(), 1, false, glm::value_ptr(m));
          draw_impl();
       }
    protected:
       ~basic_light_source() = default;
 
-      uniform projection() const noexcept
+      uniform_location projection() const noexcept
       {
          return projection_;
       }
 
-      uniform view() const noexcept
+      uniform_location view() const noexcept
       {
          return view_;
       }
 
-      uniform model() const noexcept
+      uniform_location model() const noexcept
       {
          return model_;
       }
    private:
-      uniform projection_;
-      uniform view_;
-      uniform model_;
+      uniform_location projection_;
+      uniform_location view_;
+      uniform_location model_;
 
       virtual void draw_impl() = 0;
    };
 
-   class directional_light {};
-   class point_light {};
-   class spotlight {};
+   /**
+    * @brief A light infinitely far away, such as the sun, that lights everything from `direction`.
+    */
+   struct directional_light {
+      glm::vec3 direction = glm::vec3{0.0f, -1.0f, 0.0f};
+      glm::vec3 colour = glm::vec3{1.0f};
+      float intensity = 1.0f;
+   };
+
+   /**
+    * @brief A light that shines in every direction from `position`, and fades out to nothing at
+    *        `range`.
+    */
+   struct point_light {
+      glm::vec3 position = {};
+      float range = 10.0f;
+      glm::vec3 colour = glm::vec3{1.0f};
+      float intensity = 1.0f;
+   };
+
+   /**
+    * @brief A point light restricted to a cone about `direction`. The light fades from full
+    *        strength at `inner_cone` to nothing at `outer_cone`, both measured from the axis.
+    */
+   struct spotlight {
+      glm::vec3 position = {};
+      float range = 10.0f;
+      glm::vec3 colour = glm::vec3{1.0f};
+      float intensity = 1.0f;
+      glm::vec3 direction = glm::vec3{0.0f, 0.0f, -1.0f};
+      angle inner_cone = 15.0_deg;
+      angle outer_cone = 20.0_deg;
+   };
 } // namespace doge
 
 #endif // DOGE_ENTITY_LIGHT_SOURCE_HPP
@@ -0,0 +1,152 @@
+//
+//  Copyright 2018 Christopher Di Bella
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+#ifndef DOGE_GL_CLUSTERED_LIGHTING_HPP
+#define DOGE_GL_CLUSTERED_LIGHTING_HPP
+
+#include <cstddef>
+#include <doge/entity/light_source.hpp>
+#include <doge/gl/compute_program.hpp>
+#include <doge/gl/shader_cache.hpp>
+#include <doge/gl/storage_buffer.hpp>
+#include <gl/gl_core.hpp>
+#include <glm/mat4x4.hpp>
+#include <glm/vec4.hpp>
+#include <gsl/gsl>
+#include <string>
+#include <vector>
+
+namespace doge {
+   namespace detail {
+      /**
+       * @brief A point light or spotlight, as `doge_light` in clustered_lights.glsl.
+       *
+       * A point light's cone is a whole sphere: its outer cosine is -2 and its inner cosine is -1,
+       * so the cone's smoothstep in clustered_lights.glsl is one in every direction. Equal edges
+       * would leave the smoothstep undefined.
+       */
+      struct packed_light {
+         glm::vec4 position_range;
+         glm::vec4 colour_intensity;
+         glm::vec4 direction_outer; // outer is the cosine of the outer cone
+         glm::vec4 inner;           // the cosine of the inner cone, then padding
+      };
+      static_assert(sizeof(packed_light) == 64);
+
+      struct cluster_parameters {
+         glm::vec4 tile_size;   // the size of a cluster on screen, in pixels
+         glm::vec4 depth_slice; // the scale and bias that map log(depth) to a slice
+      };
+   } // namespace detail
+
+   /**
+    * @brief The number of clusters across, down and into the view frustum, and the most lights
+    *        that may affect any one cluster. Lights past that are dropped from the cluster.
+    */
+   struct cluster_grid {
+      GLuint x = 16;
+      GLuint y = 9;
+      GLuint z = 24;
+      GLuint capacity = 128;
+
+      GLuint size() const noexcept
+      {
+         return x * y * z;
+      }
+   };
+
+   /**
+    * @brief Shades with thousands of point lights and spotlights, by binning them into a grid of
+    *        clusters that divides the view frustum, so that each fragment only loops over the
+    *        lights that can reach its cluster.
+    *
+    * The clusters are slices of the screen's tiles, spaced exponentially in depth. Their bounds
+    * only depend on the projection; the lights are binned by a compute shader each frame:
+    *
+    *    lights.project(projection, near, far, width, height); // when the projection changes
+    *    lights.write(points, spots);
+    *    lights.bin(view);
+    *    lights.bind();
+    *    // draw with a program that includes clustered_lights.glsl
+    *
+    * Fragment shaders are compiled with `defines()`, and use `doge_cluster`,
+    * `doge_cluster_light_count`, `doge_cluster_light` and `doge_shade` (see
+    * clustered_lights.glsl) to loop over their cluster's lights.
+    *
+    * The light table, the cluster bounds, the cluster lists and the grid parameters occupy the
+    * four storage block binding points from `first_binding`.
+    */
+   class clustered_lighting {
+   public:
+      /**
+       * @param max_lights The most point lights and spotlights that may be written at once.
+       * @param cache Compiles clustered_lights.comp.glsl at `path`.
+       */
+      clustered_lighting(std::size_t max_lights, shader_cache& cache,
+         const cluster_grid& grid = {}, GLuint first_binding = 1,
+         const std::string& path = "clustered_lights.comp.glsl");
+
+      /**
+       * @brief Divides the frustum of `projection` into clusters, for a viewport of `width` by
+       *        `height` pixels. `near` and `far` are the clip planes given to `projection`.
+       */
+      void project(const glm::mat4& projection, float near_plane, float far_plane, GLsizei width,
+         GLsizei height);
+
+      /**
+       * @brief Replaces the lights in the scene.
+       */
+      void write(gsl::span<const point_light> points, gsl::span<const spotlight> spots = {});
+
+      /**
+       * @brief Bins the lights into clusters, as seen through `view`. The lists are ready for the
+       *        draws that follow.
+       */
+      void bin(const glm::mat4& view);
+
+      void bind() const noexcept;
+
+      /**
+       * @brief The defines that clustered_lights.glsl needs, for shader_cache::get.
+       */
+      const shader_defines& defines() const noexcept
+      {
+         return defines_;
+      }
+
+      std::size_t light_count() const noexcept
+      {
+         return lights_.size();
+      }
+
+      const cluster_grid& grid() const noexcept
+      {
+         return grid_;
+      }
+   private:
+      std::size_t max_lights_;
+      cluster_grid grid_;
+      GLuint first_binding_;
+      shader_defines defines_;
+      std::vector<detail::packed_light> lights_;
+      compute_program binning_;
+      storage_buffer<detail::packed_light> light_table_;
+      storage_buffer<glm::vec4> bounds_;
+      storage_buffer<GLuint> lists_;
+      storage_buffer<detail::cluster_parameters> parameters_;
+   };
+} // namespace doge
+
+#endif // DOGE_GL_CLUSTERED_LIGHTING_HPP
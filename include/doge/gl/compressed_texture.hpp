@@ -0,0 +1,135 @@
+//
+//  Copyright 2018 Christopher Di Bella
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+#ifndef DOGE_GL_COMPRESSED_TEXTURE_HPP
+#define DOGE_GL_COMPRESSED_TEXTURE_HPP
+
+#include <doge/gl/texture.hpp>
+#include <gl/gl_core.hpp>
+#include <gli/gli.hpp>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+
+namespace doge {
+   namespace detail {
+      /**
+       * @brief Allocates immutable storage for every level in `source`, and then uploads each
+       *        level (and each layer) as-is. Block-compressed formats are never decoded.
+       */
+      template <texture_t Kind>
+      void specify_compressed(const gli::texture& source, const gli::gl::format& format)
+      {
+         constexpr auto target = static_cast<GLenum>(Kind);
+         const auto levels = static_cast<GLsizei>(source.levels());
+         const auto layers = static_cast<GLsizei>(source.layers());
+         const auto compressed = gli::is_compressed(source.format());
+         const auto base = source.extent(0);
+
+         gl::TexParameteri(target, gl::TEXTURE_BASE_LEVEL, 0);
+         gl::TexParameteri(target, gl::TEXTURE_MAX_LEVEL, levels - 1);
+         gl::TexParameteri(target, gl::TEXTURE_SWIZZLE_R,
+            static_cast<GLint>(format.Swizzles[0]));
+         gl::TexParameteri(target, gl::TEXTURE_SWIZZLE_G,
+            static_cast<GLint>(format.Swizzles[1]));
+         gl::TexParameteri(target, gl::TEXTURE_SWIZZLE_B,
+            static_cast<GLint>(format.Swizzles[2]));
+         gl::TexParameteri(target, gl::TEXTURE_SWIZZLE_A,
+            static_cast<GLint>(format.Swizzles[3]));
+
+         if constexpr (Kind == texture_t::texture_1d)
+            gl::TexStorage1D(target, levels, format.Internal, base.x);
+         else if constexpr (Kind == texture_t::texture_1d_array)
+            gl::TexStorage2D(target, levels, format.Internal, base.x, layers);
+         else if constexpr (Kind == texture_t::texture_2d)
+            gl::TexStorage2D(target, levels, format.Internal, base.x, base.y);
+         else if constexpr (Kind == texture_t::texture_2d_array)
+            gl::TexStorage3D(target, levels, format.Internal, base.x, base.y, layers);
+         else
+            gl::TexStorage3D(target, levels, format.Internal, base.x, base.y, base.z);
+
+         for (auto layer = GLsizei{0}; layer < layers; ++layer) {
+            for (auto level = GLsizei{0}; level < levels; ++level) {
+               const auto extent = source.extent(level);
+               const auto size = static_cast<GLsizei>(source.size(level));
+               const auto data = source.data(layer, 0, level);
+
+               if constexpr (Kind == texture_t::texture_1d) {
+                  if (compressed)
+                     gl::CompressedTexSubImage1D(target, level, 0, extent.x, format.Internal,
+                        size, data);
+                  else
+                     gl::TexSubImage1D(target, level, 0, extent.x, format.External, format.Type,
+                        data);
+               }
+               else if constexpr (Kind == texture_t::texture_1d_array ||
+                                  Kind == texture_t::texture_2d) {
+                  // a 1D array stores its layers along the second dimension
+                  const auto y = Kind == texture_t::texture_2d ? 0 : layer;
+                  const auto height = Kind == texture_t::texture_2d ? extent.y : 1;
+                  if (compressed)
+                     gl::CompressedTexSubImage2D(target, level, 0, y, extent.x, height,
+                        format.Internal, size, data);
+                  else
+                     gl::TexSubImage2D(target, level, 0, y, extent.x, height, format.External,
+                        format.Type, data);
+               }
+               else {
+                  // a 2D array stores its layers along the third dimension
+                  const auto z = Kind == texture_t::texture_3d ? 0 : layer;
+                  const auto depth = Kind == texture_t::texture_3d ? extent.z : 1;
+                  if (compressed)
+                     gl::CompressedTexSubImage3D(target, level, 0, 0, z, extent.x, extent.y, depth,
+                        format.Internal, size, data);
+                  else
+                     gl::TexSubImage3D(target, level, 0, 0, z, extent.x, extent.y, depth,
+                        format.External, format.Type, data);
+               }
+            }
+         }
+      }
+   } // namespace detail
+
+   /**
+    * @brief Loads a KTX or DDS texture at `path`, including any block-compressed format and all of
+    *        the mipmap levels stored in the file.
+    *
+    * Mipmaps are uploaded from the file rather than generated, so a file with a single level
+    * should be paired with a non-mipmapped `min_filter`. Cube maps aren't supported.
+    *
+    * @throws std::runtime_error if the file can't be loaded or its target isn't `Kind`.
+    */
+   template <texture_t Kind>
+   basic_texture<Kind> load_compressed_texture(const std::string_view path,
+      const typename basic_texture<Kind>::wrapping_t& wrapping, const minmag_t min_filter,
+      const minmag_t mag_filter, const int n = 0)
+   {
+      using namespace std::string_literals;
+
+      const auto source = gli::load(std::string{path});
+      if (source.empty())
+         throw std::runtime_error{"Unable to open texture "s + std::string{path}};
+
+      auto translator = gli::gl{gli::gl::PROFILE_GL33};
+      if (translator.translate(source.target()) != static_cast<GLenum>(Kind))
+         throw std::runtime_error{"Texture "s + std::string{path} + " has the wrong target"};
+
+      const auto format = translator.translate(source.format(), source.swizzles());
+      return basic_texture<Kind>{[&]{ detail::specify_compressed<Kind>(source, format); },
+         wrapping, min_filter, mag_filter, n};
+   }
+} // namespace doge
+
+#endif // DOGE_GL_COMPRESSED_TEXTURE_HPP
@@ -0,0 +1,155 @@
+//
+//  Copyright 2018 Christopher Di Bella
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+#ifndef DOGE_GL_COMPUTE_PROGRAM_HPP
+#define DOGE_GL_COMPUTE_PROGRAM_HPP
+
+#include <array>
+#include <cstddef>
+#include <doge/gl/shader_binary.hpp>
+#include <doge/gl/shader_cache.hpp>
+#include <doge/gl/storage_buffer.hpp>
+#include <doge/gl/texture.hpp>
+#include <experimental/ranges/concepts>
+#include <gl/gl_core.hpp>
+#include <string>
+
+namespace doge {
+   namespace ranges = std::experimental::ranges;
+
+   /**
+    * @brief The layout that `gl::DispatchComputeIndirect` reads from the indirect buffer.
+    */
+   struct dispatch_indirect_command {
+      GLuint x;
+      GLuint y;
+      GLuint z;
+   };
+
+   /**
+    * @brief A program made of a single compute shader.
+    *
+    * Uniforms are set through `program()`, exactly as for any other shader_binary.
+    */
+   class compute_program {
+   public:
+      explicit compute_program(const std::string& path);
+
+      compute_program(const std::string& path, shader_cache& cache,
+         const shader_defines& defines = {});
+
+      /**
+       * @brief Launches `x * y * z` work groups.
+       */
+      void dispatch(GLuint x, GLuint y = 1, GLuint z = 1) const;
+
+      /**
+       * @brief Launches the number of work groups stored in `commands[command]`, e.g. a count
+       *        written by an earlier culling pass.
+       */
+      void dispatch_indirect(const storage_buffer<dispatch_indirect_command>& commands,
+         std::size_t command = 0) const;
+
+      /**
+       * @brief The `local_size_x`, `local_size_y` and `local_size_z` declared by the shader.
+       */
+      const std::array<GLint, 3>& work_group_size() const noexcept
+      {
+         return work_group_size_;
+      }
+
+      /**
+       * @brief The number of work groups needed to cover `invocations` along `dimension`.
+       */
+      GLuint groups_for(const std::size_t invocations, const std::size_t dimension = 0) const
+         noexcept
+      {
+         Expects(dimension < work_group_size_.size());
+         const auto size = static_cast<std::size_t>(work_group_size_[dimension]);
+         return gsl::narrow_cast<GLuint>((invocations + size - 1) / size);
+      }
+
+      template <ranges::Invocable F>
+      auto use(const F& f) const
+      {
+         return program_.use(f);
+      }
+
+      const shader_binary& program() const noexcept
+      {
+         return program_;
+      }
+   private:
+      shader_binary program_;
+      std::array<GLint, 3> work_group_size_ = {};
+
+      void reflect_work_group_size() noexcept;
+   };
+
+   /**
+    * @brief Binds level `level` of `texture` to image unit `unit`, for `imageLoad` and
+    *        `imageStore`.
+    *
+    * @param access One of `gl::READ_ONLY`, `gl::WRITE_ONLY` or `gl::READ_WRITE`.
+    * @param format The format the shader declares for the image, e.g. `gl::RGBA8`.
+    */
+   template <texture_t Kind>
+   void bind_image(const basic_texture<Kind>& texture, const GLuint unit, const GLenum access,
+      const GLenum format, const GLint level = 0) noexcept
+   {
+      // array and 3D textures bind every layer, so that the shader can address them all
+      constexpr auto layered = Kind == texture_t::texture_3d
+         or Kind == texture_t::texture_1d_array or Kind == texture_t::texture_2d_array;
+      gl::BindImageTexture(unit, static_cast<GLuint>(texture), level, layered, 0, access, format);
+   }
+
+   /**
+    * @brief Makes the writes of earlier shaders visible to the operations in `barriers`, e.g.
+    *        `gl::SHADER_STORAGE_BARRIER_BIT` before a draw reads what a dispatch wrote.
+    */
+   inline void memory_barrier(const GLbitfield barriers) noexcept
+   {
+      gl::MemoryBarrier(barriers);
+   }
+
+   /**
+    * @brief Issues a memory barrier when it goes out of scope, so that the commands issued
+    *        within the scope are visible to the commands that follow it.
+    *
+    *    {
+    *       auto _ = scoped_barrier{gl::SHADER_STORAGE_BARRIER_BIT};
+    *       simulate.dispatch(simulate.groups_for(particle_count));
+    *    }
+    *    // draw the particles
+    */
+   class scoped_barrier {
+   public:
+      explicit scoped_barrier(const GLbitfield barriers) noexcept
+         : barriers_{barriers}
+      {}
+
+      scoped_barrier(const scoped_barrier&) = delete;
+      scoped_barrier& operator=(const scoped_barrier&) = delete;
+
+      ~scoped_barrier() noexcept
+      {
+         memory_barrier(barriers_);
+      }
+   private:
+      GLbitfield barriers_;
+   };
+} // namespace doge
+
+#endif // DOGE_GL_COMPUTE_PROGRAM_HPP
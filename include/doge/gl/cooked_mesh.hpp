@@ -0,0 +1,286 @@
+//
+//  Copyright 2018 Christopher Di Bella
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+#ifndef DOGE_GL_COOKED_MESH_HPP
+#define DOGE_GL_COOKED_MESH_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <doge/gl/handle.hpp>
+#include <doge/gl/state_cache.hpp>
+#include <doge/gl/vertex_format.hpp>
+#include <doge/utility/file.hpp>
+#include <experimental/ranges/concepts>
+#include <experimental/ranges/functional>
+#include <gl/gl_core.hpp>
+#include <glm/vec3.hpp>
+#include <glm/vec4.hpp>
+#include <gsl/gsl>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace doge {
+   namespace ranges = std::experimental::ranges;
+
+   /**
+    * @brief How one vertex attribute is stored, as recorded in a cooked mesh, so that the loader
+    *        can describe it to the GL without knowing the format at compile time.
+    */
+   struct mesh_attribute {
+      std::uint32_t components;
+      std::uint32_t type;
+      std::uint32_t offset;
+      std::uint8_t normalised;
+      std::uint8_t integer;
+      std::uint8_t padding[2];
+   };
+   static_assert(sizeof(mesh_attribute) == 16);
+
+   /**
+    * @brief A range of a cooked mesh's indices that draws it at one level of detail, and the
+    *        largest distance, in object space, by which it strays from the full-detail mesh.
+    */
+   struct mesh_lod {
+      std::uint32_t first_index;
+      std::uint32_t index_count;
+      float error;
+      std::uint32_t padding;
+   };
+   static_assert(sizeof(mesh_lod) == 16);
+
+   namespace detail {
+      template <typename Format, std::size_t... I>
+      std::vector<mesh_attribute> describe(std::index_sequence<I...>)
+      {
+         return {mesh_attribute{
+            static_cast<std::uint32_t>(Format::template attribute<I>::components),
+            static_cast<std::uint32_t>(Format::template attribute<I>::component::type),
+            static_cast<std::uint32_t>(Format::offsets[I]),
+            Format::template attribute<I>::component::normalised,
+            Format::template attribute<I>::component::integer,
+            {}}...};
+      }
+   } // namespace detail
+
+   /**
+    * @brief Describes the attributes of `vertex_format<Attributes...>` for a cooked mesh.
+    */
+   template <typename... Attributes>
+   std::vector<mesh_attribute> describe(vertex_format<Attributes...>)
+   {
+      return detail::describe<vertex_format<Attributes...>>(
+         std::index_sequence_for<Attributes...>{});
+   }
+
+   /**
+    * @brief The format that `import_obj` cooks meshes into: a position, a packed normal and a
+    *        half-float texture coordinate, in 20 bytes.
+    */
+   using cooked_vertex = vertex_format<attr<glm::vec3>, attr<glm::vec3, snorm_2_10_10_10>,
+      attr<glm::vec2, half>>;
+
+   /**
+    * @brief A mesh on the CPU, as imported by a cooker, and written out with `save`.
+    *
+    * The first attribute is always the position, as three floats.
+    */
+   struct mesh_data {
+      std::vector<mesh_attribute> attributes;
+      std::uint32_t stride = 0;
+      std::vector<std::byte> vertices;
+      std::vector<std::uint32_t> indices;
+
+      /** @brief Empty when the mesh has a single level of detail, made of every index. */
+      std::vector<mesh_lod> lods;
+
+      glm::vec3 min = glm::vec3{0.0f};
+      glm::vec3 max = glm::vec3{0.0f};
+
+      /** @brief The centre and radius of a sphere that encloses every vertex. */
+      glm::vec4 sphere = glm::vec4{0.0f};
+
+      std::size_t vertex_count() const noexcept
+      {
+         return stride == 0 ? 0 : vertices.size() / stride;
+      }
+
+      glm::vec3 position(std::size_t vertex) const noexcept;
+
+      /**
+       * @brief Recomputes the bounds from the vertices.
+       */
+      void compute_bounds() noexcept;
+
+      /**
+       * @brief Writes the mesh in the cooked format that mesh_file maps.
+       * @throws std::runtime_error if the file can't be written.
+       */
+      void save(const std::string& path) const;
+   };
+
+   /**
+    * @brief Imports a Wavefront OBJ file as a `cooked_vertex` mesh. Polygons are triangulated as
+    *        fans, all groups and objects are merged, and materials are ignored. Vertices
+    *        without a normal are given the average normal of the faces around them.
+    * @throws std::runtime_error if the file can't be read or parsed.
+    */
+   mesh_data import_obj(const std::string& path);
+
+   /**
+    * @brief A cooked mesh, mapped into memory and checked, but otherwise left as it is on disk.
+    *
+    * The file is laid out as a header, the attribute and LOD tables, and then the vertex and
+    * index blobs, each 16-byte aligned, in the byte order of the machine that cooked it.
+    */
+   class mesh_file {
+   public:
+      /**
+       * @throws std::runtime_error if the file can't be mapped, or isn't a cooked mesh of a
+       *         version that this build understands.
+       */
+      explicit mesh_file(const std::string& path);
+
+      gsl::span<const mesh_attribute> attributes() const noexcept
+      {
+         return attributes_;
+      }
+
+      gsl::span<const mesh_lod> lods() const noexcept
+      {
+         return lods_;
+      }
+
+      gsl::span<const std::byte> vertices() const noexcept
+      {
+         return vertices_;
+      }
+
+      gsl::span<const std::byte> indices() const noexcept
+      {
+         return indices_;
+      }
+
+      GLsizei stride() const noexcept
+      {
+         return stride_;
+      }
+
+      /**
+       * @brief `gl::UNSIGNED_SHORT` or `gl::UNSIGNED_INT`.
+       */
+      GLenum index_type() const noexcept
+      {
+         return index_type_;
+      }
+
+      const glm::vec3& min() const noexcept
+      {
+         return min_;
+      }
+
+      const glm::vec3& max() const noexcept
+      {
+         return max_;
+      }
+
+      const glm::vec4& sphere() const noexcept
+      {
+         return sphere_;
+      }
+   private:
+      mapped_file file_;
+      gsl::span<const mesh_attribute> attributes_;
+      gsl::span<const mesh_lod> lods_;
+      gsl::span<const std::byte> vertices_;
+      gsl::span<const std::byte> indices_;
+      GLsizei stride_ = 0;
+      GLenum index_type_ = gl::UNSIGNED_INT;
+      glm::vec3 min_;
+      glm::vec3 max_;
+      glm::vec4 sphere_;
+   };
+
+   /**
+    * @brief A cooked mesh on the GPU. Each blob is copied straight from the mapped file into its
+    *        buffer, with no parsing or conversion.
+    */
+   class cooked_mesh {
+   public:
+      explicit cooked_mesh(const mesh_file& file);
+
+      explicit cooked_mesh(const std::string& path)
+         : cooked_mesh{mesh_file{path}}
+      {}
+
+      /**
+       * @brief Draws level of detail `lod`; zero is the full-detail mesh.
+       */
+      void draw(const std::size_t lod = 0, const GLenum mode = gl::TRIANGLES) const noexcept
+      {
+         draw_instanced(1, lod, mode);
+      }
+
+      void draw_instanced(GLsizei instances, std::size_t lod = 0, GLenum mode = gl::TRIANGLES)
+         const noexcept;
+
+      /**
+       * @brief Binds the mesh's vertex array while `f` is invoked, e.g. to add instanced
+       *        attributes.
+       */
+      template <ranges::Invocable F>
+      void bind(const F& f) const noexcept
+      {
+         gl_state().bind_vertex_array(vao_);
+         ranges::invoke(f);
+      }
+
+      const std::vector<mesh_lod>& lods() const noexcept
+      {
+         return lods_;
+      }
+
+      GLenum index_type() const noexcept
+      {
+         return index_type_;
+      }
+
+      const glm::vec3& min() const noexcept
+      {
+         return min_;
+      }
+
+      const glm::vec3& max() const noexcept
+      {
+         return max_;
+      }
+
+      const glm::vec4& sphere() const noexcept
+      {
+         return sphere_;
+      }
+   private:
+      unique_vertex_array vao_ = unique_vertex_array::generate();
+      unique_buffer vbo_ = unique_buffer::generate();
+      unique_buffer ebo_ = unique_buffer::generate();
+      GLenum index_type_;
+      std::vector<mesh_lod> lods_;
+      glm::vec3 min_;
+      glm::vec3 max_;
+      glm::vec4 sphere_;
+   };
+} // namespace doge
+
+#endif // DOGE_GL_COOKED_MESH_HPP
@@ -0,0 +1,177 @@
+//
+//  Copyright 2018 Christopher Di Bella
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+#ifndef DOGE_GL_DYNAMIC_RESOLUTION_HPP
+#define DOGE_GL_DYNAMIC_RESOLUTION_HPP
+
+#include <array>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <doge/gl/framebuffer.hpp>
+#include <doge/gl/handle.hpp>
+#include <doge/gl/shader_binary.hpp>
+#include <doge/gl/shader_cache.hpp>
+#include <gl/gl_core.hpp>
+#include <string>
+
+namespace doge {
+   struct dynamic_resolution_settings {
+      /** @brief The GPU time that a frame should take, leaving some headroom below the refresh
+       *         interval for the work that isn't scaled. */
+      std::chrono::nanoseconds target = std::chrono::microseconds{14'000};
+
+      float min_scale = 0.5f;
+      float max_scale = 1.0f;
+
+      /** @brief Frame times this close to the target, as a fraction of it, leave the scale be. */
+      float tolerance = 0.05f;
+
+      /** @brief How much of the way to the ideal scale each measurement moves. Rising is slower
+       *         than falling, so that a spike is handled within a frame or two, but the scale
+       *         doesn't oscillate on its way back. */
+      float increase_rate = 0.1f;
+      float decrease_rate = 0.5f;
+
+      /** @brief How strongly `present` sharpens the upscaled image, from zero (a bilinear blit)
+       *         to one. */
+      float sharpness = 0.0f;
+   };
+
+   struct dynamic_resolution_statistics {
+      /** @brief The GPU time of the most recent frame whose queries have been read back. */
+      std::chrono::nanoseconds gpu_time{};
+
+      /** @brief Frames whose GPU time was measured, and fed to the controller. */
+      std::size_t measured = 0;
+
+      /** @brief Frames that went untimed, because every query was still waiting for the GPU. */
+      std::size_t untimed = 0;
+   };
+
+   /**
+    * @brief Renders the scene at a fraction of the window's resolution, chosen each frame so that
+    *        the GPU keeps to `dynamic_resolution_settings::target`.
+    *
+    * The offscreen target is allocated once at `max_scale`, and each frame only renders into the
+    * corner of it that the current scale covers, so changing the scale never reallocates.
+    * `present` upscales that corner to the window, bilinearly or with upscale.frag.glsl when
+    * sharpening, and times the frame with a pair of `gl::TIMESTAMP` queries. The queries are
+    * read back a few frames later, without waiting, and since the GPU time is about proportional
+    * to the pixels drawn, the scale moves towards `scale * sqrt(target / time)`.
+    *
+    *    resolution.begin();
+    *    draw_scene();
+    *    resolution.present();
+    *
+    * Passes that set their own viewport should use `width()` and `height()`, and the projection
+    * is unchanged, since both axes are scaled alike.
+    */
+   class dynamic_resolution {
+   public:
+      dynamic_resolution(GLsizei width, GLsizei height, shader_cache& cache,
+         const dynamic_resolution_settings& settings = {}, const framebuffer_format& format = {},
+         const std::string& vertex_path = "upscale.vert.glsl",
+         const std::string& fragment_path = "upscale.frag.glsl");
+
+      dynamic_resolution(const dynamic_resolution&) = delete;
+      dynamic_resolution& operator=(const dynamic_resolution&) = delete;
+
+      ~dynamic_resolution() noexcept;
+
+      /**
+       * @brief Matches a resized window. The scale is kept.
+       */
+      void resize(GLsizei width, GLsizei height);
+
+      /**
+       * @brief Binds the offscreen target, sets the viewport to the scaled size, and starts
+       *        timing the frame.
+       */
+      void begin();
+
+      /**
+       * @brief Upscales what was rendered since `begin` to the default framebuffer, finishes
+       *        timing the frame, and adjusts the scale from any timings that have arrived.
+       */
+      void present();
+
+      /**
+       * @brief The fraction of the window's width and height that is rendered.
+       */
+      float scale() const noexcept
+      {
+         return scale_;
+      }
+
+      /**
+       * @brief Overrides the scale until the controller next adjusts it, e.g. to start low.
+       */
+      void scale(float s) noexcept;
+
+      /**
+       * @brief The size that the scene is rendered at this frame.
+       */
+      GLsizei width() const noexcept;
+      GLsizei height() const noexcept;
+
+      const framebuffer& target() const noexcept
+      {
+         return target_;
+      }
+
+      dynamic_resolution_settings& settings() noexcept
+      {
+         return settings_;
+      }
+
+      const dynamic_resolution_settings& settings() const noexcept
+      {
+         return settings_;
+      }
+
+      const dynamic_resolution_statistics& statistics() const noexcept
+      {
+         return statistics_;
+      }
+   private:
+      // timings are read back this many frames later, when the GPU has usually finished them
+      static constexpr std::size_t latency = 4;
+
+      struct timing {
+         std::array<GLuint, 2> queries{};
+         float scale = 1.0f;
+         bool pending = false;
+      };
+
+      GLsizei output_width_;
+      GLsizei output_height_;
+      dynamic_resolution_settings settings_;
+      framebuffer target_;
+      shader_binary upscale_;
+      unique_vertex_array empty_;
+      std::array<timing, latency> timings_;
+      std::uint64_t frame_ = 0;
+      bool timed_ = false;
+      float scale_;
+      dynamic_resolution_statistics statistics_;
+
+      void collect() noexcept;
+      void adjust(std::chrono::nanoseconds time, float measured_scale) noexcept;
+      void upscale() const;
+   };
+} // namespace doge
+
+#endif // DOGE_GL_DYNAMIC_RESOLUTION_HPP
@@ -0,0 +1,141 @@
+//
+//  Copyright 2018 Christopher Di Bella
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+#ifndef DOGE_GL_FRAMEBUFFER_HPP
+#define DOGE_GL_FRAMEBUFFER_HPP
+
+#include <doge/gl/handle.hpp>
+#include <doge/gl/texture.hpp>
+#include <gl/gl_core.hpp>
+#include <optional>
+
+namespace doge {
+   /**
+    * @brief The attachments of a framebuffer. A format of zero leaves that attachment out.
+    */
+   struct framebuffer_format {
+      GLenum colour = gl::RGBA8;
+
+      /** @brief Either a depth format or a packed depth-stencil format. */
+      GLenum depth = gl::DEPTH24_STENCIL8;
+
+      /** @brief More than one sample renders into multisampled renderbuffers, which `resolve`
+       *         copies into the textures. */
+      GLsizei samples = 0;
+   };
+
+   /**
+    * @brief An offscreen render target, with its colour and depth in textures that can be sampled
+    *        or read back once rendering is done.
+    *
+    * This is the target for headless rendering, where there's no default framebuffer to draw to,
+    * and for any pass whose output is used again, such as a thumbnail or a reflection.
+    *
+    *    target.bind();
+    *    draw_scene();
+    *    target.resolve();
+    *    target.colour().bind(gl::TEXTURE0);
+    */
+   class framebuffer {
+   public:
+      framebuffer(GLsizei width, GLsizei height, const framebuffer_format& format = {});
+
+      /**
+       * @brief Reallocates the attachments at a new size. Their contents are lost.
+       */
+      void resize(GLsizei width, GLsizei height);
+
+      /**
+       * @brief Makes this the target for drawing and reading, and sets the viewport to cover it.
+       */
+      void bind() const noexcept;
+
+      /**
+       * @brief Makes the window's framebuffer (if there is one) the target again.
+       */
+      static void bind_default() noexcept;
+
+      /**
+       * @brief Copies the samples rendered since the last resolve into `colour()` and `depth()`.
+       *        Does nothing when the framebuffer isn't multisampled.
+       *
+       * Leaves the read framebuffer bound to the resolved attachments, ready for `gl::ReadPixels`.
+       */
+      void resolve() const noexcept;
+
+      /**
+       * @brief The resolved colour attachment.
+       */
+      const texture2d& colour() const noexcept
+      {
+         Expects(colour_);
+         return *colour_;
+      }
+
+      /**
+       * @brief The resolved depth attachment.
+       */
+      const texture2d& depth() const noexcept
+      {
+         Expects(depth_);
+         return *depth_;
+      }
+
+      GLsizei width() const noexcept
+      {
+         return width_;
+      }
+
+      GLsizei height() const noexcept
+      {
+         return height_;
+      }
+
+      const framebuffer_format& format() const noexcept
+      {
+         return format_;
+      }
+
+      /**
+       * @brief The framebuffer that holds the resolved attachments, for `gl::ReadPixels` and
+       *        `gl::BlitFramebuffer`.
+       */
+      GLuint resolved() const noexcept
+      {
+         return multisampled() ? resolve_ : draw_;
+      }
+   private:
+      GLsizei width_ = 0;
+      GLsizei height_ = 0;
+      framebuffer_format format_;
+
+      // when multisampled, rendering goes to the renderbuffers, and resolving to the textures
+      unique_framebuffer draw_;
+      unique_framebuffer resolve_;
+      unique_renderbuffer colour_samples_;
+      unique_renderbuffer depth_samples_;
+      std::optional<texture2d> colour_;
+      std::optional<texture2d> depth_;
+
+      bool multisampled() const noexcept
+      {
+         return format_.samples > 1;
+      }
+
+      GLenum depth_attachment() const noexcept;
+   };
+} // namespace doge
+
+#endif // DOGE_GL_FRAMEBUFFER_HPP
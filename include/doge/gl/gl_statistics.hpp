@@ -0,0 +1,74 @@
+//
+//  Copyright 2018 Christopher Di Bella
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+#ifndef DOGE_GL_GL_STATISTICS_HPP
+#define DOGE_GL_GL_STATISTICS_HPP
+
+#include <cstdint>
+#include <gl/gl_trace.hpp>
+
+namespace doge {
+   /**
+    * @brief What the GL was asked to do over one frame, as counted by the tracing layer in the
+    *        loader. Every field is zero unless doge is built with `DOGE_GL_TRACE`.
+    *
+    * Calls are counted as the driver sees them, so binds that `gl_state()` filters out aren't
+    * counted, and neither is work that a single call hides, such as the draws in a
+    * `MultiDrawElementsIndirect`.
+    */
+   struct gl_statistics {
+#if defined(DOGE_GL_TRACE)
+      static constexpr bool enabled = true;
+#else
+      static constexpr bool enabled = false;
+#endif // DOGE_GL_TRACE
+
+      std::uint64_t draw_calls = 0;
+      std::uint64_t dispatches = 0;
+      std::uint64_t state_changes = 0;
+      std::uint64_t program_changes = 0;
+
+      // bytes passed to BufferData, BufferStorage and BufferSubData, or to TexImage, TexSubImage
+      // and their compressed forms; writes through mapped buffers don't pass through the loader
+      std::uint64_t buffer_call_bytes = 0;
+      std::uint64_t texture_call_bytes = 0;
+
+      std::uint64_t performance_warnings = 0;
+      std::uint64_t errors = 0;
+   };
+
+   /**
+    * @brief Returns what has been counted since the last call, and starts counting afresh.
+    */
+   inline gl_statistics take_gl_statistics() noexcept
+   {
+      auto result = gl_statistics{};
+#if defined(DOGE_GL_TRACE)
+      using gl::trace::counter;
+      using gl::trace::exchange;
+      result.draw_calls = exchange(counter::draw_calls);
+      result.dispatches = exchange(counter::dispatches);
+      result.state_changes = exchange(counter::state_changes);
+      result.program_changes = exchange(counter::program_changes);
+      result.buffer_call_bytes = exchange(counter::buffer_call_bytes);
+      result.texture_call_bytes = exchange(counter::texture_call_bytes);
+      result.performance_warnings = exchange(counter::performance_warnings);
+      result.errors = exchange(counter::errors);
+#endif // DOGE_GL_TRACE
+      return result;
+   }
+} // namespace doge
+
+#endif // DOGE_GL_GL_STATISTICS_HPP
@@ -0,0 +1,268 @@
+//
+//  Copyright 2018 Christopher Di Bella
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+#ifndef DOGE_GL_HANDLE_HPP
+#define DOGE_GL_HANDLE_HPP
+
+#include <cstddef>
+#include <doge/gl/state_cache.hpp>
+#include <gl/gl_core.hpp>
+#include <gsl/gsl>
+#include <utility>
+#include <vector>
+
+namespace doge {
+   /**
+    * @brief How names of each kind of GL object are generated and deleted.
+    */
+   struct buffer_names {
+      static void generate(const GLsizei n, GLuint* const names) noexcept
+      {
+         gl::GenBuffers(n, names);
+      }
+
+      static void destroy(const GLsizei n, const GLuint* const names) noexcept
+      {
+         delete_buffers(n, names);
+      }
+   };
+
+   struct vertex_array_names {
+      static void generate(const GLsizei n, GLuint* const names) noexcept
+      {
+         gl::GenVertexArrays(n, names);
+      }
+
+      static void destroy(const GLsizei n, const GLuint* const names) noexcept
+      {
+         delete_vertex_arrays(n, names);
+      }
+   };
+
+   struct texture_names {
+      static void generate(const GLsizei n, GLuint* const names) noexcept
+      {
+         gl::GenTextures(n, names);
+      }
+
+      static void destroy(const GLsizei n, const GLuint* const names) noexcept
+      {
+         delete_textures(n, names);
+      }
+   };
+
+   struct framebuffer_names {
+      static void generate(const GLsizei n, GLuint* const names) noexcept
+      {
+         gl::GenFramebuffers(n, names);
+      }
+
+      static void destroy(const GLsizei n, const GLuint* const names) noexcept
+      {
+         gl::DeleteFramebuffers(n, names);
+      }
+   };
+
+   struct renderbuffer_names {
+      static void generate(const GLsizei n, GLuint* const names) noexcept
+      {
+         gl::GenRenderbuffers(n, names);
+      }
+
+      static void destroy(const GLsizei n, const GLuint* const names) noexcept
+      {
+         gl::DeleteRenderbuffers(n, names);
+      }
+   };
+
+   /**
+    * @brief Owns a single GL object. It is exactly one `GLuint` and is move-only; the object is
+    *        deleted when the handle is destroyed.
+    */
+   template <typename Names>
+   class unique_handle {
+   public:
+      unique_handle() = default;
+
+      explicit unique_handle(const GLuint name) noexcept
+         : name_{name}
+      {}
+
+      unique_handle(unique_handle&& other) noexcept
+         : name_{std::exchange(other.name_, 0)}
+      {}
+
+      unique_handle& operator=(unique_handle&& other) noexcept
+      {
+         reset(std::exchange(other.name_, 0));
+         return *this;
+      }
+
+      ~unique_handle() noexcept
+      {
+         reset();
+      }
+
+      /**
+       * @brief Creates a handle with a name taken from this thread's handle_pool.
+       */
+      static unique_handle generate();
+
+      /**
+       * @brief Deletes the owned object, if any, and takes ownership of `name`.
+       */
+      void reset(const GLuint name = 0) noexcept
+      {
+         if (name_ != 0)
+            Names::destroy(1, &name_);
+         name_ = name;
+      }
+
+      [[nodiscard]] GLuint release() noexcept
+      {
+         return std::exchange(name_, 0);
+      }
+
+      GLuint get() const noexcept
+      {
+         return name_;
+      }
+
+      operator GLuint() const noexcept
+      {
+         return name_;
+      }
+
+      explicit operator bool() const noexcept
+      {
+         return name_ != 0;
+      }
+   private:
+      GLuint name_ = 0;
+   };
+
+   using unique_buffer = unique_handle<buffer_names>;
+   using unique_vertex_array = unique_handle<vertex_array_names>;
+   using unique_texture = unique_handle<texture_names>;
+   using unique_framebuffer = unique_handle<framebuffer_names>;
+   using unique_renderbuffer = unique_handle<renderbuffer_names>;
+
+   static_assert(sizeof(unique_buffer) == sizeof(GLuint));
+
+   /**
+    * @brief Reserves object names in bulk, so that creating many objects costs one call to
+    *        `gl::Gen*` per batch rather than one per object.
+    *
+    * Names that are still reserved when the pool is destroyed aren't returned to the driver, as
+    * the context may already be gone by then; `clear` returns them while it is still current.
+    */
+   template <typename Names>
+   class handle_pool {
+   public:
+      explicit handle_pool(const std::size_t batch = 64) noexcept
+         : batch_{batch}
+      {
+         Expects(batch > 0);
+      }
+
+      handle_pool(const handle_pool&) = delete;
+      handle_pool& operator=(const handle_pool&) = delete;
+
+      unique_handle<Names> acquire()
+      {
+         if (free_.empty())
+            reserve(batch_);
+
+         const auto name = free_.back();
+         free_.pop_back();
+         return unique_handle<Names>{name};
+      }
+
+      /**
+       * @brief Ensures that at least `n` names are reserved, e.g. before loading a scene.
+       */
+      void reserve(const std::size_t n)
+      {
+         if (free_.size() >= n)
+            return;
+
+         const auto first = free_.size();
+         free_.resize(n);
+         Names::generate(gsl::narrow_cast<GLsizei>(n - first), free_.data() + first);
+         ++generate_calls_;
+      }
+
+      /**
+       * @brief Forgets every reserved name without returning it, for when the context that
+       *        reserved them is no longer current. They're freed along with that context.
+       */
+      void abandon() noexcept
+      {
+         free_.clear();
+      }
+
+      /**
+       * @brief Returns every reserved name to the driver.
+       */
+      void clear() noexcept
+      {
+         if (not free_.empty())
+            Names::destroy(gsl::narrow_cast<GLsizei>(free_.size()), free_.data());
+         free_.clear();
+      }
+
+      std::size_t available() const noexcept
+      {
+         return free_.size();
+      }
+
+      /**
+       * @brief The number of times the pool has called into the driver for more names.
+       */
+      std::size_t generate_calls() const noexcept
+      {
+         return generate_calls_;
+      }
+   private:
+      std::vector<GLuint> free_;
+      std::size_t batch_;
+      std::size_t generate_calls_ = 0;
+   };
+
+   /**
+    * @brief The pool of names for the context that is current on this thread.
+    */
+   template <typename Names>
+   handle_pool<Names>& name_pool() noexcept
+   {
+      thread_local auto pool = handle_pool<Names>{};
+      thread_local auto generation = context_generation();
+
+      // names reserved in another context mean nothing in this one
+      if (generation != context_generation()) {
+         pool.abandon();
+         generation = context_generation();
+      }
+      return pool;
+   }
+
+   template <typename Names>
+   unique_handle<Names> unique_handle<Names>::generate()
+   {
+      return name_pool<Names>().acquire();
+   }
+} // namespace doge
+
+#endif // DOGE_GL_HANDLE_HPP
@@ -0,0 +1,90 @@
+//
+//  Copyright 2018 Christopher Di Bella
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+#ifndef DOGE_GL_MESH_OPTIMISER_HPP
+#define DOGE_GL_MESH_OPTIMISER_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <doge/gl/cooked_mesh.hpp>
+#include <gl/gl_core.hpp>
+#include <gsl/gsl>
+
+namespace doge {
+   /**
+    * @brief How well an index buffer uses a FIFO post-transform cache of a given size.
+    *
+    * `acmr` is the average number of vertex shader invocations per triangle, which is 3 for an
+    * unindexed triangle list and approaches 0.5 for a perfect ordering of a large grid. `atvr` is
+    * the number of invocations per vertex, where 1 is the best possible.
+    */
+   struct vertex_cache_statistics {
+      std::size_t transformed = 0;
+      double acmr = 0.0;
+      double atvr = 0.0;
+   };
+
+   /**
+    * @brief Simulates a FIFO post-transform cache of `cache_size` entries over `indices`.
+    */
+   vertex_cache_statistics analyse_vertex_cache(gsl::span<const std::uint32_t> indices,
+      std::size_t vertex_count, std::size_t cache_size = 16);
+
+   /**
+    * @brief Merges the vertices of `mesh` that are byte-for-byte identical, and rewrites the
+    *        indices to refer to the survivors.
+    * @returns The number of vertices that were removed.
+    */
+   std::size_t weld_vertices(mesh_data& mesh);
+
+   /**
+    * @brief Reorders the triangles in `indices` with Tipsify (Sander, Nehab and Barczak, 2007) so
+    *        that they reuse vertices from a post-transform cache of `cache_size` entries.
+    *
+    * The overload that takes `GLint` indices is for the indices handed to `vertex`, which can
+    * be reordered before construction without touching the vertices.
+    */
+   void optimise_vertex_cache(gsl::span<std::uint32_t> indices, std::size_t vertex_count,
+      std::size_t cache_size = 16);
+
+   void optimise_vertex_cache(gsl::span<GLint> indices, std::size_t vertex_count,
+      std::size_t cache_size = 16);
+
+   /**
+    * @brief Splits each level of detail into the clusters that Tipsify produced, and sorts them
+    *        so that the ones facing away from the centre of the mesh are drawn first, which
+    *        lets early depth testing reject more of the pixels behind them.
+    *
+    * Triangles keep their order inside a cluster, so this should follow
+    * `optimise_vertex_cache`, and costs little of the cache efficiency that it bought.
+    */
+   void optimise_overdraw(mesh_data& mesh, std::size_t cache_size = 16);
+
+   /**
+    * @brief Reorders the vertices of `mesh` to match the order in which the indices first refer
+    *        to them, so that vertex fetches walk through memory, and drops unreferenced
+    *        vertices.
+    */
+   void optimise_vertex_fetch(mesh_data& mesh);
+
+   /**
+    * @brief Runs every pass above over `mesh`, in the order in which they should be used.
+    *
+    * `mesh_data::save` picks 16-bit indices by itself when the welded mesh is small enough.
+    */
+   void optimise(mesh_data& mesh, std::size_t cache_size = 16);
+} // namespace doge
+
+#endif // DOGE_GL_MESH_OPTIMISER_HPP
@@ -0,0 +1,203 @@
+//
+//  Copyright 2018 Christopher Di Bella
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+#ifndef DOGE_GL_MESH_POOL_HPP
+#define DOGE_GL_MESH_POOL_HPP
+
+#include <cstddef>
+#include <doge/gl/cooked_mesh.hpp>
+#include <doge/gl/state_cache.hpp>
+#include <doge/gl/storage_buffer.hpp>
+#include <doge/gl/vertex_format.hpp>
+#include <gl/gl_core.hpp>
+#include <gsl/gsl>
+#include <vector>
+
+namespace doge {
+   /**
+    * @brief The layout that `gl::MultiDrawElementsIndirect` reads from the indirect buffer.
+    */
+   struct draw_elements_indirect_command {
+      GLuint count;
+      GLuint instance_count;
+      GLuint first_index;
+      GLint base_vertex;
+      GLuint base_instance;
+   };
+
+   /**
+    * @brief Packs many static meshes that share a vertex format into one vertex buffer and one
+    *        index buffer, so that the whole pool is drawn with a single VAO bind and a single
+    *        `gl::MultiDrawElementsIndirect`.
+    *
+    * Each mesh gets its own indirect command. Its base instance defaults to the mesh's id, so a
+    * shader can find per-object data with `gl_BaseInstance + gl_InstanceID` (or `gl_DrawID`
+    * when `GL_ARB_shader_draw_parameters` is available), or through an instanced attribute.
+    *
+    * Requires GL 4.3 and `GL_ARB_buffer_storage`.
+    */
+   class mesh_pool {
+   public:
+      using mesh_id = std::size_t;
+
+      /**
+       * @param vertex_capacity The number of vertices the pool can hold.
+       * @param index_capacity The number of indices the pool can hold.
+       */
+      template <typename... Attributes>
+      mesh_pool(vertex_format<Attributes...>, const GLsizeiptr vertex_capacity,
+         const GLsizeiptr index_capacity)
+         : mesh_pool(gsl::narrow_cast<GLsizei>(vertex_format<Attributes...>::stride),
+              vertex_capacity, index_capacity)
+      {
+         gl_state().bind_vertex_array(vao_);
+         vertex_format<Attributes...>::format(0, 0);
+         gl::BindVertexBuffer(0, vbo_, 0, stride_);
+         gl_state().bind_buffer(gl::ELEMENT_ARRAY_BUFFER, ebo_);
+         gl_state().bind_vertex_array(0);
+      }
+
+      mesh_pool(const mesh_pool&) = delete;
+      mesh_pool& operator=(const mesh_pool&) = delete;
+
+      ~mesh_pool() noexcept;
+
+      /**
+       * @brief Copies a mesh into the pool.
+       *
+       * @param vertices Vertices encoded in the pool's format.
+       * @param indices Indices relative to the first vertex of the mesh.
+       * @returns The mesh's id, which is also the index of its indirect command.
+       * @throws std::length_error if the pool does not have room for the mesh.
+       */
+      mesh_id add(gsl::span<const std::byte> vertices, gsl::span<const GLuint> indices);
+
+      /**
+       * @brief Copies a mesh with several levels of detail into the pool. It's drawn at the first
+       *        level until `lod` picks another.
+       *
+       * @param lods The ranges of `indices` that draw each level, e.g. `mesh_data::lods`.
+       */
+      mesh_id add(gsl::span<const std::byte> vertices, gsl::span<const GLuint> indices,
+         gsl::span<const mesh_lod> lods);
+
+      /**
+       * @brief Sets which level of detail a mesh is drawn at, e.g. from a lod_selector.
+       */
+      void lod(mesh_id mesh, std::size_t level) noexcept;
+
+      /**
+       * @brief The levels of detail of a mesh, as ranges of the pool's index buffer.
+       */
+      gsl::span<const mesh_lod> lods(const mesh_id mesh) const noexcept
+      {
+         Expects(mesh < lod_ranges_.size());
+         const auto& r = lod_ranges_[mesh];
+         return gsl::span<const mesh_lod>{lods_}.subspan(gsl::narrow_cast<std::ptrdiff_t>(r.first),
+            gsl::narrow_cast<std::ptrdiff_t>(r.count));
+      }
+
+      /**
+       * @brief Sets how many instances of a mesh are drawn. Zero hides the mesh.
+       */
+      void instances(mesh_id mesh, GLuint count) noexcept;
+
+      /**
+       * @brief Sets the base instance of a mesh, i.e. the first element of any instanced
+       *        attributes that it reads.
+       */
+      void base_instance(mesh_id mesh, GLuint first) noexcept;
+
+      /**
+       * @brief Draws every mesh in the pool.
+       *
+       * Uploads the indirect commands first if any of them changed since the last draw.
+       */
+      void draw(GLenum mode = gl::TRIANGLES);
+
+      /**
+       * @brief Draws every mesh in the pool with `commands` in place of the pool's own, e.g. the
+       *        commands that an occlusion_culler wrote. There must be a command for each mesh.
+       */
+      void draw(const storage_buffer<draw_elements_indirect_command>& commands,
+         GLenum mode = gl::TRIANGLES);
+
+      /**
+       * @brief The buffer that holds the indirect commands, so that a compute pass can read them.
+       *
+       * Uploads the commands first if any of them changed.
+       */
+      GLuint commands_buffer();
+
+      /**
+       * @brief Binds the pool's vertex array while `f` is invoked, e.g. to add instanced
+       *        attributes.
+       */
+      template <ranges::Invocable F>
+      void bind(const F& f) const noexcept
+      {
+         gl_state().bind_vertex_array(vao_);
+         ranges::invoke(f);
+      }
+
+      const draw_elements_indirect_command& command(const mesh_id mesh) const noexcept
+      {
+         Expects(mesh < commands_.size());
+         return commands_[mesh];
+      }
+
+      std::size_t size() const noexcept
+      {
+         return commands_.size();
+      }
+
+      GLsizeiptr vertices_used() const noexcept
+      {
+         return vertices_used_;
+      }
+
+      GLsizeiptr indices_used() const noexcept
+      {
+         return indices_used_;
+      }
+   private:
+      GLuint vao_ = 0;
+      GLuint vbo_ = 0;
+      GLuint ebo_ = 0;
+      GLuint indirect_ = 0;
+      GLsizei stride_;
+      GLsizeiptr vertex_capacity_;
+      GLsizeiptr index_capacity_;
+      GLsizeiptr vertices_used_ = 0;
+      GLsizeiptr indices_used_ = 0;
+      GLsizeiptr indirect_capacity_ = 0;
+
+      std::vector<draw_elements_indirect_command> commands_;
+      bool dirty_ = false;
+
+      struct lod_range {
+         std::size_t first;
+         std::size_t count;
+      };
+
+      std::vector<mesh_lod> lods_; // the levels of every mesh, back to back
+      std::vector<lod_range> lod_ranges_;
+
+      mesh_pool(GLsizei stride, GLsizeiptr vertex_capacity, GLsizeiptr index_capacity);
+      void upload_commands();
+   };
+} // namespace doge
+
+#endif // DOGE_GL_MESH_POOL_HPP
@@ -0,0 +1,61 @@
+//
+//  Copyright 2018 Christopher Di Bella
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+#ifndef DOGE_GL_MESH_SIMPLIFIER_HPP
+#define DOGE_GL_MESH_SIMPLIFIER_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <doge/gl/cooked_mesh.hpp>
+#include <gsl/gsl>
+#include <vector>
+
+namespace doge {
+   struct simplified_indices {
+      std::vector<std::uint32_t> indices;
+
+      /** @brief The largest distance, in object space, that a collapse moved the surface. */
+      float error = 0.0f;
+   };
+
+   /**
+    * @brief Removes triangles from `indices` by collapsing edges in the order of their quadric
+    *        error (Garland and Heckbert, 1997), until `target_triangles` are left or the next
+    *        collapse would cost more than `max_error`.
+    *
+    * Each collapse moves a vertex onto one of its neighbours, so the result indexes into the
+    * same vertices as `indices`. Vertices on the border of the mesh, and those that share their
+    * position with another vertex, e.g. along a UV seam, never move, which keeps holes and
+    * seams from opening up. Collapses that would flip a triangle are skipped.
+    */
+   simplified_indices simplify(const mesh_data& mesh, gsl::span<const std::uint32_t> indices,
+      std::size_t target_triangles, float max_error);
+
+   /**
+    * @brief Appends a chain of coarser levels of detail to `mesh`, each simplified from the one
+    *        before to about `ratio` of its triangles.
+    *
+    * The chain stops after `levels` levels, or once a level would stray by more than
+    * `max_error` times the radius of the mesh's bounding sphere, or stops getting smaller.
+    * Errors are accumulated along the chain, so they always increase. If `mesh.lods` is empty,
+    * the whole mesh becomes the first level.
+    *
+    * @returns The number of levels that were added.
+    */
+   std::size_t generate_lods(mesh_data& mesh, std::size_t levels = 4, float ratio = 0.5f,
+      float max_error = 0.05f);
+} // namespace doge
+
+#endif // DOGE_GL_MESH_SIMPLIFIER_HPP
@@ -0,0 +1,214 @@
+//
+//  Copyright 2018 Christopher Di Bella
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+#ifndef DOGE_GL_OCCLUSION_HPP
+#define DOGE_GL_OCCLUSION_HPP
+
+#include <array>
+#include <cstddef>
+#include <doge/gl/compute_program.hpp>
+#include <doge/gl/handle.hpp>
+#include <doge/gl/mesh_pool.hpp>
+#include <doge/gl/shader_cache.hpp>
+#include <doge/gl/storage_buffer.hpp>
+#include <doge/gl/texture.hpp>
+#include <experimental/ranges/concepts>
+#include <experimental/ranges/functional>
+#include <gl/gl_core.hpp>
+#include <glm/mat4x4.hpp>
+#include <glm/vec4.hpp>
+#include <optional>
+#include <string>
+
+namespace doge {
+   namespace ranges = std::experimental::ranges;
+
+   /**
+    * @brief Counts from the most recent cull whose results have reached the CPU, which is
+    *        usually two or three frames old. Meshes with no instances aren't counted.
+    */
+   struct occlusion_statistics {
+      std::size_t drawn = 0;
+      std::size_t culled = 0;
+   };
+
+   /**
+    * @brief Culls the meshes of a mesh_pool that are hidden behind what has already been drawn,
+    *        by testing their bounds against a hierarchical-Z pyramid on the GPU.
+    *
+    * Each frame, draw the occluders (e.g. a depth pre-pass of the largest objects), and then
+    *
+    *    culler.build_pyramid();
+    *    culler.cull(projection * view, spheres, pool);
+    *    culler.draw(pool);
+    *
+    * Level `n` of the pyramid holds the farthest depth of each `2^n` texel square of the depth
+    * buffer, so a mesh is hidden when its nearest depth is farther than the few texels that cover
+    * its bounds. Culling only ever sets a mesh's instance count to zero in a copy of the pool's
+    * commands, so nothing is lost when it becomes visible again.
+    *
+    * The passes are hiz_reduce.comp.glsl and hiz_test.comp.glsl.
+    */
+   class occlusion_culler {
+   public:
+      /**
+       * @param width The width of the depth buffer to be culled against, in pixels.
+       * @param height The height of the depth buffer to be culled against, in pixels.
+       */
+      occlusion_culler(GLsizei width, GLsizei height, shader_cache& cache,
+         const std::string& reduce_path = "hiz_reduce.comp.glsl",
+         const std::string& test_path = "hiz_test.comp.glsl");
+
+      occlusion_culler(const occlusion_culler&) = delete;
+      occlusion_culler& operator=(const occlusion_culler&) = delete;
+
+      ~occlusion_culler() noexcept;
+
+      /**
+       * @brief Matches the pyramid to a resized depth buffer.
+       */
+      void resize(GLsizei width, GLsizei height);
+
+      /**
+       * @brief Builds the pyramid from the depth buffer of the framebuffer bound to
+       *        `gl::READ_FRAMEBUFFER`.
+       */
+      void build_pyramid();
+
+      /**
+       * @brief Tests each mesh in `pool` against the pyramid, and writes the commands that draw
+       *        only the visible ones.
+       *
+       * @param spheres The world-space bounds of each mesh in `pool`, as a centre and radius,
+       *        indexed by mesh id. Instanced meshes need bounds that enclose every instance.
+       */
+      void cull(const glm::mat4& view_projection, const storage_buffer<glm::vec4>& spheres,
+         mesh_pool& pool);
+
+      /**
+       * @brief Draws the meshes that the last `cull` found visible.
+       */
+      void draw(mesh_pool& pool, const GLenum mode = gl::TRIANGLES)
+      {
+         if (commands_)
+            pool.draw(*commands_, mode);
+      }
+
+      const storage_buffer<draw_elements_indirect_command>& commands() const noexcept
+      {
+         Expects(commands_);
+         return *commands_;
+      }
+
+      const texture2d& pyramid() const noexcept
+      {
+         return *pyramid_;
+      }
+
+      GLsizei levels() const noexcept
+      {
+         return levels_;
+      }
+
+      const occlusion_statistics& statistics() const noexcept
+      {
+         return statistics_;
+      }
+   private:
+      // results are read back this many culls later, when the GPU has long since written them
+      static constexpr std::size_t statistics_latency = 3;
+
+      GLsizei width_ = 0;
+      GLsizei height_ = 0;
+      GLsizei levels_ = 0;
+      compute_program copy_;
+      compute_program reduce_;
+      compute_program test_;
+      std::optional<texture2d> depth_;
+      std::optional<texture2d> pyramid_;
+      std::optional<storage_buffer<draw_elements_indirect_command>> commands_;
+
+      std::array<unique_buffer, statistics_latency> counters_;
+      std::array<GLsync, statistics_latency> fences_ = {};
+      std::size_t frame_ = 0;
+      occlusion_statistics statistics_;
+
+      void collect_statistics(std::size_t slot);
+   };
+
+   /**
+    * @brief Hides a draw when a cheap proxy for it (such as its bounding box) was hidden, using
+    *        an occlusion query and conditional rendering. This is coarser than occlusion_culler,
+    *        but needs no compute shaders and no mesh_pool.
+    *
+    *    query.test([&]{ draw_bounding_box(); });
+    *    // ...
+    *    query.draw_if_visible([&]{ draw_object(); });
+    *
+    * The GL skips the draw itself when the query has finished, and draws anyway when it hasn't, so
+    * the CPU never waits for the result.
+    */
+   class occlusion_query {
+   public:
+      occlusion_query() noexcept
+      {
+         gl::GenQueries(1, &index_);
+      }
+
+      occlusion_query(const occlusion_query&) = delete;
+      occlusion_query& operator=(const occlusion_query&) = delete;
+
+      ~occlusion_query() noexcept
+      {
+         gl::DeleteQueries(1, &index_);
+      }
+
+      /**
+       * @brief Draws the proxy drawn by `f` into the query, without writing colour or depth.
+       *        The colour and depth write masks are restored afterwards.
+       */
+      template <ranges::Invocable F>
+      void test(const F& f) const noexcept
+      {
+         auto colour = std::array<GLboolean, 4>{};
+         auto depth = GLboolean{};
+         gl::GetBooleanv(gl::COLOR_WRITEMASK, colour.data());
+         gl::GetBooleanv(gl::DEPTH_WRITEMASK, &depth);
+
+         gl::ColorMask(false, false, false, false);
+         gl::DepthMask(false);
+         gl::BeginQuery(gl::ANY_SAMPLES_PASSED_CONSERVATIVE, index_);
+         ranges::invoke(f);
+         gl::EndQuery(gl::ANY_SAMPLES_PASSED_CONSERVATIVE);
+         gl::ColorMask(colour[0], colour[1], colour[2], colour[3]);
+         gl::DepthMask(depth);
+      }
+
+      /**
+       * @brief Issues the draws made by `f`, which the GL discards if the last proxy was hidden.
+       */
+      template <ranges::Invocable F>
+      void draw_if_visible(const F& f) const noexcept
+      {
+         gl::BeginConditionalRender(index_, gl::QUERY_BY_REGION_NO_WAIT);
+         ranges::invoke(f);
+         gl::EndConditionalRender();
+      }
+   private:
+      GLuint index_ = 0;
+   };
+} // namespace doge
+
+#endif // DOGE_GL_OCCLUSION_HPP
@@ -0,0 +1,90 @@
+//
+//  Copyright 2018 Christopher Di Bella
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+#ifndef DOGE_GL_PROGRAM_CACHE_HPP
+#define DOGE_GL_PROGRAM_CACHE_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <doge/gl/shader_source.hpp>
+#include <gl/gl_core.hpp>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace doge {
+   struct program_cache_statistics {
+      std::size_t hits = 0;
+      std::size_t misses = 0;
+      std::size_t rejected = 0; // binaries that were found, but refused by the driver
+   };
+
+   /**
+    * @brief Stores linked programs on disk with `gl::GetProgramBinary`, so that later runs can
+    *        skip compiling and linking.
+    *
+    * Programs are keyed on their shader sources and the GL vendor, renderer and version strings,
+    * so a driver update invalidates the cache rather than feeding it stale binaries. Binaries that
+    * the driver rejects anyway are rebuilt from source and replaced.
+    *
+    * The cache directory must already exist. A context must be current when the cache is
+    * constructed.
+    */
+   class program_cache {
+   public:
+      using sources_t = std::vector<std::pair<shader_source::type, std::string>>;
+
+      explicit program_cache(std::string directory);
+
+      /**
+       * @brief Computes the cache key for a program made from `sources`, which hold shader code
+       *        rather than paths.
+       */
+      std::uint64_t key(const sources_t& sources) const noexcept;
+
+      /**
+       * @brief Loads the binary stored under `key` into `program`.
+       * @returns true if a binary was found and the driver linked it successfully.
+       */
+      bool load(std::uint64_t key, GLuint program);
+
+      /**
+       * @brief Stores the binary of the linked `program` under `key`.
+       */
+      void store(std::uint64_t key, GLuint program) const;
+
+      /**
+       * @brief Builds each program so that its binary is cached before it's first needed.
+       *
+       * Binaries are only valid for the driver that produced them, so this is meant to be run on
+       * the target machine (e.g. by an installer or a first-run step), with `paths` in the same
+       * form accepted by `shader_binary`.
+       */
+      void prewarm(const std::vector<sources_t>& paths);
+
+      const program_cache_statistics& statistics() const noexcept
+      {
+         return statistics_;
+      }
+   private:
+      std::string directory_;
+      std::uint64_t driver_;
+      program_cache_statistics statistics_;
+
+      std::string path(std::uint64_t key) const;
+   };
+} // namespace doge
+
+#endif // DOGE_GL_PROGRAM_CACHE_HPP
@@ -0,0 +1,191 @@
+//
+//  Copyright 2018 Christopher Di Bella
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+#ifndef DOGE_GL_READBACK_HPP
+#define DOGE_GL_READBACK_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <doge/gl/compute_program.hpp>
+#include <doge/gl/framebuffer.hpp>
+#include <doge/gl/handle.hpp>
+#include <doge/gl/shader_cache.hpp>
+#include <doge/gl/state_cache.hpp>
+#include <experimental/ranges/concepts>
+#include <experimental/ranges/functional>
+#include <gl/gl_core.hpp>
+#include <gsl/gsl>
+#include <optional>
+#include <string>
+#include <vector>
+
+namespace doge {
+   namespace ranges = std::experimental::ranges;
+
+   /**
+    * @brief The layout of the bytes that an async_readback hands back.
+    *
+    * `rgba8` is four bytes per pixel, with the bottom row first, as the GL stores it.
+    *
+    * `i420` is planar 8-bit YUV 4:2:0 with BT.709 limited-range coefficients, top row first, as
+    * video encoders expect: a full-size Y plane, followed by quarter-size U and V planes. It is
+    * converted on the GPU, and is three eighths the size of `rgba8`.
+    */
+   enum class readback_encoding { rgba8, i420 };
+
+   struct readback_statistics {
+      /** @brief Frames whose reads were issued. */
+      std::size_t captured = 0;
+
+      /** @brief Frames that were handed to a callback. */
+      std::size_t delivered = 0;
+
+      /** @brief Frames that weren't read because every buffer was still waiting for the GPU. */
+      std::size_t dropped = 0;
+   };
+
+   /**
+    * @brief Reads frames back to the CPU without waiting for the GPU to finish them.
+    *
+    * Each `read` copies a frame into the next of a ring of pixel pack buffers and fences it.
+    * `poll` later hands every frame whose copy has finished to a callback, oldest first, and never
+    * blocks; a frame usually arrives `depth - 1` frames after it was read.
+    *
+    *    capture.read(target);
+    *    capture.poll([&](gsl::span<const std::byte> pixels, std::uint64_t frame) {
+    *       encoder.push(pixels, frame); });
+    *
+    * When every buffer is still in flight, the new frame is dropped rather than stalling.
+    */
+   class async_readback {
+   public:
+      /**
+       * @brief Reads `rgba8` frames.
+       */
+      async_readback(GLsizei width, GLsizei height, std::size_t depth = 3);
+
+      /**
+       * @brief Reads frames with `encoding`, converting them with the compute shader at `path`
+       *        when they're `i420`. `i420` needs a width that is a multiple of 8 and an even
+       *        height.
+       */
+      async_readback(GLsizei width, GLsizei height, readback_encoding encoding,
+         shader_cache& cache, std::size_t depth = 3,
+         const std::string& path = "rgb_to_yuv.comp.glsl");
+
+      async_readback(const async_readback&) = delete;
+      async_readback& operator=(const async_readback&) = delete;
+
+      ~async_readback() noexcept;
+
+      /**
+       * @brief Reads the framebuffer bound to `gl::READ_FRAMEBUFFER`, starting at `(x, y)`.
+       *        Only for `rgba8`.
+       */
+      void read(GLint x = 0, GLint y = 0);
+
+      /**
+       * @brief Resolves `source` and reads its colour attachment, which must be at least as
+       *        large as the frames.
+       */
+      void read(const framebuffer& source);
+
+      /**
+       * @brief Hands each finished frame to `f`, along with the number of the `read` that
+       *        captured it. The bytes are only valid until `f` returns.
+       *
+       * @returns The number of frames handed to `f`.
+       */
+      template <ranges::Invocable<gsl::span<const std::byte>, std::uint64_t> F>
+      std::size_t poll(const F& f)
+      {
+         auto delivered = std::size_t{0};
+         for (; pending_ != 0; --pending_, ++delivered) {
+            auto& oldest = slots_[(next_ + slots_.size() - pending_) % slots_.size()];
+            if (not finished(oldest))
+               break;
+
+            gl_state().bind_buffer(gl::PIXEL_PACK_BUFFER, oldest.buffer);
+            const auto bytes = gl::MapBufferRange(gl::PIXEL_PACK_BUFFER, 0,
+               gsl::narrow_cast<GLsizeiptr>(frame_size_), gl::MAP_READ_BIT);
+            if (bytes != nullptr) {
+               ranges::invoke(f, gsl::span<const std::byte>{static_cast<const std::byte*>(bytes),
+                  gsl::narrow_cast<std::ptrdiff_t>(frame_size_)}, oldest.frame);
+               gl::UnmapBuffer(gl::PIXEL_PACK_BUFFER);
+            }
+            gl_state().bind_buffer(gl::PIXEL_PACK_BUFFER, 0);
+         }
+
+         statistics_.delivered += delivered;
+         return delivered;
+      }
+
+      /**
+       * @brief The number of frames read but not yet handed back.
+       */
+      std::size_t pending() const noexcept
+      {
+         return pending_;
+      }
+
+      /**
+       * @brief The size of each frame handed back, in bytes.
+       */
+      std::size_t frame_size() const noexcept
+      {
+         return frame_size_;
+      }
+
+      readback_encoding encoding() const noexcept
+      {
+         return encoding_;
+      }
+
+      const readback_statistics& statistics() const noexcept
+      {
+         return statistics_;
+      }
+   private:
+      struct slot {
+         unique_buffer buffer;
+         GLsync fence = nullptr;
+         std::uint64_t frame = 0;
+      };
+
+      GLsizei width_;
+      GLsizei height_;
+      readback_encoding encoding_ = readback_encoding::rgba8;
+      std::size_t frame_size_;
+      std::optional<compute_program> convert_;
+      std::vector<slot> slots_;
+      std::size_t next_ = 0;
+      std::size_t pending_ = 0;
+      std::uint64_t frame_ = 0;
+      readback_statistics statistics_;
+
+      void allocate(std::size_t depth);
+
+      /**
+       * @brief The slot for the next frame, or null if every slot is still in flight.
+       */
+      slot* acquire() noexcept;
+
+      void submit(slot& s) noexcept;
+
+      static bool finished(slot& s) noexcept;
+   };
+} // namespace doge
+
+#endif // DOGE_GL_READBACK_HPP
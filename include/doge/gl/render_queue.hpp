@@ -0,0 +1,135 @@
+//
+//  Copyright 2018 Christopher Di Bella
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+#ifndef DOGE_GL_RENDER_QUEUE_HPP
+#define DOGE_GL_RENDER_QUEUE_HPP
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <gl/gl_core.hpp>
+#include <mutex>
+#include <vector>
+
+namespace doge {
+   /**
+    * @brief Builds a key that orders packets by pass, then program, texture set, vertex array,
+    *        and finally depth.
+    *
+    * The key is laid out as `pass:4 | program:12 | textures:12 | vertex_array:12 | depth:24`.
+    * GL names are usually small, so only their low bits are kept; collisions only cost an extra
+    * state change. `depth` is clamped to [0, 1]; translucent passes should pass `1 - depth` to
+    * draw back to front.
+    */
+   constexpr std::uint64_t sort_key(const std::uint64_t pass, const GLuint program,
+      const GLuint textures, const GLuint vertex_array, const float depth) noexcept
+   {
+      const auto clamped = depth < 0.0f ? 0.0f : depth > 1.0f ? 1.0f : depth;
+      const auto quantised = static_cast<std::uint64_t>(clamped * 0xFF'FFFF);
+      return (pass & 0xF) << 60 | std::uint64_t{program & 0xFFF} << 48
+         | std::uint64_t{textures & 0xFFF} << 36 | std::uint64_t{vertex_array & 0xFFF} << 24
+         | quantised;
+   }
+
+   /**
+    * @brief Everything needed to issue one draw, without running any code on the GL thread.
+    *
+    * Per-object data is reached through `base_instance`, e.g. by indexing a storage buffer with
+    * `gl_BaseInstance`, or through instanced attributes.
+    */
+   struct draw_packet {
+      static constexpr std::size_t max_textures = 4;
+
+      struct texture_binding {
+         GLenum target = gl::TEXTURE_2D;
+         GLuint texture = 0; // zero leaves the unit untouched
+      };
+
+      std::uint64_t key = 0;
+      GLuint program = 0;
+      GLuint vertex_array = 0;
+      std::array<texture_binding, max_textures> textures = {};
+      GLenum mode = gl::TRIANGLES;
+      GLenum index_type = 0; // zero draws arrays rather than elements
+      GLint first = 0; // the first vertex, or the first index
+      GLsizei count = 0;
+      GLsizei instances = 1;
+      GLint base_vertex = 0;
+      GLuint base_instance = 0;
+   };
+
+   struct render_queue_statistics {
+      std::size_t packets = 0;
+      std::size_t program_changes = 0;
+      std::size_t texture_changes = 0;
+      std::size_t vertex_array_changes = 0;
+   };
+
+   /**
+    * @brief Collects draw packets from any number of threads, and submits them in key order.
+    *
+    * Each recording thread asks for its own bucket, so recording doesn't take a lock:
+    *
+    *    // on a worker
+    *    auto& bucket = queue.bucket();
+    *    for (const auto& i : objects)
+    *       bucket.push_back(make_packet(i));
+    *
+    *    // on the GL thread, once the workers have finished
+    *    queue.submit();
+    *
+    * `submit` radix-sorts the packets from every bucket, issues them through the state cache, and
+    * empties the buckets for the next frame.
+    */
+   class render_queue {
+   public:
+      using bucket_type = std::vector<draw_packet>;
+
+      /**
+       * @brief Returns an empty bucket for the calling thread to record into until the next
+       *        `submit`. Buckets keep their capacity between frames.
+       */
+      bucket_type& bucket();
+
+      /**
+       * @brief Sorts and draws every packet recorded since the last submit. Must be called from
+       *        the thread that owns the context, after all recording has finished.
+       */
+      void submit();
+
+      const render_queue_statistics& statistics() const noexcept
+      {
+         return statistics_;
+      }
+   private:
+      struct sort_entry {
+         std::uint64_t key;
+         const draw_packet* packet;
+      };
+
+      std::mutex mutex_;
+      std::deque<bucket_type> buckets_; // a deque, so handing out a bucket never moves the others
+      std::size_t buckets_used_ = 0;
+      std::vector<sort_entry> order_;
+      std::vector<sort_entry> scratch_;
+      std::vector<std::size_t> counts_; // the radix sort's histogram, allocated by the first sort
+      render_queue_statistics statistics_;
+
+      void sort();
+   };
+} // namespace doge
+
+#endif // DOGE_GL_RENDER_QUEUE_HPP
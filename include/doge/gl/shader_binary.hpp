@@ -16,42 +16,264 @@
 #ifndef DOGE_GL_SHADER_BINARY_HPP
 #define DOGE_GL_SHADER_BINARY_HPP
 
+#include <cstddef>
+#include <cstdint>
+#include <doge/detail/gl_invocable.hpp>
 #include <doge/gl/shader_source.hpp>
+#include <doge/gl/state_cache.hpp>
 #include <experimental/ranges/concepts>
 #include <experimental/ranges/functional>
 #include <gl/gl_core.hpp>
+#include <gsl/gsl>
+#include <optional>
 #include <stdexcept>
 #include <string>
+#include <string_view>
 #include <vector>
 
 namespace doge {
    namespace ranges = std::experimental::ranges;
 
+   class program_cache;
+   class shader_cache;
+
+   struct uniform_not_found : public std::runtime_error {
+      uniform_not_found(const std::string_view id)
+         : std::runtime_error{std::string{id}}
+      {}
+   };
+
+   /**
+    * @brief Counts how uniform names were resolved by a shader_binary, and how many uniform writes
+    *        reached the driver.
+    *
+    * A hit is a name that was found in the table reflected at link time; a miss is a name that
+    * had to be resolved by the driver with `gl::GetUniformLocation`. A redundant write is one
+    * whose value matched the program's shadow copy, and so was never sent.
+    */
+   struct uniform_statistics {
+      std::size_t hits = 0;
+      std::size_t misses = 0;
+      std::size_t uploads = 0;
+      std::size_t redundant = 0;
+   };
+
+   namespace detail {
+      template <typename T>
+      constexpr GLenum uniform_component_v = gl::FLOAT;
+
+      template <>
+      constexpr GLenum uniform_component_v<GLint> = gl::INT;
+
+      template <>
+      constexpr GLenum uniform_component_v<GLuint> = gl::UNSIGNED_INT;
+   } // namespace detail
+
    class shader_binary {
    public:
       shader_binary(const std::vector<std::pair<shader_source::type, std::string>>& paths)
          : shader_binary{compile_shaders(paths)}
       {}
 
+      /**
+       * @brief Builds the program from the binary stored in `cache`, or from `paths` if there is
+       *        no usable binary (in which case the newly linked binary is added to the cache).
+       */
+      shader_binary(const std::vector<std::pair<shader_source::type, std::string>>& paths,
+         program_cache& cache);
+
       shader_binary(const std::vector<shader_source>& shaders);
 
+      /**
+       * @brief Builds the program from shaders held in `cache`, so that stages shared with other
+       *        programs are only compiled once. `defines` are applied to every stage.
+       */
+      shader_binary(const std::vector<std::pair<shader_source::type, std::string>>& paths,
+         shader_cache& cache, const std::vector<std::pair<std::string, std::string>>& defines = {});
+
+      /**
+       * @brief Submits the shaders in `paths` and the program for compilation and linking, and
+       *        returns without waiting for the driver.
+       *
+       * Errors are reported when the program is first used, or when `wait` is called. Where
+       * `GL_KHR_parallel_shader_compile` is available, the driver compiles on its own threads and
+       * `ready` can be polled.
+       */
+      shader_binary(const std::vector<std::pair<shader_source::type, std::string>>& paths,
+         deferred_build_t);
+
+      /**
+       * @brief Checks whether a deferred build has finished, without blocking.
+       *
+       * Without `GL_KHR_parallel_shader_compile` this can't be known without blocking, so it
+       * always returns true.
+       */
+      bool ready() const noexcept;
+
+      /**
+       * @brief Finishes a deferred build. Does nothing if the program has already been built.
+       * @throws std::runtime_error if any shader failed to compile or the program failed to link.
+       */
+      void wait() const;
+
+      /**
+       * @brief Binds the program, uploads any uniforms staged with `set_uniform`, and calls `f`.
+       */
       template <ranges::Invocable F>
-      auto use(const F& f) const noexcept
+      auto use(const F& f) const
       {
-         gl::UseProgram(index_);
+         wait();
+         gl_state().use_program(index_);
+         flush_uniforms();
          return ranges::invoke(f);
       }
 
+      /**
+       * @brief Returns the location of the active uniform `id`.
+       *
+       * Active uniforms are reflected once when the program is linked, so this is a hash lookup
+       * rather than a call into the driver. Names that were not reflected (e.g. `lights[3]`) fall
+       * back to `gl::GetUniformLocation`.
+       *
+       * Locations can be resolved outside of the frame loop and passed to `set_uniform` so that no
+       * string work is done per frame. The `doge::uniform(GLint, ...)` overloads take them too,
+       * but bypass the shadow copy, so shouldn't be mixed with `set_uniform` on one uniform.
+       *
+       * @throws uniform_not_found if `id` is not an active uniform in the program.
+       */
+      GLint uniform_location(std::string_view id) const;
+
+      /**
+       * @brief Stages `value` as the uniform at `location`, without calling the driver.
+       *
+       * The program keeps a shadow copy of every active uniform, read back when it's linked, so
+       * writing the value that the uniform already holds is a `memcmp` and nothing more. Values
+       * that differ are sent by the next `flush_uniforms`, which needn't be while the program is
+       * bound.
+       */
+      template <typename T>
+      requires
+         not ranges::RandomAccessRange<T> and
+         requires { typename detail::gl_traits<T>::type; }
+      void set_uniform(const GLint location, const T& value) const
+      {
+         using component = typename detail::gl_traits<T>::type;
+         stage(location, std::addressof(value), sizeof(T), detail::uniform_component_v<component>);
+      }
+
+      /**
+       * @brief Stages consecutive elements of an array uniform, starting at the one at `location`.
+       */
+      template <typename T>
+      requires requires { typename detail::gl_traits<T>::type; }
+      void set_uniform(const GLint location, const gsl::span<const T> values) const
+      {
+         using component = typename detail::gl_traits<T>::type;
+         stage(location, values.data(), sizeof(T) * gsl::narrow_cast<std::size_t>(values.size()),
+            detail::uniform_component_v<component>);
+      }
+
+      template <typename T>
+      void set_uniform(const std::string_view id, const T& value) const
+      {
+         set_uniform(uniform_location(id), value);
+      }
+
+      /**
+       * @brief Sends every uniform whose staged value differs from what the driver holds, one
+       *        `gl::ProgramUniform*` call each. Call it after staging, and before drawing.
+       */
+      void flush_uniforms() const;
+
+      /**
+       * @brief Records `size` bytes at `data` as the value of the uniform at `location`, and
+       *        returns whether they differ from the shadow copy, in which case the caller must
+       *        send them itself. For the `doge::uniform` overloads that take a program.
+       */
+      bool update_shadow(GLint location, const void* data, std::size_t size) const;
+
+      /**
+       * @brief Marks the shadow copy of the uniform at `location` as unknown, after it was set in
+       *        a way that can't be compared, such as with a transposed matrix.
+       */
+      void forget_uniform(GLint location) const noexcept;
+
+      const uniform_statistics& uniform_lookups() const noexcept
+      {
+         return lookups_;
+      }
+
       explicit operator GLuint() const noexcept
       {
          return index_;
       }
    private:
+      struct uniform_entry {
+         std::size_t hash;
+         GLint location;
+         std::string name;
+      };
+
+      // one per active uniform outside of a block, whose elements are contiguous in shadow_
+      struct shadowed_uniform {
+         GLenum type;
+         GLenum component;
+         std::uint32_t offset;
+         std::uint32_t element_size;
+         std::uint32_t elements;
+         std::uint32_t first_location; // where its elements' locations start in element_locations_
+         std::uint32_t dirty_begin = 0; // the elements that flush_uniforms still has to send
+         std::uint32_t dirty_end = 0;
+         bool known = true;
+      };
+
+      // sorted by location, which needn't follow the order that the elements are stored in
+      struct shadow_location {
+         GLint location;
+         std::uint32_t uniform;
+         std::uint32_t element;
+      };
+
+      struct pending_build {
+         std::vector<shader_source> shaders;
+         std::vector<std::string> paths;
+      };
+
       GLuint index_;
 
+      // uniforms are reflected once a deferred build finishes, which may be in a const function
+      mutable std::vector<uniform_entry> uniforms_;
+      mutable uniform_statistics lookups_;
+      mutable std::optional<pending_build> pending_;
+      mutable std::vector<std::byte> shadow_;
+      mutable std::vector<shadowed_uniform> shadowed_;
+      mutable std::vector<shadow_location> shadow_locations_;
+      mutable std::vector<GLint> element_locations_;
+      mutable std::vector<std::uint32_t> dirty_;
+
       std::vector<shader_source>
       compile_shaders(const std::vector<std::pair<shader_source::type, std::string>>& paths);
+
+      void link(const std::vector<shader_source>& shaders);
+
+      void check_link() const;
+
+      void reflect_uniforms() const;
+
+      void shadow_uniform(std::string_view base, GLint location, GLenum type, GLint elements) const;
+
+      const shadow_location* find_shadow(GLint location) const noexcept;
+
+      void stage(GLint location, const void* data, std::size_t size, GLenum component) const;
    };
+
+   /**
+    * @brief Submits every program in `programs` as a deferred build, so that the driver can
+    *        compile all of them at once.
+    */
+   std::vector<shader_binary>
+   submit_programs(const std::vector<std::vector<std::pair<shader_source::type, std::string>>>&
+      programs);
 } // namespace doge
 
 #endif // DOGE_GL_SHADER_BINARY_HPP
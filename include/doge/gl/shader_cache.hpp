@@ -0,0 +1,95 @@
+//
+//  Copyright 2018 Christopher Di Bella
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+#ifndef DOGE_GL_SHADER_CACHE_HPP
+#define DOGE_GL_SHADER_CACHE_HPP
+
+#include <cstddef>
+#include <doge/gl/shader_source.hpp>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace doge {
+   /**
+    * @brief Macros to define before the first line of a shader, as `#define name value`.
+    */
+   using shader_defines = std::vector<std::pair<std::string, std::string>>;
+
+   /**
+    * @brief Expands the shader at `path` into a single string.
+    *
+    * `#include "file"` is replaced by the contents of `file`, which is relative to the including
+    * file's directory. Each file is only included once. `defines` are inserted after the
+    * `#version` directive, so that permutations of a shader can be generated from one file.
+    *
+    * `#line` directives are emitted so that the compiler's log still refers to the original
+    * lines. Files are numbered by the order in which they are first included, with `path` as 0.
+    *
+    * @throws std::runtime_error if `path` or an included file can't be opened.
+    */
+   std::string preprocess_shader(const std::string& path, const shader_defines& defines = {});
+
+   struct shader_cache_statistics {
+      std::size_t hits = 0;
+      std::size_t misses = 0;
+   };
+
+   /**
+    * @brief Compiles each distinct shader once, so that programs sharing a stage reattach the
+    *        same shader object.
+    *
+    * Shaders are keyed on their stage and their preprocessed code, not on their path, so a
+    * changed file is recompiled, and two permutations that expand to the same code share a
+    * shader.
+    */
+   class shader_cache {
+   public:
+      /**
+       * @brief Returns the compiled shader for `path` with `defines`, compiling it on a miss.
+       * @throws std::runtime_error if the shader can't be read or doesn't compile.
+       */
+      std::shared_ptr<const shader_source>
+      get(shader_source::type type, const std::string& path, const shader_defines& defines = {});
+
+      std::size_t size() const noexcept
+      {
+         return shaders_.size();
+      }
+
+      void clear() noexcept
+      {
+         shaders_.clear();
+      }
+
+      const shader_cache_statistics& statistics() const noexcept
+      {
+         return statistics_;
+      }
+   private:
+      struct entry {
+         shader_source::type type;
+         std::string code;
+         std::shared_ptr<const shader_source> shader;
+      };
+
+      std::unordered_multimap<std::size_t, entry> shaders_;
+      shader_cache_statistics statistics_;
+   };
+} // namespace doge
+
+#endif // DOGE_GL_SHADER_CACHE_HPP
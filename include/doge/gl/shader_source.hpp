@@ -21,8 +21,30 @@
 #include <gl/gl_core.hpp>
 #include <stdexcept>
 #include <string>
+#include <string_view>
+#include <utility>
 
 namespace doge {
+   /**
+    * @brief Selects the constructors that submit work to the driver without waiting for it to
+    *        finish, so that many shaders can be compiled in parallel.
+    */
+   struct deferred_build_t {
+      explicit deferred_build_t() = default;
+   };
+
+   inline constexpr auto deferred_build = deferred_build_t{};
+
+   /**
+    * @brief Selects the shader_source constructor that compiles GLSL held in memory, rather than
+    *        the contents of a file.
+    */
+   struct shader_code_t {
+      explicit shader_code_t() = default;
+   };
+
+   inline constexpr auto shader_code = shader_code_t{};
+
    class shader_source {
    public:
       enum type {
@@ -34,20 +56,49 @@ namespace doge {
 
       shader_source(const type t, const std::string& path);
 
-      shader_source(shader_source&&) = default;
-      shader_source(const shader_source&) = default;
+      /**
+       * @brief Submits the shader for compilation without checking the result; `check` must be
+       *        called before the shader's errors can be reported.
+       */
+      shader_source(const type t, const std::string& path, deferred_build_t);
+
+      /**
+       * @brief Compiles `code`. `name` identifies the shader in error messages.
+       */
+      shader_source(const type t, shader_code_t, std::string_view code, const std::string& name);
+
+      shader_source(shader_source&& other) noexcept
+         : index_{std::exchange(other.index_, 0)}
+      {}
 
-      shader_source& operator=(shader_source&&) = default;
-      shader_source& operator=(const shader_source&) = default;
+      shader_source(const shader_source&) = delete;
+
+      shader_source& operator=(shader_source&& other) noexcept
+      {
+         std::swap(index_, other.index_);
+         return *this;
+      }
+
+      shader_source& operator=(const shader_source&) = delete;
 
       ~shader_source() noexcept;
 
+      /**
+       * @brief Waits for compilation to finish.
+       * @throws std::runtime_error containing `path` and the compiler's log if compilation failed.
+       */
+      void check(const std::string& path) const;
+
       constexpr operator GLuint() const noexcept
       {
          return index_;
       }
    private:
       GLuint index_;
+
+      explicit shader_source(type t);
+
+      void compile(std::string_view code) noexcept;
    };
 } // namespace doge
 
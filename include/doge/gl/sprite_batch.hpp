@@ -0,0 +1,183 @@
+//
+//  Copyright 2018 Christopher Di Bella
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+#ifndef DOGE_GL_SPRITE_BATCH_HPP
+#define DOGE_GL_SPRITE_BATCH_HPP
+
+#include <array>
+#include <cstddef>
+#include <doge/gl/handle.hpp>
+#include <doge/gl/shader_binary.hpp>
+#include <doge/gl/shader_cache.hpp>
+#include <doge/gl/stream_buffer.hpp>
+#include <doge/gl/texture.hpp>
+#include <doge/gl/texture_atlas.hpp>
+#include <doge/gl/vertex_format.hpp>
+#include <gl/gl_core.hpp>
+#include <glm/mat4x4.hpp>
+#include <glm/vec2.hpp>
+#include <glm/vec4.hpp>
+#include <gsl/gsl>
+#include <string>
+
+namespace doge {
+   /**
+    * @brief An axis-aligned quad, in the units of the batch's projection.
+    */
+   struct sprite {
+      glm::vec2 position = {}; // the bottom-left corner
+      glm::vec2 size = {};
+      glm::vec2 uv_min = {0.0f, 0.0f};
+      glm::vec2 uv_max = {1.0f, 1.0f};
+      glm::vec4 colour = {1.0f, 1.0f, 1.0f, 1.0f};
+   };
+
+   struct sprite_batch_statistics {
+      std::size_t quads = 0;
+      std::size_t draws = 0;
+
+      // why each draw was issued before `end`
+      std::size_t texture_flushes = 0;
+      std::size_t program_flushes = 0;
+      std::size_t full_flushes = 0;
+   };
+
+   /**
+    * @brief Draws 2D quads in immediate mode, with one indexed draw per run of quads that share a
+    *        texture and a program.
+    *
+    * Quads are written straight into a stream_buffer, so nothing is copied or uploaded per quad.
+    * The batch is drawn when the texture or program changes, when the current region is full, and
+    * at `end`. The indices never change, so they are built once, as 16-bit indices, which limits
+    * a draw to 16384 quads.
+    *
+    *    batch.begin(width, height);
+    *    for (const auto& i : glyphs)
+    *       batch.draw(font, font.region(i.name), i.position, i.size);
+    *    batch.end();
+    *
+    * `begin` disables depth testing and blends with `gl::SRC_ALPHA, gl::ONE_MINUS_SRC_ALPHA`, and
+    * `end` puts back whichever of the two were enabled, and the blend function.
+    * Programs passed to `program` must read the same attributes as sprite.vert.glsl, and have a
+    * `mat4 projection` uniform.
+    */
+   class sprite_batch {
+   public:
+      static constexpr std::size_t max_capacity = 16384;
+
+      /**
+       * @param capacity The number of quads that fit in each region of the stream.
+       */
+      explicit sprite_batch(shader_cache& cache, std::size_t capacity = 4096,
+         const std::string& vertex_path = "sprite.vert.glsl",
+         const std::string& fragment_path = "sprite.frag.glsl");
+
+      // the current program may be the batch's own, so a copy would draw with the original's
+      sprite_batch(const sprite_batch&) = delete;
+      sprite_batch& operator=(const sprite_batch&) = delete;
+
+      /**
+       * @brief Starts a frame of quads, transformed by `projection`.
+       */
+      void begin(const glm::mat4& projection);
+
+      /**
+       * @brief Starts a frame of quads in pixels, with the origin at the bottom-left corner of a
+       *        `width` by `height` viewport.
+       */
+      void begin(GLsizei width, GLsizei height);
+
+      /**
+       * @brief Draws the following quads with `p`, which must outlive the batch's next draw.
+       */
+      void program(const shader_binary& p);
+
+      /**
+       * @brief Goes back to drawing with the batch's own program.
+       */
+      void reset_program();
+
+      void draw(const texture2d& texture, const sprite& s);
+
+      /**
+       * @brief Draws a quad of solid colour, e.g. for debug overlays. It shares the draw of any
+       *        other untextured quads around it.
+       */
+      void draw(const sprite& s);
+
+      /**
+       * @brief Draws the image `region` from `atlas`, so that images on one page share a draw.
+       */
+      void draw(const texture_atlas& atlas, const atlas_region& region, glm::vec2 position,
+         glm::vec2 size, const glm::vec4& colour = {1.0f, 1.0f, 1.0f, 1.0f});
+
+      /**
+       * @brief Draws an arbitrary quad, e.g. a rotated one. The corners go anticlockwise from
+       *        the one that maps to `uv_min`.
+       */
+      void draw(const texture2d& texture, const std::array<glm::vec2, 4>& corners,
+         glm::vec2 uv_min, glm::vec2 uv_max, const glm::vec4& colour);
+
+      /**
+       * @brief Draws the quads written since the last draw.
+       */
+      void flush();
+
+      /**
+       * @brief Draws whatever is left, and fences the stream so that its region isn't rewritten
+       *        while the GPU is reading it.
+       */
+      void end();
+
+      /**
+       * @brief The statistics since the last call to `begin`.
+       */
+      const sprite_batch_statistics& statistics() const noexcept
+      {
+         return statistics_;
+      }
+   private:
+      // position, texture coordinates and colour
+      using sprite_vertex = vertex_format<attr<glm::vec2>, attr<glm::vec2>,
+         attr<glm::vec4, unorm8>>;
+
+      static constexpr std::size_t quad_size = 4 * sprite_vertex::stride;
+
+      std::size_t capacity_;
+      stream_buffer stream_;
+      shader_binary default_program_;
+      unique_vertex_array vao_;
+      unique_buffer indices_;
+      texture2d white_;
+
+      gsl::span<std::byte> region_;
+      std::size_t first_ = 0; // the first quad in the region that hasn't been drawn
+      std::size_t count_ = 0; // the quads written since then
+      GLuint texture_ = 0;
+      const shader_binary* program_ = &default_program_;
+      glm::mat4 projection_ = glm::mat4{1.0f};
+      bool depth_test_ = false;
+      bool blend_ = false;
+      std::array<GLint, 4> blend_func_ = {}; // source and destination RGB, then alpha
+      bool drawing_ = false;
+      sprite_batch_statistics statistics_;
+
+      // makes room for a quad that uses `texture`, drawing the quads before it if they can't share
+      // a draw with it, and returns the index of the quad in the region
+      std::size_t reserve(GLuint texture);
+   };
+} // namespace doge
+
+#endif // DOGE_GL_SPRITE_BATCH_HPP
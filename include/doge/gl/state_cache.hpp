@@ -0,0 +1,149 @@
+//
+//  Copyright 2018 Christopher Di Bella
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+#ifndef DOGE_GL_STATE_CACHE_HPP
+#define DOGE_GL_STATE_CACHE_HPP
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <gl/gl_core.hpp>
+#include <limits>
+#include <utility>
+#include <vector>
+
+namespace doge {
+   struct state_cache_statistics {
+      std::size_t issued = 0;
+      std::size_t elided = 0; // calls that were dropped, since the state was already set
+   };
+
+   /**
+    * @brief Tracks the GL state that doge changes, so that redundant binds are dropped before
+    *        they reach the driver.
+    *
+    * State starts out unknown, so the first call to set each piece of state is always issued.
+    * Code that changes tracked state by calling the GL directly must call `invalidate` afterwards.
+    *
+    * The cache describes the context that is current on the calling thread, so there is one per
+    * thread (see `doge::gl_state`), and `context_changed` invalidates it whenever a context is made
+    * current, so that state recorded for one context is never trusted in another.
+    */
+   class state_cache {
+   public:
+      static constexpr std::size_t texture_units = 32;
+
+      void use_program(GLuint program) noexcept;
+
+      /**
+       * @brief Binds `vertex_array`. The element array buffer is part of the vertex array's state,
+       *        so changing vertex arrays also forgets which element array buffer is bound.
+       */
+      void bind_vertex_array(GLuint vertex_array) noexcept;
+
+      void bind_buffer(GLenum target, GLuint buffer) noexcept;
+
+      /**
+       * @brief Binds `buffer` to the indexed binding point `index` of `target`. Indexed bindings
+       *        aren't tracked, so the call is always issued, but it also binds `buffer` to the
+       *        generic `target` binding, which is recorded.
+       */
+      void bind_buffer_base(GLenum target, GLuint index, GLuint buffer) noexcept;
+      void bind_buffer_range(GLenum target, GLuint index, GLuint buffer, GLintptr offset,
+         GLsizeiptr size) noexcept;
+
+      void active_texture(GLenum unit) noexcept;
+
+      /**
+       * @brief Binds `texture` to `target` on `unit`, and leaves `unit` as the active texture unit
+       *        so that it may be followed by calls to `gl::TexParameter*`.
+       */
+      void bind_texture(GLenum unit, GLenum target, GLuint texture) noexcept;
+
+      void enable(GLenum capability) noexcept;
+      void disable(GLenum capability) noexcept;
+
+      void viewport(GLint x, GLint y, GLsizei width, GLsizei height) noexcept;
+
+      /**
+       * @brief Records that an object was deleted. The GL unbinds deleted objects, and may reuse
+       *        their names, so every cached binding to the object is reset.
+       */
+      void forget_buffer(GLuint buffer) noexcept;
+      void forget_texture(GLuint texture) noexcept;
+      void forget_vertex_array(GLuint vertex_array) noexcept;
+      void forget_program(GLuint program) noexcept;
+
+      /**
+       * @brief Marks all state as unknown.
+       */
+      void invalidate() noexcept;
+
+      const state_cache_statistics& statistics() const noexcept
+      {
+         return statistics_;
+      }
+
+      void reset_statistics() noexcept
+      {
+         statistics_ = {};
+      }
+   private:
+      // no object is ever given this name, so it can't match a real binding
+      static constexpr GLuint unknown = std::numeric_limits<GLuint>::max();
+
+      GLuint program_ = unknown;
+      GLuint vertex_array_ = unknown;
+      GLenum active_texture_ = 0;
+      std::vector<std::pair<GLenum, GLuint>> buffers_;
+      std::array<std::vector<std::pair<GLenum, GLuint>>, texture_units> textures_;
+      std::vector<std::pair<GLenum, GLuint>> capabilities_;
+      std::array<GLint, 4> viewport_ = {};
+      bool viewport_known_ = false;
+      state_cache_statistics statistics_;
+
+      bool elide(bool redundant) noexcept;
+   };
+
+   /**
+    * @brief The state cache for the context that is current on this thread.
+    */
+   state_cache& gl_state() noexcept;
+
+   /**
+    * @brief Records that a context was made current on this thread, so that nothing cached for
+    *        the context that was current before is trusted: `gl_state()` is invalidated, and the
+    *        names reserved by each `name_pool` are dropped.
+    *
+    * screen_data, headless_context and upload_context call this whenever they make a context
+    * current; code that makes a context current itself must call it too.
+    */
+   void context_changed() noexcept;
+
+   /**
+    * @brief The number of times `context_changed` has been called on this thread.
+    */
+   std::uint64_t context_generation() noexcept;
+
+   /**
+    * @brief Deletes objects, and removes them from the current state cache.
+    */
+   void delete_buffers(GLsizei n, const GLuint* buffers) noexcept;
+   void delete_textures(GLsizei n, const GLuint* textures) noexcept;
+   void delete_vertex_arrays(GLsizei n, const GLuint* vertex_arrays) noexcept;
+   void delete_program(GLuint program) noexcept;
+} // namespace doge
+
+#endif // DOGE_GL_STATE_CACHE_HPP
@@ -0,0 +1,136 @@
+//
+//  Copyright 2018 Christopher Di Bella
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+#ifndef DOGE_GL_STORAGE_BUFFER_HPP
+#define DOGE_GL_STORAGE_BUFFER_HPP
+
+#include <cstddef>
+#include <doge/gl/state_cache.hpp>
+#include <gl/gl_core.hpp>
+#include <gsl/gsl>
+#include <type_traits>
+#include <vector>
+
+namespace doge {
+   /**
+    * @brief A typed array in a shader storage buffer, i.e. a `buffer` block in GLSL.
+    *
+    * `T` must match the std430 layout of the block's array elements; glm's `vec3` is 12 bytes but
+    * is aligned to 16 in std430, so prefer `vec4` members.
+    *
+    * Uploads and reads go through `gl::COPY_WRITE_BUFFER` and `gl::COPY_READ_BUFFER`, so they
+    * don't disturb the storage buffer binding points.
+    */
+   template <typename T>
+   requires
+      std::is_trivially_copyable_v<T>
+   class storage_buffer {
+   public:
+      /**
+       * @brief Creates a buffer of `size` default-initialised elements.
+       */
+      explicit storage_buffer(const std::size_t size, const GLenum usage = gl::DYNAMIC_COPY)
+         : size_{size}
+      {
+         Expects(size > 0);
+         allocate(nullptr, usage);
+      }
+
+      storage_buffer(const gsl::span<const T> data, const GLenum usage = gl::DYNAMIC_COPY)
+         : size_{static_cast<std::size_t>(data.size())}
+      {
+         Expects(not data.empty());
+         allocate(data.data(), usage);
+      }
+
+      storage_buffer(const storage_buffer&) = delete;
+      storage_buffer& operator=(const storage_buffer&) = delete;
+
+      ~storage_buffer() noexcept
+      {
+         delete_buffers(1, &index_);
+      }
+
+      /**
+       * @brief Binds the whole buffer to the storage block binding point `binding`.
+       */
+      void bind(const GLuint binding) const noexcept
+      {
+         gl_state().bind_buffer_base(gl::SHADER_STORAGE_BUFFER, binding, index_);
+      }
+
+      /**
+       * @brief Binds elements `[first, first + count)` to the storage block binding point
+       *        `binding`. The byte offset must meet `gl::SHADER_STORAGE_BUFFER_OFFSET_ALIGNMENT`.
+       */
+      void bind(const GLuint binding, const std::size_t first, const std::size_t count) const
+         noexcept
+      {
+         Expects(first + count <= size_);
+         gl_state().bind_buffer_range(gl::SHADER_STORAGE_BUFFER, binding, index_,
+            first * sizeof(T), count * sizeof(T));
+      }
+
+      /**
+       * @brief Overwrites the elements starting at `first` with `data`.
+       */
+      void write(const gsl::span<const T> data, const std::size_t first = 0) noexcept
+      {
+         Expects(first + data.size() <= size_);
+         gl_state().bind_buffer(gl::COPY_WRITE_BUFFER, index_);
+         gl::BufferSubData(gl::COPY_WRITE_BUFFER, first * sizeof(T), data.size() * sizeof(T),
+            data.data());
+         gl_state().bind_buffer(gl::COPY_WRITE_BUFFER, 0);
+      }
+
+      /**
+       * @brief Copies the buffer's contents back to the CPU.
+       *
+       * This stalls until every command that writes to the buffer has finished; a compute shader
+       * that writes it must be followed by `memory_barrier(gl::BUFFER_UPDATE_BARRIER_BIT)`.
+       */
+      std::vector<T> read() const
+      {
+         auto result = std::vector<T>(size_);
+         gl_state().bind_buffer(gl::COPY_READ_BUFFER, index_);
+         gl::GetBufferSubData(gl::COPY_READ_BUFFER, 0, size_ * sizeof(T), result.data());
+         gl_state().bind_buffer(gl::COPY_READ_BUFFER, 0);
+         return result;
+      }
+
+      std::size_t size() const noexcept
+      {
+         return size_;
+      }
+
+      explicit operator GLuint() const noexcept
+      {
+         return index_;
+      }
+   private:
+      GLuint index_ = 0;
+      std::size_t size_;
+
+      void allocate(const T* const data, const GLenum usage) noexcept
+      {
+         gl::GenBuffers(1, &index_);
+         gl_state().bind_buffer(gl::COPY_WRITE_BUFFER, index_);
+         gl::BufferData(gl::COPY_WRITE_BUFFER, size_ * sizeof(T), data, usage);
+         gl_state().bind_buffer(gl::COPY_WRITE_BUFFER, 0);
+      }
+   };
+} // namespace doge
+
+#endif // DOGE_GL_STORAGE_BUFFER_HPP
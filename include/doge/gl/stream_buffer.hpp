@@ -0,0 +1,113 @@
+//
+//  Copyright 2018 Christopher Di Bella
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+#ifndef DOGE_GL_STREAM_BUFFER_HPP
+#define DOGE_GL_STREAM_BUFFER_HPP
+
+#include <array>
+#include <cstddef>
+#include <experimental/ranges/concepts>
+#include <gl/gl_core.hpp>
+#include <gsl/gsl>
+#include <type_traits>
+
+namespace doge {
+   namespace ranges = std::experimental::ranges;
+
+   /**
+    * @brief A persistently mapped buffer for data that changes every frame.
+    *
+    * The buffer is split into `region_count` regions. The CPU writes into one region while the
+    * GPU reads from the others, and each region is guarded by a fence so that it is never
+    * overwritten while a draw might still be reading from it.
+    *
+    * A frame looks like:
+    *
+    *    auto particles = stream.next_region_as<glm::vec4>(); // waits only if the GPU is behind
+    *    // ... write particles ...
+    *    // ... draw, reading from stream.offset() ...
+    *    stream.fence();
+    *
+    * Requires `GL_ARB_buffer_storage` (core in GL 4.4).
+    */
+   class stream_buffer {
+   public:
+      static constexpr std::size_t region_count = 3;
+
+      explicit stream_buffer(GLsizeiptr region_size);
+
+      stream_buffer(const stream_buffer&) = delete;
+      stream_buffer& operator=(const stream_buffer&) = delete;
+
+      ~stream_buffer() noexcept;
+
+      /**
+       * @brief Advances to the next region and returns it for writing.
+       *
+       * Blocks if the GPU has not yet finished with the region's previous contents.
+       */
+      gsl::span<std::byte> next_region();
+
+      template <typename T>
+      requires
+         std::is_trivially_copyable_v<T>
+      gsl::span<T> next_region_as()
+      {
+         const auto bytes = next_region();
+         return {reinterpret_cast<T*>(bytes.data()),
+            gsl::narrow_cast<std::ptrdiff_t>(bytes.size() / sizeof(T))};
+      }
+
+      /**
+       * @brief Marks the end of the commands that read from the current region.
+       */
+      void fence() noexcept;
+
+      /**
+       * @brief The offset, in bytes, of the current region from the start of the buffer.
+       */
+      GLintptr offset() const noexcept
+      {
+         return gsl::narrow_cast<GLintptr>(region_) * region_size_;
+      }
+
+      GLsizeiptr region_size() const noexcept
+      {
+         return region_size_;
+      }
+
+      /**
+       * @brief The number of times `next_region` had to wait for the GPU.
+       */
+      std::size_t stalls() const noexcept
+      {
+         return stalls_;
+      }
+
+      explicit operator GLuint() const noexcept
+      {
+         return index_;
+      }
+   private:
+      GLuint index_ = 0;
+      GLsizeiptr region_size_;
+      std::byte* mapping_ = nullptr;
+      std::array<GLsync, region_count> fences_ = {};
+      std::size_t region_ = region_count - 1;
+      std::size_t stalls_ = 0;
+   };
+} // namespace doge
+
+#endif // DOGE_GL_STREAM_BUFFER_HPP
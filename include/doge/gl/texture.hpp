@@ -16,16 +16,24 @@
 #ifndef DOGE_GL_TEXTURE_HPP
 #define DOGE_GL_TEXTURE_HPP
 
+#include <algorithm>
 #include <array>
-#include <doge/utility/reference_count.hpp>
+#include <cstddef>
+#include <doge/gl/handle.hpp>
+#include <doge/gl/state_cache.hpp>
+#include <doge/utility/file.hpp>
 #include <doge/utility/type_traits.hpp>
 #include <experimental/ranges/algorithm>
 #include <experimental/ranges/concepts>
+#include <experimental/ranges/functional>
 #include <experimental/ranges/iterator>
 #include <gl/gl_core.hpp>
 #include <gsl/gsl>
 #include <memory>
 #include <stb_image.h>
+#include <stdexcept>
+#include <string>
+#include <string_view>
 #include <tuple>
 #include <utility>
 
@@ -35,12 +43,58 @@ namespace doge {
    enum class texture_t {
       texture_1d = gl::TEXTURE_1D,
       texture_2d = gl::TEXTURE_2D,
-      texture_3d = gl::TEXTURE_3D
+      texture_3d = gl::TEXTURE_3D,
+      texture_1d_array = gl::TEXTURE_1D_ARRAY,
+      texture_2d_array = gl::TEXTURE_2D_ARRAY
    };
 
    template <texture_t Kind>
    class basic_texture;
 
+   /**
+    * @brief Pixels decoded from an image file.
+    */
+   struct image {
+      int width = 0;
+      int height = 0;
+      int channels = 0;
+      std::unique_ptr<unsigned char, void(*)(void*)> data = {nullptr, stbi_image_free};
+
+      std::size_t size() const noexcept
+      {
+         return static_cast<std::size_t>(width) * height * channels;
+      }
+   };
+
+   /**
+    * @brief Decodes the image at `path`, with the rows flipped so that the first row is the bottom
+    *        of the image, as the GL expects.
+    *
+    * This doesn't touch the GL or any global decoder state, so it may be called from any thread.
+    */
+   inline image decode_image(const std::string_view path)
+   {
+      // decoded straight from the mapped file, rather than through stdio
+      const auto file = mapped_file{std::string{path}};
+      const auto bytes = file.bytes();
+
+      auto result = image{};
+      result.data.reset(stbi_load_from_memory(reinterpret_cast<const stbi_uc*>(bytes.data()),
+         gsl::narrow_cast<int>(bytes.size()), &result.width, &result.height, &result.channels, 0));
+
+      using namespace std::string_literals;
+      if (not result.data)
+         throw std::runtime_error{"Unable to open texture "s + std::string{path}};
+
+      const auto row = static_cast<std::size_t>(result.width) * result.channels;
+      for (auto top = 0, bottom = result.height - 1; top < bottom; ++top, --bottom) {
+         const auto first = result.data.get() + top * row;
+         std::swap_ranges(first, first + row, result.data.get() + bottom * row);
+      }
+
+      return result;
+   }
+
    template <texture_t Kind>
    void texture_parameter(const basic_texture<Kind>&, GLenum pname, GLfloat param) noexcept
    {
@@ -117,6 +171,8 @@ namespace doge {
    using texture1d = basic_texture<texture_t::texture_1d>;
    using texture2d = basic_texture<texture_t::texture_2d>;
    using texture3d = basic_texture<texture_t::texture_3d>;
+   using texture1d_array = basic_texture<texture_t::texture_1d_array>;
+   using texture2d_array = basic_texture<texture_t::texture_2d_array>;
 
    enum class texture_wrap_t {
       clamp_to_edge = gl::CLAMP_TO_EDGE,
@@ -173,6 +229,20 @@ namespace doge {
     */
    void wrap(const texture3d& tex, texture_wrap_t, texture_wrap_t, texture_wrap_t) noexcept;
 
+   /**
+    * @brief Sets the wrap parameter for an array of single-dimensional textures. The layer is
+    *        selected by an integer, so it isn't wrapped.
+    * @seealso doge::wrap(const texture1d&, texture_wrap_t) noexcept;
+    */
+   void wrap(const texture1d_array& tex, texture_wrap_t) noexcept;
+
+   /**
+    * @brief Sets the wrap parameters for an array of two-dimensional textures. The layer is
+    *        selected by an integer, so it isn't wrapped.
+    * @seealso doge::wrap(const texture2d&, texture_wrap_t, texture_wrap_t) noexcept;
+    */
+   void wrap(const texture2d_array& tex, texture_wrap_t, texture_wrap_t) noexcept;
+
    enum class minmag_t {
       nearest = gl::NEAREST,
       linear = gl::LINEAR,
@@ -210,43 +280,60 @@ namespace doge {
 
    template <texture_t Kind>
    class basic_texture {
-      using wrapping_t =
-         std::conditional_t<Kind == texture_t::texture_1d, std::tuple<texture_wrap_t>,
-         std::conditional_t<Kind == texture_t::texture_2d, std::tuple<texture_wrap_t, texture_wrap_t>,
-            std::tuple<texture_wrap_t, texture_wrap_t, texture_wrap_t>>>;
    public:
       static constexpr auto texture_type = Kind;
 
+      using wrapping_t =
+         std::conditional_t<Kind == texture_t::texture_1d || Kind == texture_t::texture_1d_array,
+            std::tuple<texture_wrap_t>,
+         std::conditional_t<Kind == texture_t::texture_2d || Kind == texture_t::texture_2d_array,
+            std::tuple<texture_wrap_t, texture_wrap_t>,
+            std::tuple<texture_wrap_t, texture_wrap_t, texture_wrap_t>>>;
+
       basic_texture(const std::string_view path, const wrapping_t& wrapping, minmag_t min_filter,
          minmag_t mag_filter, int n = 0)
-         : index_{
-               [this]{
-                 ranges::Integral object_ = GLuint{};
-                 gl::GenTextures(size_, &object_);
-                 return object_;
-              }(),
-              [this](GLuint* i) noexcept { gl::DeleteTextures(size_, i); }
-           }
-      {
-         ranges::SignedIntegral width = 0;
-         ranges::SignedIntegral height = 0;
-         ranges::SignedIntegral channels = 0;
-         stbi_set_flip_vertically_on_load(true);
-         auto data = std::unique_ptr<unsigned char, void(*)(void*)>{
-            stbi_load(path.data(), &width, &height, &channels, 0), stbi_image_free};
+         : basic_texture{decode_image(path), wrapping, min_filter, mag_filter, n}
+      {}
 
-         using namespace std::string_literals;
-         if (not data)
-            throw std::runtime_error{"Unable to open texture "s + path.data()};
+      basic_texture(const image& pixels, const wrapping_t& wrapping, minmag_t min_filter,
+         minmag_t mag_filter, int n = 0)
+         : basic_texture{pixels.width, pixels.height, pixels.channels, pixels.data.get(), wrapping,
+              min_filter, mag_filter, n}
+      {}
 
-         GLenum format = channels == 1 ? gl::RED
-                       : channels == 3 ? gl::RGB : gl::RGBA;
+      /**
+       * @brief Creates a texture from `channels`-component, 8-bit pixels.
+       *
+       * If a buffer is bound to `gl::PIXEL_UNPACK_BUFFER`, then `pixels` is an offset into that
+       * buffer, rather than a pointer to client memory.
+       */
+      basic_texture(const GLsizei width, const GLsizei height, const int channels,
+         const void* const pixels, const wrapping_t& wrapping, minmag_t min_filter,
+         minmag_t mag_filter, int n = 0)
+         : basic_texture{[=]{
+               GLenum format = channels == 1 ? gl::RED
+                             : channels == 3 ? gl::RGB : gl::RGBA;
 
+               gl::TexImage2D(static_cast<GLenum>(Kind), 0, format, width, height, 0, format,
+                  gl::UNSIGNED_BYTE, pixels);
+               gl::GenerateMipmap(static_cast<GLenum>(Kind));
+            }, wrapping, min_filter, mag_filter, n}
+      {}
+
+      /**
+       * @brief Creates a texture whose storage and contents are specified by `specify`.
+       *
+       * `specify` is invoked while the new texture is bound to `gl::TEXTURE0 + n`, and before the
+       * wrapping and filters are applied. This is how image formats that basic_texture doesn't
+       * decode itself are uploaded (see doge/gl/compressed_texture.hpp).
+       */
+      template <ranges::Invocable F>
+      basic_texture(const F& specify, const wrapping_t& wrapping, minmag_t min_filter,
+         minmag_t mag_filter, int n = 0)
+         : index_{unique_texture::generate()}
+      {
          bind(gl::TEXTURE0 + n);
-         
-         gl::TexImage2D(static_cast<GLenum>(Kind), 0, format, width, height, 0, format,
-            gl::UNSIGNED_BYTE, data.get());
-         gl::GenerateMipmap(static_cast<GLenum>(Kind));
+         specify();
 
          std::apply([this](auto&&... args) noexcept {
             doge::wrap(*this, std::forward<decltype(args)>(args)...); }, wrapping);
@@ -257,9 +344,9 @@ namespace doge {
 
       void bind(const GLenum active_texture) const noexcept
       {
-         Expects(gl::TEXTURE0 <= active_texture && active_texture <= gl::TEXTURE16);
-         gl::ActiveTexture(active_texture);
-         gl::BindTexture(static_cast<GLenum>(Kind), index_);
+         Expects(gl::TEXTURE0 <= active_texture);
+         Expects(active_texture < gl::TEXTURE0 + state_cache::texture_units);
+         gl_state().bind_texture(active_texture, static_cast<GLenum>(Kind), index_);
       }
 
       template <ranges::Invocable F>
@@ -268,10 +355,13 @@ namespace doge {
          bind(active_texture);
          ranges::invoke(f);
       }
+
+      explicit operator GLuint() const noexcept
+      {
+         return index_;
+      }
    private:
-      static constexpr GLuint size_ = 1;
-      //GLuint object_;
-      reference_count<GLuint> index_;
+      unique_texture index_;
    };
 } // namespace doge
 
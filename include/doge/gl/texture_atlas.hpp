@@ -0,0 +1,174 @@
+//
+//  Copyright 2018 Christopher Di Bella
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+#ifndef DOGE_GL_TEXTURE_ATLAS_HPP
+#define DOGE_GL_TEXTURE_ATLAS_HPP
+
+#include <cstddef>
+#include <doge/gl/texture.hpp>
+#include <functional>
+#include <gl/gl_core.hpp>
+#include <glm/vec2.hpp>
+#include <gsl/gsl>
+#include <map>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace doge {
+   /**
+    * @brief Packs rectangles into a fixed-size page, bottom-left first, by tracking the top edge
+    *        (the skyline) of everything placed so far.
+    */
+   class skyline_packer {
+   public:
+      skyline_packer(int width, int height);
+
+      /**
+       * @brief Reserves a `width` by `height` rectangle, and returns its bottom-left corner, or
+       *        `std::nullopt` if the page has no room for it.
+       */
+      std::optional<glm::ivec2> insert(int width, int height);
+
+      /**
+       * @brief The fraction of the page that has been reserved.
+       */
+      double occupancy() const noexcept;
+   private:
+      struct segment {
+         int x;
+         int y;
+         int width;
+      };
+
+      int width_;
+      int height_;
+      long long used_ = 0;
+      std::vector<segment> skyline_;
+   };
+
+   /**
+    * @brief Where an image lives in an atlas.
+    */
+   struct atlas_region {
+      std::size_t page = 0;
+
+      // texture coordinates of the image's bottom-left and top-right corners, padding excluded
+      glm::vec2 min = {};
+      glm::vec2 max = {};
+   };
+
+   struct atlas_options {
+      int page_size = 2048;
+
+      /**
+       * @brief Texels around each image that repeat its edge. Mip level `n` reads `2^n` texels
+       *        past an image's edge, so the mip chain stops at `log2(padding)`.
+       */
+      int padding = 4;
+   };
+
+   /**
+    * @brief The pages and regions of an atlas, in client memory.
+    */
+   struct packed_atlas {
+      int page_size = 0;
+      int max_level = 0;
+
+      // RGBA8 pixels, bottom row first
+      std::vector<std::vector<unsigned char>> pages;
+      std::map<std::string, atlas_region, std::less<>> regions;
+
+      /**
+       * @brief Writes the atlas to `path` as one file: a header, the region index, and then the
+       *        raw pages, so that loading it needs neither decoding nor packing.
+       */
+      void save(const std::string& path) const;
+
+      /**
+       * @throws std::runtime_error if `path` isn't an atlas written by `save`.
+       */
+      static packed_atlas load(const std::string& path);
+   };
+
+   /**
+    * @brief Packs many small images into a few large pages.
+    */
+   class atlas_builder {
+   public:
+      explicit atlas_builder(const atlas_options& options = {});
+
+      /**
+       * @brief Adds `pixels` to the atlas, to be looked up as `name`. Images with one or two
+       *        channels are treated as grey and grey-alpha.
+       */
+      void add(std::string name, image pixels);
+
+      /**
+       * @brief Adds every PNG in `directory`, named after its file name without the extension.
+       */
+      void add_directory(const std::string& directory);
+
+      /**
+       * @brief Packs the images, tallest first, opening pages as they fill up.
+       * @throws std::runtime_error if an image is larger than a page.
+       */
+      packed_atlas build() const;
+   private:
+      atlas_options options_;
+      std::vector<std::pair<std::string, image>> images_;
+   };
+
+   /**
+    * @brief An atlas whose pages have been uploaded as textures.
+    */
+   class texture_atlas {
+   public:
+      explicit texture_atlas(const packed_atlas& atlas);
+
+      /**
+       * @brief Builds an atlas from every PNG in `directory` at start-up.
+       */
+      static texture_atlas from_directory(const std::string& directory,
+         const atlas_options& options = {});
+
+      /**
+       * @brief Loads an atlas written by packed_atlas::save, e.g. by the `atlas_pack` tool.
+       */
+      static texture_atlas from_file(const std::string& path);
+
+      /**
+       * @throws std::out_of_range if the atlas has no image called `name`.
+       */
+      const atlas_region& region(std::string_view name) const;
+
+      const texture2d& page(const std::size_t i) const noexcept
+      {
+         Expects(i < pages_.size());
+         return pages_[i];
+      }
+
+      std::size_t page_count() const noexcept
+      {
+         return pages_.size();
+      }
+   private:
+      std::vector<texture2d> pages_;
+      std::map<std::string, atlas_region, std::less<>> regions_;
+   };
+} // namespace doge
+
+#endif // DOGE_GL_TEXTURE_ATLAS_HPP
@@ -0,0 +1,158 @@
+//
+//  Copyright 2018 Christopher Di Bella
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+#ifndef DOGE_GL_TEXTURE_LOADER_HPP
+#define DOGE_GL_TEXTURE_LOADER_HPP
+
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <doge/gl/texture.hpp>
+#include <gl/gl_core.hpp>
+#include <gsl/gsl>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <thread>
+#include <tuple>
+#include <vector>
+
+namespace doge {
+   namespace detail {
+      struct pending_texture {
+         std::string path;
+         std::tuple<texture_wrap_t, texture_wrap_t> wrapping;
+         minmag_t min_filter;
+         minmag_t mag_filter;
+
+         // written by a worker thread
+         image pixels = {};
+         std::string error = {};
+
+         // written by the GL thread
+         std::optional<texture2d> texture = {};
+         bool failed = false;
+      };
+   } // namespace detail
+
+   /**
+    * @brief A texture that is being loaded by a texture_loader.
+    */
+   class texture_handle {
+   public:
+      /**
+       * @brief Returns true if the texture has been uploaded and can be bound.
+       */
+      bool resident() const noexcept
+      {
+         return state_->texture.has_value();
+      }
+
+      /**
+       * @brief Returns true if the image could not be decoded. The reason is given by `error`.
+       */
+      bool failed() const noexcept
+      {
+         return state_->failed;
+      }
+
+      const std::string& error() const noexcept
+      {
+         return state_->error;
+      }
+
+      const texture2d& get() const noexcept
+      {
+         Expects(resident());
+         return *state_->texture;
+      }
+
+      /**
+       * @brief Binds the texture if it's resident, and `fallback` otherwise.
+       */
+      void bind(const GLenum active_texture, const texture2d& fallback) const noexcept
+      {
+         if (resident())
+            get().bind(active_texture);
+         else
+            fallback.bind(active_texture);
+      }
+   private:
+      friend class texture_loader;
+
+      explicit texture_handle(std::shared_ptr<detail::pending_texture> state) noexcept
+         : state_{std::move(state)}
+      {}
+
+      std::shared_ptr<detail::pending_texture> state_;
+   };
+
+   /**
+    * @brief Loads textures without stalling the frame loop.
+    *
+    * Images are decoded by a pool of worker threads. Decoded images are uploaded through a pixel
+    * unpack buffer by `update`, which should be called once per frame on the GL thread, and which
+    * uploads no more than `upload_budget` bytes per call.
+    */
+   class texture_loader {
+   public:
+      /**
+       * @brief Uses one worker per hardware thread, less one for the GL thread, and a 16 MiB
+       *        upload budget.
+       */
+      texture_loader();
+
+      texture_loader(std::size_t threads, GLsizeiptr upload_budget);
+
+      texture_loader(const texture_loader&) = delete;
+      texture_loader& operator=(const texture_loader&) = delete;
+
+      ~texture_loader();
+
+      texture_handle load(std::string path, const std::tuple<texture_wrap_t, texture_wrap_t>& wrapping,
+         minmag_t min_filter, minmag_t mag_filter);
+
+      /**
+       * @brief Uploads decoded images until the upload budget is spent. A single image that is
+       *        larger than the budget is uploaded on its own.
+       */
+      void update();
+
+      /**
+       * @brief The number of textures that are not yet resident.
+       */
+      std::size_t pending() const noexcept
+      {
+         return pending_;
+      }
+   private:
+      std::mutex mutex_;
+      std::condition_variable work_available_;
+      std::deque<std::shared_ptr<detail::pending_texture>> decode_queue_;
+      std::deque<std::shared_ptr<detail::pending_texture>> upload_queue_;
+      bool stopping_ = false;
+
+      GLsizeiptr upload_budget_;
+      GLuint unpack_buffer_ = 0;
+      std::size_t pending_ = 0;
+      std::vector<std::thread> workers_;
+
+      void work();
+      void upload(detail::pending_texture& texture) noexcept;
+   };
+} // namespace doge
+
+#endif // DOGE_GL_TEXTURE_LOADER_HPP
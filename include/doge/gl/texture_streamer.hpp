@@ -0,0 +1,154 @@
+//
+//  Copyright 2018 Christopher Di Bella
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+#ifndef DOGE_GL_TEXTURE_STREAMER_HPP
+#define DOGE_GL_TEXTURE_STREAMER_HPP
+
+#include <cstddef>
+#include <doge/gl/texture.hpp>
+#include <doge/utility/file.hpp>
+#include <gl/gl_core.hpp>
+#include <glm/vec3.hpp>
+#include <gsl/gsl>
+#include <optional>
+#include <string>
+#include <tuple>
+#include <vector>
+
+namespace doge {
+   class camera;
+
+   struct texture_streamer_statistics {
+      std::size_t resident_bytes = 0;
+      std::size_t uploaded_bytes = 0; // since the streamer was created
+      std::size_t reallocations = 0;  // textures whose storage was grown or shrunk
+      std::size_t evictions = 0;      // levels dropped to stay within the budget
+   };
+
+   /**
+    * @brief Streams the mipmap levels of KTX textures in and out of video memory, so that only
+    *        the levels that objects are close enough to need are resident.
+    *
+    * Each texture starts with only its smallest levels resident, so adding one is cheap. Finer
+    * levels are uploaded coarsest first, a few per `update`, straight from the mapped file. While
+    * levels are still pending, `gl::TEXTURE_BASE_LEVEL` and `gl::TEXTURE_MIN_LOD` stop the
+    * sampler from reading them.
+    *
+    * A texture's storage only spans the levels it wants, so dropping fine levels to stay within
+    * the budget really frees their memory. The storage is re-created and the resident levels are
+    * copied on the GPU whenever that span changes, so hold on to the id, not the `texture2d`.
+    *
+    * Only uncompressed or block-compressed 2D KTX (version 1) files are supported.
+    */
+   class texture_streamer {
+   public:
+      /**
+       * @param budget The number of bytes that streamed textures may occupy in video memory. The
+       *        smallest levels of each texture are always resident, even if that exceeds it.
+       * @param upload_limit Roughly the number of bytes that `update` uploads, so that streaming
+       *        doesn't hitch the frame. Levels aren't split, so the last one may overshoot it.
+       * @param tail_size Levels no larger than this are resident as soon as a texture is added.
+       */
+      explicit texture_streamer(std::size_t budget, std::size_t upload_limit = 4 << 20,
+         GLsizei tail_size = 64) noexcept;
+
+      /**
+       * @brief Adds the texture at `path`, which is applied to an object bounded by the sphere at
+       *        `centre` with `radius`.
+       *
+       * @returns The id of the texture.
+       * @throws std::runtime_error if `path` isn't a supported KTX file.
+       */
+      std::size_t add(const std::string& path, const glm::vec3& centre, float radius,
+         const std::tuple<texture_wrap_t, texture_wrap_t>& wrapping, minmag_t min_filter,
+         minmag_t mag_filter);
+
+      /**
+       * @brief Moves the bounding sphere of texture `id`, e.g. when its object moves.
+       */
+      void place(std::size_t id, const glm::vec3& centre, float radius) noexcept;
+
+      /**
+       * @brief Chooses the levels each texture needs when viewed from `viewer`, evicts levels
+       *        until the choice fits in the budget, and then uploads pending levels.
+       *
+       * @param viewport_height The height of the viewport, in pixels.
+       * @param field_of_view The vertical field of view, in radians.
+       */
+      void update(const glm::vec3& viewer, GLsizei viewport_height, float field_of_view);
+
+      /**
+       * @brief As above, using `viewer`'s position and field of view.
+       */
+      void update(const camera& viewer, GLsizei viewport_height);
+
+      const texture2d& texture(const std::size_t id) const noexcept
+      {
+         Expects(id < textures_.size());
+         return *textures_[id].texture;
+      }
+
+      /**
+       * @brief The finest level of texture `id` that can currently be sampled.
+       */
+      GLsizei resident_level(const std::size_t id) const noexcept
+      {
+         Expects(id < textures_.size());
+         return textures_[id].resident_base;
+      }
+
+      const texture_streamer_statistics& statistics() const noexcept
+      {
+         return statistics_;
+      }
+   private:
+      struct streamed_texture {
+         mapped_file file;
+         std::vector<gsl::span<const std::byte>> levels;
+         GLenum internal_format = 0;
+         GLenum format = 0;
+         GLenum type = 0;
+         GLsizei width = 0;
+         GLsizei height = 0;
+
+         std::tuple<texture_wrap_t, texture_wrap_t> wrapping;
+         minmag_t min_filter;
+         minmag_t mag_filter;
+
+         glm::vec3 centre;
+         float radius;
+
+         std::optional<texture2d> texture = {};
+         GLsizei storage_base = 0;   // the finest level that has storage
+         GLsizei resident_base = 0;  // the finest level that has been uploaded
+         GLsizei tail_base = 0;      // the finest level that is never evicted
+         GLsizei wanted = 0;
+         float priority = 0.0f;
+      };
+
+      std::size_t budget_;
+      std::size_t upload_limit_;
+      GLsizei tail_size_;
+      std::vector<streamed_texture> textures_;
+      texture_streamer_statistics statistics_;
+
+      static std::size_t storage_size(const streamed_texture& t, GLsizei base) noexcept;
+      void reallocate(streamed_texture& t, GLsizei base);
+      void upload(streamed_texture& t, GLsizei level);
+      static void clamp(const streamed_texture& t) noexcept;
+   };
+} // namespace doge
+
+#endif // DOGE_GL_TEXTURE_STREAMER_HPP
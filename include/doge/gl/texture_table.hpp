@@ -0,0 +1,115 @@
+//
+//  Copyright 2018 Christopher Di Bella
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+#ifndef DOGE_GL_TEXTURE_TABLE_HPP
+#define DOGE_GL_TEXTURE_TABLE_HPP
+
+#include <cstddef>
+#include <doge/gl/shader_cache.hpp>
+#include <doge/gl/storage_buffer.hpp>
+#include <doge/gl/texture.hpp>
+#include <gl/gl_core.hpp>
+#include <gsl/gsl>
+#include <optional>
+#include <string>
+#include <tuple>
+#include <vector>
+
+namespace doge {
+   /**
+    * @brief A table of textures that shaders index by material, so that objects with different
+    *        textures can share one draw (or one multi-draw) without rebinding texture units.
+    *
+    * When `GL_ARB_bindless_texture` is available, each image becomes its own texture2d whose
+    * 64-bit handle is made resident and stored in the table. Otherwise, the images become the
+    * layers of one texture2d_array, and the table stores each image's layer; the images must all
+    * have the same size in that case.
+    *
+    * The table is a `buffer` block with one 64-bit entry per texture. Shaders are compiled with
+    * `defines()`, and declare the block as
+    *
+    *    #ifdef DOGE_BINDLESS
+    *    #extension GL_ARB_bindless_texture : require
+    *    layout(std430, binding = 0) readonly buffer texture_table { sampler2D textures[]; };
+    *    #define DOGE_TEXTURE(i, uv) texture(textures[i], uv)
+    *    #else
+    *    layout(std430, binding = 0) readonly buffer texture_table { uvec2 layers[]; };
+    *    uniform sampler2DArray texture_array;
+    *    #define DOGE_TEXTURE(i, uv) texture(texture_array, vec3(uv, layers[i].x))
+    *    #endif
+    *
+    * Handles are only valid in the context that made them resident.
+    */
+   class texture_table {
+   public:
+      /**
+       * @brief Decodes and uploads each image in `paths`, in order, so that entry `i` refers to
+       *        `paths[i]`.
+       *
+       * @param force_array Builds the array table even when bindless textures are supported.
+       */
+      texture_table(gsl::span<const std::string> paths,
+         const std::tuple<texture_wrap_t, texture_wrap_t>& wrapping, minmag_t min_filter,
+         minmag_t mag_filter, bool force_array = false);
+
+      texture_table(const texture_table&) = delete;
+      texture_table& operator=(const texture_table&) = delete;
+
+      ~texture_table() noexcept;
+
+      /**
+       * @brief Returns true if the driver supports `GL_ARB_bindless_texture`.
+       */
+      static bool bindless_supported() noexcept;
+
+      bool bindless() const noexcept
+      {
+         return not array_.has_value();
+      }
+
+      std::size_t size() const noexcept
+      {
+         return entries_.size();
+      }
+
+      /**
+       * @brief The resident handle of texture `i` for a bindless table, or its layer otherwise.
+       */
+      GLuint64 entry(const std::size_t i) const noexcept
+      {
+         Expects(i < entries_.size());
+         return entries_[i];
+      }
+
+      /**
+       * @brief Binds the table to the storage block binding point `binding`. An array table also
+       *        binds its texture to `unit`; a bindless table needs no texture units.
+       */
+      void bind(GLuint binding, GLenum unit = gl::TEXTURE0) const noexcept;
+
+      /**
+       * @brief The defines that select the table's path in the shader. Pass these to
+       *        shader_cache::get, so that each path is cached as its own variant.
+       */
+      shader_defines defines() const;
+   private:
+      std::vector<texture2d> textures_;
+      std::optional<texture2d_array> array_;
+      std::vector<GLuint64> entries_;
+      std::optional<storage_buffer<GLuint64>> table_;
+   };
+} // namespace doge
+
+#endif // DOGE_GL_TEXTURE_TABLE_HPP
@@ -25,17 +25,9 @@
 namespace doge {
    namespace ranges = std::experimental::ranges;
 
-   struct uniform_not_found : public std::runtime_error {
-      uniform_not_found(const std::string_view id)
-         : std::runtime_error{id.data()}
-      {}
-   };
-
-   GLint uniform(const shader_binary& program, const std::string_view id)
+   inline GLint uniform(const shader_binary& program, const std::string_view id)
    {
-      if (ranges::SignedIntegral i = gl::GetUniformLocation(program.index(), id.data()); i >= 0)
-         return i;
-      throw uniform_not_found{id};
+      return program.uniform_location(id);
    }
 
    namespace detail {
@@ -48,19 +40,28 @@ namespace doge {
          ranges::invoke(f, location, std::forward<Args>(args)...);
       }
 
-      template <typename F, typename... Args>
+      /**
+       * @brief Sets the uniform `id` with `f`, unless the `count` values at `value` match the
+       *        program's shadow copy of it. A null `value` can't be compared, and is always set.
+       */
+      template <typename T, typename F, typename... Args>
       requires
          ranges::Invocable<F, GLint, Args...>
-      void uniform_impl(const shader_binary& program, const std::string_view id, const F& f,
-         Args&&... args)
+      void uniform_impl(const shader_binary& program, const std::string_view id, const T* value,
+         const std::size_t count, const F& f, Args&&... args)
       {
-         uniform_impl(uniform(program, id), f, std::forward<Args>(args)...);
+         const auto location = uniform(program, id);
+         if (not value)
+            program.forget_uniform(location);
+         else if (not program.update_shadow(location, value, count * sizeof(T)))
+            return;
+         uniform_impl(location, f, std::forward<Args>(args)...);
       }
    } // namespace detail
 
    void uniform(const shader_binary& program, const std::string_view id, const GLfloat v)
    {
-      doge::detail::uniform_impl(program, id, gl::Uniform1f, v);
+      doge::detail::uniform_impl(program, id, std::addressof(v), 1, gl::Uniform1f, v);
    }
 
    template <ranges::RandomAccessRange Rng>
@@ -70,12 +71,13 @@ namespace doge {
    }
    void uniform(const shader_binary& program, const std::string_view id, const Rng& rng)
    {
-      doge::detail::uniform_impl(program, id, gl::Uniform1fv, 1, std::addressof(rng[0]));
+      doge::detail::uniform_impl(program, id, std::addressof(rng[0]), ranges::size(rng),
+         gl::Uniform1fv, gsl::narrow_cast<GLsizei>(ranges::size(rng)), std::addressof(rng[0]));
    }
 
    void uniform(const shader_binary& program, const std::string_view id, const glm::vec2 v)
    {
-      doge::detail::uniform_impl(program, id, gl::Uniform2f, v.x, v.y);
+      doge::detail::uniform_impl(program, id, std::addressof(v), 1, gl::Uniform2f, v.x, v.y);
    }
 
    template <ranges::RandomAccessRange Rng>
@@ -85,13 +87,13 @@ namespace doge {
    }
    void uniform(const shader_binary& program, const std::string_view id, const Rng& rng)
    {
-      doge::detail::uniform_impl(program, id, gl::Uniform2fv,
-         gsl::narrow_cast<GLsizei>(ranges::size(rng)), std::addressof(rng[0][0]));
+      doge::detail::uniform_impl(program, id, std::addressof(rng[0]), ranges::size(rng),
+         gl::Uniform2fv, gsl::narrow_cast<GLsizei>(ranges::size(rng)), std::addressof(rng[0][0]));
    }
 
    void uniform(const shader_binary& program, const std::string_view id, const glm::vec3 v)
    {
-      doge::detail::uniform_impl(program, id, gl::Uniform3f, v.x, v.y, v.z);
+      doge::detail::uniform_impl(program, id, std::addressof(v), 1, gl::Uniform3f, v.x, v.y, v.z);
    }
 
    template <ranges::RandomAccessRange Rng>
@@ -101,13 +103,14 @@ namespace doge {
    }
    void uniform(const shader_binary& program, const std::string_view id, const Rng& rng)
    {
-      doge::detail::uniform_impl(program, id, gl::Uniform3fv,
-         gsl::narrow_cast<GLsizei>(ranges::size(rng)), std::addressof(rng[0][0]));
+      doge::detail::uniform_impl(program, id, std::addressof(rng[0]), ranges::size(rng),
+         gl::Uniform3fv, gsl::narrow_cast<GLsizei>(ranges::size(rng)), std::addressof(rng[0][0]));
    }
 
    void uniform(const shader_binary& program, const std::string_view id, const glm::vec4& v)
    {
-      doge::detail::uniform_impl(program, id, gl::Uniform4f, v.x, v.y, v.z, v.w);
+      doge::detail::uniform_impl(program, id, std::addressof(v), 1,
+         gl::Uniform4f, v.x, v.y, v.z, v.w);
    }
 
    template <ranges::RandomAccessRange Rng>
@@ -117,13 +120,13 @@ namespace doge {
    }
    void uniform(const shader_binary& program, const std::string_view id, const Rng& rng)
    {
-      doge::detail::uniform_impl(program, id, gl::Uniform4fv,
-         gsl::narrow_cast<GLsizei>(ranges::size(rng)), std::addressof(rng[0][0]));
+      doge::detail::uniform_impl(program, id, std::addressof(rng[0]), ranges::size(rng),
+         gl::Uniform4fv, gsl::narrow_cast<GLsizei>(ranges::size(rng)), std::addressof(rng[0][0]));
    }
 
    void uniform(const shader_binary& program, const std::string_view id, const GLint i)
    {
-      doge::detail::uniform_impl(program, id, gl::Uniform1i, i);
+      doge::detail::uniform_impl(program, id, std::addressof(i), 1, gl::Uniform1i, i);
    }
 
    template <ranges::RandomAccessRange Rng>
@@ -133,13 +136,13 @@ namespace doge {
    }
    void uniform(const shader_binary& program, const std::string_view id, const Rng& rng)
    {
-      doge::detail::uniform_impl(program, id, gl::Uniform1iv,
-         gsl::narrow_cast<GLsizei>(ranges::size(rng)), std::addressof(rng[0][0]));
+      doge::detail::uniform_impl(program, id, std::addressof(rng[0]), ranges::size(rng),
+         gl::Uniform1iv, gsl::narrow_cast<GLsizei>(ranges::size(rng)), std::addressof(rng[0][0]));
    }
 
    void uniform(const shader_binary& program, const std::string_view id, const glm::ivec2 v)
    {
-      doge::detail::uniform_impl(program, id, gl::Uniform2i, v.x, v.y);
+      doge::detail::uniform_impl(program, id, std::addressof(v), 1, gl::Uniform2i, v.x, v.y);
    }
 
    template <ranges::RandomAccessRange Rng>
@@ -149,13 +152,13 @@ namespace doge {
    }
    void uniform(const shader_binary& program, const std::string_view id, const Rng& rng)
    {
-      doge::detail::uniform_impl(program, id, gl::Uniform2iv,
-         gsl::narrow_cast<GLsizei>(ranges::size(rng)), std::addressof(rng[0][0]));
+      doge::detail::uniform_impl(program, id, std::addressof(rng[0]), ranges::size(rng),
+         gl::Uniform2iv, gsl::narrow_cast<GLsizei>(ranges::size(rng)), std::addressof(rng[0][0]));
    }
 
    void uniform(const shader_binary& program, const std::string_view id, const glm::ivec3 v)
    {
-      doge::detail::uniform_impl(program, id, gl::Uniform3i, v.x, v.y, v.z);
+      doge::detail::uniform_impl(program, id, std::addressof(v), 1, gl::Uniform3i, v.x, v.y, v.z);
    }
 
    template <ranges::RandomAccessRange Rng>
@@ -165,13 +168,14 @@ namespace doge {
    }
    void uniform(const shader_binary& program, const std::string_view id, const Rng& rng)
    {
-      doge::detail::uniform_impl(program, id, gl::Uniform3iv,
-         gsl::narrow_cast<GLsizei>(ranges::size(rng)), std::addressof(rng[0][0]));
+      doge::detail::uniform_impl(program, id, std::addressof(rng[0]), ranges::size(rng),
+         gl::Uniform3iv, gsl::narrow_cast<GLsizei>(ranges::size(rng)), std::addressof(rng[0][0]));
    }
 
    void uniform(const shader_binary& program, const std::string_view id, const glm::ivec4 v)
    {
-      doge::detail::uniform_impl(program, id, gl::Uniform4i, v.x, v.y, v.z, v.w);
+      doge::detail::uniform_impl(program, id, std::addressof(v), 1,
+         gl::Uniform4i, v.x, v.y, v.z, v.w);
    }
 
    template <ranges::RandomAccessRange Rng>
@@ -181,13 +185,13 @@ namespace doge {
    }
    void uniform(const shader_binary& program, const std::string_view id, const Rng& rng)
    {
-      doge::detail::uniform_impl(program, id, gl::Uniform4iv,
-         gsl::narrow_cast<GLsizei>(ranges::size(rng)), std::addressof(rng[0][0]));
+      doge::detail::uniform_impl(program, id, std::addressof(rng[0]), ranges::size(rng),
+         gl::Uniform4iv, gsl::narrow_cast<GLsizei>(ranges::size(rng)), std::addressof(rng[0][0]));
    }
 
    void uniform(const shader_binary& program, const std::string_view id, const GLuint v)
    {
-      doge::detail::uniform_impl(program, id, gl::Uniform1ui, v);
+      doge::detail::uniform_impl(program, id, std::addressof(v), 1, gl::Uniform1ui, v);
    }
 
    template <ranges::RandomAccessRange Rng>
@@ -197,13 +201,13 @@ namespace doge {
    }
    void uniform(const shader_binary& program, const std::string_view id, const Rng& rng)
    {
-      doge::detail::uniform_impl(program, id, gl::Uniform1uiv,
-         gsl::narrow_cast<GLsizei>(ranges::size(rng)), std::addressof(rng[0][0]));
+      doge::detail::uniform_impl(program, id, std::addressof(rng[0]), ranges::size(rng),
+         gl::Uniform1uiv, gsl::narrow_cast<GLsizei>(ranges::size(rng)), std::addressof(rng[0][0]));
    }
 
    void uniform(const shader_binary& program, const std::string_view id, const glm::uvec2 v)
    {
-      doge::detail::uniform_impl(program, id, gl::Uniform2ui, v.x, v.y);
+      doge::detail::uniform_impl(program, id, std::addressof(v), 1, gl::Uniform2ui, v.x, v.y);
    }
 
    template <ranges::RandomAccessRange Rng>
@@ -213,13 +217,13 @@ namespace doge {
    }
    void uniform(const shader_binary& program, const std::string_view id, const Rng& rng)
    {
-      doge::detail::uniform_impl(program, id, gl::Uniform2uiv,
-         gsl::narrow_cast<GLsizei>(ranges::size(rng)), std::addressof(rng[0][0]));
+      doge::detail::uniform_impl(program, id, std::addressof(rng[0]), ranges::size(rng),
+         gl::Uniform2uiv, gsl::narrow_cast<GLsizei>(ranges::size(rng)), std::addressof(rng[0][0]));
    }
 
    void uniform(const shader_binary& program, const std::string_view id, const glm::uvec3 v)
    {
-      doge::detail::uniform_impl(program, id, gl::Uniform3ui, v.x, v.y, v.z);
+      doge::detail::uniform_impl(program, id, std::addressof(v), 1, gl::Uniform3ui, v.x, v.y, v.z);
    }
 
    template <ranges::RandomAccessRange Rng>
@@ -229,13 +233,14 @@ namespace doge {
    }
    void uniform(const shader_binary& program, const std::string_view id, const Rng& rng)
    {
-      doge::detail::uniform_impl(program, id, gl::Uniform3uiv,
-         gsl::narrow_cast<GLsizei>(ranges::size(rng)), std::addressof(rng[0][0]));
+      doge::detail::uniform_impl(program, id, std::addressof(rng[0]), ranges::size(rng),
+         gl::Uniform3uiv, gsl::narrow_cast<GLsizei>(ranges::size(rng)), std::addressof(rng[0][0]));
    }
 
    void uniform(const shader_binary& program, const std::string_view id, const glm::uvec4 v)
    {
-      doge::detail::uniform_impl(program, id, gl::Uniform4ui, v.x, v.y, v.z, v.w);
+      doge::detail::uniform_impl(program, id, std::addressof(v), 1,
+         gl::Uniform4ui, v.x, v.y, v.z, v.w);
    }
 
    template <ranges::RandomAccessRange Rng>
@@ -245,15 +250,15 @@ namespace doge {
    }
    void uniform(const shader_binary& program, const std::string_view id, const Rng& rng)
    {
-      doge::detail::uniform_impl(program, id, gl::Uniform4uiv,
-         gsl::narrow_cast<GLsizei>(ranges::size(rng)), std::addressof(rng[0][0]));
+      doge::detail::uniform_impl(program, id, std::addressof(rng[0]), ranges::size(rng),
+         gl::Uniform4uiv, gsl::narrow_cast<GLsizei>(ranges::size(rng)), std::addressof(rng[0][0]));
    }
 
    void uniform(const shader_binary& program, const std::string_view id, const bool transpose,
       const glm::mat2& m)
    {
-      doge::detail::uniform_impl(program, id, gl::UniformMatrix2fv, 1, transpose,
-         glm::value_ptr(m));
+      doge::detail::uniform_impl(program, id, transpose ? nullptr : std::addressof(m), 1,
+         gl::UniformMatrix2fv, 1, transpose, glm::value_ptr(m));
    }
 
    template <ranges::RandomAccessRange Rng>
@@ -264,15 +269,16 @@ namespace doge {
    void uniform(const shader_binary& program, const std::string_view id, const bool transpose,
       const Rng& rng)
    {
-      doge::detail::uniform_impl(program, id, gl::UniformMatrix2fv,
+      const auto shadowed = transpose ? nullptr : std::addressof(rng[0]);
+      doge::detail::uniform_impl(program, id, shadowed, ranges::size(rng), gl::UniformMatrix2fv,
          gsl::narrow_cast<GLsizei>(ranges::size(rng)), transpose, std::addressof(rng[0][0][0]));
    }
 
    void uniform(const shader_binary& program, const std::string_view id, const bool transpose,
       const glm::mat3& m)
    {
-      doge::detail::uniform_impl(program, id, gl::UniformMatrix3fv, 1, transpose,
-         glm::value_ptr(m));
+      doge::detail::uniform_impl(program, id, transpose ? nullptr : std::addressof(m), 1,
+         gl::UniformMatrix3fv, 1, transpose, glm::value_ptr(m));
    }
 
    template <ranges::RandomAccessRange Rng>
@@ -283,15 +289,16 @@ namespace doge {
    void uniform(const shader_binary& program, const std::string_view id, const bool transpose,
       const Rng& rng)
    {
-      doge::detail::uniform_impl(program, id, gl::UniformMatrix3fv,
+      const auto shadowed = transpose ? nullptr : std::addressof(rng[0]);
+      doge::detail::uniform_impl(program, id, shadowed, ranges::size(rng), gl::UniformMatrix3fv,
          gsl::narrow_cast<GLsizei>(ranges::size(rng)), transpose, std::addressof(rng[0][0][0]));
    }
 
    void uniform(const shader_binary& program, const std::string_view id, const bool transpose,
       const glm::mat4& m)
    {
-      doge::detail::uniform_impl(program, id, gl::UniformMatrix4fv, 1, transpose,
-         glm::value_ptr(m));
+      doge::detail::uniform_impl(program, id, transpose ? nullptr : std::addressof(m), 1,
+         gl::UniformMatrix4fv, 1, transpose, glm::value_ptr(m));
    }
 
    template <ranges::RandomAccessRange Rng>
@@ -302,15 +309,16 @@ namespace doge {
    void uniform(const shader_binary& program, const std::string_view id, const bool transpose,
       const Rng& rng)
    {
-      doge::detail::uniform_impl(program, id, gl::UniformMatrix4fv,
+      const auto shadowed = transpose ? nullptr : std::addressof(rng[0]);
+      doge::detail::uniform_impl(program, id, shadowed, ranges::size(rng), gl::UniformMatrix4fv,
          gsl::narrow_cast<GLsizei>(ranges::size(rng)), transpose, std::addressof(rng[0][0][0]));
    }
 
    void uniform(const shader_binary& program, const std::string_view id, const bool transpose,
       const glm::mat2x3& m)
    {
-      doge::detail::uniform_impl(program, id, gl::UniformMatrix2x3fv, 1, transpose,
-         glm::value_ptr(m));
+      doge::detail::uniform_impl(program, id, transpose ? nullptr : std::addressof(m), 1,
+         gl::UniformMatrix2x3fv, 1, transpose, glm::value_ptr(m));
    }
 
    template <ranges::RandomAccessRange Rng>
@@ -321,15 +329,16 @@ namespace doge {
    void uniform(const shader_binary& program, const std::string_view id, const bool transpose,
       const Rng& rng)
    {
-      doge::detail::uniform_impl(program, id, gl::UniformMatrix2x3fv,
+      const auto shadowed = transpose ? nullptr : std::addressof(rng[0]);
+      doge::detail::uniform_impl(program, id, shadowed, ranges::size(rng), gl::UniformMatrix2x3fv,
          gsl::narrow_cast<GLsizei>(ranges::size(rng)), transpose, std::addressof(rng[0][0][0]));
    }
 
    void uniform(const shader_binary& program, const std::string_view id, const bool transpose,
       const glm::mat3x2& m)
    {
-      doge::detail::uniform_impl(program, id, gl::UniformMatrix3x2fv, 1, transpose,
-         glm::value_ptr(m));
+      doge::detail::uniform_impl(program, id, transpose ? nullptr : std::addressof(m), 1,
+         gl::UniformMatrix3x2fv, 1, transpose, glm::value_ptr(m));
    }
 
    template <ranges::RandomAccessRange Rng>
@@ -340,15 +349,16 @@ namespace doge {
    void uniform(const shader_binary& program, const std::string_view id, const bool transpose,
       const Rng& rng)
    {
-      doge::detail::uniform_impl(program, id, gl::UniformMatrix3x2fv,
+      const auto shadowed = transpose ? nullptr : std::addressof(rng[0]);
+      doge::detail::uniform_impl(program, id, shadowed, ranges::size(rng), gl::UniformMatrix3x2fv,
          gsl::narrow_cast<GLsizei>(ranges::size(rng)), transpose, std::addressof(rng[0][0][0]));
    }
 
    void uniform(const shader_binary& program, const std::string_view id, const bool transpose,
       const glm::mat4x2& m)
    {
-      doge::detail::uniform_impl(program, id, gl::UniformMatrix4x2fv, 1, transpose,
-         glm::value_ptr(m));
+      doge::detail::uniform_impl(program, id, transpose ? nullptr : std::addressof(m), 1,
+         gl::UniformMatrix4x2fv, 1, transpose, glm::value_ptr(m));
    }
 
    template <ranges::RandomAccessRange Rng>
@@ -359,15 +369,16 @@ namespace doge {
    void uniform(const shader_binary& program, const std::string_view id, const bool transpose,
       const Rng& rng)
    {
-      doge::detail::uniform_impl(program, id, gl::UniformMatrix4x2fv,
+      const auto shadowed = transpose ? nullptr : std::addressof(rng[0]);
+      doge::detail::uniform_impl(program, id, shadowed, ranges::size(rng), gl::UniformMatrix4x2fv,
          gsl::narrow_cast<GLsizei>(ranges::size(rng)), transpose, std::addressof(rng[0][0][0]));
    }
 
    void uniform(const shader_binary& program, const std::string_view id, const bool transpose,
       const glm::mat2x4& m)
    {
-      doge::detail::uniform_impl(program, id, gl::UniformMatrix2x4fv, 1, transpose,
-         glm::value_ptr(m));
+      doge::detail::uniform_impl(program, id, transpose ? nullptr : std::addressof(m), 1,
+         gl::UniformMatrix2x4fv, 1, transpose, glm::value_ptr(m));
    }
 
    template <ranges::RandomAccessRange Rng>
@@ -378,15 +389,16 @@ namespace doge {
    void uniform(const shader_binary& program, const std::string_view id, const bool transpose,
       const Rng& rng)
    {
-      doge::detail::uniform_impl(program, id, gl::UniformMatrix2x4fv,
+      const auto shadowed = transpose ? nullptr : std::addressof(rng[0]);
+      doge::detail::uniform_impl(program, id, shadowed, ranges::size(rng), gl::UniformMatrix2x4fv,
          gsl::narrow_cast<GLsizei>(ranges::size(rng)), transpose, std::addressof(rng[0][0][0]));
    }
 
    void uniform(const shader_binary& program, const std::string_view id, const bool transpose,
       const glm::mat4x3& m)
    {
-      doge::detail::uniform_impl(program, id, gl::UniformMatrix4x3fv, 1, transpose,
-         glm::value_ptr(m));
+      doge::detail::uniform_impl(program, id, transpose ? nullptr : std::addressof(m), 1,
+         gl::UniformMatrix4x3fv, 1, transpose, glm::value_ptr(m));
    }
 
    template <ranges::RandomAccessRange Rng>
@@ -397,15 +409,16 @@ namespace doge {
    void uniform(const shader_binary& program, const std::string_view id, const bool transpose,
       const Rng& rng)
    {
-      doge::detail::uniform_impl(program, id, gl::UniformMatrix4x3fv,
+      const auto shadowed = transpose ? nullptr : std::addressof(rng[0]);
+      doge::detail::uniform_impl(program, id, shadowed, ranges::size(rng), gl::UniformMatrix4x3fv,
          gsl::narrow_cast<GLsizei>(ranges::size(rng)), transpose, std::addressof(rng[0][0][0]));
    }
 
    void uniform(const shader_binary& program, const std::string_view id, const bool transpose,
       const glm::mat3x4& m)
    {
-      doge::detail::uniform_impl(program, id, gl::UniformMatrix3x4fv, 1, transpose,
-         glm::value_ptr(m));
+      doge::detail::uniform_impl(program, id, transpose ? nullptr : std::addressof(m), 1,
+         gl::UniformMatrix3x4fv, 1, transpose, glm::value_ptr(m));
    }
 
    template <ranges::RandomAccessRange Rng>
@@ -416,7 +429,8 @@ namespace doge {
    void uniform(const shader_binary& program, const std::string_view id, const bool transpose,
       const Rng& rng)
    {
-      doge::detail::uniform_impl(program, id, gl::UniformMatrix3x4fv,
+      const auto shadowed = transpose ? nullptr : std::addressof(rng[0]);
+      doge::detail::uniform_impl(program, id, shadowed, ranges::size(rng), gl::UniformMatrix3x4fv,
          gsl::narrow_cast<GLsizei>(ranges::size(rng)), transpose, std::addressof(rng[0][0][0]));
    }
 
@@ -0,0 +1,336 @@
+//
+//  Copyright 2018 Christopher Di Bella
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+#ifndef DOGE_GL_UNIFORM_BLOCK_HPP
+#define DOGE_GL_UNIFORM_BLOCK_HPP
+
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <cstring>
+#include <doge/detail/gl_invocable.hpp>
+#include <doge/gl/shader_binary.hpp>
+#include <doge/gl/state_cache.hpp>
+#include <doge/utility/type_traits.hpp>
+#include <gl/gl_core.hpp>
+#include <string>
+#include <string_view>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+
+namespace doge {
+   enum class block_layout_t { std140, std430 };
+
+   /**
+    * @brief Describes the members of `Struct` that are mirrored in a shader block, in the order
+    *        they are declared in the shader. Specialise this for each block:
+    *
+    *    template <>
+    *    struct doge::block_members<camera_data> {
+    *       static constexpr auto value = std::make_tuple(&camera_data::projection,
+    *          &camera_data::view);
+    *    };
+    *
+    * Members may be scalars, glm vectors and matrices, or `std::array`s of them.
+    */
+   template <typename Struct>
+   struct block_members;
+
+   namespace detail {
+      /**
+       * @brief Where one member sits in a block. Every member is a run of `count` elements (a
+       *        matrix is a run of its columns), each `element_size` bytes, placed `stride` bytes
+       *        apart.
+       */
+      struct block_member_layout {
+         std::size_t alignment;
+         std::size_t stride;
+         std::size_t count;
+         std::size_t element_size;
+
+         constexpr std::size_t size() const noexcept
+         {
+            return count == 1 ? element_size : stride * count;
+         }
+      };
+
+      constexpr std::size_t round_up(const std::size_t n, const std::size_t alignment) noexcept
+      {
+         return (n + alignment - 1) / alignment * alignment;
+      }
+
+      template <typename T>
+      constexpr bool is_std_array_v = false;
+
+      template <typename T, std::size_t N>
+      constexpr bool is_std_array_v<std::array<T, N>> = true;
+
+      // std140 rounds the alignment of arrays (and so matrices) up to that of a vec4
+      template <block_layout_t Layout>
+      constexpr block_member_layout array_of(const block_member_layout element,
+         const std::size_t count) noexcept
+      {
+         const auto alignment = Layout == block_layout_t::std140
+                              ? round_up(element.alignment, 16) : element.alignment;
+         return {alignment, round_up(element.element_size, alignment), element.count * count,
+            element.element_size};
+      }
+
+      template <block_layout_t Layout, typename T>
+      constexpr block_member_layout block_layout_of() noexcept
+      {
+         if constexpr (is_glm_matrix_v<T>) {
+            constexpr auto column = block_layout_of<Layout, typename T::col_type>();
+            return array_of<Layout>(column, T::length());
+         }
+         else if constexpr (is_std_array_v<T>) {
+            constexpr auto element = block_layout_of<Layout, typename T::value_type>();
+            constexpr auto result = array_of<Layout>(element, std::tuple_size_v<T>);
+            static_assert(element.count == 1 || element.alignment == result.alignment,
+               "arrays of matrices must have vec4-aligned columns");
+            return result;
+         }
+         else {
+            constexpr auto components = gl_traits<T>::size;
+            constexpr auto scalar = sizeof(typename gl_traits<T>::type);
+            static_assert(sizeof(T) == components * scalar);
+
+            // a vec3 is aligned as if it were a vec4
+            return {(components == 3 ? 4 : components) * scalar, components * scalar, 1,
+               components * scalar};
+         }
+      }
+
+      template <typename Struct>
+      using block_members_t = std::remove_cv_t<decltype(block_members<Struct>::value)>;
+
+      template <typename Struct, std::size_t I>
+      using block_member_t = remove_cv_ref_t<
+         decltype(std::declval<const Struct&>().*std::get<I>(block_members<Struct>::value))>;
+
+      template <typename Struct, block_layout_t Layout, std::size_t... I>
+      constexpr auto block_layouts(std::index_sequence<I...>) noexcept
+      {
+         return std::array<block_member_layout, sizeof...(I)>{
+            block_layout_of<Layout, block_member_t<Struct, I>>()...};
+      }
+
+      // the last offset is the size of the whole block
+      template <std::size_t N>
+      constexpr auto block_offsets(const std::array<block_member_layout, N>& layouts) noexcept
+      {
+         auto result = std::array<std::size_t, N + 1>{};
+         auto end = std::size_t{0};
+         for (auto i = std::size_t{0}; i != N; ++i) {
+            result[i] = round_up(end, layouts[i].alignment);
+            end = result[i] + layouts[i].size();
+         }
+         result[N] = round_up(end, 16);
+         return result;
+      }
+
+      // returns the number of members if `Member` isn't found
+      template <typename Struct, auto Member, std::size_t I = 0>
+      constexpr std::size_t block_index_of() noexcept
+      {
+         using members = block_members_t<Struct>;
+         if constexpr (std::is_same_v<decltype(Member), std::tuple_element_t<I, members>>) {
+            if (std::get<I>(block_members<Struct>::value) == Member)
+               return I;
+         }
+
+         if constexpr (I + 1 < std::tuple_size_v<members>)
+            return block_index_of<Struct, Member, I + 1>();
+         else
+            return std::tuple_size_v<members>;
+      }
+   } // namespace detail
+
+   /**
+    * @brief A uniform buffer (std140) or shader storage buffer (std430) that mirrors `Struct`.
+    *
+    * The layout of the block is computed at compile time from the member types described by
+    * `block_members<Struct>`. Members are written to a staging copy, and `upload` sends only the
+    * bytes that changed since the last upload, in a single call. One block can be shared by every
+    * program that declares it with the same binding:
+    *
+    *    layout (std140, binding = 0) uniform camera {
+    *       mat4 projection;
+    *       mat4 view;
+    *    };
+    */
+   template <typename Struct, block_layout_t Layout = block_layout_t::std140>
+   class uniform_block {
+      static constexpr auto members_ = block_members<Struct>::value;
+      static constexpr auto member_count = std::tuple_size_v<detail::block_members_t<Struct>>;
+      static constexpr auto layouts_ = detail::block_layouts<Struct, Layout>(
+         std::make_index_sequence<member_count>{});
+      static constexpr auto offsets_ = detail::block_offsets(layouts_);
+
+      template <std::size_t I>
+      using member_t = detail::block_member_t<Struct, I>;
+
+      template <auto Member>
+      static constexpr auto index_of = detail::block_index_of<Struct, Member>();
+   public:
+      static constexpr GLenum target = Layout == block_layout_t::std140 ? gl::UNIFORM_BUFFER
+                                                                        : gl::SHADER_STORAGE_BUFFER;
+
+      /**
+       * @brief The size of the block in bytes.
+       */
+      static constexpr std::size_t size = offsets_[member_count];
+
+      /**
+       * @brief The byte offset of member `I` in the block.
+       */
+      template <std::size_t I>
+      static constexpr std::size_t offset = offsets_[I];
+
+      /**
+       * @brief Creates a zero-filled block and binds it to the indexed binding point `binding`.
+       */
+      explicit uniform_block(const GLuint binding)
+      {
+         gl::GenBuffers(1, &index_);
+         gl_state().bind_buffer(target, index_);
+         gl::BufferData(target, size, staging_.data(), gl::DYNAMIC_DRAW);
+         bind(binding);
+      }
+
+      uniform_block(const uniform_block&) = delete;
+      uniform_block& operator=(const uniform_block&) = delete;
+
+      ~uniform_block() noexcept
+      {
+         delete_buffers(1, &index_);
+      }
+
+      /**
+       * @brief Writes one member, e.g. `block.set<&camera_data::view>(view)`.
+       */
+      template <auto Member>
+      void set(const member_t<index_of<Member>>& value) noexcept
+      {
+         static_assert(index_of<Member> != member_count,
+            "Member isn't described by block_members");
+         write<index_of<Member>>(value);
+      }
+
+      /**
+       * @brief Writes every member of `value`. Members that haven't changed aren't uploaded.
+       */
+      void set(const Struct& value) noexcept
+      {
+         std::apply([&, this](const auto... member) noexcept {
+            auto i = std::size_t{0};
+            (write(i++, std::addressof(value.*member)), ...);
+         }, members_);
+      }
+
+      /**
+       * @brief Sends the changed bytes to the buffer with one `gl::BufferSubData`.
+       */
+      void upload() noexcept
+      {
+         if (dirty_begin_ >= dirty_end_)
+            return;
+
+         gl_state().bind_buffer(target, index_);
+         gl::BufferSubData(target, dirty_begin_, dirty_end_ - dirty_begin_,
+            staging_.data() + dirty_begin_);
+         dirty_begin_ = size;
+         dirty_end_ = 0;
+      }
+
+      void bind(const GLuint binding) noexcept
+      {
+         binding_ = binding;
+         gl_state().bind_buffer_base(target, binding_, index_);
+      }
+
+      GLuint binding() const noexcept
+      {
+         return binding_;
+      }
+
+      explicit operator GLuint() const noexcept
+      {
+         return index_;
+      }
+   private:
+      GLuint index_ = 0;
+      GLuint binding_ = 0;
+      std::array<std::byte, size> staging_{};
+      std::size_t dirty_begin_ = size;
+      std::size_t dirty_end_ = 0;
+
+      template <std::size_t I>
+      void write(const member_t<I>& value) noexcept
+      {
+         write(I, std::addressof(value));
+      }
+
+      // glm types are tightly packed, so elements are read `element_size` bytes apart
+      void write(const std::size_t member, const void* const value) noexcept
+      {
+         const auto& layout = layouts_[member];
+         const auto source = static_cast<const std::byte*>(value);
+         for (auto i = std::size_t{0}; i != layout.count; ++i) {
+            const auto offset = offsets_[member] + i * layout.stride;
+            const auto element = source + i * layout.element_size;
+            if (std::memcmp(staging_.data() + offset, element, layout.element_size) != 0) {
+               std::memcpy(staging_.data() + offset, element, layout.element_size);
+               dirty_begin_ = std::min(dirty_begin_, offset);
+               dirty_end_ = std::max(dirty_end_, offset + layout.element_size);
+            }
+         }
+      }
+   };
+
+   /**
+    * @brief Points the uniform block `name` in `program` at the binding point `binding`, for
+    *        shaders that don't declare a binding themselves.
+    *
+    * @throws uniform_not_found if `program` has no active uniform block called `name`.
+    */
+   inline void uniform_block_binding(const shader_binary& program, const std::string_view name,
+      const GLuint binding)
+   {
+      const auto index = gl::GetUniformBlockIndex(static_cast<GLuint>(program),
+         std::string{name}.c_str());
+      if (index == gl::INVALID_INDEX)
+         throw uniform_not_found{name};
+      gl::UniformBlockBinding(static_cast<GLuint>(program), index, binding);
+   }
+
+   /**
+    * @brief Points the shader storage block `name` in `program` at the binding point `binding`.
+    *
+    * @throws uniform_not_found if `program` has no active storage block called `name`.
+    */
+   inline void storage_block_binding(const shader_binary& program, const std::string_view name,
+      const GLuint binding)
+   {
+      const auto index = gl::GetProgramResourceIndex(static_cast<GLuint>(program),
+         gl::SHADER_STORAGE_BLOCK, std::string{name}.c_str());
+      if (index == gl::INVALID_INDEX)
+         throw uniform_not_found{name};
+      gl::ShaderStorageBlockBinding(static_cast<GLuint>(program), index, binding);
+   }
+} // namespace doge
+
+#endif // DOGE_GL_UNIFORM_BLOCK_HPP
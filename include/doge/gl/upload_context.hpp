@@ -0,0 +1,173 @@
+//
+//  Copyright 2018 Christopher Di Bella
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+#ifndef DOGE_GL_UPLOAD_CONTEXT_HPP
+#define DOGE_GL_UPLOAD_CONTEXT_HPP
+
+#include <condition_variable>
+#include <deque>
+#include <experimental/ranges/concepts>
+#include <experimental/ranges/functional>
+#include <functional>
+#include <future>
+#include <gl/gl_core.hpp>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <type_traits>
+#include <utility>
+
+namespace doge {
+   namespace ranges = std::experimental::ranges;
+
+   /**
+    * @brief Marks the point in an upload thread's commands after which the objects that it made
+    *        are complete. Move-only.
+    */
+   class upload_fence {
+   public:
+      upload_fence() = default;
+
+      explicit upload_fence(const GLsync sync) noexcept
+         : sync_{sync}
+      {}
+
+      upload_fence(upload_fence&& other) noexcept
+         : sync_{std::exchange(other.sync_, nullptr)}
+      {}
+
+      upload_fence& operator=(upload_fence&& other) noexcept
+      {
+         upload_fence{std::move(other)}.swap(*this);
+         return *this;
+      }
+
+      ~upload_fence() noexcept
+      {
+         if (sync_)
+            gl::DeleteSync(sync_);
+      }
+
+      /**
+       * @brief Makes the current context's later commands wait for the upload, without blocking
+       *        the calling thread. Call this on the render thread before first using the objects.
+       */
+      void wait() noexcept
+      {
+         if (sync_) {
+            gl::WaitSync(sync_, 0, gl::TIMEOUT_IGNORED);
+            gl::DeleteSync(std::exchange(sync_, nullptr));
+         }
+      }
+
+      void swap(upload_fence& other) noexcept
+      {
+         std::swap(sync_, other.sync_);
+      }
+   private:
+      GLsync sync_ = nullptr;
+   };
+
+   /**
+    * @brief The objects made by an upload job, and the fence to wait on before using them.
+    */
+   template <typename T>
+   struct upload_result {
+      T value;
+      upload_fence fence;
+   };
+
+   template <>
+   struct upload_result<void> {
+      upload_fence fence;
+   };
+
+   /**
+    * @brief A thread with its own GL context, which shares objects with the render thread's, for
+    *        creating buffers, textures and programs without competing with rendering.
+    *
+    *    auto pending = uploads.submit([]{ return texture2d{"brick.png", wrapping, min, mag}; });
+    *    // ... frames later, on the render thread
+    *    if (pending.wait_for(0s) == std::future_status::ready) {
+    *       auto [texture, fence] = pending.get();
+    *       fence.wait();
+    *    }
+    *
+    * Vertex arrays and framebuffers aren't shared between contexts, so they must still be made on
+    * the render thread, from buffers and textures made here.
+    *
+    * An object deleted on the render thread is only forgotten by the render thread's state cache,
+    * so the upload thread's cache is invalidated before each job.
+    */
+   class upload_context {
+   public:
+      /**
+       * @param make_current Makes the shared context current on the calling thread. It is only
+       *        ever called on the upload thread.
+       * @param release Leaves the calling thread with no current context.
+       */
+      upload_context(std::function<void()> make_current, std::function<void()> release);
+
+      upload_context(const upload_context&) = delete;
+      upload_context& operator=(const upload_context&) = delete;
+
+      /**
+       * @brief Finishes the jobs already submitted, and then stops the thread.
+       */
+      ~upload_context();
+
+      /**
+       * @brief Runs `f` on the upload thread, in the order jobs were submitted, and then fences
+       *        and flushes its commands.
+       */
+      template <ranges::Invocable F>
+      std::future<upload_result<std::invoke_result_t<F>>> submit(F f)
+      {
+         using result = std::invoke_result_t<F>;
+         auto task = std::make_shared<std::packaged_task<upload_result<result>()>>(
+            [f = std::move(f)]() mutable {
+               if constexpr (std::is_void_v<result>) {
+                  ranges::invoke(f);
+                  return upload_result<void>{fence()};
+               }
+               else {
+                  auto value = ranges::invoke(f);
+                  return upload_result<result>{std::move(value), fence()};
+               }
+            });
+
+         auto future = task->get_future();
+         push([task = std::move(task)]{ (*task)(); });
+         return future;
+      }
+   private:
+      std::mutex mutex_;
+      std::condition_variable work_available_;
+      std::deque<std::function<void()>> jobs_;
+      bool stopping_ = false;
+      std::thread thread_;
+
+      void push(std::function<void()> job);
+      void work(const std::function<void()>& make_current, const std::function<void()>& release);
+
+      /**
+       * @brief Fences the upload thread's commands so far, and flushes them so that another
+       *        context can wait on the fence.
+       */
+      static upload_fence fence() noexcept;
+   };
+} // namespace doge
+
+#endif // DOGE_GL_UPLOAD_CONTEXT_HPP
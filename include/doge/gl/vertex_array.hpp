@@ -16,13 +16,21 @@
 #ifndef DOGE_GL_VERTEX_ARRAY_HPP
 #define DOGE_GL_VERTEX_ARRAY_HPP
 
+#include <algorithm>
 #include <cassert>
+#include <deque>
 #include <doge/gl/buffer_interpreter.hpp>
-#include <doge/utility/reference_count.hpp>
+#include <doge/gl/handle.hpp>
+#include <doge/gl/state_cache.hpp>
+#include <doge/gl/stream_buffer.hpp>
+#include <doge/gl/vertex_format.hpp>
 #include <experimental/ranges/concepts>
+#include <experimental/ranges/functional>
 #include <gl/gl_core.hpp>
 #include <gsl/gsl>
+#include <limits>
 #include <memory>
+#include <numeric>
 #include <optional>
 #include <type_traits>
 #include <variant>
@@ -42,6 +50,11 @@ namespace doge {
          init(target, usage, size, stride, []{});
       }
 
+      /**
+       * @brief Uploads indexed vertices. The indices are stored as 16 bits whenever they all fit,
+       *        and can be reordered for the post-transform cache beforehand with
+       *        `optimise_vertex_cache`.
+       */
       vertex(const GLenum target, const GLenum usage,
          gsl::not_null<std::shared_ptr<std::vector<GLfloat>>> data, std::vector<GLint> indices,
          const GLint size, const std::vector<GLint>& stride)
@@ -51,18 +64,55 @@ namespace doge {
          Expects(not data_->empty());
          Expects(indices_ and not indices_->empty());
 
-         init(target, usage, size, stride, [this, usage]{
-            gl::BindBuffer(gl::ELEMENT_ARRAY_BUFFER, *ebo_);
-            gl::BufferData(gl::ELEMENT_ARRAY_BUFFER, indices_->size() * sizeof(GLint),
-               indices_->data(), usage); });
+         init(target, usage, size, stride, [this, usage]{ bind_indices(usage); });
+      }
+
+      /**
+       * @brief Uploads interleaved vertices that were encoded with `vertex_format::write`.
+       *
+       * The attributes are described by `Format` rather than a list of float counts, so they can
+       * be stored as half floats, normalised integers or packed normals.
+       */
+      template <typename... Attributes>
+      vertex(const GLenum target, const GLenum usage, const gsl::span<const std::byte> data,
+         vertex_format<Attributes...>)
+      {
+         Expects(not data.empty());
+         init(target, usage, data, []{}, []{ vertex_format<Attributes...>::interpret(); });
+      }
+
+      template <typename... Attributes>
+      vertex(const GLenum target, const GLenum usage, const gsl::span<const std::byte> data,
+         std::vector<GLint> indices, vertex_format<Attributes...>)
+         : indices_{std::move(indices)}
+      {
+         Expects(not data.empty());
+         Expects(indices_ and not indices_->empty());
+
+         init(target, usage, data, [this, usage]{ bind_indices(usage); },
+            []{ vertex_format<Attributes...>::interpret(); });
+      }
+
+      /**
+       * @brief Sources the vertex data from a stream_buffer instead of a buffer owned by the vertex.
+       *
+       * The attributes are pointed at the stream's current region each time the vertex is bound,
+       * so data written after `data.next_region()` is drawn without any further uploads. `data`
+       * must outlive the vertex.
+       */
+      vertex(const stream_buffer& data, const GLint size, const std::vector<GLint>& stride)
+      {
+         gl_state().bind_vertex_array(vao_);
+         format(0, 0, stride);
+         gl_state().bind_vertex_array(0);
+         streams_.push_back({&data, 0, gsl::narrow_cast<GLsizei>(size * sizeof(GLfloat))});
       }
 
       enum draw_type { triangles = gl::TRIANGLES };
 
       void draw(const draw_type mode) const noexcept
       {
-         gl::DrawElements(gsl::narrow_cast<GLint>(mode), indices_->size(), gl::UNSIGNED_INT,
-            nullptr);
+         gl::DrawElements(gsl::narrow_cast<GLint>(mode), indices_->size(), index_type_, nullptr);
       }
 
       void draw(const draw_type mode, const GLint first, const GLint last) const noexcept
@@ -70,53 +120,192 @@ namespace doge {
          gl::DrawArrays(gsl::narrow_cast<GLint>(mode), first, last);
       }
 
+      /**
+       * @brief Draws `instances` copies of the indexed mesh with a single draw call.
+       */
+      void draw_instanced(const draw_type mode, const GLsizei instances) const noexcept
+      {
+         gl::DrawElementsInstanced(gsl::narrow_cast<GLint>(mode), indices_->size(), index_type_,
+            nullptr, instances);
+      }
+
+      /**
+       * @brief Draws `instances` copies of the vertices `[first, first + count)` with a single draw
+       *        call.
+       */
+      void draw_instanced(const draw_type mode, const GLint first, const GLsizei count,
+         const GLsizei instances) const noexcept
+      {
+         gl::DrawArraysInstanced(gsl::narrow_cast<GLint>(mode), first, count, instances);
+      }
+
+      /**
+       * @brief Adds a stream of per-instance attributes to the vertex array.
+       *
+       * @param usage The usage hint for the instance buffer, e.g. `gl::DYNAMIC_DRAW` if the data is
+       *        updated every frame.
+       * @param data The per-instance data, packed as floats.
+       * @param first_index The attribute index of the first attribute in the stream. This should
+       *        follow the per-vertex attributes.
+       * @param components The number of components in each attribute. GL limits attributes to
+       *        four components, so a `glm::mat4` is described as `{4, 4, 4, 4}`.
+       * @param divisor The number of instances that advance to the next element in `data`.
+       * @returns An identifier for the stream, to be passed to `update_instances`.
+       */
+      std::size_t instance_attributes(const GLenum usage,
+         gsl::not_null<std::shared_ptr<std::vector<GLfloat>>> data, const GLuint first_index,
+         const std::vector<GLint>& components, const GLuint divisor = 1)
+      {
+         Expects(not data->empty());
+         Expects(divisor > 0);
+
+         auto& stream = instances_.emplace_back(instance_stream{unique_buffer::generate(),
+            std::move(data.get()), usage});
+
+         bind([&, this]{
+            gl_state().bind_buffer(gl::ARRAY_BUFFER, stream.vbo);
+            gl::BufferData(gl::ARRAY_BUFFER, stream.data->size() * sizeof(GLfloat),
+               std::data(*stream.data), stream.usage);
+            const auto size = std::accumulate(components.begin(), components.end(), GLint{});
+            interpret(first_index, size, components, divisor);
+            unbind(gl::ARRAY_BUFFER);
+         });
+
+         return instances_.size() - 1;
+      }
+
+      /**
+       * @brief Adds a stream of per-instance attributes that are read from a stream_buffer.
+       *
+       * See the overload taking a usage hint for a description of the parameters. `data` must
+       * outlive the vertex.
+       */
+      void instance_attributes(const stream_buffer& data, const GLuint first_index,
+         const std::vector<GLint>& components, const GLuint divisor = 1)
+      {
+         Expects(first_index > 0);
+         Expects(divisor > 0);
+
+         // attributes from a stream use the binding point that matches their first index
+         bind([&, this]{
+            format(first_index, first_index, components);
+            gl::VertexBindingDivisor(first_index, divisor);
+         });
+
+         const auto size = std::accumulate(components.begin(), components.end(), GLint{});
+         streams_.push_back({&data, first_index,
+            gsl::narrow_cast<GLsizei>(size * sizeof(GLfloat))});
+      }
+
+      /**
+       * @brief Re-uploads the data for an instance stream after it has been modified.
+       */
+      void update_instances(const std::size_t stream) const noexcept
+      {
+         Expects(stream < instances_.size());
+         const auto& s = instances_[stream];
+         gl_state().bind_buffer(gl::ARRAY_BUFFER, s.vbo);
+         gl::BufferData(gl::ARRAY_BUFFER, s.data->size() * sizeof(GLfloat), std::data(*s.data),
+            s.usage);
+         gl_state().bind_buffer(gl::ARRAY_BUFFER, 0);
+      }
+
       template <ranges::Invocable F>
       void bind(const F& f) const noexcept
       {
-         gl::BindVertexArray(vao_);
+         gl_state().bind_vertex_array(vao_);
+         for (const auto& i : streams_) {
+            gl::BindVertexBuffer(i.binding, static_cast<GLuint>(*i.buffer), i.buffer->offset(),
+               i.stride);
+         }
          ranges::invoke(f);
       }
    private:
-      GLuint array_size_ = 1;
-      reference_count<GLuint> vao_ = make_reference_count(array_size_, gl::GenVertexArrays,
-         gl::DeleteVertexArrays);
-
-      GLuint buffer_size_ = 1;
-      reference_count<GLuint> vbo_ = make_reference_count(buffer_size_, gl::GenBuffers,
-         gl::DeleteBuffers);
+      unique_vertex_array vao_ = unique_vertex_array::generate();
+      unique_buffer vbo_ = unique_buffer::generate();
 
       std::shared_ptr<std::vector<GLfloat>> data_;
 
       std::optional<std::vector<GLint>> indices_;
-      std::optional<reference_count<GLuint>> ebo_ = indices_ ?
-         make_reference_count(1, gl::GenBuffers, gl::DeleteBuffers) :
-         std::optional<reference_count<GLuint>>{};
+      std::optional<unique_buffer> ebo_ = indices_ ?
+         std::optional<unique_buffer>{unique_buffer::generate()} : std::nullopt;
+      GLenum index_type_ = gl::UNSIGNED_INT;
 
-      template <typename F1, typename F2>
-      static reference_count<GLuint> make_reference_count(GLuint size, F1 f1, F2 f2) noexcept
-      {
-         auto result = GLuint{};
-         ranges::invoke(f1, size, &result);
-         return {result, [size, f2 = std::move(f2)](const auto i) noexcept {
-            ranges::invoke(f2, size, i); }};
-      }
+      struct instance_stream {
+         unique_buffer vbo;
+         std::shared_ptr<std::vector<GLfloat>> data;
+         GLenum usage;
+      };
+
+      // a deque, so that adding a stream never relocates the buffers that are already owned
+      std::deque<instance_stream> instances_;
+
+      struct stream_binding {
+         const stream_buffer* buffer;
+         GLuint binding;
+         GLsizei stride;
+      };
+
+      std::vector<stream_binding> streams_;
 
       void bind_buffer(const GLenum target, const GLenum usage) const noexcept
       {
-         gl::BindBuffer(target, vbo_);
+         gl_state().bind_buffer(target, vbo_);
          gl::BufferData(target, data_->size() * sizeof(GLfloat), std::data(*data_), usage);
       }
 
-      void interpret(const GLint size, const std::vector<GLint>& interpreter) noexcept
+      // uploads 16-bit indices when every index fits in one, halving the index bandwidth; no
+      // indices are uploaded as an empty buffer of 32-bit ones
+      void bind_indices(const GLenum usage) noexcept
+      {
+         gl_state().bind_buffer(gl::ELEMENT_ARRAY_BUFFER, *ebo_);
+
+         auto narrow = false;
+         if (not indices_->empty()) {
+            const auto [low, high] = std::minmax_element(indices_->begin(), indices_->end());
+            narrow = *low >= 0 and *high <= std::numeric_limits<GLushort>::max();
+         }
+
+         if (narrow) {
+            auto shorts = std::vector<GLushort>(indices_->begin(), indices_->end());
+            gl::BufferData(gl::ELEMENT_ARRAY_BUFFER, shorts.size() * sizeof(GLushort),
+               shorts.data(), usage);
+            index_type_ = gl::UNSIGNED_SHORT;
+         }
+         else {
+            gl::BufferData(gl::ELEMENT_ARRAY_BUFFER, indices_->size() * sizeof(GLint),
+               indices_->data(), usage);
+         }
+      }
+
+      void interpret(const GLuint first_index, const GLint size,
+         const std::vector<GLint>& interpreter, const GLuint divisor = 0) noexcept
       {
          using ranges::Integral, ranges::SignedIntegral;
          Integral offset = GLsizeiptr{};
          for (Integral i = decltype(interpreter.size()){}; i != interpreter.size(); ++i) {
-            const SignedIntegral index = static_cast<GLint>(i);
+            const Integral index = first_index + static_cast<GLuint>(i);
             const SignedIntegral stride = interpreter[i];
             gl::VertexAttribPointer(index, stride, gl::FLOAT, false, size * sizeof(GLfloat),
                reinterpret_cast<GLvoid*>(offset * sizeof(GLfloat)));
             gl::EnableVertexAttribArray(index);
+            if (divisor != 0)
+               gl::VertexAttribDivisor(index, divisor);
+            offset += stride;
+         }
+      }
+
+      void format(const GLuint first_index, const GLuint binding,
+         const std::vector<GLint>& interpreter) noexcept
+      {
+         using ranges::Integral, ranges::SignedIntegral;
+         Integral offset = GLuint{};
+         for (Integral i = decltype(interpreter.size()){}; i != interpreter.size(); ++i) {
+            const Integral index = first_index + static_cast<GLuint>(i);
+            const SignedIntegral stride = interpreter[i];
+            gl::VertexAttribFormat(index, stride, gl::FLOAT, false, offset * sizeof(GLfloat));
+            gl::VertexAttribBinding(index, binding);
+            gl::EnableVertexAttribArray(index);
             offset += stride;
          }
       }
@@ -128,15 +317,28 @@ namespace doge {
          bind([&, this]{
             bind_buffer(target, usage);
             ranges::invoke(ebo);
-            interpret(size, stride);
+            interpret(0, size, stride);
+            unbind(target);
+         });
+      }
+
+      template <ranges::Invocable F1, ranges::Invocable F2>
+      void init(const GLenum target, const GLenum usage, const gsl::span<const std::byte> data,
+         const F1& ebo, const F2& interpret)
+      {
+         bind([&, this]{
+            gl_state().bind_buffer(target, vbo_);
+            gl::BufferData(target, data.size(), data.data(), usage);
+            ranges::invoke(ebo);
+            ranges::invoke(interpret);
             unbind(target);
          });
       }
 
       static void unbind(const GLenum target) noexcept
       {
-         gl::BindBuffer(target, 0);
-         gl::BindVertexArray(0);
+         gl_state().bind_buffer(target, 0);
+         gl_state().bind_vertex_array(0);
       }
    };
 } // namespace doge
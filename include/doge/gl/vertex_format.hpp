@@ -0,0 +1,325 @@
+//
+//  Copyright 2018 Christopher Di Bella
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+#ifndef DOGE_GL_VERTEX_FORMAT_HPP
+#define DOGE_GL_VERTEX_FORMAT_HPP
+
+#include <array>
+#include <cstddef>
+#include <cstring>
+#include <doge/detail/gl_invocable.hpp>
+#include <experimental/ranges/concepts>
+#include <gl/gl_core.hpp>
+#include <glm/glm.hpp>
+#include <glm/gtc/packing.hpp>
+#include <gsl/gsl>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+
+namespace doge {
+   namespace ranges = std::experimental::ranges;
+
+   /**
+    * @brief Component tag for 16-bit IEEE floats (`gl::HALF_FLOAT`).
+    *
+    * `GLhalf` is a typedef for `GLushort`, so it can't be told apart from an unsigned integer
+    * attribute; this tag is used instead.
+    */
+   struct half {};
+
+   /**
+    * @brief Component tag for integers that the shader reads as floats in [-1, 1] or [0, 1].
+    */
+   template <ranges::Integral T>
+   struct normalised {};
+
+   using snorm8 = normalised<GLbyte>;
+   using unorm8 = normalised<GLubyte>;
+   using snorm16 = normalised<GLshort>;
+   using unorm16 = normalised<GLushort>;
+
+   /**
+    * @brief Component tag for vectors packed into a single `gl::INT_2_10_10_10_REV` word.
+    *
+    * The attribute always has four components: a shader that declares a `vec3` input ignores the
+    * two-bit w component. Well-suited to normals and tangents.
+    */
+   struct snorm_2_10_10_10 {};
+
+   /**
+    * @brief Describes how one component of a vertex attribute is stored in the buffer.
+    *
+    * Float, half, normalised and packed components are read as floats by the shader; plain integer
+    * components are read as integers (through `gl::VertexAttribIPointer`).
+    */
+   template <typename Component>
+   struct vertex_component;
+
+   template <>
+   struct vertex_component<GLfloat> {
+      using storage_type = GLfloat;
+      static constexpr GLenum type = gl::FLOAT;
+      static constexpr bool normalised = false;
+      static constexpr bool integer = false;
+      static constexpr bool packed = false;
+
+      static storage_type pack(const float f) noexcept
+      { return f; }
+   };
+
+   template <>
+   struct vertex_component<half> {
+      using storage_type = GLhalf;
+      static constexpr GLenum type = gl::HALF_FLOAT;
+      static constexpr bool normalised = false;
+      static constexpr bool integer = false;
+      static constexpr bool packed = false;
+
+      static storage_type pack(const float f) noexcept
+      { return glm::packHalf1x16(f); }
+   };
+
+   namespace detail {
+      template <ranges::Integral T>
+      constexpr GLenum integral_type() noexcept
+      {
+         static_assert(sizeof(T) == 1 or sizeof(T) == 2 or sizeof(T) == 4);
+         if constexpr (sizeof(T) == 1)
+            return std::is_signed_v<T> ? gl::BYTE : gl::UNSIGNED_BYTE;
+         else if constexpr (sizeof(T) == 2)
+            return std::is_signed_v<T> ? gl::SHORT : gl::UNSIGNED_SHORT;
+         else
+            return std::is_signed_v<T> ? gl::INT : gl::UNSIGNED_INT;
+      }
+   } // namespace detail
+
+   template <ranges::Integral T>
+   struct vertex_component<normalised<T>> {
+      using storage_type = T;
+      static constexpr GLenum type = detail::integral_type<T>();
+      static constexpr bool normalised = true;
+      static constexpr bool integer = false;
+      static constexpr bool packed = false;
+
+      static storage_type pack(const float f) noexcept
+      {
+         static_assert(sizeof(T) <= 2, "normalised components are limited to 8 and 16 bits");
+         if constexpr (sizeof(T) == 1)
+            return std::is_signed_v<T> ? static_cast<T>(glm::packSnorm1x8(f)) : glm::packUnorm1x8(f);
+         else
+            return std::is_signed_v<T> ? static_cast<T>(glm::packSnorm1x16(f)) : glm::packUnorm1x16(f);
+      }
+   };
+
+   template <ranges::Integral T>
+   struct vertex_component<T> {
+      using storage_type = T;
+      static constexpr GLenum type = detail::integral_type<T>();
+      static constexpr bool normalised = false;
+      static constexpr bool integer = true;
+      static constexpr bool packed = false;
+
+      template <typename U>
+      static storage_type pack(const U u) noexcept
+      { return static_cast<T>(u); }
+   };
+
+   template <>
+   struct vertex_component<snorm_2_10_10_10> {
+      using storage_type = GLuint;
+      static constexpr GLenum type = gl::INT_2_10_10_10_REV;
+      static constexpr bool normalised = true;
+      static constexpr bool integer = false;
+      static constexpr bool packed = true;
+
+      static storage_type pack(const glm::vec3& v) noexcept
+      { return pack(glm::vec4{v, 0.0f}); }
+
+      static storage_type pack(const glm::vec4& v) noexcept
+      { return glm::packSnorm3x10_1x2(v); }
+   };
+
+   /**
+    * @brief A single vertex attribute: the shader-side type `Vector` (e.g. `glm::vec3`) and how
+    *        each of its components is stored in the buffer.
+    */
+   template <typename Vector, typename Component = GLfloat>
+   struct attr {
+      using vector_type = Vector;
+      using component = vertex_component<Component>;
+
+      /** @brief The number of components passed to the attribute pointer. */
+      static constexpr GLint components = component::packed ? 4 :
+         GLint{detail::gl_traits<Vector>::size};
+
+      /** @brief The number of bytes the attribute occupies in each vertex. */
+      static constexpr std::size_t size = component::packed ? sizeof(typename component::storage_type) :
+         components * sizeof(typename component::storage_type);
+
+      /**
+       * @brief Encodes `value` into the `size` bytes starting at `out`.
+       */
+      static void write(std::byte* const out, const Vector& value) noexcept
+      {
+         if constexpr (component::packed) {
+            const auto packed = component::pack(value);
+            std::memcpy(out, &packed, sizeof(packed));
+         }
+         else if constexpr (components == 1) {
+            const auto packed = component::pack(value);
+            std::memcpy(out, &packed, sizeof(packed));
+         }
+         else {
+            for (auto i = 0; i != components; ++i) {
+               const auto packed = component::pack(value[i]);
+               std::memcpy(out + i * sizeof(packed), &packed, sizeof(packed));
+            }
+         }
+      }
+   };
+
+   namespace detail {
+      /// GL prefers attributes that start on a four-byte boundary.
+      constexpr std::size_t attribute_alignment = 4;
+
+      constexpr std::size_t align_attribute(const std::size_t offset) noexcept
+      {
+         return (offset + attribute_alignment - 1) / attribute_alignment * attribute_alignment;
+      }
+
+      template <typename... Attributes>
+      constexpr std::array<std::size_t, sizeof...(Attributes)> attribute_offsets() noexcept
+      {
+         auto result = std::array<std::size_t, sizeof...(Attributes)>{};
+         auto sizes = std::array<std::size_t, sizeof...(Attributes)>{Attributes::size...};
+         auto offset = std::size_t{};
+         for (auto i = std::size_t{}; i != result.size(); ++i) {
+            result[i] = offset;
+            offset = align_attribute(offset + sizes[i]);
+         }
+         return result;
+      }
+
+      template <typename... Attributes>
+      constexpr std::size_t vertex_stride() noexcept
+      {
+         auto stride = std::size_t{};
+         ((stride = align_attribute(stride + Attributes::size)), ...);
+         return stride;
+      }
+   } // namespace detail
+
+   /**
+    * @brief A compile-time description of an interleaved vertex, e.g.
+    *        `vertex_format<attr<glm::vec3>, attr<glm::vec3, snorm_2_10_10_10>, attr<glm::vec2, half>>`.
+    *
+    * Attributes are laid out in order, each starting on a four-byte boundary, and are assigned
+    * consecutive attribute indices.
+    */
+   template <typename... Attributes>
+   struct vertex_format {
+      static_assert(sizeof...(Attributes) > 0, "a vertex needs at least one attribute");
+
+      template <std::size_t I>
+      using attribute = std::tuple_element_t<I, std::tuple<Attributes...>>;
+
+      /** @brief The number of attributes in the format. */
+      static constexpr std::size_t attribute_count = sizeof...(Attributes);
+
+      /** @brief The byte offset of each attribute from the start of the vertex. */
+      static constexpr std::array<std::size_t, attribute_count> offsets =
+         detail::attribute_offsets<Attributes...>();
+
+      /** @brief The number of bytes between consecutive vertices. */
+      static constexpr std::size_t stride = detail::vertex_stride<Attributes...>();
+
+      template <std::size_t I>
+      static constexpr std::size_t offset = offsets[I];
+
+      /**
+       * @brief Points attributes `[first_index, first_index + attribute_count)` at the buffer that
+       *        is currently bound to `gl::ARRAY_BUFFER`.
+       */
+      static void interpret(const GLuint first_index = 0, const GLuint divisor = 0) noexcept
+      {
+         interpret_all(first_index, divisor, std::index_sequence_for<Attributes...>{});
+      }
+
+      /**
+       * @brief Describes the attributes relative to the vertex buffer bound at `binding`, for use
+       *        with `gl::BindVertexBuffer`.
+       */
+      static void format(const GLuint first_index, const GLuint binding) noexcept
+      {
+         format_all(first_index, binding, std::index_sequence_for<Attributes...>{});
+      }
+
+      /**
+       * @brief Encodes attribute `I` of vertex `index` into `vertices`.
+       */
+      template <std::size_t I>
+      static void write(const gsl::span<std::byte> vertices, const std::size_t index,
+         const typename attribute<I>::vector_type& value) noexcept
+      {
+         Expects((index + 1) * stride <= static_cast<std::size_t>(vertices.size()));
+         attribute<I>::write(vertices.data() + index * stride + offset<I>, value);
+      }
+   private:
+      template <std::size_t... I>
+      static void interpret_all(const GLuint first_index, const GLuint divisor,
+         std::index_sequence<I...>) noexcept
+      {
+         (interpret_one<I>(first_index + I, divisor), ...);
+      }
+
+      template <std::size_t I>
+      static void interpret_one(const GLuint index, const GLuint divisor) noexcept
+      {
+         using a = attribute<I>;
+         const auto pointer = reinterpret_cast<const GLvoid*>(offset<I>);
+         if constexpr (a::component::integer)
+            gl::VertexAttribIPointer(index, a::components, a::component::type, stride, pointer);
+         else
+            gl::VertexAttribPointer(index, a::components, a::component::type,
+               a::component::normalised, stride, pointer);
+         gl::EnableVertexAttribArray(index);
+         if (divisor != 0)
+            gl::VertexAttribDivisor(index, divisor);
+      }
+
+      template <std::size_t... I>
+      static void format_all(const GLuint first_index, const GLuint binding,
+         std::index_sequence<I...>) noexcept
+      {
+         (format_one<I>(first_index + I, binding), ...);
+      }
+
+      template <std::size_t I>
+      static void format_one(const GLuint index, const GLuint binding) noexcept
+      {
+         using a = attribute<I>;
+         if constexpr (a::component::integer)
+            gl::VertexAttribIFormat(index, a::components, a::component::type, offset<I>);
+         else
+            gl::VertexAttribFormat(index, a::components, a::component::type,
+               a::component::normalised, offset<I>);
+         gl::VertexAttribBinding(index, binding);
+         gl::EnableVertexAttribArray(index);
+      }
+   };
+} // namespace doge
+
+#endif // DOGE_GL_VERTEX_FORMAT_HPP
@@ -16,6 +16,10 @@
 #ifndef DOGE_HID_HPP
 #define DOGE_HID_HPP
 
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <doge/utility/spsc_queue.hpp>
 #include <experimental/ranges/concepts>
 #include <functional>
 #include <gl/gl_core.hpp>
@@ -26,8 +30,61 @@ namespace doge::hid {
    enum class key_state { up, release, press, down };
    using std::experimental::ranges::Regular;
 
+   /**
+    * @brief One input callback from GLFW, stamped with the time it was received.
+    */
+   struct input_event {
+      enum class device { keyboard, mouse_button, cursor, scroll };
+
+      device source = device::keyboard;
+      int code = 0; // the key or button
+      int action = 0;
+      int mods = 0;
+      glm::vec2 value = {}; // the cursor position, or the scroll offset
+      double time = 0.0; // from glfwGetTime
+   };
+
    class hid {
    public:
+      static constexpr std::size_t event_capacity = 1024;
+
+      /**
+       * @brief Applies every event received since the last call to the keyboard and mouse state,
+       *        in the order they arrived, and passes each one to `listener`.
+       *
+       * Callbacks only queue events, so several presses or cursor moves within one frame are
+       * all seen rather than collapsing into the last one. `engine::play` calls this at the
+       * start of every frame.
+       *
+       * @returns The number of events that were processed.
+       */
+      template <typename F>
+      requires
+         std::experimental::ranges::Invocable<F, const input_event&>
+      static std::size_t process_events(const F& listener);
+
+      static std::size_t process_events()
+      {
+         return process_events([](const input_event&) noexcept {});
+      }
+
+      /**
+       * @brief The number of events that were discarded because the queue was full.
+       */
+      static std::size_t dropped_events() noexcept
+      {
+         return dropped_.load(std::memory_order_relaxed);
+      }
+
+      /**
+       * @brief The longest time, in seconds, that an event processed by the last call to
+       *        `process_events` spent waiting in the queue.
+       */
+      static double event_latency() noexcept
+      {
+         return latency_;
+      }
+
       static bool shift() noexcept
       {
          return shift_;
@@ -48,6 +105,13 @@ namespace doge::hid {
          return super_;
       }
    protected:
+      static void push(input_event e) noexcept
+      {
+         e.time = glfwGetTime();
+         if (not events_.try_push(e))
+            dropped_.fetch_add(1, std::memory_order_relaxed);
+      }
+
       static void modifiers(const int mods) noexcept
       {
          shift_ = mods & GLFW_MOD_SHIFT;
@@ -62,6 +126,9 @@ namespace doge::hid {
       static inline Regular control_ = false;
       static inline Regular alt_ = false;
       static inline Regular super_ = false;
+      static inline spsc_queue<input_event, event_capacity> events_;
+      static inline std::atomic<std::size_t> dropped_ = 0;
+      static inline double latency_ = 0.0;
    };
 
    class keyboard : public hid {
@@ -74,25 +141,37 @@ namespace doge::hid {
 
       static key_state key(const int i) noexcept
       {
-         return key_mask_.at(i + 1);
+         return key_mask_[i + 1];
       }
 
       static void key(const int i, const key_state s) noexcept
       {
-         key_mask_.at(i + 1) = s;
+         key_mask_[i + 1] = s;
       }
    private:
-      static inline Regular key_mask_ = std::vector(360, key_state::up);
+      friend class hid;
+
+      // GLFW_KEY_UNKNOWN is -1, so keys are stored one place along
+      static inline std::array<key_state, GLFW_KEY_LAST + 2> key_mask_ = [] {
+         auto result = std::array<key_state, GLFW_KEY_LAST + 2>{};
+         result.fill(key_state::up);
+         return result;
+      }();
 
       static void callback(GLFWwindow*, int key, int, int action, int mods) noexcept
       {
-         ++key;
-         if (action == GLFW_PRESS && key_mask_[key] != key_state::down)
+         push({input_event::device::keyboard, key, action, mods});
+      }
+
+      static void apply(const input_event& e) noexcept
+      {
+         const auto key = e.code + 1;
+         if (e.action == GLFW_PRESS && key_mask_[key] != key_state::down)
             key_mask_[key] = key_state::press;
-         else if (action == GLFW_RELEASE && key_mask_[key] != key_state::up)
+         else if (e.action == GLFW_RELEASE && key_mask_[key] != key_state::up)
             key_mask_[key] = key_state::release;
 
-         modifiers(mods);
+         modifiers(e.mods);
       }
    };
 
@@ -141,6 +220,16 @@ namespace doge::hid {
          //   glfwSetCursorEnterCallback(w, enter_callback);
       }
 
+      static key_state key(const int i) noexcept
+      {
+         return key_mask_[i];
+      }
+
+      static void key(const int i, const key_state s) noexcept
+      {
+         key_mask_[i] = s;
+      }
+
       static [[nodiscard]] glm::vec2 cursor(index i) noexcept
       {
          return cursor_[i];
@@ -213,33 +302,54 @@ namespace doge::hid {
          return conditionally_invoke(scroll(current) == v, f, std::forward<Args>(args)...);
       }
    private:
-      static inline Regular key_mask_ = std::vector(8, key_state::up);
+      friend class hid;
+
+      static inline std::array<key_state, GLFW_MOUSE_BUTTON_LAST + 1> key_mask_ = [] {
+         auto result = std::array<key_state, GLFW_MOUSE_BUTTON_LAST + 1>{};
+         result.fill(key_state::up);
+         return result;
+      }();
       static inline Regular cursor_ = std::array<glm::vec2, 2>{{{960.0f, 540.0f}, {960.0f, 540.0f}}};
       static inline Regular scroll_ = std::array<glm::vec2, 2>{{{0.0f, 0.0f}, {0.0f, 0.0f}}};
       static inline Regular sensitivity_ = 0.1f;
 
       static void button_callback(GLFWwindow*, int key, int action, int mods) noexcept
       {
-         if (action == GLFW_PRESS && key_mask_[key] != key_state::down)
-            key_mask_[key] = key_state::press;
-         else if (action == GLFW_RELEASE && key_mask_[key] != key_state::up)
-            key_mask_[key] = key_state::release;
-
-         modifiers(mods);
+         push({input_event::device::mouse_button, key, action, mods});
       }
 
       static void cursor_callback(GLFWwindow*, double x, double y) noexcept
       {
-         cursor_[previous] = cursor_[current];
-         cursor_[current].x = static_cast<float>(x);
-         cursor_[current].y = static_cast<float>(y);
+         push({input_event::device::cursor, 0, 0, 0,
+            {static_cast<float>(x), static_cast<float>(y)}});
       }
 
       static void scroll_callback(GLFWwindow*, double x, double y) noexcept
       {
-         scroll_[previous] = scroll_[current];
-         scroll_[current].x = static_cast<float>(x);
-         scroll_[current].y = static_cast<float>(y);
+         push({input_event::device::scroll, 0, 0, 0,
+            {static_cast<float>(x), static_cast<float>(y)}});
+      }
+
+      // deltas are measured from the last update(), so every sample in a frame contributes
+      static void apply(const input_event& e) noexcept
+      {
+         switch (e.source) {
+         case input_event::device::mouse_button:
+            if (e.action == GLFW_PRESS && key_mask_[e.code] != key_state::down)
+               key_mask_[e.code] = key_state::press;
+            else if (e.action == GLFW_RELEASE && key_mask_[e.code] != key_state::up)
+               key_mask_[e.code] = key_state::release;
+            modifiers(e.mods);
+            break;
+         case input_event::device::cursor:
+            cursor_[current] = e.value;
+            break;
+         case input_event::device::scroll:
+            scroll_[current] += e.value;
+            break;
+         case input_event::device::keyboard:
+            break;
+         }
       }
 
       template <typename F, typename... Args>
@@ -256,6 +366,29 @@ namespace doge::hid {
       }
    };
 
+   template <typename F>
+   requires
+      std::experimental::ranges::Invocable<F, const input_event&>
+   std::size_t hid::process_events(const F& listener)
+   {
+      const auto now = glfwGetTime();
+      auto oldest = now;
+      auto count = std::size_t{0};
+      while (const auto e = events_.try_pop()) {
+         if (e->source == input_event::device::keyboard)
+            keyboard::apply(*e);
+         else
+            mouse::apply(*e);
+
+         oldest = std::min(oldest, e->time);
+         std::experimental::ranges::invoke(listener, *e);
+         ++count;
+      }
+
+      latency_ = now - oldest;
+      return count;
+   }
+
    template <typename T, typename F, typename... Args>
    requires
       std::experimental::ranges::Invocable<F, Args...> &&
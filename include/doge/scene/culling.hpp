@@ -0,0 +1,188 @@
+//
+//  Copyright 2018 Christopher Di Bella
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+#ifndef DOGE_SCENE_CULLING_HPP
+#define DOGE_SCENE_CULLING_HPP
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <doge/utility/job_system.hpp>
+#include <glm/mat4x4.hpp>
+#include <glm/vec3.hpp>
+#include <glm/vec4.hpp>
+#include <gsl/gsl>
+#include <vector>
+
+namespace doge {
+   /**
+    * @brief The six planes of a view frustum, with normals that point inwards.
+    */
+   class frustum {
+   public:
+      enum plane { left, right, bottom, top, near_clip, far_clip };
+
+      /**
+       * @brief Extracts the planes from a camera's matrices, e.g.
+       *        `frustum{camera.project(aspect, 0.1f, 100.0f), camera.view()}`.
+       */
+      frustum(const glm::mat4& projection, const glm::mat4& view) noexcept;
+
+      /**
+       * @brief Extracts the planes from a combined `projection * view` matrix.
+       */
+      explicit frustum(const glm::mat4& view_projection) noexcept;
+
+      const glm::vec4& operator[](const plane p) const noexcept
+      {
+         return planes_[p];
+      }
+   private:
+      std::array<glm::vec4, 6> planes_;
+   };
+
+   /**
+    * @brief Bounding spheres stored as a structure of arrays, so that they can be tested several
+    *        at a time.
+    */
+   class bounding_spheres {
+   public:
+      void push_back(const glm::vec3& centre, const float radius)
+      {
+         x_.push_back(centre.x);
+         y_.push_back(centre.y);
+         z_.push_back(centre.z);
+         radius_.push_back(radius);
+      }
+
+      void set(const std::size_t i, const glm::vec3& centre, const float radius) noexcept
+      {
+         Expects(i < size());
+         x_[i] = centre.x;
+         y_[i] = centre.y;
+         z_[i] = centre.z;
+         radius_[i] = radius;
+      }
+
+      void reserve(const std::size_t n)
+      {
+         x_.reserve(n);
+         y_.reserve(n);
+         z_.reserve(n);
+         radius_.reserve(n);
+      }
+
+      void clear() noexcept
+      {
+         x_.clear();
+         y_.clear();
+         z_.clear();
+         radius_.clear();
+      }
+
+      std::size_t size() const noexcept
+      {
+         return x_.size();
+      }
+
+      const float* x() const noexcept { return x_.data(); }
+      const float* y() const noexcept { return y_.data(); }
+      const float* z() const noexcept { return z_.data(); }
+      const float* radius() const noexcept { return radius_.data(); }
+   private:
+      std::vector<float> x_;
+      std::vector<float> y_;
+      std::vector<float> z_;
+      std::vector<float> radius_;
+   };
+
+   /**
+    * @brief Axis-aligned bounding boxes, stored as centres and half-extents in a structure of
+    *        arrays.
+    */
+   class bounding_boxes {
+   public:
+      void push_back(const glm::vec3& min, const glm::vec3& max)
+      {
+         const auto centre = (min + max) * 0.5f;
+         const auto extent = (max - min) * 0.5f;
+         x_.push_back(centre.x);
+         y_.push_back(centre.y);
+         z_.push_back(centre.z);
+         ex_.push_back(extent.x);
+         ey_.push_back(extent.y);
+         ez_.push_back(extent.z);
+      }
+
+      void reserve(const std::size_t n)
+      {
+         for (auto* i : {&x_, &y_, &z_, &ex_, &ey_, &ez_})
+            i->reserve(n);
+      }
+
+      void clear() noexcept
+      {
+         for (auto* i : {&x_, &y_, &z_, &ex_, &ey_, &ez_})
+            i->clear();
+      }
+
+      std::size_t size() const noexcept
+      {
+         return x_.size();
+      }
+
+      const float* x() const noexcept { return x_.data(); }
+      const float* y() const noexcept { return y_.data(); }
+      const float* z() const noexcept { return z_.data(); }
+      const float* extent_x() const noexcept { return ex_.data(); }
+      const float* extent_y() const noexcept { return ey_.data(); }
+      const float* extent_z() const noexcept { return ez_.data(); }
+   private:
+      std::vector<float> x_;
+      std::vector<float> y_;
+      std::vector<float> z_;
+      std::vector<float> ex_;
+      std::vector<float> ey_;
+      std::vector<float> ez_;
+   };
+
+   /**
+    * @brief Writes the indices of the volumes that intersect `f` to `visible`, in ascending order.
+    *
+    * The tests are vectorised with AVX (eight volumes at a time) or SSE (four at a time),
+    * depending on what the build targets. `visible` is overwritten, and can be fed directly to
+    * an instance buffer or used to fill indirect draw commands.
+    *
+    * @param threads The number of threads to split the volumes across. Small sets are always
+    *        culled on the calling thread.
+    * @returns The number of visible volumes.
+    */
+   std::size_t cull(const frustum& f, const bounding_spheres& spheres,
+      std::vector<std::uint32_t>& visible, std::size_t threads = 1);
+
+   std::size_t cull(const frustum& f, const bounding_boxes& boxes,
+      std::vector<std::uint32_t>& visible, std::size_t threads = 1);
+
+   /**
+    * @brief Culls on the threads of `jobs` instead of starting threads of its own.
+    */
+   std::size_t cull(const frustum& f, const bounding_spheres& spheres,
+      std::vector<std::uint32_t>& visible, job_system& jobs);
+
+   std::size_t cull(const frustum& f, const bounding_boxes& boxes,
+      std::vector<std::uint32_t>& visible, job_system& jobs);
+} // namespace doge
+
+#endif // DOGE_SCENE_CULLING_HPP
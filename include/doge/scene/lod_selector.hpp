@@ -0,0 +1,132 @@
+//
+//  Copyright 2018 Christopher Di Bella
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+#ifndef DOGE_SCENE_LOD_SELECTOR_HPP
+#define DOGE_SCENE_LOD_SELECTOR_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <doge/gl/cooked_mesh.hpp>
+#include <doge/scene/culling.hpp>
+#include <doge/units/angle.hpp>
+#include <glm/vec3.hpp>
+#include <gsl/gsl>
+#include <vector>
+
+namespace doge {
+   struct lod_statistics {
+      std::size_t selected = 0;
+      std::size_t changed = 0;
+   };
+
+   /**
+    * @brief Picks a level of detail for each object from the size of its mesh's error on screen.
+    *
+    * An object is drawn at the coarsest level whose error, projected at the distance of the
+    * nearest point of its bounding sphere, is no larger than `threshold` pixels. Objects only
+    * move to a coarser level once its error is `hysteresis` below the threshold, and only move
+    * back once it is `hysteresis` above, so an object sitting on the boundary doesn't pop
+    * back and forth. Selection runs on the visible set from `cull`:
+    *
+    *    cull(frustum{view_projection}, spheres, visible);
+    *    selector.select(camera.position(), camera.field_of_view(), height, spheres, visible);
+    *    for (const auto i : visible)
+    *       pool.lod(i, selector.level(i));
+    *
+    * Objects that aren't visible keep the level they had, so they don't pop when they return.
+    */
+   class lod_selector {
+   public:
+      using chain_id = std::size_t;
+      using object_id = std::size_t;
+
+      /**
+       * @param threshold The largest error, in pixels, that is acceptable on screen.
+       * @param hysteresis The fraction of `threshold` that an error must cross before an object
+       *        changes level.
+       */
+      explicit lod_selector(float threshold = 1.0f, float hysteresis = 0.25f) noexcept;
+
+      /**
+       * @brief Registers the levels of a mesh, whose errors must increase from the first.
+       */
+      chain_id add_chain(gsl::span<const mesh_lod> lods);
+
+      /**
+       * @brief Adds an object drawn with `chain`, at the finest level. Objects are numbered in
+       *        the order that they're added, to match their bounding spheres.
+       *
+       * @param scale The largest scale in the object's transform, which makes its mesh's error
+       *        larger in world space.
+       */
+      object_id add(chain_id chain, float scale = 1.0f);
+
+      void scale(object_id object, float scale) noexcept;
+
+      /**
+       * @brief Picks a level for each of the `visible` objects, whose world-space bounds are in
+       *        `spheres`.
+       *
+       * @param field_of_view The vertical field of view, e.g. `camera.field_of_view()`.
+       * @param viewport_height The height, in pixels, of the viewport the objects are drawn to.
+       */
+      void select(const glm::vec3& eye, angle field_of_view, int viewport_height,
+         const bounding_spheres& spheres, gsl::span<const std::uint32_t> visible) noexcept;
+
+      /**
+       * @brief Picks a level for every object.
+       */
+      void select(const glm::vec3& eye, angle field_of_view, int viewport_height,
+         const bounding_spheres& spheres) noexcept;
+
+      std::uint32_t level(const object_id object) const noexcept
+      {
+         Expects(object < levels_.size());
+         return levels_[object];
+      }
+
+      std::size_t size() const noexcept
+      {
+         return levels_.size();
+      }
+
+      /**
+       * @brief Describes the most recent `select`.
+       */
+      const lod_statistics& statistics() const noexcept
+      {
+         return statistics_;
+      }
+   private:
+      struct chain {
+         std::uint32_t first;
+         std::uint32_t count;
+      };
+
+      float threshold_;
+      float hysteresis_;
+      std::vector<float> errors_; // the errors of every chain, back to back
+      std::vector<chain> chains_;
+      std::vector<std::uint32_t> chain_of_;
+      std::vector<float> scales_;
+      std::vector<std::uint32_t> levels_;
+      lod_statistics statistics_;
+
+      void select_one(std::uint32_t object, const glm::vec3& eye, float pixels_per_unit,
+         const bounding_spheres& spheres) noexcept;
+   };
+} // namespace doge
+
+#endif // DOGE_SCENE_LOD_SELECTOR_HPP
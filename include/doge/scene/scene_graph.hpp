@@ -0,0 +1,186 @@
+//
+//  Copyright 2018 Christopher Di Bella
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+#ifndef DOGE_SCENE_SCENE_GRAPH_HPP
+#define DOGE_SCENE_SCENE_GRAPH_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <doge/scene/culling.hpp>
+#include <doge/scene/transforms.hpp>
+#include <doge/utility/job_system.hpp>
+#include <glm/gtc/quaternion.hpp>
+#include <glm/mat4x4.hpp>
+#include <glm/vec3.hpp>
+#include <gsl/gsl>
+#include <limits>
+#include <vector>
+
+namespace doge {
+   /**
+    * @brief A hierarchy of transforms, whose world matrices are only recomputed for the subtrees
+    *        that changed since the last `update`.
+    *
+    * Nodes are stored in slots sorted by their depth in the hierarchy, so every parent is
+    * updated before its children in one linear pass, and the nodes at one depth can be
+    * updated in parallel. Local transforms are kept in a `transforms`, and the results are
+    * dense arrays in slot order, ready for the instancing and culling stages:
+    *
+    *    graph.update();
+    *    cull(frustum{view_projection}, graph.world_bounds(), visible);
+    *    write_matrices(graph, visible, instance_region);
+    *
+    * Slots are renumbered when the hierarchy changes, so nodes are referred to by id, and
+    * `slot` maps an id to its current slot.
+    */
+   class scene_graph {
+   public:
+      using node_id = std::uint32_t;
+      static constexpr auto no_node = std::numeric_limits<node_id>::max();
+
+      /**
+       * @brief Adds a node below `parent`, or a root if `parent` is `no_node`.
+       *
+       * @param bounds A sphere around the node's own contents, in its local space, which is
+       *        carried into world space along with the node's matrix.
+       */
+      node_id add(node_id parent = no_node, const glm::vec3& position = glm::vec3{0.0f},
+         const glm::quat& rotation = {1.0f, 0.0f, 0.0f, 0.0f},
+         const glm::vec3& scale = glm::vec3{1.0f}, const glm::vec4& bounds = glm::vec4{0.0f});
+
+      /**
+       * @brief Removes a node, and everything below it.
+       */
+      void remove(node_id node);
+
+      /**
+       * @brief Moves a node, and everything below it, to a new parent. The node's local transform
+       *        is kept, so it moves in the world unless the parents' transforms match.
+       */
+      void reparent(node_id node, node_id parent);
+
+      void local(node_id node, const glm::vec3& position, const glm::quat& rotation,
+         const glm::vec3& scale) noexcept;
+
+      void position(node_id node, const glm::vec3& position) noexcept;
+
+      void bounds(node_id node, const glm::vec4& bounds) noexcept;
+
+      /**
+       * @brief Recomputes the world matrices and bounds of every node that changed, or is below
+       *        one that did. Does nothing when no node changed.
+       *
+       * @param threads The number of threads to split each depth across. Small depths are
+       *        always updated on the calling thread.
+       */
+      void update(std::size_t threads = 1);
+
+      /**
+       * @brief Updates on the threads of `jobs` instead of starting threads of its own.
+       */
+      void update(job_system& jobs);
+
+      std::size_t size() const noexcept
+      {
+         return node_of_.size();
+      }
+
+      std::uint32_t slot(const node_id node) const noexcept
+      {
+         Expects(node < slot_of_.size() and slot_of_[node] != no_node);
+         return slot_of_[node];
+      }
+
+      node_id node(const std::uint32_t slot) const noexcept
+      {
+         Expects(slot < node_of_.size());
+         return node_of_[slot];
+      }
+
+      const glm::mat4& world(const node_id node) const noexcept
+      {
+         return world_[slot(node)];
+      }
+
+      /** @brief Each slot's world matrix, as of the last `update`. */
+      gsl::span<const glm::mat4> world_matrices() const noexcept
+      {
+         return world_;
+      }
+
+      /** @brief Each slot's bounds in world space, as of the last `update`. */
+      const bounding_spheres& world_bounds() const noexcept
+      {
+         return world_bounds_;
+      }
+
+      /**
+       * @brief The slots whose world matrices changed in the last `update`, in ascending order,
+       *        so that only they need to be uploaded. A slot that `remove` or `reparent` gave to
+       *        another node counts as changed.
+       */
+      gsl::span<const std::uint32_t> changed() const noexcept
+      {
+         return changed_;
+      }
+   private:
+      static constexpr auto clean = std::numeric_limits<std::size_t>::max();
+
+      // indexed by slot
+      transforms local_;
+      std::vector<glm::vec4> local_bounds_;
+      std::vector<node_id> node_of_;
+      std::vector<node_id> parent_of_;
+      std::vector<std::uint32_t> parent_slot_;
+      std::vector<std::uint32_t> depth_;
+      std::vector<std::uint8_t> dirty_;
+      std::vector<glm::mat4> world_;
+      bounding_spheres world_bounds_;
+
+      // indexed by node
+      std::vector<std::uint32_t> slot_of_;
+      std::vector<node_id> free_;
+
+      std::vector<std::size_t> depths_; // the first slot at each depth
+      std::vector<std::uint32_t> changed_;
+      std::size_t first_dirty_ = clean;
+      bool layout_dirty_ = false;
+
+      // what each thread needs to update its share of a depth, kept between updates
+      struct scratch {
+         std::vector<std::uint32_t> slots;
+         std::vector<glm::mat4> locals;
+      };
+
+      std::vector<scratch> scratch_;
+
+      void mark(std::uint32_t slot) noexcept;
+      void sort();
+      void rebuild(const std::vector<std::uint32_t>& order);
+      template <typename Spread>
+      void update(std::size_t threads, const Spread& spread);
+
+      void update_range(std::size_t first, std::size_t last, scratch& s) noexcept;
+   };
+
+   /**
+    * @brief Writes the world matrices of the slots in `slots`, e.g. the output of `cull` on the
+    *        graph's world bounds, to `out`.
+    */
+   void write_matrices(const scene_graph& graph, gsl::span<const std::uint32_t> slots,
+      gsl::span<glm::mat4> out) noexcept;
+} // namespace doge
+
+#endif // DOGE_SCENE_SCENE_GRAPH_HPP
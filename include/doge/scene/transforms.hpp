@@ -0,0 +1,117 @@
+//
+//  Copyright 2018 Christopher Di Bella
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+#ifndef DOGE_SCENE_TRANSFORMS_HPP
+#define DOGE_SCENE_TRANSFORMS_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <glm/gtc/quaternion.hpp>
+#include <glm/mat4x4.hpp>
+#include <glm/vec3.hpp>
+#include <glm/vec4.hpp>
+#include <gsl/gsl>
+#include <vector>
+
+namespace doge {
+   /**
+    * @brief Positions, rotations and scales for many objects, stored as a structure of arrays so
+    *        that their matrices can be built several at a time.
+    */
+   class transforms {
+   public:
+      void push_back(const glm::vec3& position, const glm::quat& rotation = {1.0f, 0.0f, 0.0f, 0.0f},
+         const glm::vec3& scale = glm::vec3{1.0f})
+      {
+         for (auto i = 0; i != 3; ++i) {
+            position_[i].push_back(position[i]);
+            scale_[i].push_back(scale[i]);
+         }
+         rotation_[0].push_back(rotation.x);
+         rotation_[1].push_back(rotation.y);
+         rotation_[2].push_back(rotation.z);
+         rotation_[3].push_back(rotation.w);
+      }
+
+      void set(const std::size_t i, const glm::vec3& position, const glm::quat& rotation,
+         const glm::vec3& scale) noexcept
+      {
+         Expects(i < size());
+         for (auto j = 0; j != 3; ++j) {
+            position_[j][i] = position[j];
+            scale_[j][i] = scale[j];
+         }
+         rotation_[0][i] = rotation.x;
+         rotation_[1][i] = rotation.y;
+         rotation_[2][i] = rotation.z;
+         rotation_[3][i] = rotation.w;
+      }
+
+      void position(const std::size_t i, const glm::vec3& p) noexcept
+      {
+         Expects(i < size());
+         for (auto j = 0; j != 3; ++j)
+            position_[j][i] = p[j];
+      }
+
+      void reserve(const std::size_t n);
+      void clear() noexcept;
+
+      std::size_t size() const noexcept
+      {
+         return position_[0].size();
+      }
+
+      /** @brief The x, y or z components of every position. */
+      const float* position(const int axis) const noexcept { return position_[axis].data(); }
+
+      /** @brief The x, y, z or w components of every rotation. */
+      const float* rotation(const int axis) const noexcept { return rotation_[axis].data(); }
+
+      /** @brief The x, y or z components of every scale. */
+      const float* scale(const int axis) const noexcept { return scale_[axis].data(); }
+   private:
+      std::vector<float> position_[3];
+      std::vector<float> rotation_[4];
+      std::vector<float> scale_[3];
+   };
+
+   /**
+    * @brief Writes `translate * rotate * scale` for every transform to `out`.
+    *
+    * Eight matrices are built at a time with AVX when the build targets it. `out` may be a
+    * region of a stream_buffer, so that the matrices go straight to an instance buffer.
+    */
+   void write_matrices(const transforms& t, gsl::span<glm::mat4> out) noexcept;
+
+   /**
+    * @brief Writes the matrices of the transforms in `indices`, e.g. the output of `cull`.
+    */
+   void write_matrices(const transforms& t, gsl::span<const std::uint32_t> indices,
+      gsl::span<glm::mat4> out) noexcept;
+
+   /**
+    * @brief Writes the top three rows of each matrix, which is all an affine transform needs.
+    *
+    * Each transform takes three `vec4`s, a quarter less than a `mat4`. A vertex shader rebuilds
+    * the matrix with `transpose(mat4(r0, r1, r2, vec4(0, 0, 0, 1)))`.
+    */
+   void write_affine_rows(const transforms& t, gsl::span<glm::vec4> out) noexcept;
+
+   void write_affine_rows(const transforms& t, gsl::span<const std::uint32_t> indices,
+      gsl::span<glm::vec4> out) noexcept;
+} // namespace doge
+
+#endif // DOGE_SCENE_TRANSFORMS_HPP
@@ -17,14 +17,76 @@
 #define DOGE_UTILITY_FILE_IO_HPP
 
 //#include <filesystem>
+#include <cstddef>
+#include <gsl/gsl>
 #include <string>
+#include <string_view>
+#include <vector>
 
 namespace doge {
+   /**
+    * @brief A read-only view of a whole file, mapped into memory for as long as the object lives.
+    *
+    * Nothing is copied until the bytes are read, so loaders can parse them in place.
+    */
+   class mapped_file {
+   public:
+      /**
+       * @throws std::runtime_error if the file can't be opened or mapped.
+       */
+      explicit mapped_file(const std::string& path);
+
+      mapped_file(mapped_file&& other) noexcept;
+      mapped_file& operator=(mapped_file&& other) noexcept;
+
+      ~mapped_file() noexcept;
+
+      gsl::span<const std::byte> bytes() const noexcept
+      {
+         return {data_, gsl::narrow_cast<std::ptrdiff_t>(size_)};
+      }
+
+      std::string_view text() const noexcept
+      {
+         return {reinterpret_cast<const char*>(data_), size_};
+      }
+
+      std::size_t size() const noexcept
+      {
+         return size_;
+      }
+   private:
+      const std::byte* data_ = nullptr;
+      std::size_t size_ = 0;
+#ifdef _WIN32
+      void* mapping_ = nullptr;
+#endif // _WIN32
+
+      void unmap() noexcept;
+   };
+
    template <typename T>
    T from_file(const std::string&);
 
    template <>
    std::string from_file<std::string>(const std::string& path);
+
+   template <>
+   std::vector<std::byte> from_file<std::vector<std::byte>>(const std::string& path);
+
+   /**
+    * @brief Replaces the contents of the file at `path` with `bytes`.
+    * @throws std::runtime_error if the file can't be written.
+    */
+   void to_file(const std::string& path, gsl::span<const std::byte> bytes);
+
+   /**
+    * @brief Returns the paths of the regular files in `directory` whose names end in
+    *        `extension`, in lexicographical order. Subdirectories aren't searched.
+    * @throws std::runtime_error if the directory can't be opened.
+    */
+   std::vector<std::string> list_directory(const std::string& directory,
+      std::string_view extension = {});
 } // namespace doge
 
 #endif // DOGE_UTILITY_FILE_IO_HPP
@@ -0,0 +1,195 @@
+//
+//  Copyright 2018 Christopher Di Bella
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+#ifndef DOGE_UTILITY_FRAME_ARENA_HPP
+#define DOGE_UTILITY_FRAME_ARENA_HPP
+
+#include <array>
+#include <cstddef>
+#include <memory>
+#include <new>
+#include <type_traits>
+#include <vector>
+
+namespace doge {
+   struct arena_statistics {
+      std::size_t allocations = 0;
+      std::size_t bytes = 0;
+      std::size_t heap_allocations = 0; // blocks taken from the heap because the arena was full
+   };
+
+   /**
+    * @brief A linear allocator: allocating bumps a pointer, and everything is freed at once by
+    *        `reset`.
+    *
+    * When the arena runs out of room it takes an overflow block from the heap, rather than
+    * failing. The next `reset` grows the arena to cover what was overflowed, so a workload that
+    * repeats only touches the heap until the arena has reached its working size.
+    */
+   class arena {
+   public:
+      explicit arena(std::size_t capacity);
+
+      arena(const arena&) = delete;
+      arena& operator=(const arena&) = delete;
+
+      /**
+       * @brief Returns `size` bytes aligned to `alignment`, which must be a power of two.
+       */
+      void* allocate(std::size_t size, std::size_t alignment = alignof(std::max_align_t));
+
+      template <typename T>
+      requires
+         std::is_trivially_destructible_v<T>
+      T* allocate_array(const std::size_t n)
+      {
+         return static_cast<T*>(allocate(n * sizeof(T), alignof(T)));
+      }
+
+      /**
+       * @brief Frees everything allocated since the last reset. Objects in the arena are not
+       *        destroyed.
+       */
+      void reset();
+
+      std::size_t capacity() const noexcept
+      {
+         return capacity_;
+      }
+
+      std::size_t used() const noexcept
+      {
+         return used_;
+      }
+
+      const arena_statistics& statistics() const noexcept
+      {
+         return statistics_;
+      }
+   private:
+      std::unique_ptr<std::byte[]> block_;
+      std::size_t capacity_;
+      std::size_t used_ = 0;
+      std::vector<std::unique_ptr<std::byte[]>> overflow_;
+      std::byte* overflow_top_ = nullptr;
+      std::size_t overflow_left_ = 0;
+      std::size_t overflowed_ = 0;
+      arena_statistics statistics_;
+
+      void* allocate_overflow(std::size_t size, std::size_t alignment);
+   };
+
+   /**
+    * @brief A pair of arenas that alternate each frame.
+    *
+    * Memory allocated during a frame stays valid for the whole of the following frame, so data
+    * recorded in one frame may still be read by the next (e.g. by an upload that lags a frame
+    * behind).
+    *
+    * The application owns the arena, and calls `next_frame` at the start of each frame, e.g.
+    * first thing in the logic passed to `engine::play`.
+    */
+   class frame_arena {
+   public:
+      explicit frame_arena(std::size_t capacity = 1 << 20);
+
+      /**
+       * @brief The arena for the current frame.
+       */
+      arena& current() noexcept
+      {
+         return *arenas_[frame_ % arenas_.size()];
+      }
+
+      /**
+       * @brief Moves to the next frame, reusing the arena from two frames ago.
+       *
+       * Once `steady_after` frames have passed, the frame that is ending must not have needed
+       * the heap, i.e. steady-state frames must be allocation-free.
+       */
+      void next_frame();
+
+      /**
+       * @brief The number of frames that are allowed to grow the arenas before they are expected
+       *        to be allocation-free. Zero disables the check.
+       */
+      void steady_after(const std::size_t frames) noexcept
+      {
+         steady_after_ = frames;
+      }
+
+      std::size_t frame() const noexcept
+      {
+         return frame_;
+      }
+   private:
+      std::array<std::unique_ptr<arena>, 2> arenas_;
+      std::size_t frame_ = 0;
+      std::size_t steady_after_ = 0;
+   };
+
+   /**
+    * @brief A standard allocator that takes its memory from an arena. Deallocation is a no-op;
+    *        memory is reclaimed when the arena is reset.
+    */
+   template <typename T>
+   class arena_allocator {
+   public:
+      using value_type = T;
+
+      arena_allocator(arena& a) noexcept
+         : arena_{&a}
+      {}
+
+      template <typename U>
+      arena_allocator(const arena_allocator<U>& other) noexcept
+         : arena_{other.arena_}
+      {}
+
+      T* allocate(const std::size_t n)
+      {
+         return static_cast<T*>(arena_->allocate(n * sizeof(T), alignof(T)));
+      }
+
+      void deallocate(T*, std::size_t) noexcept
+      {}
+
+      template <typename U>
+      bool operator==(const arena_allocator<U>& other) const noexcept
+      {
+         return arena_ == other.arena_;
+      }
+
+      template <typename U>
+      bool operator!=(const arena_allocator<U>& other) const noexcept
+      {
+         return not (*this == other);
+      }
+   private:
+      template <typename U>
+      friend class arena_allocator;
+
+      arena* arena_;
+   };
+
+   /**
+    * @brief A vector for transient data, e.g. `arena_vector<glm::mat4>{frames.current()}`,
+    *        where `frames` is a frame_arena. It must not outlive the arena's next reset.
+    */
+   template <typename T>
+   using arena_vector = std::vector<T, arena_allocator<T>>;
+} // namespace doge
+
+#endif // DOGE_UTILITY_FRAME_ARENA_HPP
@@ -0,0 +1,59 @@
+//
+//  Copyright 2018 Christopher Di Bella
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+#ifndef DOGE_UTILITY_HEADLESS_CONTEXT_HPP
+#define DOGE_UTILITY_HEADLESS_CONTEXT_HPP
+
+#include <EGL/egl.h>
+
+namespace doge {
+   /**
+    * @brief An OpenGL 4.3 core context with no window and no default framebuffer, created through
+    *        EGL, so that it needs neither a display server nor GLFW. Render into a `framebuffer`.
+    *
+    * Only built when `DOGE_HEADLESS` is enabled. Programs that use it must be linked with
+    * `link_headless`, whose loader fetches GL functions through EGL; it leaves out X11 entirely.
+    *
+    * A process may hold any number of these, e.g. one per render job, each current on its own
+    * thread. Contexts created with `share` see the same buffers, textures and programs.
+    */
+   class headless_context {
+   public:
+      /**
+       * @param share A context whose objects are shared with the new one, or null.
+       */
+      explicit headless_context(const headless_context* share = nullptr);
+
+      headless_context(const headless_context&) = delete;
+      headless_context& operator=(const headless_context&) = delete;
+
+      ~headless_context() noexcept;
+
+      /**
+       * @brief Makes this context current on the calling thread. It can't be current on any
+       *        other thread at the same time.
+       */
+      void make_current() const;
+
+      /**
+       * @brief Leaves the calling thread with no current context.
+       */
+      static void release_current() noexcept;
+   private:
+      EGLContext context_ = EGL_NO_CONTEXT;
+   };
+} // namespace doge
+
+#endif // DOGE_UTILITY_HEADLESS_CONTEXT_HPP
@@ -0,0 +1,257 @@
+//
+//  Copyright 2018 Christopher Di Bella
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+#ifndef DOGE_UTILITY_JOB_SYSTEM_HPP
+#define DOGE_UTILITY_JOB_SYSTEM_HPP
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <experimental/ranges/concepts>
+#include <experimental/ranges/functional>
+#include <functional>
+#include <gsl/gsl>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace doge {
+   namespace ranges = std::experimental::ranges;
+
+   /**
+    * @brief Counts the jobs that were started with it and haven't finished yet.
+    */
+   class job_counter {
+   public:
+      job_counter() = default;
+      job_counter(const job_counter&) = delete;
+      job_counter& operator=(const job_counter&) = delete;
+
+      bool done() const noexcept
+      {
+         return pending_.load(std::memory_order_acquire) == 0;
+      }
+   private:
+      friend class job_system;
+      std::atomic<std::size_t> pending_ = 0;
+   };
+
+   /**
+    * @brief A work-stealing scheduler with one job deque per worker thread.
+    *
+    * A thread pushes and pops jobs at the back of its own deque, so recently spawned work runs
+    * while its data is still in cache, and idle workers steal the oldest jobs from the front
+    * of the others'. Threads that aren't workers push to a shared deque. Waiting on a counter
+    * runs other jobs rather than blocking, so jobs may wait on the jobs they spawn:
+    *
+    *    auto counter = job_counter{};
+    *    jobs.run([&]{ scene.update(jobs); }, counter);
+    *    jobs.run([&]{ animate(skeletons); }, counter);
+    *    jobs.wait(counter);
+    *
+    * Jobs must not throw.
+    */
+   class job_system {
+   public:
+      /**
+       * @param workers The number of threads to start. The thread that waits on a counter also
+       *        runs jobs, so this defaults to one fewer than the number of cores.
+       * @param pin Whether to pin each worker to its own core, so that the OS doesn't migrate
+       *        them away from their caches. Only supported on Linux.
+       */
+      explicit job_system(std::size_t workers = default_workers(), bool pin = true);
+
+      job_system(const job_system&) = delete;
+      job_system& operator=(const job_system&) = delete;
+
+      ~job_system();
+
+      /**
+       * @brief Queues `f` to run on any thread, counting it with `counter` until it returns.
+       */
+      template <ranges::Invocable F>
+      void run(F f, job_counter& counter)
+      {
+         counter.pending_.fetch_add(1, std::memory_order_relaxed);
+         push(job{std::function<void()>{std::move(f)}, &counter});
+      }
+
+      /**
+       * @brief Runs jobs until every job counted by `counter` has finished.
+       */
+      void wait(const job_counter& counter) noexcept;
+
+      /**
+       * @brief Invokes `f(begin, end)` on consecutive subranges of `[first, last)` of at most
+       *        `grain` elements each, in parallel, and returns once they've all finished.
+       *
+       * The calling thread takes the first subrange, so a range that fits in one grain never
+       * touches the queues.
+       */
+      template <typename F>
+      requires
+         ranges::Invocable<const F&, std::size_t, std::size_t>
+      void parallel_for(const std::size_t first, const std::size_t last, const std::size_t grain,
+         const F& f)
+      {
+         Expects(first <= last);
+         Expects(grain > 0);
+
+         auto counter = job_counter{};
+         for (auto i = first + grain; i < last; i += grain) {
+            const auto end = std::min(last, i + grain);
+            run([&f, i, end]{ ranges::invoke(f, i, end); }, counter);
+         }
+         ranges::invoke(f, first, std::min(last, first + grain));
+         wait(counter);
+      }
+
+      /**
+       * @brief The number of threads that run jobs, including the one that waits.
+       */
+      std::size_t concurrency() const noexcept
+      {
+         return workers_.size() + 1;
+      }
+
+      static std::size_t default_workers() noexcept
+      {
+         const auto cores = std::thread::hardware_concurrency();
+         return cores > 1 ? cores - 1 : 0;
+      }
+   private:
+      struct job {
+         std::function<void()> work;
+         job_counter* counter;
+      };
+
+      struct alignas(64) queue {
+         std::mutex mutex;
+         std::deque<job> jobs;
+      };
+
+      // queues_[i] belongs to worker i, and the last one to every other thread
+      std::vector<std::unique_ptr<queue>> queues_;
+      std::vector<std::thread> workers_;
+
+      std::mutex sleep_mutex_;
+      std::condition_variable wake_;
+      std::atomic<std::size_t> queued_ = 0;
+      std::atomic<bool> stopping_ = false;
+
+      void push(job j);
+      bool run_one(std::size_t self) noexcept;
+      void work(std::size_t self) noexcept;
+      std::size_t own_queue() const noexcept;
+   };
+
+   /**
+    * @brief Jobs with dependencies between them, which can be run on a job_system any number of
+    *        times, e.g. once per frame.
+    *
+    *    auto frame = job_graph{};
+    *    const auto transforms = frame.add([&]{ scene.update(jobs); });
+    *    const auto culling = frame.add([&]{ cull(frustum, scene.world_bounds(), visible, jobs); });
+    *    const auto animation = frame.add([&]{ animate(skeletons); });
+    *    frame.precede(transforms, culling);
+    *    ...
+    *    frame.run(jobs);
+    */
+   class job_graph {
+   public:
+      using node_id = std::size_t;
+
+      template <ranges::Invocable F>
+      node_id add(F f)
+      {
+         nodes_.emplace_back(std::function<void()>{std::move(f)});
+         return nodes_.size() - 1;
+      }
+
+      /**
+       * @brief Makes `after` wait for `before` to finish. The graph must stay acyclic.
+       */
+      void precede(node_id before, node_id after);
+
+      /**
+       * @brief Runs every job once, in an order that respects the dependencies, and returns once
+       *        they've all finished.
+       */
+      void run(job_system& jobs);
+
+      std::size_t size() const noexcept
+      {
+         return nodes_.size();
+      }
+   private:
+      struct node {
+         explicit node(std::function<void()> f)
+            : work{std::move(f)}
+         {}
+
+         std::function<void()> work;
+         std::vector<node_id> successors;
+         std::size_t predecessors = 0;
+         std::atomic<std::size_t> remaining = 0;
+      };
+
+      // a deque, because the nodes hold atomics and can't be moved
+      std::deque<node> nodes_;
+
+      void start(job_system& jobs, job_counter& counter, node_id n);
+   };
+
+   namespace detail {
+      /**
+       * @brief Runs `chunk(i)` for each `i` in `[0, chunks)`, each but the first on a thread of
+       *        its own, and the first on the calling thread.
+       */
+      struct on_threads {
+         template <typename F>
+         void operator()(const std::size_t chunks, const F& chunk) const
+         {
+            auto workers = std::vector<std::thread>{};
+            workers.reserve(chunks - 1);
+            for (auto i = std::size_t{1}; i != chunks; ++i)
+               workers.emplace_back(chunk, i);
+            chunk(0);
+            for (auto& i : workers)
+               i.join();
+         }
+      };
+
+      /**
+       * @brief Runs `chunk(i)` for each `i` in `[0, chunks)` as jobs on `jobs`.
+       */
+      struct on_jobs {
+         job_system& jobs;
+
+         template <typename F>
+         void operator()(const std::size_t chunks, const F& chunk) const
+         {
+            const auto run = [&chunk](const std::size_t first, const std::size_t last) {
+               for (auto i = first; i != last; ++i)
+                  chunk(i);
+            };
+            jobs.parallel_for(0, chunks, 1, run);
+         }
+      };
+   } // namespace detail
+} // namespace doge
+
+#endif // DOGE_UTILITY_JOB_SYSTEM_HPP
@@ -0,0 +1,177 @@
+//
+//  Copyright 2018 Christopher Di Bella
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+#ifndef DOGE_UTILITY_PROFILER_HPP
+#define DOGE_UTILITY_PROFILER_HPP
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <gl/gl_core.hpp>
+#include <iosfwd>
+#include <string_view>
+#include <vector>
+
+namespace doge {
+   /**
+    * @brief Per-scope timings, aggregated over the frames that the profiler still remembers.
+    *
+    * GPU timings are only aggregated for the frames whose queries were ready when they were read
+    * back, so `gpu_samples` may be less than `cpu_samples`.
+    */
+   struct scope_statistics {
+      struct timing {
+         std::chrono::nanoseconds min{};
+         std::chrono::nanoseconds average{};
+         std::chrono::nanoseconds p99{};
+      };
+
+      timing cpu;
+      timing gpu;
+      std::size_t cpu_samples = 0;
+      std::size_t gpu_samples = 0;
+   };
+
+   /**
+    * @brief Records CPU and GPU time spent in named scopes, one frame at a time.
+    *
+    * CPU time is measured with `std::chrono::steady_clock`, and GPU time with `gl::TIMESTAMP`
+    * queries. Queries are read back `frame_latency` frames after they're issued, and a frame
+    * whose queries still aren't ready is published without GPU timings, so the profiler never
+    * waits on the GPU.
+    *
+    * Finished frames are published to a ring of the last `history` frames. Only the thread that
+    * owns the GL context may begin frames and scopes, but `statistics` and `export_chrome_trace`
+    * are lock-free and may be called from any thread.
+    *
+    *    profiler.begin_frame();
+    *    {
+    *       auto s = profiler.scope("shadows");
+    *       // ... draw ...
+    *    }
+    *    profiler.end_frame();
+    */
+   class profiler {
+   public:
+      static constexpr std::size_t frame_latency = 3;
+      static constexpr std::size_t history = 256;
+      static constexpr std::size_t max_scopes = 64;
+
+      class scoped_marker {
+      public:
+         scoped_marker(const scoped_marker&) = delete;
+         scoped_marker& operator=(const scoped_marker&) = delete;
+
+         ~scoped_marker() noexcept
+         {
+            profiler_.end_scope(index_);
+         }
+      private:
+         friend class profiler;
+
+         scoped_marker(profiler& p, const std::size_t index) noexcept
+            : profiler_{p},
+              index_{index}
+         {}
+
+         profiler& profiler_;
+         std::size_t index_;
+      };
+
+      profiler();
+
+      profiler(const profiler&) = delete;
+      profiler& operator=(const profiler&) = delete;
+
+      ~profiler() noexcept;
+
+      /**
+       * @brief Starts recording a new frame, and publishes the frame whose queries are now
+       *        `frame_latency` frames old.
+       */
+      void begin_frame();
+
+      void end_frame() noexcept;
+
+      /**
+       * @brief Times everything until the returned marker is destroyed.
+       *
+       * `name` must outlive the profiler: a string literal is expected. Scopes beyond the first
+       * `max_scopes` in a frame aren't recorded.
+       */
+      [[nodiscard]] scoped_marker scope(std::string_view name) noexcept;
+
+      scope_statistics statistics(std::string_view name) const;
+
+      /**
+       * @brief Writes the remembered frames in the Chrome trace event format (load it using
+       *        chrome://tracing). CPU scopes are on thread 0, and GPU scopes are on thread 1.
+       */
+      void export_chrome_trace(std::ostream& out) const;
+
+      /**
+       * @brief The number of frames published so far.
+       */
+      std::uint64_t frames() const noexcept
+      {
+         return published_.load(std::memory_order_acquire);
+      }
+   private:
+      // all times are relative to epoch_ (or gpu_epoch_), in nanoseconds
+      struct scope_record {
+         std::string_view name;
+         std::int64_t cpu_begin = 0;
+         std::int64_t cpu_end = 0;
+         std::int64_t gpu_begin = -1;
+         std::int64_t gpu_end = -1;
+      };
+
+      struct frame_record {
+         std::uint64_t frame = 0;
+         std::size_t count = 0;
+         std::array<scope_record, max_scopes> scopes;
+      };
+
+      struct published_frame {
+         std::atomic<std::uint64_t> sequence{0};
+         frame_record record;
+      };
+
+      struct pending_frame {
+         frame_record record;
+         std::array<GLuint, 2 * max_scopes> queries{};
+         GLuint last_query = 0;
+         bool unpublished = false;
+      };
+
+      std::chrono::steady_clock::time_point epoch_ = std::chrono::steady_clock::now();
+      std::int64_t gpu_epoch_ = 0;
+      std::uint64_t frame_ = 0;
+      std::array<pending_frame, frame_latency + 1> pending_;
+      std::vector<published_frame> ring_;
+      std::atomic<std::uint64_t> published_{0};
+
+      void end_scope(std::size_t index) noexcept;
+      void publish(pending_frame& frame);
+      std::int64_t now() const noexcept;
+
+      template <typename F>
+      void for_each_frame(F f) const;
+   };
+} // namespace doge
+
+#endif // DOGE_UTILITY_PROFILER_HPP
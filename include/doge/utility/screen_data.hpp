@@ -16,6 +16,8 @@
 #ifndef DOGE_UTILITY_SCREEN_DATA_HPP
 #define DOGE_UTILITY_SCREEN_DATA_HPP
 
+#include <doge/gl/state_cache.hpp>
+#include <doge/gl/upload_context.hpp>
 #include <gl/gl_core.hpp>
 #include <GLFW/glfw3.h>
 #include <gsl/gsl>
@@ -24,7 +26,12 @@
 namespace doge {
    class screen_data {
    public:
-      enum class backend_t { gl, vulkan };
+      /**
+       * @brief `headless` creates the same context as `gl`, but in a window that is never shown,
+       *        so its default framebuffer can't be relied upon; render into a `framebuffer`
+       *        instead. On machines with no display server at all, use `headless_context`.
+       */
+      enum class backend_t { gl, vulkan, headless };
 
       screen_data() = default;
 
@@ -74,9 +81,33 @@ namespace doge {
 
       void make_window()
       {
+         upload_.reset();
+         upload_window_.reset();
          window_ = make_window_impl();
       }
 
+      /**
+       * @brief A thread whose context shares objects with the window's, created on first use.
+       *        Must first be called from the thread that created the window.
+       */
+      upload_context& uploads()
+      {
+         if (not upload_) {
+            Expects(backend_ != backend_t::vulkan);
+
+            // the window's hints are still set, so the contexts match, as sharing requires
+            glfwWindowHint(GLFW_VISIBLE, false);
+            upload_window_.reset(glfwCreateWindow(1, 1, "doge uploads", nullptr, window()));
+            if (not upload_window_)
+               throw std::runtime_error{"Could not create a shared context with glfw3."};
+
+            upload_ = std::make_unique<upload_context>(
+               [w = upload_window_.get()]{ glfwMakeContextCurrent(w); },
+               []{ glfwMakeContextCurrent(nullptr); });
+         }
+         return *upload_;
+      }
+
       bool open() noexcept
       {
          return not glfwWindowShouldClose(window());
@@ -112,6 +143,11 @@ namespace doge {
       const GLFWvidmode* vidmode_ = glfwGetVideoMode(monitor_.get());
       std::unique_ptr<GLFWwindow, void(*)(GLFWwindow*)> window_ = make_window_impl();
 
+      // the upload thread is stopped before the contexts it shares are destroyed
+      std::unique_ptr<GLFWwindow, void(*)(GLFWwindow*)> upload_window_ = {nullptr,
+         [](GLFWwindow* p){ if (p) glfwDestroyWindow(p); }};
+      std::unique_ptr<upload_context> upload_;
+
       float set_aspect_ratio() const noexcept
       {
          return gsl::narrow_cast<float>(width_) / gsl::narrow_cast<float>(height_);
@@ -119,27 +155,38 @@ namespace doge {
 
       std::unique_ptr<GLFWwindow, void(*)(GLFWwindow*)> make_window_impl()
       {
-         if (backend_ == backend_t::gl) {
+         const auto headless = backend_ == backend_t::headless;
+         if (backend_ == backend_t::gl or headless) {
             glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 4);
             glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 3);
             glfwWindowHint(GLFW_OPENGL_FORWARD_COMPAT, true);
             glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
-            glfwWindowHint(GLFW_SAMPLES, antialiasing_);
+            glfwWindowHint(GLFW_SAMPLES, headless ? 0 : antialiasing_);
+#if defined(DOGE_GL_TRACE)
+            // so that drivers report performance warnings through KHR_debug
+            glfwWindowHint(GLFW_OPENGL_DEBUG_CONTEXT, true);
+#endif // DOGE_GL_TRACE
          }
+         glfwWindowHint(GLFW_VISIBLE, not headless);
 
+         const auto monitor = fullscreen_ and not headless ? monitor_.get() : nullptr;
          auto w = std::unique_ptr<GLFWwindow, void(*)(GLFWwindow*)>{
-            glfwCreateWindow(width_, height_, "doge", fullscreen_ ? monitor_.get() : nullptr, nullptr),
+            glfwCreateWindow(width_, height_, "doge", monitor, nullptr),
             [](GLFWwindow* p){ if (p) glfwDestroyWindow(p); }};
-         glfwMakeContextCurrent(window_.get());
-         glfwSetFramebufferSizeCallback(window_.get(), screen_data::framebuffer_size_callback);
-         if (auto gl_load_gen = gl::sys::LoadFunctions(); not (window_ || gl_load_gen))
+         if (not w)
             throw std::runtime_error{"Could not open window with glfw3."};
+
+         glfwMakeContextCurrent(w.get());
+         context_changed();
+         glfwSetFramebufferSizeCallback(w.get(), screen_data::framebuffer_size_callback);
+         if (not gl::sys::LoadFunctions())
+            throw std::runtime_error{"Could not load OpenGL functions."};
          return w;
       }
 
       static void framebuffer_size_callback(GLFWwindow*, const int width, const int height) noexcept
       {
-         gl::Viewport(0, 0, width, height);
+         gl_state().viewport(0, 0, width, height);
       }
    };
 }
@@ -0,0 +1,87 @@
+//
+//  Copyright 2018 Christopher Di Bella
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+#ifndef DOGE_UTILITY_SPSC_QUEUE_HPP
+#define DOGE_UTILITY_SPSC_QUEUE_HPP
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <optional>
+#include <type_traits>
+
+namespace doge {
+   /**
+    * @brief A fixed-capacity, lock-free queue for exactly one producer thread and one consumer
+    *        thread.
+    *
+    * Neither `try_push` nor `try_pop` allocate or block, so the producer may be a callback that
+    * must return quickly.
+    */
+   template <typename T, std::size_t Capacity>
+   requires
+      std::is_trivially_copyable_v<T> && (Capacity > 1) && ((Capacity & (Capacity - 1)) == 0)
+   class spsc_queue {
+   public:
+      static constexpr std::size_t capacity = Capacity;
+
+      /**
+       * @brief Appends `value`. Only call from the producer thread.
+       * @returns false if the queue is full, in which case `value` is discarded.
+       */
+      bool try_push(const T& value) noexcept
+      {
+         const auto tail = tail_.load(std::memory_order_relaxed);
+         if (tail - head_.load(std::memory_order_acquire) == capacity)
+            return false;
+
+         buffer_[tail & mask] = value;
+         tail_.store(tail + 1, std::memory_order_release);
+         return true;
+      }
+
+      /**
+       * @brief Removes the oldest value. Only call from the consumer thread.
+       */
+      std::optional<T> try_pop() noexcept
+      {
+         const auto head = head_.load(std::memory_order_relaxed);
+         if (head == tail_.load(std::memory_order_acquire))
+            return std::nullopt;
+
+         const auto value = buffer_[head & mask];
+         head_.store(head + 1, std::memory_order_release);
+         return value;
+      }
+
+      /**
+       * @brief An estimate of the number of queued values; exact only on the consumer thread
+       *        while the producer is idle.
+       */
+      std::size_t size() const noexcept
+      {
+         return tail_.load(std::memory_order_acquire) - head_.load(std::memory_order_acquire);
+      }
+   private:
+      static constexpr std::size_t mask = capacity - 1;
+
+      // the indices only ever grow, and are wrapped when the buffer is indexed
+      alignas(64) std::atomic<std::size_t> head_ = 0;
+      alignas(64) std::atomic<std::size_t> tail_ = 0;
+      alignas(64) std::array<T, capacity> buffer_;
+   };
+} // namespace doge
+
+#endif // DOGE_UTILITY_SPSC_QUEUE_HPP
@@ -35,7 +35,7 @@ namespace doge {
    namespace detail {
       template <GLenum Kind>
       constexpr bool is_texture_type_v = Kind == gl::TEXTURE_1D || Kind == gl::TEXTURE_2D ||
-         Kind == gl::TEXTURE_3D;
+         Kind == gl::TEXTURE_3D || Kind == gl::TEXTURE_1D_ARRAY || Kind == gl::TEXTURE_2D_ARRAY;
 
       template <glm::length_t I, typename T, glm::qualifier Q>
       constexpr bool is_glm_vec(const glm::vec<I, T, Q>&) noexcept
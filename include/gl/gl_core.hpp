@@ -174,9 +174,26 @@ namespace gl
 			int m_numMissing;
 		};
 		
+		extern LoadTest var_ARB_bindless_texture;
+		extern LoadTest var_ARB_buffer_storage;
+		extern LoadTest var_KHR_parallel_shader_compile;
+		
 	} //namespace exts
 	enum
 	{
+		UNSIGNED_INT64_ARB               = 0x140F,
+		
+		BUFFER_IMMUTABLE_STORAGE         = 0x821F,
+		BUFFER_STORAGE_FLAGS             = 0x8220,
+		CLIENT_MAPPED_BUFFER_BARRIER_BIT = 0x00004000,
+		CLIENT_STORAGE_BIT               = 0x0200,
+		DYNAMIC_STORAGE_BIT              = 0x0100,
+		MAP_COHERENT_BIT                 = 0x0080,
+		MAP_PERSISTENT_BIT               = 0x0040,
+		
+		COMPLETION_STATUS_KHR            = 0x91B1,
+		MAX_SHADER_COMPILER_THREADS_KHR  = 0x91B0,
+		
 		ALPHA                            = 0x1906,
 		ALWAYS                           = 0x0207,
 		AND                              = 0x1501,
@@ -1496,6 +1513,32 @@ namespace gl
 		VIEW_COMPATIBILITY_CLASS         = 0x82B6,
 		
 	};
+	
+	namespace _detail
+	{
+	} //namespace _detail
+	
+	extern GLuint64 (CODEGEN_FUNCPTR *GetTextureHandleARB)(GLuint texture);
+	extern GLuint64 (CODEGEN_FUNCPTR *GetTextureSamplerHandleARB)(GLuint texture, GLuint sampler);
+	extern void (CODEGEN_FUNCPTR *MakeTextureHandleResidentARB)(GLuint64 handle);
+	extern void (CODEGEN_FUNCPTR *MakeTextureHandleNonResidentARB)(GLuint64 handle);
+	extern GLuint64 (CODEGEN_FUNCPTR *GetImageHandleARB)(GLuint texture, GLint level, GLboolean layered, GLint layer, GLenum format);
+	extern void (CODEGEN_FUNCPTR *MakeImageHandleResidentARB)(GLuint64 handle, GLenum access);
+	extern void (CODEGEN_FUNCPTR *MakeImageHandleNonResidentARB)(GLuint64 handle);
+	extern void (CODEGEN_FUNCPTR *UniformHandleui64ARB)(GLint location, GLuint64 value);
+	extern void (CODEGEN_FUNCPTR *UniformHandleui64vARB)(GLint location, GLsizei count, const GLuint64 * value);
+	extern void (CODEGEN_FUNCPTR *ProgramUniformHandleui64ARB)(GLuint program, GLint location, GLuint64 value);
+	extern void (CODEGEN_FUNCPTR *ProgramUniformHandleui64vARB)(GLuint program, GLint location, GLsizei count, const GLuint64 * values);
+	extern GLboolean (CODEGEN_FUNCPTR *IsTextureHandleResidentARB)(GLuint64 handle);
+	extern GLboolean (CODEGEN_FUNCPTR *IsImageHandleResidentARB)(GLuint64 handle);
+	extern void (CODEGEN_FUNCPTR *VertexAttribL1ui64ARB)(GLuint index, GLuint64EXT x);
+	extern void (CODEGEN_FUNCPTR *VertexAttribL1ui64vARB)(GLuint index, const GLuint64EXT * v);
+	extern void (CODEGEN_FUNCPTR *GetVertexAttribLui64vARB)(GLuint index, GLenum pname, GLuint64EXT * params);
+	
+	extern void (CODEGEN_FUNCPTR *BufferStorage)(GLenum target, GLsizeiptr size, const void * data, GLbitfield flags);
+	
+	extern void (CODEGEN_FUNCPTR *MaxShaderCompilerThreadsKHR)(GLuint count);
+	
 	extern void (CODEGEN_FUNCPTR *BlendFunc)(GLenum sfactor, GLenum dfactor);
 	extern void (CODEGEN_FUNCPTR *Clear)(GLbitfield mask);
 	extern void (CODEGEN_FUNCPTR *ClearColor)(GLfloat red, GLfloat green, GLfloat blue, GLfloat alpha);
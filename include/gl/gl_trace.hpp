@@ -0,0 +1,74 @@
+//
+//  Copyright 2018 Christopher Di Bella
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+#ifndef DOGE_GL_TRACE_HPP
+#define DOGE_GL_TRACE_HPP
+
+#if defined(DOGE_GL_TRACE)
+
+#include <cstdint>
+#include <gl/gl_core.hpp>
+
+namespace gl::trace {
+   /**
+    * @brief What the tracing layer counts. Each call through a hooked function adds one to its
+    *        counter, except for uploads, which add the number of bytes that they send.
+    *
+    * Only bytes passed to a call are seen, so writes through a mapped buffer aren't counted,
+    * whether it's a stream_buffer or a pixel unpack buffer; the TexSubImage that reads the
+    * latter is.
+    */
+   enum class counter : int {
+      draw_calls,           // DrawArrays, DrawElements and their instanced and indirect forms
+      dispatches,           // DispatchCompute and DispatchComputeIndirect
+      state_changes,        // binds, Enable/Disable, blend, depth, cull, mask, viewport, scissor
+      program_changes,      // UseProgram and BindProgramPipeline
+      buffer_call_bytes,    // BufferData and BufferStorage with data, and BufferSubData
+      texture_call_bytes,   // TexImage and TexSubImage with data, and their compressed forms
+      performance_warnings, // KHR_debug messages of DEBUG_TYPE_PERFORMANCE
+      errors,               // KHR_debug messages of DEBUG_TYPE_ERROR
+      count
+   };
+
+   /**
+    * @brief Passed every KHR_debug message above DEBUG_SEVERITY_NOTIFICATION. Messages are
+    *        synchronous, so a breakpoint in the handler stops at the call that caused them.
+    */
+   using message_handler = void (*)(GLenum source, GLenum type, GLenum severity,
+      const char* message);
+
+   /**
+    * @brief Swaps the hooked function pointers for ones that count calls before forwarding them,
+    *        and installs the KHR_debug callback. `sys::LoadFunctions` calls this, so only the
+    *        pointers of the context that was current then are traced.
+    */
+   void install();
+
+   /**
+    * @brief Returns a counter's value, and zeroes it. Counters are shared by every thread that
+    *        makes GL calls, including the upload context's.
+    */
+   std::uint64_t exchange(counter c) noexcept;
+
+   /**
+    * @brief Replaces the handler of KHR_debug messages; the default writes them to stderr. A null
+    *        handler keeps counting messages without reporting them.
+    */
+   void set_message_handler(message_handler handler) noexcept;
+} // namespace gl::trace
+
+#endif // DOGE_GL_TRACE
+
+#endif // DOGE_GL_TRACE_HPP
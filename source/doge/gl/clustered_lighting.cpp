@@ -0,0 +1,175 @@
+//
+//  Copyright 2018 Christopher Di Bella
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+#include <algorithm>
+#include <cmath>
+#include <doge/gl/clustered_lighting.hpp>
+#include <glm/common.hpp>
+#include <glm/geometric.hpp>
+#include <glm/gtc/type_ptr.hpp>
+#include <glm/matrix.hpp>
+#include <glm/vec3.hpp>
+#include <limits>
+#include <string>
+
+namespace doge {
+   namespace {
+      shader_defines cluster_defines(const cluster_grid& grid, const GLuint first_binding)
+      {
+         return {
+            {"DOGE_CLUSTER_X", std::to_string(grid.x) + "u"},
+            {"DOGE_CLUSTER_Y", std::to_string(grid.y) + "u"},
+            {"DOGE_CLUSTER_Z", std::to_string(grid.z) + "u"},
+            {"DOGE_CLUSTER_COUNT", std::to_string(grid.size()) + "u"},
+            {"DOGE_CLUSTER_CAPACITY", std::to_string(grid.capacity) + "u"},
+            {"DOGE_LIGHT_BINDING", std::to_string(first_binding)},
+            {"DOGE_CLUSTER_BOUNDS_BINDING", std::to_string(first_binding + 1)},
+            {"DOGE_CLUSTER_LISTS_BINDING", std::to_string(first_binding + 2)},
+            {"DOGE_CLUSTER_PARAMETERS_BINDING", std::to_string(first_binding + 3)}};
+      }
+
+      // a point light's cone covers every direction: the dot product is never below the inner
+      // cosine of -1, and the outer cosine of -2 keeps the smoothstep's edges apart
+      detail::packed_light pack(const point_light& light) noexcept
+      {
+         return {glm::vec4{light.position, light.range},
+            glm::vec4{light.colour, light.intensity}, glm::vec4{0.0f, 0.0f, -1.0f, -2.0f},
+            glm::vec4{-1.0f, 0.0f, 0.0f, 0.0f}};
+      }
+
+      detail::packed_light pack(const spotlight& light) noexcept
+      {
+         return {glm::vec4{light.position, light.range},
+            glm::vec4{light.colour, light.intensity},
+            glm::vec4{glm::normalize(light.direction), std::cos(light.outer_cone)},
+            glm::vec4{std::cos(light.inner_cone), 0.0f, 0.0f, 0.0f}};
+      }
+   } // namespace <anonymous>
+
+   clustered_lighting::clustered_lighting(const std::size_t max_lights, shader_cache& cache,
+      const cluster_grid& grid, const GLuint first_binding, const std::string& path)
+      : max_lights_{max_lights},
+        grid_{grid},
+        first_binding_{first_binding},
+        defines_{cluster_defines(grid, first_binding)},
+        binning_{path, cache, defines_},
+        light_table_{max_lights},
+        bounds_{2 * static_cast<std::size_t>(grid.size())},
+        lists_{static_cast<std::size_t>(grid.size()) * (1 + grid.capacity)},
+        parameters_{1}
+   {
+      Expects(max_lights > 0);
+      Expects(grid.size() > 0);
+      Expects(grid.capacity > 0);
+      lights_.reserve(max_lights);
+   }
+
+   void clustered_lighting::project(const glm::mat4& projection, const float near_plane,
+      const float far_plane, const GLsizei width, const GLsizei height)
+   {
+      Expects(0.0f < near_plane and near_plane < far_plane);
+      Expects(width > 0 and height > 0);
+
+      // a point on the near plane, in view space, for each corner of each tile
+      const auto inverse = glm::inverse(projection);
+      const auto unproject = [&inverse](const float x, const float y) noexcept {
+         const auto p = inverse * glm::vec4{x, y, -1.0f, 1.0f};
+         return glm::vec3{p} / p.w;
+      };
+
+      const auto ratio = far_plane / near_plane;
+      auto bounds = std::vector<glm::vec4>(2 * static_cast<std::size_t>(grid_.size()));
+      for (auto z = GLuint{0}; z < grid_.z; ++z) {
+         // slices are spaced exponentially, so that clusters stay roughly cubic with depth
+         const auto slice_near = near_plane * std::pow(ratio, static_cast<float>(z) / grid_.z);
+         const auto slice_far = near_plane * std::pow(ratio, static_cast<float>(z + 1) / grid_.z);
+
+         for (auto y = GLuint{0}; y < grid_.y; ++y) {
+            const auto bottom = -1.0f + 2.0f * y / grid_.y;
+            const auto top = -1.0f + 2.0f * (y + 1) / grid_.y;
+
+            for (auto x = GLuint{0}; x < grid_.x; ++x) {
+               const auto left = -1.0f + 2.0f * x / grid_.x;
+               const auto right = -1.0f + 2.0f * (x + 1) / grid_.x;
+
+               auto lo = glm::vec3{std::numeric_limits<float>::max()};
+               auto hi = glm::vec3{std::numeric_limits<float>::lowest()};
+               for (const auto& corner : {unproject(left, bottom), unproject(right, bottom),
+                  unproject(left, top), unproject(right, top)})
+               {
+                  // the view looks down -z, so a point at depth d is the corner scaled to z = -d
+                  for (const auto depth : {slice_near, slice_far}) {
+                     const auto p = corner * (depth / -corner.z);
+                     lo = glm::min(lo, p);
+                     hi = glm::max(hi, p);
+                  }
+               }
+
+               const auto i = x + grid_.x * (y + grid_.y * z);
+               bounds[2 * i] = glm::vec4{lo, 0.0f};
+               bounds[2 * i + 1] = glm::vec4{hi, 0.0f};
+            }
+         }
+      }
+      bounds_.write(bounds);
+
+      const auto log_ratio = std::log(ratio);
+      const auto parameters = detail::cluster_parameters{
+         glm::vec4{static_cast<float>(width) / grid_.x, static_cast<float>(height) / grid_.y,
+            0.0f, 0.0f},
+         glm::vec4{grid_.z / log_ratio, -(grid_.z * std::log(near_plane)) / log_ratio, 0.0f,
+            0.0f}};
+      parameters_.write(gsl::span<const detail::cluster_parameters>{&parameters, 1});
+   }
+
+   void clustered_lighting::write(const gsl::span<const point_light> points,
+      const gsl::span<const spotlight> spots)
+   {
+      Expects(static_cast<std::size_t>(points.size() + spots.size()) <= max_lights_);
+
+      lights_.clear();
+      for (const auto& i : points)
+         lights_.push_back(pack(i));
+      for (const auto& i : spots)
+         lights_.push_back(pack(i));
+
+      if (not lights_.empty())
+         light_table_.write(lights_);
+   }
+
+   void clustered_lighting::bin(const glm::mat4& view)
+   {
+      const auto& program = binning_.program();
+      binning_.use([&]{
+         gl::UniformMatrix4fv(program.uniform_location("view"), 1, false, glm::value_ptr(view));
+         gl::Uniform1ui(program.uniform_location("light_count"),
+            gsl::narrow_cast<GLuint>(lights_.size()));
+      });
+
+      light_table_.bind(first_binding_);
+      bounds_.bind(first_binding_ + 1);
+      lists_.bind(first_binding_ + 2);
+      parameters_.bind(first_binding_ + 3);
+      binning_.dispatch(binning_.groups_for(grid_.size()));
+      memory_barrier(gl::SHADER_STORAGE_BARRIER_BIT);
+   }
+
+   void clustered_lighting::bind() const noexcept
+   {
+      light_table_.bind(first_binding_);
+      lists_.bind(first_binding_ + 2);
+      parameters_.bind(first_binding_ + 3);
+   }
+} // namespace doge
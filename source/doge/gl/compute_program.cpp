@@ -0,0 +1,61 @@
+//
+//  Copyright 2018 Christopher Di Bella
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+#include <doge/gl/compute_program.hpp>
+
+namespace doge {
+   namespace {
+      std::vector<std::pair<shader_source::type, std::string>> compute_stage(const std::string& path)
+      {
+         return {{shader_source::compute, path}};
+      }
+   } // namespace <anonymous>
+
+   compute_program::compute_program(const std::string& path)
+      : program_{compute_stage(path)}
+   {
+      reflect_work_group_size();
+   }
+
+   compute_program::compute_program(const std::string& path, shader_cache& cache,
+      const shader_defines& defines)
+      : program_{compute_stage(path), cache, defines}
+   {
+      reflect_work_group_size();
+   }
+
+   void compute_program::dispatch(const GLuint x, const GLuint y, const GLuint z) const
+   {
+      Expects(x > 0 and y > 0 and z > 0);
+      program_.use([x, y, z]{ gl::DispatchCompute(x, y, z); });
+   }
+
+   void compute_program::dispatch_indirect(
+      const storage_buffer<dispatch_indirect_command>& commands, const std::size_t command) const
+   {
+      Expects(command < commands.size());
+      program_.use([&]{
+         gl_state().bind_buffer(gl::DISPATCH_INDIRECT_BUFFER, static_cast<GLuint>(commands));
+         gl::DispatchComputeIndirect(
+            gsl::narrow_cast<GLintptr>(command * sizeof(dispatch_indirect_command)));
+      });
+   }
+
+   void compute_program::reflect_work_group_size() noexcept
+   {
+      gl::GetProgramiv(static_cast<GLuint>(program_), gl::COMPUTE_WORK_GROUP_SIZE,
+         work_group_size_.data());
+   }
+} // namespace doge
@@ -0,0 +1,426 @@
+//
+//  Copyright 2018 Christopher Di Bella
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+#include <algorithm>
+#include <array>
+#include <cctype>
+#include <cstdlib>
+#include <cstring>
+#include <doge/gl/cooked_mesh.hpp>
+#include <glm/geometric.hpp>
+#include <limits>
+#include <stdexcept>
+#include <unordered_map>
+
+namespace doge {
+   namespace {
+      constexpr auto mesh_magic = std::array<char, 4>{'D', 'M', 'S', 'H'};
+      constexpr std::uint32_t mesh_version = 1;
+
+      // blobs start on this boundary, so that they can be used straight from the mapped file
+      constexpr std::size_t blob_alignment = 16;
+
+      struct mesh_header {
+         std::array<char, 4> magic;
+         std::uint32_t version;
+         std::uint32_t attribute_count;
+         std::uint32_t stride;
+         std::uint32_t vertex_count;
+         std::uint32_t index_count;
+         std::uint32_t index_type;
+         std::uint32_t lod_count;
+         std::array<float, 3> min;
+         std::array<float, 3> max;
+         std::array<float, 4> sphere;
+         std::uint64_t vertex_offset;
+         std::uint64_t index_offset;
+      };
+      static_assert(sizeof(mesh_header) == 88);
+
+      constexpr std::size_t round_up(const std::size_t n, const std::size_t alignment) noexcept
+      {
+         return (n + alignment - 1) / alignment * alignment;
+      }
+
+      template <typename T>
+      requires
+         std::is_trivially_copyable_v<T>
+      void append(std::vector<std::byte>& bytes, const T* const first, const std::size_t count)
+      {
+         const auto p = reinterpret_cast<const std::byte*>(first);
+         bytes.insert(bytes.end(), p, p + count * sizeof(T));
+      }
+
+      constexpr std::size_t index_size(const GLenum type) noexcept
+      {
+         return type == gl::UNSIGNED_SHORT ? sizeof(GLushort) : sizeof(GLuint);
+      }
+
+      constexpr std::size_t component_size(const GLenum type) noexcept
+      {
+         switch (type) {
+         case gl::BYTE:
+         case gl::UNSIGNED_BYTE:
+            return 1;
+         case gl::SHORT:
+         case gl::UNSIGNED_SHORT:
+         case gl::HALF_FLOAT:
+            return 2;
+         default:
+            return 4;
+         }
+      }
+
+      struct obj_corner {
+         int position;
+         int uv;
+         int normal;
+
+         bool operator==(const obj_corner& other) const noexcept
+         {
+            return position == other.position and uv == other.uv and normal == other.normal;
+         }
+      };
+
+      struct obj_corner_hash {
+         std::size_t operator()(const obj_corner& c) const noexcept
+         {
+            auto result = static_cast<std::size_t>(c.position);
+            result = result * 1'000'003 ^ static_cast<std::size_t>(c.uv);
+            return result * 1'000'003 ^ static_cast<std::size_t>(c.normal);
+         }
+      };
+   } // namespace <anonymous>
+
+   glm::vec3 mesh_data::position(const std::size_t vertex) const noexcept
+   {
+      Expects(vertex < vertex_count());
+      auto result = glm::vec3{};
+      std::memcpy(&result, vertices.data() + vertex * stride, sizeof(result));
+      return result;
+   }
+
+   void mesh_data::compute_bounds() noexcept
+   {
+      const auto count = vertex_count();
+      if (count == 0)
+         return;
+
+      min = max = position(0);
+      for (auto i = std::size_t{1}; i < count; ++i) {
+         const auto p = position(i);
+         min = glm::min(min, p);
+         max = glm::max(max, p);
+      }
+
+      const auto centre = (min + max) * 0.5f;
+      auto radius = 0.0f;
+      for (auto i = std::size_t{0}; i < count; ++i)
+         radius = std::max(radius, glm::distance(centre, position(i)));
+      sphere = glm::vec4{centre, radius};
+   }
+
+   void mesh_data::save(const std::string& path) const
+   {
+      Expects(not attributes.empty() and stride > 0);
+      Expects(vertices.size() % stride == 0);
+
+      const auto whole = std::array<mesh_lod, 1>{
+         mesh_lod{0, gsl::narrow_cast<std::uint32_t>(indices.size()), 0.0f, 0}};
+      const auto table = lods.empty() ? gsl::span<const mesh_lod>{whole}
+                                      : gsl::span<const mesh_lod>{lods};
+
+      auto header = mesh_header{};
+      header.magic = mesh_magic;
+      header.version = mesh_version;
+      header.attribute_count = gsl::narrow_cast<std::uint32_t>(attributes.size());
+      header.stride = stride;
+      header.vertex_count = gsl::narrow_cast<std::uint32_t>(vertex_count());
+      header.index_count = gsl::narrow_cast<std::uint32_t>(indices.size());
+      // 16-bit indices halve the index bandwidth whenever every vertex can be addressed by one
+      const auto narrow = vertex_count() <= std::numeric_limits<GLushort>::max() + std::size_t{1};
+      header.index_type = narrow ? gl::UNSIGNED_SHORT : gl::UNSIGNED_INT;
+      header.lod_count = gsl::narrow_cast<std::uint32_t>(table.size());
+      header.min = {min.x, min.y, min.z};
+      header.max = {max.x, max.y, max.z};
+      header.sphere = {sphere.x, sphere.y, sphere.z, sphere.w};
+
+      const auto tables = sizeof(header) + attributes.size() * sizeof(mesh_attribute)
+         + table.size() * sizeof(mesh_lod);
+      header.vertex_offset = round_up(tables, blob_alignment);
+      header.index_offset = round_up(header.vertex_offset + vertices.size(), blob_alignment);
+
+      auto bytes = std::vector<std::byte>{};
+      bytes.reserve(header.index_offset + indices.size() * index_size(header.index_type));
+      append(bytes, &header, 1);
+      append(bytes, attributes.data(), attributes.size());
+      append(bytes, table.data(), static_cast<std::size_t>(table.size()));
+      bytes.resize(header.vertex_offset);
+      append(bytes, vertices.data(), vertices.size());
+      bytes.resize(header.index_offset);
+      if (narrow) {
+         auto shorts = std::vector<GLushort>(indices.size());
+         std::transform(indices.begin(), indices.end(), shorts.begin(),
+            [](const auto i) { return gsl::narrow_cast<GLushort>(i); });
+         append(bytes, shorts.data(), shorts.size());
+      }
+      else {
+         append(bytes, indices.data(), indices.size());
+      }
+
+      to_file(path, bytes);
+   }
+
+   mesh_data import_obj(const std::string& path)
+   {
+      const auto text = from_file<std::string>(path);
+
+      auto positions = std::vector<glm::vec3>{};
+      auto uvs = std::vector<glm::vec2>{};
+      auto normals = std::vector<glm::vec3>{};
+      auto corners = std::vector<obj_corner>{};
+      auto indices = std::vector<std::uint32_t>{};
+      auto unique = std::unordered_map<obj_corner, std::uint32_t, obj_corner_hash>{};
+
+      auto line_number = 0;
+      const auto invalid = [&]{
+         return std::runtime_error{"Invalid OBJ file " + path + " at line "
+            + std::to_string(line_number)};
+      };
+
+      // OBJ indices count from one, and negative ones count back from the last element
+      const auto resolve = [&](const long i, const std::size_t size) {
+         const auto result = i < 0 ? static_cast<long>(size) + i : i - 1;
+         if (result < 0 or result >= static_cast<long>(size))
+            throw invalid();
+         return static_cast<int>(result);
+      };
+
+      const auto read_floats = [&](const char* p, float* const out, const int count) {
+         for (auto i = 0; i < count; ++i) {
+            auto end = static_cast<char*>(nullptr);
+            out[i] = std::strtof(p, &end);
+            if (end == p)
+               throw invalid();
+            p = end;
+         }
+      };
+
+      for (auto first = std::size_t{0}; first < text.size(); ++line_number) {
+         auto last = text.find('\n', first);
+         if (last == std::string::npos)
+            last = text.size();
+         auto line = std::string{text, first, last - first};
+         first = last + 1;
+
+         if (const auto comment = line.find('#'); comment != std::string::npos)
+            line.erase(comment);
+         const auto p = line.c_str();
+
+         if (line.compare(0, 2, "v ") == 0) {
+            read_floats(p + 2, &positions.emplace_back().x, 3);
+         }
+         else if (line.compare(0, 3, "vt ") == 0) {
+            read_floats(p + 3, &uvs.emplace_back().x, 2);
+         }
+         else if (line.compare(0, 3, "vn ") == 0) {
+            read_floats(p + 3, &normals.emplace_back().x, 3);
+         }
+         else if (line.compare(0, 2, "f ") == 0) {
+            auto face = std::vector<std::uint32_t>{};
+            for (auto q = p + 2; *q != '\0';) {
+               auto end = static_cast<char*>(nullptr);
+               const auto v = std::strtol(q, &end, 10);
+               if (end == q) {
+                  if (std::isspace(static_cast<unsigned char>(*q)) == 0)
+                     throw invalid();
+                  ++q;
+                  continue;
+               }
+
+               auto corner = obj_corner{resolve(v, positions.size()), -1, -1};
+               q = end;
+               if (*q == '/') {
+                  ++q;
+                  if (*q != '/') {
+                     corner.uv = resolve(std::strtol(q, &end, 10), uvs.size());
+                     q = end;
+                  }
+                  if (*q == '/') {
+                     ++q;
+                     corner.normal = resolve(std::strtol(q, &end, 10), normals.size());
+                     q = end;
+                  }
+               }
+
+               const auto [i, added] = unique.try_emplace(corner,
+                  gsl::narrow_cast<std::uint32_t>(corners.size()));
+               if (added)
+                  corners.push_back(corner);
+               face.push_back(i->second);
+            }
+
+            if (face.size() < 3)
+               throw invalid();
+            for (auto i = std::size_t{2}; i < face.size(); ++i)
+               indices.insert(indices.end(), {face[0], face[i - 1], face[i]});
+         }
+      }
+
+      if (indices.empty())
+         throw std::runtime_error{"OBJ file " + path + " has no faces"};
+
+      // corners without a normal share the area-weighted normals of the faces that they're in
+      auto smooth = std::vector<glm::vec3>(corners.size(), glm::vec3{0.0f});
+      for (auto i = std::size_t{0}; i < indices.size(); i += 3) {
+         const auto& a = positions[static_cast<std::size_t>(corners[indices[i]].position)];
+         const auto& b = positions[static_cast<std::size_t>(corners[indices[i + 1]].position)];
+         const auto& c = positions[static_cast<std::size_t>(corners[indices[i + 2]].position)];
+         const auto n = glm::cross(b - a, c - a);
+         for (auto j = i; j < i + 3; ++j)
+            smooth[indices[j]] += n;
+      }
+
+      auto result = mesh_data{};
+      result.attributes = describe(cooked_vertex{});
+      result.stride = cooked_vertex::stride;
+      result.vertices.resize(corners.size() * cooked_vertex::stride);
+      for (auto i = std::size_t{0}; i < corners.size(); ++i) {
+         const auto& c = corners[i];
+         const auto length = glm::length(smooth[i]);
+         const auto normal = c.normal >= 0 ? normals[static_cast<std::size_t>(c.normal)]
+                           : length > 0.0f ? smooth[i] / length : glm::vec3{0.0f, 0.0f, 1.0f};
+         const auto uv = c.uv >= 0 ? uvs[static_cast<std::size_t>(c.uv)] : glm::vec2{0.0f};
+
+         cooked_vertex::write<0>(result.vertices, i, positions[static_cast<std::size_t>(c.position)]);
+         cooked_vertex::write<1>(result.vertices, i, normal);
+         cooked_vertex::write<2>(result.vertices, i, uv);
+      }
+
+      result.indices = std::move(indices);
+      result.compute_bounds();
+      return result;
+   }
+
+   mesh_file::mesh_file(const std::string& path)
+      : file_{path}
+   {
+      const auto bytes = file_.bytes();
+      const auto size = static_cast<std::size_t>(bytes.size());
+      const auto invalid = [&path]{
+         return std::runtime_error{"Invalid cooked mesh " + path};
+      };
+
+      auto header = mesh_header{};
+      if (size < sizeof(header))
+         throw invalid();
+      std::memcpy(&header, bytes.data(), sizeof(header));
+      if (header.magic != mesh_magic)
+         throw invalid();
+      if (header.version != mesh_version) {
+         throw std::runtime_error{"Cooked mesh " + path + " is version "
+            + std::to_string(header.version) + ", but only version "
+            + std::to_string(mesh_version) + " is supported; cook it again"};
+      }
+
+      const auto tables = sizeof(header) + header.attribute_count * sizeof(mesh_attribute)
+         + header.lod_count * sizeof(mesh_lod);
+      const auto vertex_bytes = static_cast<std::size_t>(header.vertex_count) * header.stride;
+      const auto index_bytes = static_cast<std::size_t>(header.index_count)
+         * index_size(header.index_type);
+      if ((header.index_type != gl::UNSIGNED_SHORT and header.index_type != gl::UNSIGNED_INT)
+          or header.attribute_count == 0 or header.lod_count == 0 or tables > size
+          or header.vertex_offset < tables or header.vertex_offset % blob_alignment != 0
+          or header.index_offset % blob_alignment != 0
+          or header.vertex_offset + vertex_bytes > header.index_offset
+          or header.index_offset + index_bytes > size)
+      {
+         throw invalid();
+      }
+
+      attributes_ = {reinterpret_cast<const mesh_attribute*>(bytes.data() + sizeof(header)),
+         gsl::narrow_cast<std::ptrdiff_t>(header.attribute_count)};
+      lods_ = {reinterpret_cast<const mesh_lod*>(bytes.data() + sizeof(header)
+         + header.attribute_count * sizeof(mesh_attribute)),
+         gsl::narrow_cast<std::ptrdiff_t>(header.lod_count)};
+      vertices_ = bytes.subspan(gsl::narrow_cast<std::ptrdiff_t>(header.vertex_offset),
+         gsl::narrow_cast<std::ptrdiff_t>(vertex_bytes));
+      indices_ = bytes.subspan(gsl::narrow_cast<std::ptrdiff_t>(header.index_offset),
+         gsl::narrow_cast<std::ptrdiff_t>(index_bytes));
+
+      for (const auto& a : attributes_) {
+         if (a.components == 0 or a.components > 4
+             or a.offset + component_size(a.type) * (a.type == gl::INT_2_10_10_10_REV ? 1
+                : a.components) > header.stride)
+         {
+            throw invalid();
+         }
+      }
+
+      for (const auto& l : lods_) {
+         if (static_cast<std::uint64_t>(l.first_index) + l.index_count > header.index_count)
+            throw invalid();
+      }
+
+      stride_ = gsl::narrow_cast<GLsizei>(header.stride);
+      index_type_ = header.index_type;
+      min_ = {header.min[0], header.min[1], header.min[2]};
+      max_ = {header.max[0], header.max[1], header.max[2]};
+      sphere_ = {header.sphere[0], header.sphere[1], header.sphere[2], header.sphere[3]};
+   }
+
+   cooked_mesh::cooked_mesh(const mesh_file& file)
+      : index_type_{file.index_type()},
+        lods_(file.lods().begin(), file.lods().end()),
+        min_{file.min()},
+        max_{file.max()},
+        sphere_{file.sphere()}
+   {
+      const auto vertices = file.vertices();
+      const auto indices = file.indices();
+
+      gl_state().bind_vertex_array(vao_);
+      gl_state().bind_buffer(gl::ARRAY_BUFFER, vbo_);
+      gl::BufferData(gl::ARRAY_BUFFER, vertices.size(), vertices.data(), gl::STATIC_DRAW);
+      gl_state().bind_buffer(gl::ELEMENT_ARRAY_BUFFER, ebo_);
+      gl::BufferData(gl::ELEMENT_ARRAY_BUFFER, indices.size(), indices.data(), gl::STATIC_DRAW);
+
+      auto index = GLuint{0};
+      for (const auto& a : file.attributes()) {
+         const auto components = gsl::narrow_cast<GLint>(a.components);
+         if (a.integer)
+            gl::VertexAttribIFormat(index, components, a.type, a.offset);
+         else
+            gl::VertexAttribFormat(index, components, a.type, a.normalised, a.offset);
+         gl::VertexAttribBinding(index, 0);
+         gl::EnableVertexAttribArray(index);
+         ++index;
+      }
+      gl::BindVertexBuffer(0, vbo_, 0, file.stride());
+
+      gl_state().bind_vertex_array(0);
+      gl_state().bind_buffer(gl::ARRAY_BUFFER, 0);
+   }
+
+   void cooked_mesh::draw_instanced(const GLsizei instances, const std::size_t lod,
+      const GLenum mode) const noexcept
+   {
+      Expects(lod < lods_.size());
+      const auto& l = lods_[lod];
+      gl_state().bind_vertex_array(vao_);
+      gl::DrawElementsInstanced(mode, gsl::narrow_cast<GLsizei>(l.index_count), index_type_,
+         reinterpret_cast<const GLvoid*>(l.first_index * index_size(index_type_)), instances);
+   }
+} // namespace doge
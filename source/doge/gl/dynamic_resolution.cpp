@@ -0,0 +1,194 @@
+//
+//  Copyright 2018 Christopher Di Bella
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+#include <algorithm>
+#include <cmath>
+#include <doge/gl/dynamic_resolution.hpp>
+#include <doge/gl/state_cache.hpp>
+#include <glm/vec2.hpp>
+
+namespace doge {
+   namespace {
+      GLsizei scaled(const GLsizei extent, const float scale) noexcept
+      {
+         return std::max(GLsizei{1}, static_cast<GLsizei>(std::lround(static_cast<float>(extent)
+            * scale)));
+      }
+   } // namespace <anonymous>
+
+   dynamic_resolution::dynamic_resolution(const GLsizei width, const GLsizei height,
+      shader_cache& cache, const dynamic_resolution_settings& settings,
+      const framebuffer_format& format, const std::string& vertex_path,
+      const std::string& fragment_path)
+      : output_width_{width},
+        output_height_{height},
+        settings_{settings},
+        target_{scaled(width, settings.max_scale), scaled(height, settings.max_scale), format},
+        upscale_{{{shader_source::vertex, vertex_path}, {shader_source::fragment, fragment_path}},
+           cache},
+        empty_{unique_vertex_array::generate()},
+        scale_{settings.max_scale}
+   {
+      Expects(format.colour != 0);
+      Expects(settings.min_scale > 0.0f and settings.min_scale <= settings.max_scale);
+      Expects(settings.target.count() > 0);
+      for (auto& i : timings_)
+         gl::GenQueries(gsl::narrow_cast<GLsizei>(i.queries.size()), i.queries.data());
+   }
+
+   dynamic_resolution::~dynamic_resolution() noexcept
+   {
+      for (auto& i : timings_)
+         gl::DeleteQueries(gsl::narrow_cast<GLsizei>(i.queries.size()), i.queries.data());
+   }
+
+   void dynamic_resolution::resize(const GLsizei width, const GLsizei height)
+   {
+      Expects(width > 0 and height > 0);
+      output_width_ = width;
+      output_height_ = height;
+      target_.resize(scaled(width, settings_.max_scale), scaled(height, settings_.max_scale));
+   }
+
+   void dynamic_resolution::scale(const float s) noexcept
+   {
+      scale_ = std::clamp(s, settings_.min_scale, settings_.max_scale);
+   }
+
+   GLsizei dynamic_resolution::width() const noexcept
+   {
+      return std::min(scaled(output_width_, scale_), target_.width());
+   }
+
+   GLsizei dynamic_resolution::height() const noexcept
+   {
+      return std::min(scaled(output_height_, scale_), target_.height());
+   }
+
+   void dynamic_resolution::begin()
+   {
+      collect();
+
+      // a frame whose slot is still waiting for the GPU goes untimed, rather than stalling
+      auto& t = timings_[frame_ % latency];
+      timed_ = not t.pending;
+      if (timed_) {
+         gl::QueryCounter(t.queries[0], gl::TIMESTAMP);
+         t.scale = scale_;
+      }
+      else {
+         ++statistics_.untimed;
+      }
+
+      target_.bind();
+      gl_state().viewport(0, 0, width(), height());
+   }
+
+   void dynamic_resolution::present()
+   {
+      target_.resolve();
+      upscale();
+
+      auto& t = timings_[frame_ % latency];
+      if (timed_) {
+         gl::QueryCounter(t.queries[1], gl::TIMESTAMP);
+         t.pending = true;
+      }
+      ++frame_;
+   }
+
+   void dynamic_resolution::collect() noexcept
+   {
+      // oldest first, so that the controller sees the timings in the order they were made
+      for (auto i = std::size_t{0}; i != latency; ++i) {
+         auto& t = timings_[(frame_ + i) % latency];
+         if (not t.pending)
+            continue;
+
+         auto available = GLuint64{0};
+         gl::GetQueryObjectui64v(t.queries[1], gl::QUERY_RESULT_AVAILABLE, &available);
+         if (not available)
+            return;
+
+         auto begin = GLuint64{0};
+         auto end = GLuint64{0};
+         gl::GetQueryObjectui64v(t.queries[0], gl::QUERY_RESULT, &begin);
+         gl::GetQueryObjectui64v(t.queries[1], gl::QUERY_RESULT, &end);
+         t.pending = false;
+         adjust(std::chrono::nanoseconds{static_cast<std::int64_t>(end - begin)}, t.scale);
+      }
+   }
+
+   void dynamic_resolution::adjust(const std::chrono::nanoseconds time, const float measured_scale)
+      noexcept
+   {
+      statistics_.gpu_time = time;
+      ++statistics_.measured;
+      if (time.count() <= 0)
+         return;
+
+      const auto ratio = static_cast<float>(settings_.target.count())
+         / static_cast<float>(time.count());
+      if (std::abs(1.0f - ratio) <= settings_.tolerance)
+         return;
+
+      // the timing is a few frames old, so the ideal scale is found from the scale it was made at
+      const auto ideal = std::clamp(measured_scale * std::sqrt(ratio), settings_.min_scale,
+         settings_.max_scale);
+      const auto rate = ideal > scale_ ? settings_.increase_rate : settings_.decrease_rate;
+      scale_ = std::clamp(scale_ + rate * (ideal - scale_), settings_.min_scale,
+         settings_.max_scale);
+   }
+
+   void dynamic_resolution::upscale() const
+   {
+      const auto w = width();
+      const auto h = height();
+      if (settings_.sharpness <= 0.0f) {
+         gl::BindFramebuffer(gl::DRAW_FRAMEBUFFER, 0);
+         gl::BlitFramebuffer(0, 0, w, h, 0, 0, output_width_, output_height_,
+            gl::COLOR_BUFFER_BIT, gl::LINEAR);
+         framebuffer::bind_default();
+         gl_state().viewport(0, 0, output_width_, output_height_);
+         return;
+      }
+
+      framebuffer::bind_default();
+      gl_state().viewport(0, 0, output_width_, output_height_);
+
+      // the full-screen triangle must neither be depth tested nor blended into the last frame
+      const auto depth_test = gl::IsEnabled(gl::DEPTH_TEST);
+      const auto blend = gl::IsEnabled(gl::BLEND);
+      gl_state().disable(gl::DEPTH_TEST);
+      gl_state().disable(gl::BLEND);
+
+      const auto texel = glm::vec2{1.0f / static_cast<float>(target_.width()),
+         1.0f / static_cast<float>(target_.height())};
+      upscale_.set_uniform("rendered", glm::vec2{static_cast<float>(w), static_cast<float>(h)}
+         * texel);
+      upscale_.set_uniform("texel", texel);
+      upscale_.set_uniform("sharpness", std::min(settings_.sharpness, 1.0f));
+      upscale_.use([this]{
+         target_.colour().bind(gl::TEXTURE0);
+         gl_state().bind_vertex_array(empty_);
+         gl::DrawArrays(gl::TRIANGLES, 0, 3);
+      });
+
+      if (depth_test)
+         gl_state().enable(gl::DEPTH_TEST);
+      if (blend)
+         gl_state().enable(gl::BLEND);
+   }
+} // namespace doge
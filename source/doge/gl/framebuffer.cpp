@@ -0,0 +1,160 @@
+//
+//  Copyright 2018 Christopher Di Bella
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+#include <doge/gl/framebuffer.hpp>
+#include <doge/gl/state_cache.hpp>
+#include <stdexcept>
+#include <string>
+#include <tuple>
+
+namespace doge {
+   namespace {
+      constexpr auto clamped = std::make_tuple(texture_wrap_t::clamp_to_edge,
+         texture_wrap_t::clamp_to_edge);
+
+      void check_complete(const GLenum target)
+      {
+         if (const auto status = gl::CheckFramebufferStatus(target);
+             status != gl::FRAMEBUFFER_COMPLETE) {
+            throw std::runtime_error{"Framebuffer is incomplete (status " + std::to_string(status)
+               + ")"};
+         }
+      }
+
+      texture2d make_attachment(const GLenum format, const GLsizei width, const GLsizei height,
+         const minmag_t filter)
+      {
+         return texture2d{[=]{
+            gl::TexStorage2D(gl::TEXTURE_2D, 1, format, width, height);
+         }, clamped, filter, filter};
+      }
+
+      unique_renderbuffer make_samples(const GLenum format, const GLsizei samples,
+         const GLsizei width, const GLsizei height)
+      {
+         auto result = unique_renderbuffer::generate();
+         gl::BindRenderbuffer(gl::RENDERBUFFER, result);
+         gl::RenderbufferStorageMultisample(gl::RENDERBUFFER, samples, format, width, height);
+         gl::BindRenderbuffer(gl::RENDERBUFFER, 0);
+         return result;
+      }
+   } // namespace <anonymous>
+
+   framebuffer::framebuffer(const GLsizei width, const GLsizei height,
+      const framebuffer_format& format)
+      : format_{format}
+   {
+      Expects(format.colour != 0 or format.depth != 0);
+      resize(width, height);
+   }
+
+   void framebuffer::resize(const GLsizei width, const GLsizei height)
+   {
+      Expects(width > 0 and height > 0);
+      width_ = width;
+      height_ = height;
+
+      draw_ = unique_framebuffer::generate();
+      colour_.reset();
+      depth_.reset();
+      if (format_.colour != 0)
+         colour_ = make_attachment(format_.colour, width, height, minmag_t::linear);
+      if (format_.depth != 0)
+         depth_ = make_attachment(format_.depth, width, height, minmag_t::nearest);
+
+      // textures are attached to whichever framebuffer holds the final image
+      const auto attach_textures = [this](const GLenum target) {
+         if (colour_) {
+            gl::FramebufferTexture2D(target, gl::COLOR_ATTACHMENT0, gl::TEXTURE_2D,
+               static_cast<GLuint>(*colour_), 0);
+         }
+         if (depth_) {
+            gl::FramebufferTexture2D(target, depth_attachment(), gl::TEXTURE_2D,
+               static_cast<GLuint>(*depth_), 0);
+         }
+      };
+
+      gl::BindFramebuffer(gl::DRAW_FRAMEBUFFER, draw_);
+      if (multisampled()) {
+         colour_samples_.reset();
+         depth_samples_.reset();
+         if (format_.colour != 0) {
+            colour_samples_ = make_samples(format_.colour, format_.samples, width, height);
+            gl::FramebufferRenderbuffer(gl::DRAW_FRAMEBUFFER, gl::COLOR_ATTACHMENT0,
+               gl::RENDERBUFFER, colour_samples_);
+         }
+         if (format_.depth != 0) {
+            depth_samples_ = make_samples(format_.depth, format_.samples, width, height);
+            gl::FramebufferRenderbuffer(gl::DRAW_FRAMEBUFFER, depth_attachment(),
+               gl::RENDERBUFFER, depth_samples_);
+         }
+      }
+      else {
+         attach_textures(gl::DRAW_FRAMEBUFFER);
+      }
+
+      if (format_.colour == 0)
+         gl::DrawBuffer(gl::NONE);
+      check_complete(gl::DRAW_FRAMEBUFFER);
+
+      if (multisampled()) {
+         resolve_ = unique_framebuffer::generate();
+         gl::BindFramebuffer(gl::DRAW_FRAMEBUFFER, resolve_);
+         attach_textures(gl::DRAW_FRAMEBUFFER);
+         if (format_.colour == 0)
+            gl::DrawBuffer(gl::NONE);
+         check_complete(gl::DRAW_FRAMEBUFFER);
+      }
+
+      gl::BindFramebuffer(gl::DRAW_FRAMEBUFFER, 0);
+   }
+
+   void framebuffer::bind() const noexcept
+   {
+      gl::BindFramebuffer(gl::FRAMEBUFFER, draw_);
+      gl_state().viewport(0, 0, width_, height_);
+   }
+
+   void framebuffer::bind_default() noexcept
+   {
+      gl::BindFramebuffer(gl::FRAMEBUFFER, 0);
+   }
+
+   void framebuffer::resolve() const noexcept
+   {
+      if (not multisampled()) {
+         gl::BindFramebuffer(gl::READ_FRAMEBUFFER, draw_);
+         return;
+      }
+
+      auto mask = GLbitfield{0};
+      if (format_.colour != 0)
+         mask |= gl::COLOR_BUFFER_BIT;
+      if (format_.depth != 0)
+         mask |= gl::DEPTH_BUFFER_BIT;
+
+      gl::BindFramebuffer(gl::READ_FRAMEBUFFER, draw_);
+      gl::BindFramebuffer(gl::DRAW_FRAMEBUFFER, resolve_);
+      gl::BlitFramebuffer(0, 0, width_, height_, 0, 0, width_, height_, mask, gl::NEAREST);
+      gl::BindFramebuffer(gl::DRAW_FRAMEBUFFER, draw_);
+      gl::BindFramebuffer(gl::READ_FRAMEBUFFER, resolve_);
+   }
+
+   GLenum framebuffer::depth_attachment() const noexcept
+   {
+      return format_.depth == gl::DEPTH24_STENCIL8 or format_.depth == gl::DEPTH32F_STENCIL8
+           ? gl::DEPTH_STENCIL_ATTACHMENT : gl::DEPTH_ATTACHMENT;
+   }
+} // namespace doge
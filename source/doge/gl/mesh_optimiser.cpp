@@ -0,0 +1,342 @@
+//
+//  Copyright 2018 Christopher Di Bella
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+#include <algorithm>
+#include <cstring>
+#include <doge/gl/mesh_optimiser.hpp>
+#include <glm/geometric.hpp>
+#include <limits>
+#include <numeric>
+#include <string_view>
+#include <type_traits>
+#include <unordered_map>
+#include <vector>
+
+namespace doge {
+   namespace {
+      constexpr auto no_vertex = std::numeric_limits<std::uint32_t>::max();
+
+      // A FIFO post-transform cache. A vertex is cached if fewer than `size` vertices have been
+      // transformed since it was, so only a timestamp per vertex needs to be kept.
+      class fifo_cache {
+      public:
+         fifo_cache(const std::size_t vertex_count, const std::size_t size)
+            : stamps_(vertex_count),
+              size_{size},
+              time_{size + 1}
+         {}
+
+         /** @returns true if `v` was already in the cache. */
+         bool touch(const std::uint32_t v) noexcept
+         {
+            if (time_ - stamps_[v] <= size_)
+               return true;
+            stamps_[v] = time_++;
+            return false;
+         }
+      private:
+         std::vector<std::size_t> stamps_;
+         std::size_t size_;
+         std::size_t time_;
+      };
+
+      std::vector<mesh_lod> lods_of(const mesh_data& mesh)
+      {
+         if (not mesh.lods.empty())
+            return mesh.lods;
+         return {mesh_lod{0, gsl::narrow_cast<std::uint32_t>(mesh.indices.size()), 0.0f, 0}};
+      }
+
+      gsl::span<std::uint32_t> indices_of(mesh_data& mesh, const mesh_lod& lod)
+      {
+         Expects(lod.first_index + std::size_t{lod.index_count} <= mesh.indices.size());
+         return gsl::span<std::uint32_t>{mesh.indices}.subspan(
+            gsl::narrow_cast<std::ptrdiff_t>(lod.first_index),
+            gsl::narrow_cast<std::ptrdiff_t>(lod.index_count));
+      }
+
+      // Tipsify fans around one vertex at a time, emitting every triangle that still refers to
+      // it, and then moves to the vertex of those triangles that is most likely to still be in
+      // the cache after its own fan is emitted. When there are none it backtracks through the
+      // vertices that were emitted most recently, and then scans for anything that's left.
+      template <typename Index>
+      void tipsify(const gsl::span<Index> indices, const std::size_t vertex_count,
+         const std::size_t cache_size)
+      {
+         Expects(indices.size() % 3 == 0);
+         if (indices.empty())
+            return;
+
+         auto live = std::vector<std::uint32_t>(vertex_count);
+         for (const auto i : indices) {
+            // negative indices wrap around, and are caught along with those that are too large
+            Expects(static_cast<std::make_unsigned_t<Index>>(i) < vertex_count);
+            ++live[static_cast<std::size_t>(i)];
+         }
+
+         // the triangles around each vertex, packed into one array
+         auto offsets = std::vector<std::uint32_t>(vertex_count + 1);
+         std::partial_sum(live.begin(), live.end(), offsets.begin() + 1);
+         auto adjacency = std::vector<std::uint32_t>(static_cast<std::size_t>(indices.size()));
+         {
+            auto next = offsets;
+            for (auto i = std::size_t{0}; i < adjacency.size(); ++i)
+               adjacency[next[static_cast<std::size_t>(indices[i])]++] = i / 3;
+         }
+
+         auto emitted = std::vector<bool>(adjacency.size() / 3);
+         auto stamps = std::vector<std::size_t>(vertex_count);
+         auto time = cache_size + 1;
+         auto dead_end = std::vector<std::uint32_t>{};
+         auto candidates = std::vector<std::uint32_t>{};
+         auto scan = std::size_t{0};
+
+         auto result = std::vector<Index>{};
+         result.reserve(adjacency.size());
+
+         for (auto fan = static_cast<std::uint32_t>(indices[0]); fan != no_vertex;) {
+            candidates.clear();
+            for (auto a = offsets[fan]; a != offsets[fan + 1]; ++a) {
+               const auto t = adjacency[a];
+               if (emitted[t])
+                  continue;
+               emitted[t] = true;
+
+               for (auto k = std::size_t{0}; k < 3; ++k) {
+                  const auto i = indices[3 * t + k];
+                  const auto v = static_cast<std::uint32_t>(i);
+                  result.push_back(i);
+                  dead_end.push_back(v);
+                  candidates.push_back(v);
+                  --live[v];
+                  if (time - stamps[v] > cache_size)
+                     stamps[v] = time++;
+               }
+            }
+
+            // prefer the vertex that has been in the cache the longest, provided that its fan
+            // won't push it out again
+            fan = no_vertex;
+            auto best = std::size_t{0};
+            for (const auto v : candidates) {
+               if (live[v] == 0)
+                  continue;
+               const auto age = time - stamps[v];
+               const auto priority = age + 2 * live[v] <= cache_size ? age : 0;
+               if (fan == no_vertex or priority > best) {
+                  fan = v;
+                  best = priority;
+               }
+            }
+
+            while (fan == no_vertex and not dead_end.empty()) {
+               if (live[dead_end.back()] > 0)
+                  fan = dead_end.back();
+               dead_end.pop_back();
+            }
+
+            for (; fan == no_vertex and scan < vertex_count; ++scan) {
+               if (live[scan] > 0)
+                  fan = gsl::narrow_cast<std::uint32_t>(scan);
+            }
+         }
+
+         std::copy(result.begin(), result.end(), indices.begin());
+      }
+
+      glm::vec3 face_normal(const mesh_data& mesh, const std::uint32_t* const triangle) noexcept
+      {
+         const auto a = mesh.position(triangle[0]);
+         return glm::cross(mesh.position(triangle[1]) - a, mesh.position(triangle[2]) - a);
+      }
+
+      glm::vec3 face_centre(const mesh_data& mesh, const std::uint32_t* const triangle) noexcept
+      {
+         return (mesh.position(triangle[0]) + mesh.position(triangle[1])
+            + mesh.position(triangle[2])) / 3.0f;
+      }
+
+      void sort_clusters(mesh_data& mesh, const gsl::span<std::uint32_t> indices,
+         const std::size_t cache_size)
+      {
+         const auto triangle_count = static_cast<std::size_t>(indices.size()) / 3;
+         if (triangle_count < 2)
+            return;
+
+         // a cluster starts wherever the cache was flushed, i.e. a triangle missed on every
+         // vertex, because reordering whole clusters can only cost those same misses again
+         auto starts = std::vector<std::size_t>{};
+         auto cache = fifo_cache{mesh.vertex_count(), cache_size};
+         for (auto t = std::size_t{0}; t < triangle_count; ++t) {
+            auto hits = 0;
+            for (auto k = std::size_t{0}; k < 3; ++k)
+               hits += cache.touch(indices[3 * t + k]);
+            if (hits == 0)
+               starts.push_back(t);
+         }
+         starts.push_back(triangle_count);
+         if (starts.size() <= 2)
+            return;
+
+         // weighting by area keeps slivers from dragging the centres around
+         auto centre = glm::vec3{0.0f};
+         auto total = 0.0f;
+         for (auto t = std::size_t{0}; t < triangle_count; ++t) {
+            const auto area = glm::length(face_normal(mesh, &indices[3 * t]));
+            centre += face_centre(mesh, &indices[3 * t]) * area;
+            total += area;
+         }
+         if (total > 0.0f)
+            centre /= total;
+
+         const auto cluster_count = starts.size() - 1;
+         auto keys = std::vector<float>(cluster_count);
+         for (auto c = std::size_t{0}; c < cluster_count; ++c) {
+            auto normal = glm::vec3{0.0f};
+            auto cluster_centre = glm::vec3{0.0f};
+            auto area = 0.0f;
+            for (auto t = starts[c]; t < starts[c + 1]; ++t) {
+               const auto n = face_normal(mesh, &indices[3 * t]);
+               const auto a = glm::length(n);
+               normal += n;
+               cluster_centre += face_centre(mesh, &indices[3 * t]) * a;
+               area += a;
+            }
+
+            const auto length = glm::length(normal);
+            if (area > 0.0f and length > 0.0f)
+               keys[c] = glm::dot(cluster_centre / area - centre, normal / length);
+         }
+
+         auto order = std::vector<std::size_t>(cluster_count);
+         std::iota(order.begin(), order.end(), std::size_t{0});
+         std::stable_sort(order.begin(), order.end(),
+            [&keys](const auto a, const auto b) { return keys[a] > keys[b]; });
+
+         auto result = std::vector<std::uint32_t>{};
+         result.reserve(static_cast<std::size_t>(indices.size()));
+         for (const auto c : order) {
+            result.insert(result.end(), indices.begin() + 3 * starts[c],
+               indices.begin() + 3 * starts[c + 1]);
+         }
+         std::copy(result.begin(), result.end(), indices.begin());
+      }
+   } // namespace <anonymous>
+
+   vertex_cache_statistics analyse_vertex_cache(const gsl::span<const std::uint32_t> indices,
+      const std::size_t vertex_count, const std::size_t cache_size)
+   {
+      Expects(indices.size() % 3 == 0);
+
+      auto result = vertex_cache_statistics{};
+      auto cache = fifo_cache{vertex_count, cache_size};
+      for (const auto i : indices) {
+         Expects(i < vertex_count);
+         result.transformed += not cache.touch(i);
+      }
+
+      if (not indices.empty())
+         result.acmr = static_cast<double>(result.transformed) / (indices.size() / 3);
+      if (vertex_count > 0)
+         result.atvr = static_cast<double>(result.transformed) / vertex_count;
+      return result;
+   }
+
+   std::size_t weld_vertices(mesh_data& mesh)
+   {
+      Expects(mesh.stride > 0);
+
+      const auto count = mesh.vertex_count();
+      auto remap = std::vector<std::uint32_t>(count);
+      auto welded = std::vector<std::byte>{};
+      welded.reserve(mesh.vertices.size());
+
+      // the keys view the original vertices, which are only replaced once the map is done with
+      auto unique = std::unordered_map<std::string_view, std::uint32_t>{};
+      unique.reserve(count);
+      for (auto i = std::size_t{0}; i < count; ++i) {
+         const auto first = mesh.vertices.data() + i * mesh.stride;
+         const auto key = std::string_view{reinterpret_cast<const char*>(first), mesh.stride};
+         const auto [existing, inserted] = unique.try_emplace(key,
+            gsl::narrow_cast<std::uint32_t>(welded.size() / mesh.stride));
+         if (inserted)
+            welded.insert(welded.end(), first, first + mesh.stride);
+         remap[i] = existing->second;
+      }
+
+      for (auto& i : mesh.indices) {
+         Expects(i < count);
+         i = remap[i];
+      }
+
+      const auto removed = count - welded.size() / mesh.stride;
+      mesh.vertices = std::move(welded);
+      return removed;
+   }
+
+   void optimise_vertex_cache(const gsl::span<std::uint32_t> indices,
+      const std::size_t vertex_count, const std::size_t cache_size)
+   {
+      tipsify(indices, vertex_count, cache_size);
+   }
+
+   void optimise_vertex_cache(const gsl::span<GLint> indices, const std::size_t vertex_count,
+      const std::size_t cache_size)
+   {
+      tipsify(indices, vertex_count, cache_size);
+   }
+
+   void optimise_overdraw(mesh_data& mesh, const std::size_t cache_size)
+   {
+      for (const auto& lod : lods_of(mesh))
+         sort_clusters(mesh, indices_of(mesh, lod), cache_size);
+   }
+
+   void optimise_vertex_fetch(mesh_data& mesh)
+   {
+      Expects(mesh.stride > 0);
+
+      const auto count = mesh.vertex_count();
+      auto remap = std::vector<std::uint32_t>(count, no_vertex);
+      auto next = std::uint32_t{0};
+      for (auto& i : mesh.indices) {
+         Expects(i < count);
+         if (remap[i] == no_vertex)
+            remap[i] = next++;
+         i = remap[i];
+      }
+
+      auto reordered = std::vector<std::byte>(std::size_t{next} * mesh.stride);
+      for (auto v = std::size_t{0}; v < count; ++v) {
+         if (remap[v] != no_vertex) {
+            std::memcpy(reordered.data() + std::size_t{remap[v]} * mesh.stride,
+               mesh.vertices.data() + v * mesh.stride, mesh.stride);
+         }
+      }
+      mesh.vertices = std::move(reordered);
+   }
+
+   void optimise(mesh_data& mesh, const std::size_t cache_size)
+   {
+      weld_vertices(mesh);
+      for (const auto& lod : lods_of(mesh))
+         optimise_vertex_cache(indices_of(mesh, lod), mesh.vertex_count(), cache_size);
+      optimise_overdraw(mesh, cache_size);
+      optimise_vertex_fetch(mesh);
+
+      // vertices that nothing referred to are gone, so the bounds may have shrunk
+      mesh.compute_bounds();
+   }
+} // namespace doge
@@ -0,0 +1,186 @@
+//
+//  Copyright 2018 Christopher Di Bella
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+#include <doge/gl/mesh_pool.hpp>
+#include <stdexcept>
+
+namespace doge {
+   namespace {
+      GLuint make_storage(const GLenum target, const GLsizeiptr size)
+      {
+         auto result = GLuint{};
+         gl::GenBuffers(1, &result);
+         gl_state().bind_buffer(target, result);
+         gl::BufferStorage(target, size, nullptr, gl::DYNAMIC_STORAGE_BIT);
+         gl_state().bind_buffer(target, 0);
+         return result;
+      }
+   } // namespace <anonymous>
+
+   mesh_pool::mesh_pool(const GLsizei stride, const GLsizeiptr vertex_capacity,
+      const GLsizeiptr index_capacity)
+      : stride_{stride},
+        vertex_capacity_{vertex_capacity},
+        index_capacity_{index_capacity}
+   {
+      Expects(stride > 0);
+      Expects(vertex_capacity > 0);
+      Expects(index_capacity > 0);
+      if (not gl::exts::var_ARB_buffer_storage)
+         throw std::runtime_error{"mesh_pool requires GL_ARB_buffer_storage"};
+
+      gl::GenVertexArrays(1, &vao_);
+      vbo_ = make_storage(gl::COPY_WRITE_BUFFER, vertex_capacity_ * stride_);
+      ebo_ = make_storage(gl::COPY_WRITE_BUFFER, index_capacity_ * sizeof(GLuint));
+   }
+
+   mesh_pool::~mesh_pool() noexcept
+   {
+      const GLuint buffers[] = {vbo_, ebo_, indirect_};
+      delete_buffers(indirect_ ? 3 : 2, buffers);
+      delete_vertex_arrays(1, &vao_);
+   }
+
+   mesh_pool::mesh_id mesh_pool::add(const gsl::span<const std::byte> vertices,
+      const gsl::span<const GLuint> indices)
+   {
+      const auto whole = mesh_lod{0, gsl::narrow_cast<std::uint32_t>(indices.size()), 0.0f, 0};
+      return add(vertices, indices, gsl::span<const mesh_lod>{&whole, 1});
+   }
+
+   mesh_pool::mesh_id mesh_pool::add(const gsl::span<const std::byte> vertices,
+      const gsl::span<const GLuint> indices, const gsl::span<const mesh_lod> lods)
+   {
+      Expects(not vertices.empty());
+      Expects(vertices.size() % stride_ == 0);
+      Expects(not indices.empty());
+      Expects(not lods.empty());
+
+      const auto vertex_count = gsl::narrow_cast<GLsizeiptr>(vertices.size() / stride_);
+      const auto index_count = gsl::narrow_cast<GLsizeiptr>(indices.size());
+      if (vertices_used_ + vertex_count > vertex_capacity_
+          or indices_used_ + index_count > index_capacity_)
+         throw std::length_error{"mesh_pool is full"};
+
+      gl_state().bind_buffer(gl::COPY_WRITE_BUFFER, vbo_);
+      gl::BufferSubData(gl::COPY_WRITE_BUFFER, vertices_used_ * stride_, vertices.size(),
+         vertices.data());
+      gl_state().bind_buffer(gl::COPY_WRITE_BUFFER, ebo_);
+      gl::BufferSubData(gl::COPY_WRITE_BUFFER, indices_used_ * sizeof(GLuint),
+         indices.size() * sizeof(GLuint), indices.data());
+      gl_state().bind_buffer(gl::COPY_WRITE_BUFFER, 0);
+
+      // the levels are kept relative to the pool's index buffer, ready to go into a command
+      lod_ranges_.push_back({lods_.size(), static_cast<std::size_t>(lods.size())});
+      for (auto i : lods) {
+         Expects(i.first_index + std::size_t{i.index_count}
+            <= static_cast<std::size_t>(indices.size()));
+         i.first_index += gsl::narrow_cast<std::uint32_t>(indices_used_);
+         lods_.push_back(i);
+      }
+
+      const auto id = commands_.size();
+      commands_.push_back({
+         lods[0].index_count,
+         1,
+         lods_[lod_ranges_.back().first].first_index,
+         gsl::narrow_cast<GLint>(vertices_used_),
+         gsl::narrow_cast<GLuint>(id)});
+      vertices_used_ += vertex_count;
+      indices_used_ += index_count;
+      dirty_ = true;
+      return id;
+   }
+
+   void mesh_pool::lod(const mesh_id mesh, const std::size_t level) noexcept
+   {
+      const auto levels = lods(mesh);
+      Expects(level < static_cast<std::size_t>(levels.size()));
+
+      const auto& l = levels[gsl::narrow_cast<std::ptrdiff_t>(level)];
+      auto& command = commands_[mesh];
+      if (command.first_index != l.first_index) {
+         command.first_index = l.first_index;
+         command.count = l.index_count;
+         dirty_ = true;
+      }
+   }
+
+   void mesh_pool::instances(const mesh_id mesh, const GLuint count) noexcept
+   {
+      Expects(mesh < commands_.size());
+      commands_[mesh].instance_count = count;
+      dirty_ = true;
+   }
+
+   void mesh_pool::base_instance(const mesh_id mesh, const GLuint first) noexcept
+   {
+      Expects(mesh < commands_.size());
+      commands_[mesh].base_instance = first;
+      dirty_ = true;
+   }
+
+   void mesh_pool::draw(const GLenum mode)
+   {
+      if (commands_.empty())
+         return;
+
+      if (dirty_)
+         upload_commands();
+
+      gl_state().bind_vertex_array(vao_);
+      gl_state().bind_buffer(gl::DRAW_INDIRECT_BUFFER, indirect_);
+      gl::MultiDrawElementsIndirect(mode, gl::UNSIGNED_INT, nullptr,
+         gsl::narrow_cast<GLsizei>(commands_.size()), 0);
+   }
+
+   void mesh_pool::draw(const storage_buffer<draw_elements_indirect_command>& commands,
+      const GLenum mode)
+   {
+      Expects(commands.size() >= commands_.size());
+      if (commands_.empty())
+         return;
+
+      gl_state().bind_vertex_array(vao_);
+      gl_state().bind_buffer(gl::DRAW_INDIRECT_BUFFER, static_cast<GLuint>(commands));
+      gl::MultiDrawElementsIndirect(mode, gl::UNSIGNED_INT, nullptr,
+         gsl::narrow_cast<GLsizei>(commands_.size()), 0);
+   }
+
+   GLuint mesh_pool::commands_buffer()
+   {
+      if (dirty_)
+         upload_commands();
+      return indirect_;
+   }
+
+   void mesh_pool::upload_commands()
+   {
+      const auto size = gsl::narrow_cast<GLsizeiptr>(commands_.size()
+         * sizeof(draw_elements_indirect_command));
+
+      // the indirect buffer is mutable storage, so that it can grow as meshes are added
+      if (not indirect_)
+         gl::GenBuffers(1, &indirect_);
+
+      gl_state().bind_buffer(gl::DRAW_INDIRECT_BUFFER, indirect_);
+      if (size > indirect_capacity_) {
+         indirect_capacity_ = size * 2;
+         gl::BufferData(gl::DRAW_INDIRECT_BUFFER, indirect_capacity_, nullptr, gl::DYNAMIC_DRAW);
+      }
+      gl::BufferSubData(gl::DRAW_INDIRECT_BUFFER, 0, size, commands_.data());
+      dirty_ = false;
+   }
+} // namespace doge
@@ -0,0 +1,319 @@
+//
+//  Copyright 2018 Christopher Di Bella
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstring>
+#include <doge/gl/mesh_simplifier.hpp>
+#include <glm/geometric.hpp>
+#include <queue>
+#include <unordered_map>
+
+namespace doge {
+   namespace {
+      // The symmetric 4x4 matrix that sums the squared distances to a set of planes, stored as its
+      // upper triangle. Doubles, because the sums lose too much precision in floats.
+      class quadric {
+      public:
+         quadric() = default;
+
+         quadric(const glm::vec3& n, const float d) noexcept
+            : q_{n.x * n.x, n.x * n.y, n.x * n.z, n.x * d,
+                 n.y * n.y, n.y * n.z, n.y * d,
+                 n.z * n.z, n.z * d,
+                 static_cast<double>(d) * d}
+         {}
+
+         quadric& operator+=(const quadric& other) noexcept
+         {
+            for (auto i = std::size_t{0}; i < q_.size(); ++i)
+               q_[i] += other.q_[i];
+            return *this;
+         }
+
+         double operator()(const glm::vec3& p) const noexcept
+         {
+            const auto x = double{p.x};
+            const auto y = double{p.y};
+            const auto z = double{p.z};
+            return q_[0] * x * x + 2 * q_[1] * x * y + 2 * q_[2] * x * z + 2 * q_[3] * x
+               + q_[4] * y * y + 2 * q_[5] * y * z + 2 * q_[6] * y
+               + q_[7] * z * z + 2 * q_[8] * z
+               + q_[9];
+         }
+      private:
+         std::array<double, 10> q_ = {};
+      };
+
+      struct collapse {
+         double cost;
+         std::uint32_t from;
+         std::uint32_t to;
+         std::uint32_t from_version;
+         std::uint32_t to_version;
+
+         // std::priority_queue is a max-heap, and the cheapest collapse should come out first
+         friend bool operator<(const collapse& a, const collapse& b) noexcept
+         {
+            return a.cost > b.cost;
+         }
+      };
+
+      using position_key = std::array<std::uint32_t, 3>;
+
+      struct position_hash {
+         std::size_t operator()(const position_key& p) const noexcept
+         {
+            return (std::size_t{p[0]} * 73856093u) ^ (std::size_t{p[1]} * 19349663u)
+               ^ (std::size_t{p[2]} * 83492791u);
+         }
+      };
+
+      std::uint64_t edge_key(const std::uint32_t a, const std::uint32_t b) noexcept
+      {
+         return std::uint64_t{std::min(a, b)} << 32 | std::max(a, b);
+      }
+
+      class simplifier {
+      public:
+         simplifier(const mesh_data& mesh, const gsl::span<const std::uint32_t> indices)
+            : mesh_{mesh},
+              indices_(indices.begin(), indices.end()),
+              removed_(indices_.size() / 3),
+              adjacency_(mesh.vertex_count()),
+              quadrics_(mesh.vertex_count()),
+              locked_(mesh.vertex_count()),
+              dead_(mesh.vertex_count()),
+              versions_(mesh.vertex_count())
+         {
+            Expects(indices_.size() % 3 == 0);
+
+            // vertices are told apart by position, so that seams aren't mistaken for borders
+            auto positions = std::unordered_map<position_key, std::uint32_t, position_hash>{};
+            auto canonical = std::vector<std::uint32_t>(mesh.vertex_count());
+            auto wedges = std::vector<std::uint32_t>(mesh.vertex_count());
+            for (auto v = std::size_t{0}; v < mesh.vertex_count(); ++v) {
+               const auto p = mesh.position(v);
+               auto key = position_key{};
+               std::memcpy(key.data(), &p, sizeof(key));
+               const auto i = positions.try_emplace(key, gsl::narrow_cast<std::uint32_t>(v)).first;
+               canonical[v] = i->second;
+               ++wedges[i->second];
+            }
+            for (auto v = std::size_t{0}; v < mesh.vertex_count(); ++v)
+               locked_[v] = wedges[canonical[v]] > 1;
+
+            auto edges = std::unordered_map<std::uint64_t, std::uint32_t>{};
+            for (auto t = std::size_t{0}; t < removed_.size(); ++t) {
+               const auto* const c = &indices_[3 * t];
+               for (auto k = std::size_t{0}; k < 3; ++k) {
+                  Expects(c[k] < mesh.vertex_count());
+                  adjacency_[c[k]].push_back(gsl::narrow_cast<std::uint32_t>(t));
+                  ++edges[edge_key(canonical[c[k]], canonical[c[(k + 1) % 3]])];
+               }
+
+               const auto n = normal(c[0], c[1], c[2]);
+               const auto length = glm::length(n);
+               if (length > 0.0f) {
+                  const auto unit = n / length;
+                  const auto plane = quadric{unit, -glm::dot(unit, mesh.position(c[0]))};
+                  for (auto k = std::size_t{0}; k < 3; ++k)
+                     quadrics_[c[k]] += plane;
+               }
+            }
+
+            // an edge that isn't shared by exactly two triangles is on a border, or non-manifold
+            for (auto t = std::size_t{0}; t < removed_.size(); ++t) {
+               const auto* const c = &indices_[3 * t];
+               for (auto k = std::size_t{0}; k < 3; ++k) {
+                  const auto a = c[k];
+                  const auto b = c[(k + 1) % 3];
+                  if (edges[edge_key(canonical[a], canonical[b])] != 2) {
+                     locked_[a] = true;
+                     locked_[b] = true;
+                  }
+               }
+            }
+
+            for (auto t = std::size_t{0}; t < removed_.size(); ++t) {
+               const auto* const c = &indices_[3 * t];
+               for (auto k = std::size_t{0}; k < 3; ++k)
+                  push(c[k], c[(k + 1) % 3]);
+            }
+         }
+
+         simplified_indices run(const std::size_t target_triangles, const float max_error)
+         {
+            const auto limit = static_cast<double>(max_error) * max_error;
+            auto triangles = removed_.size();
+            auto worst = 0.0;
+
+            while (triangles > target_triangles and not heap_.empty()) {
+               const auto next = heap_.top();
+               heap_.pop();
+               if (dead_[next.from] or dead_[next.to] or versions_[next.from] != next.from_version
+                   or versions_[next.to] != next.to_version)
+                  continue;
+               if (next.cost > limit)
+                  break;
+               if (flips(next.from, next.to))
+                  continue;
+
+               triangles -= apply(next.from, next.to);
+               worst = std::max(worst, next.cost);
+            }
+
+            auto result = simplified_indices{};
+            result.indices.reserve(triangles * 3);
+            for (auto t = std::size_t{0}; t < removed_.size(); ++t) {
+               if (not removed_[t])
+                  result.indices.insert(result.indices.end(), &indices_[3 * t],
+                     &indices_[3 * t + 3]);
+            }
+            result.error = static_cast<float>(std::sqrt(worst));
+            return result;
+         }
+      private:
+         const mesh_data& mesh_;
+         std::vector<std::uint32_t> indices_;
+         std::vector<bool> removed_;
+         std::vector<std::vector<std::uint32_t>> adjacency_;
+         std::vector<quadric> quadrics_;
+         std::vector<bool> locked_;
+         std::vector<bool> dead_;
+         std::vector<std::uint32_t> versions_;
+         std::priority_queue<collapse> heap_;
+
+         glm::vec3 normal(const std::uint32_t a, const std::uint32_t b, const std::uint32_t c) const
+            noexcept
+         {
+            const auto p = mesh_.position(a);
+            return glm::cross(mesh_.position(b) - p, mesh_.position(c) - p);
+         }
+
+         void push(const std::uint32_t from, const std::uint32_t to)
+         {
+            if (not locked_[from]) {
+               auto q = quadrics_[from];
+               q += quadrics_[to];
+               heap_.push({q(mesh_.position(to)), from, to, versions_[from], versions_[to]});
+            }
+            if (not locked_[to]) {
+               auto q = quadrics_[to];
+               q += quadrics_[from];
+               heap_.push({q(mesh_.position(from)), to, from, versions_[to], versions_[from]});
+            }
+         }
+
+         // moving `from` onto `to` mustn't turn any of the triangles that survive upside down
+         bool flips(const std::uint32_t from, const std::uint32_t to) const noexcept
+         {
+            for (const auto t : adjacency_[from]) {
+               const auto* const c = &indices_[3 * t];
+               if (removed_[t] or c[0] == to or c[1] == to or c[2] == to)
+                  continue;
+
+               auto moved = std::array<std::uint32_t, 3>{c[0], c[1], c[2]};
+               std::replace(moved.begin(), moved.end(), from, to);
+               if (glm::dot(normal(c[0], c[1], c[2]), normal(moved[0], moved[1], moved[2])) <= 0.0f)
+                  return true;
+            }
+            return false;
+         }
+
+         // returns the number of triangles that were removed
+         std::size_t apply(const std::uint32_t from, const std::uint32_t to)
+         {
+            auto removed = std::size_t{0};
+            for (const auto t : adjacency_[from]) {
+               if (removed_[t])
+                  continue;
+
+               auto* const c = &indices_[3 * t];
+               if (c[0] == to or c[1] == to or c[2] == to) {
+                  removed_[t] = true;
+                  ++removed;
+               }
+               else {
+                  std::replace(c, c + 3, from, to);
+                  adjacency_[to].push_back(t);
+               }
+            }
+
+            dead_[from] = true;
+            adjacency_[from] = {};
+            quadrics_[to] += quadrics_[from];
+
+            // only collapses that involve `to` have changed cost
+            ++versions_[to];
+            auto& around = adjacency_[to];
+            around.erase(std::remove_if(around.begin(), around.end(),
+               [this](const auto t) { return removed_[t]; }), around.end());
+            for (const auto t : around) {
+               const auto* const c = &indices_[3 * t];
+               for (auto k = std::size_t{0}; k < 3; ++k) {
+                  if (c[k] != to)
+                     push(to, c[k]);
+               }
+            }
+            return removed;
+         }
+      };
+   } // namespace <anonymous>
+
+   simplified_indices simplify(const mesh_data& mesh, const gsl::span<const std::uint32_t> indices,
+      const std::size_t target_triangles, const float max_error)
+   {
+      Expects(mesh.stride > 0);
+      return simplifier{mesh, indices}.run(target_triangles, max_error);
+   }
+
+   std::size_t generate_lods(mesh_data& mesh, const std::size_t levels, const float ratio,
+      const float max_error)
+   {
+      Expects(ratio > 0.0f and ratio < 1.0f);
+
+      if (mesh.lods.empty())
+         mesh.lods.push_back({0, gsl::narrow_cast<std::uint32_t>(mesh.indices.size()), 0.0f, 0});
+      if (mesh.sphere.w <= 0.0f)
+         mesh.compute_bounds();
+
+      const auto budget = max_error * mesh.sphere.w;
+      auto added = std::size_t{0};
+      for (; added < levels; ++added) {
+         const auto previous = mesh.lods.back();
+         const auto triangles = std::size_t{previous.index_count} / 3;
+         const auto target = static_cast<std::size_t>(triangles * ratio);
+         if (target == 0 or previous.error >= budget)
+            break;
+
+         const auto source = gsl::span<const std::uint32_t>{mesh.indices}.subspan(
+            gsl::narrow_cast<std::ptrdiff_t>(previous.first_index),
+            gsl::narrow_cast<std::ptrdiff_t>(previous.index_count));
+         auto next = simplify(mesh, source, target, budget - previous.error);
+
+         // a level that barely shrinks isn't worth the memory, and the next one won't either
+         if (next.indices.empty() or next.indices.size() / 3 > triangles - triangles / 8)
+            break;
+
+         mesh.lods.push_back({gsl::narrow_cast<std::uint32_t>(mesh.indices.size()),
+            gsl::narrow_cast<std::uint32_t>(next.indices.size()), previous.error + next.error,
+            0});
+         mesh.indices.insert(mesh.indices.end(), next.indices.begin(), next.indices.end());
+      }
+      return added;
+   }
+} // namespace doge
@@ -0,0 +1,166 @@
+//
+//  Copyright 2018 Christopher Di Bella
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+#include <algorithm>
+#include <cmath>
+#include <doge/gl/occlusion.hpp>
+#include <doge/gl/state_cache.hpp>
+#include <glm/gtc/type_ptr.hpp>
+
+namespace doge {
+   namespace {
+      constexpr GLsizei level_extent(const GLsizei base, const GLsizei level) noexcept
+      {
+         return std::max(base >> level, GLsizei{1});
+      }
+
+      constexpr GLuint statistics_binding = 3;
+   } // namespace <anonymous>
+
+   occlusion_culler::occlusion_culler(const GLsizei width, const GLsizei height,
+      shader_cache& cache, const std::string& reduce_path, const std::string& test_path)
+      : copy_{reduce_path, cache, {{"DOGE_HIZ_COPY", "1"}}},
+        reduce_{reduce_path, cache},
+        test_{test_path, cache}
+   {
+      for (auto& i : counters_) {
+         i = unique_buffer::generate();
+         gl_state().bind_buffer(gl::COPY_WRITE_BUFFER, i);
+         gl::BufferData(gl::COPY_WRITE_BUFFER, 2 * sizeof(GLuint), nullptr, gl::DYNAMIC_READ);
+      }
+      gl_state().bind_buffer(gl::COPY_WRITE_BUFFER, 0);
+
+      resize(width, height);
+   }
+
+   occlusion_culler::~occlusion_culler() noexcept
+   {
+      for (const auto i : fences_) {
+         if (i)
+            gl::DeleteSync(i);
+      }
+   }
+
+   void occlusion_culler::resize(const GLsizei width, const GLsizei height)
+   {
+      Expects(width > 0 and height > 0);
+      width_ = width;
+      height_ = height;
+      levels_ = gsl::narrow_cast<GLsizei>(std::log2(std::max(width, height))) + 1;
+
+      const auto wrapping = std::make_tuple(texture_wrap_t::clamp_to_edge,
+         texture_wrap_t::clamp_to_edge);
+      depth_.emplace([&]{
+         gl::TexStorage2D(gl::TEXTURE_2D, 1, gl::DEPTH_COMPONENT32F, width, height);
+      }, wrapping, minmag_t::nearest, minmag_t::nearest);
+
+      pyramid_.emplace([&]{
+         gl::TexStorage2D(gl::TEXTURE_2D, levels_, gl::R32F, width, height);
+      }, wrapping, minmag_t::nearest_mipmap_nearest, minmag_t::nearest);
+   }
+
+   void occlusion_culler::build_pyramid()
+   {
+      depth_->bind(gl::TEXTURE0, [this]{
+         gl::CopyTexSubImage2D(gl::TEXTURE_2D, 0, 0, 0, 0, 0, width_, height_);
+      });
+
+      bind_image(*pyramid_, 0, gl::WRITE_ONLY, gl::R32F, 0);
+      copy_.dispatch(copy_.groups_for(static_cast<std::size_t>(width_), 0),
+         copy_.groups_for(static_cast<std::size_t>(height_), 1));
+      memory_barrier(gl::TEXTURE_FETCH_BARRIER_BIT | gl::SHADER_IMAGE_ACCESS_BARRIER_BIT);
+
+      // each level is reduced from the one above it, which is made the only level that can be
+      // sampled, so that the level being written is never read
+      pyramid_->bind(gl::TEXTURE0);
+      for (auto level = GLsizei{1}; level < levels_; ++level) {
+         texture_parameter(*pyramid_, gl::TEXTURE_BASE_LEVEL, level - 1);
+         texture_parameter(*pyramid_, gl::TEXTURE_MAX_LEVEL, level - 1);
+         bind_image(*pyramid_, 0, gl::WRITE_ONLY, gl::R32F, level);
+
+         const auto width = static_cast<std::size_t>(level_extent(width_, level));
+         const auto height = static_cast<std::size_t>(level_extent(height_, level));
+         reduce_.dispatch(reduce_.groups_for(width, 0), reduce_.groups_for(height, 1));
+         memory_barrier(gl::TEXTURE_FETCH_BARRIER_BIT | gl::SHADER_IMAGE_ACCESS_BARRIER_BIT);
+      }
+
+      texture_parameter(*pyramid_, gl::TEXTURE_BASE_LEVEL, 0);
+      texture_parameter(*pyramid_, gl::TEXTURE_MAX_LEVEL, levels_ - 1);
+   }
+
+   void occlusion_culler::cull(const glm::mat4& view_projection,
+      const storage_buffer<glm::vec4>& spheres, mesh_pool& pool)
+   {
+      const auto meshes = pool.size();
+      Expects(spheres.size() >= meshes);
+      if (meshes == 0)
+         return;
+
+      if (not commands_ or commands_->size() < meshes)
+         commands_.emplace(meshes * 2);
+
+      const auto slot = frame_ % statistics_latency;
+      collect_statistics(slot);
+
+      constexpr GLuint zero[] = {0, 0};
+      gl_state().bind_buffer(gl::COPY_WRITE_BUFFER, counters_[slot]);
+      gl::BufferSubData(gl::COPY_WRITE_BUFFER, 0, sizeof(zero), zero);
+      gl_state().bind_buffer(gl::COPY_WRITE_BUFFER, 0);
+
+      const auto& program = test_.program();
+      test_.use([&]{
+         gl::UniformMatrix4fv(program.uniform_location("view_projection"), 1, false,
+            glm::value_ptr(view_projection));
+         gl::Uniform2f(program.uniform_location("viewport"), static_cast<GLfloat>(width_),
+            static_cast<GLfloat>(height_));
+         gl::Uniform1i(program.uniform_location("levels"), levels_);
+         gl::Uniform1ui(program.uniform_location("mesh_count"), gsl::narrow_cast<GLuint>(meshes));
+      });
+
+      pyramid_->bind(gl::TEXTURE0);
+      spheres.bind(0);
+      gl_state().bind_buffer_range(gl::SHADER_STORAGE_BUFFER, 1, pool.commands_buffer(), 0,
+         gsl::narrow_cast<GLsizeiptr>(meshes * sizeof(draw_elements_indirect_command)));
+      commands_->bind(2);
+      gl_state().bind_buffer_base(gl::SHADER_STORAGE_BUFFER, statistics_binding, counters_[slot]);
+
+      test_.dispatch(test_.groups_for(meshes));
+      memory_barrier(gl::COMMAND_BARRIER_BIT | gl::SHADER_STORAGE_BARRIER_BIT
+         | gl::BUFFER_UPDATE_BARRIER_BIT);
+
+      fences_[slot] = gl::FenceSync(gl::SYNC_GPU_COMMANDS_COMPLETE, 0);
+      ++frame_;
+   }
+
+   void occlusion_culler::collect_statistics(const std::size_t slot)
+   {
+      auto& fence = fences_[slot];
+      if (not fence)
+         return;
+
+      // a cull that still hasn't finished after a few frames is skipped, rather than waited on
+      const auto status = gl::ClientWaitSync(fence, 0, 0);
+      if (status == gl::ALREADY_SIGNALED or status == gl::CONDITION_SATISFIED) {
+         GLuint counts[] = {0, 0};
+         gl_state().bind_buffer(gl::COPY_READ_BUFFER, counters_[slot]);
+         gl::GetBufferSubData(gl::COPY_READ_BUFFER, 0, sizeof(counts), counts);
+         gl_state().bind_buffer(gl::COPY_READ_BUFFER, 0);
+         statistics_ = {counts[0], counts[1]};
+      }
+
+      gl::DeleteSync(fence);
+      fence = nullptr;
+   }
+} // namespace doge
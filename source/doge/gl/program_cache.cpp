@@ -0,0 +1,140 @@
+//
+//  Copyright 2018 Christopher Di Bella
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+#include <array>
+#include <cinttypes>
+#include <cstdio>
+#include <doge/gl/program_cache.hpp>
+#include <doge/gl/shader_binary.hpp>
+#include <doge/gl/state_cache.hpp>
+#include <experimental/ranges/concepts>
+#include <fstream>
+#include <string_view>
+
+namespace doge {
+   namespace ranges = std::experimental::ranges;
+
+   namespace {
+      constexpr std::uint64_t fnv_offset_basis = 14695981039346656037ull;
+      constexpr std::uint64_t fnv_prime = 1099511628211ull;
+
+      // FNV-1a is used instead of std::hash because the keys must be stable between runs
+      std::uint64_t fnv1a(std::uint64_t hash, const std::string_view bytes) noexcept
+      {
+         for (const auto c : bytes) {
+            hash ^= static_cast<unsigned char>(c);
+            hash *= fnv_prime;
+         }
+         return hash;
+      }
+
+      std::string_view gl_string(const GLenum name) noexcept
+      {
+         const auto s = reinterpret_cast<const char*>(gl::GetString(name));
+         return s ? s : "";
+      }
+
+      struct binary_header {
+         std::uint64_t key;
+         GLenum format;
+         GLsizei length;
+      };
+   } // namespace <anonymous>
+
+   program_cache::program_cache(std::string directory)
+      : directory_{std::move(directory)},
+        driver_{fnv1a(fnv1a(fnv1a(fnv_offset_basis, gl_string(gl::VENDOR)),
+           gl_string(gl::RENDERER)), gl_string(gl::VERSION))}
+   {}
+
+   std::uint64_t program_cache::key(const sources_t& sources) const noexcept
+   {
+      ranges::Regular hash = driver_;
+      for (const auto& [type, source] : sources) {
+         const ranges::Regular t = static_cast<GLenum>(type);
+         hash = fnv1a(hash, {reinterpret_cast<const char*>(&t), sizeof(t)});
+         hash = fnv1a(hash, source);
+      }
+      return hash;
+   }
+
+   bool program_cache::load(const std::uint64_t key, const GLuint program)
+   {
+      auto in = std::ifstream{path(key), std::ios::binary | std::ios::ate};
+      const ranges::SignedIntegral size = static_cast<std::streamoff>(in.tellg());
+      in.seekg(0);
+
+      ranges::Regular header = binary_header{};
+      if (not in.read(reinterpret_cast<char*>(&header), sizeof(header)) or header.key != key) {
+         ++statistics_.misses;
+         return false;
+      }
+
+      // a truncated or corrupt file is a miss, rather than a length to allocate blindly
+      const ranges::SignedIntegral available = size - static_cast<std::streamoff>(sizeof(header));
+      if (header.length <= 0 or header.length > available) {
+         ++statistics_.misses;
+         return false;
+      }
+
+      ranges::Regular binary = std::vector<char>(header.length);
+      if (not in.read(binary.data(), header.length)) {
+         ++statistics_.misses;
+         return false;
+      }
+
+      gl::ProgramBinary(program, header.format, binary.data(), header.length);
+      ranges::SignedIntegral successful = 0;
+      if (gl::GetProgramiv(program, gl::LINK_STATUS, &successful); not successful) {
+         ++statistics_.rejected;
+         return false;
+      }
+
+      ++statistics_.hits;
+      return true;
+   }
+
+   void program_cache::store(const std::uint64_t key, const GLuint program) const
+   {
+      ranges::SignedIntegral length = 0;
+      gl::GetProgramiv(program, gl::PROGRAM_BINARY_LENGTH, &length);
+      if (length <= 0) // the driver doesn't support any binary formats
+         return;
+
+      ranges::Regular header = binary_header{key, GLenum{}, GLsizei{}};
+      ranges::Regular binary = std::vector<char>(length);
+      gl::GetProgramBinary(program, length, &header.length, &header.format, binary.data());
+
+      if (auto out = std::ofstream{path(key), std::ios::binary}) {
+         out.write(reinterpret_cast<const char*>(&header), sizeof(header));
+         out.write(binary.data(), header.length);
+      }
+   }
+
+   void program_cache::prewarm(const std::vector<sources_t>& paths)
+   {
+      for (const auto& i : paths) {
+         const auto program = shader_binary{i, *this};
+         delete_program(static_cast<GLuint>(program));
+      }
+   }
+
+   std::string program_cache::path(const std::uint64_t key) const
+   {
+      ranges::Regular name = std::array<char, 17>{};
+      std::snprintf(name.data(), name.size(), "%016" PRIx64, key);
+      return directory_ + '/' + name.data() + ".program";
+   }
+} // namespace doge
@@ -0,0 +1,149 @@
+//
+//  Copyright 2018 Christopher Di Bella
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+#include <doge/gl/readback.hpp>
+
+namespace doge {
+   namespace {
+      std::size_t encoded_size(const GLsizei width, const GLsizei height,
+         const readback_encoding encoding) noexcept
+      {
+         const auto pixels = static_cast<std::size_t>(width) * static_cast<std::size_t>(height);
+         return encoding == readback_encoding::rgba8 ? pixels * 4 : pixels * 3 / 2;
+      }
+   } // namespace <anonymous>
+
+   async_readback::async_readback(const GLsizei width, const GLsizei height,
+      const std::size_t depth)
+      : width_{width},
+        height_{height},
+        frame_size_{encoded_size(width, height, readback_encoding::rgba8)}
+   {
+      Expects(width > 0 and height > 0);
+      allocate(depth);
+   }
+
+   async_readback::async_readback(const GLsizei width, const GLsizei height,
+      const readback_encoding encoding, shader_cache& cache, const std::size_t depth,
+      const std::string& path)
+      : width_{width},
+        height_{height},
+        encoding_{encoding},
+        frame_size_{encoded_size(width, height, encoding)}
+   {
+      Expects(width > 0 and height > 0);
+      if (encoding == readback_encoding::i420) {
+         // each invocation converts an 8 by 2 block, so that every write is a whole uint
+         Expects(width % 8 == 0 and height % 2 == 0);
+         convert_.emplace(path, cache);
+      }
+      allocate(depth);
+   }
+
+   async_readback::~async_readback() noexcept
+   {
+      for (const auto& i : slots_) {
+         if (i.fence)
+            gl::DeleteSync(i.fence);
+      }
+   }
+
+   void async_readback::read(const GLint x, const GLint y)
+   {
+      Expects(encoding_ == readback_encoding::rgba8);
+      const auto s = acquire();
+      if (s == nullptr)
+         return;
+
+      gl_state().bind_buffer(gl::PIXEL_PACK_BUFFER, s->buffer);
+      gl::ReadPixels(x, y, width_, height_, gl::RGBA, gl::UNSIGNED_BYTE, nullptr);
+      gl_state().bind_buffer(gl::PIXEL_PACK_BUFFER, 0);
+      submit(*s);
+   }
+
+   void async_readback::read(const framebuffer& source)
+   {
+      Expects(source.width() >= width_ and source.height() >= height_);
+      source.resolve();
+      if (encoding_ == readback_encoding::rgba8) {
+         read(0, 0);
+         return;
+      }
+
+      const auto s = acquire();
+      if (s == nullptr)
+         return;
+
+      const auto& program = convert_->program();
+      convert_->use([&]{
+         gl::Uniform2i(program.uniform_location("frame_size"), width_, height_);
+      });
+      source.colour().bind(gl::TEXTURE0);
+      gl_state().bind_buffer_base(gl::SHADER_STORAGE_BUFFER, 0, s->buffer);
+
+      const auto blocks_x = static_cast<std::size_t>(width_ / 8);
+      const auto blocks_y = static_cast<std::size_t>(height_ / 2);
+      convert_->dispatch(convert_->groups_for(blocks_x, 0), convert_->groups_for(blocks_y, 1));
+      memory_barrier(gl::BUFFER_UPDATE_BARRIER_BIT);
+      submit(*s);
+   }
+
+   void async_readback::allocate(const std::size_t depth)
+   {
+      Expects(depth > 0);
+      slots_.resize(depth);
+      for (auto& i : slots_) {
+         i.buffer = unique_buffer::generate();
+         gl_state().bind_buffer(gl::PIXEL_PACK_BUFFER, i.buffer);
+         gl::BufferData(gl::PIXEL_PACK_BUFFER, gsl::narrow_cast<GLsizeiptr>(frame_size_), nullptr,
+            gl::STREAM_READ);
+      }
+      gl_state().bind_buffer(gl::PIXEL_PACK_BUFFER, 0);
+   }
+
+   async_readback::slot* async_readback::acquire() noexcept
+   {
+      if (pending_ == slots_.size()) {
+         ++statistics_.dropped;
+         ++frame_;
+         return nullptr;
+      }
+      return &slots_[next_];
+   }
+
+   void async_readback::submit(slot& s) noexcept
+   {
+      s.fence = gl::FenceSync(gl::SYNC_GPU_COMMANDS_COMPLETE, 0);
+      s.frame = frame_++;
+      next_ = (next_ + 1) % slots_.size();
+      ++pending_;
+      ++statistics_.captured;
+   }
+
+   bool async_readback::finished(slot& s) noexcept
+   {
+      if (s.fence == nullptr)
+         return true;
+
+      // the first check flushes, so that a fence issued just before a long pause still signals
+      const auto status = gl::ClientWaitSync(s.fence, gl::SYNC_FLUSH_COMMANDS_BIT, 0);
+      if (status != gl::ALREADY_SIGNALED and status != gl::CONDITION_SATISFIED)
+         return false;
+
+      gl::DeleteSync(s.fence);
+      s.fence = nullptr;
+      return true;
+   }
+} // namespace doge
@@ -0,0 +1,129 @@
+//
+//  Copyright 2018 Christopher Di Bella
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+#include <algorithm>
+#include <doge/gl/render_queue.hpp>
+#include <doge/gl/state_cache.hpp>
+#include <gsl/gsl>
+#include <utility>
+
+namespace doge {
+   namespace {
+      constexpr auto radix_bits = 16;
+      constexpr auto radix_size = std::size_t{1} << radix_bits;
+
+      std::size_t index_size(const GLenum type) noexcept
+      {
+         switch (type) {
+         case gl::UNSIGNED_BYTE:
+            return 1;
+         case gl::UNSIGNED_SHORT:
+            return 2;
+         default:
+            return 4;
+         }
+      }
+   } // namespace <anonymous>
+
+   render_queue::bucket_type& render_queue::bucket()
+   {
+      auto lock = std::lock_guard{mutex_};
+      if (buckets_used_ == buckets_.size())
+         buckets_.emplace_back();
+      return buckets_[buckets_used_++];
+   }
+
+   void render_queue::submit()
+   {
+      order_.clear();
+      for (auto i = std::size_t{0}; i != buckets_used_; ++i) {
+         for (const auto& packet : buckets_[i])
+            order_.push_back({packet.key, &packet});
+      }
+      sort();
+
+      statistics_ = {};
+      statistics_.packets = order_.size();
+
+      auto& state = gl_state();
+      const draw_packet* previous = nullptr;
+      for (const auto& i : order_) {
+         const auto& p = *i.packet;
+         if (not previous or previous->program != p.program) {
+            state.use_program(p.program);
+            ++statistics_.program_changes;
+         }
+
+         for (auto unit = std::size_t{0}; unit != draw_packet::max_textures; ++unit) {
+            const auto& t = p.textures[unit];
+            if (t.texture == 0)
+               continue;
+            if (not previous or previous->textures[unit].texture != t.texture)
+               ++statistics_.texture_changes;
+            state.bind_texture(gl::TEXTURE0 + gsl::narrow_cast<GLenum>(unit), t.target,
+               t.texture);
+         }
+
+         if (not previous or previous->vertex_array != p.vertex_array) {
+            state.bind_vertex_array(p.vertex_array);
+            ++statistics_.vertex_array_changes;
+         }
+
+         if (p.index_type == 0) {
+            gl::DrawArraysInstancedBaseInstance(p.mode, p.first, p.count, p.instances,
+               p.base_instance);
+         }
+         else {
+            const auto offset = static_cast<std::uintptr_t>(p.first) * index_size(p.index_type);
+            gl::DrawElementsInstancedBaseVertexBaseInstance(p.mode, p.count, p.index_type,
+               reinterpret_cast<const void*>(offset), p.instances, p.base_vertex,
+               p.base_instance);
+         }
+         previous = i.packet;
+      }
+
+      for (auto i = std::size_t{0}; i != buckets_used_; ++i)
+         buckets_[i].clear();
+      buckets_used_ = 0;
+   }
+
+   // an LSD radix sort on 16-bit digits; stable, so equal keys keep their recording order
+   void render_queue::sort()
+   {
+      if (order_.size() < 2)
+         return;
+
+      scratch_.resize(order_.size());
+      counts_.resize(radix_size);
+      for (auto shift = 0; shift != 64; shift += radix_bits) {
+         std::fill(counts_.begin(), counts_.end(), std::size_t{0});
+         for (const auto& i : order_)
+            ++counts_[(i.key >> shift) & (radix_size - 1)];
+
+         // every key shares this digit, so the pass wouldn't move anything
+         const auto digit = (order_.front().key >> shift) & (radix_size - 1);
+         if (counts_[digit] == order_.size())
+            continue;
+
+         auto total = std::size_t{0};
+         for (auto& i : counts_)
+            total += std::exchange(i, total);
+
+         for (const auto& i : order_)
+            scratch_[counts_[(i.key >> shift) & (radix_size - 1)]++] = i;
+         order_.swap(scratch_);
+      }
+   }
+} // namespace doge
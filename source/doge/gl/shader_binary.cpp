@@ -1,23 +1,288 @@
+#include <doge/gl/program_cache.hpp>
+#include <doge/gl/shader_cache.hpp>
 #include <doge/gl/shader_binary.hpp>
+#include <algorithm>
+#include <cstring>
+#include <doge/utility/file.hpp>
+#include <experimental/ranges/algorithm>
 #include <experimental/ranges/concepts>
+#include <functional>
 
 namespace doge {
    namespace ranges = std::experimental::ranges;
    using std::vector, std::pair, std::string;
 
+   namespace {
+      std::size_t hash_name(const std::string_view name) noexcept
+      {
+         return std::hash<std::string_view>{}(name);
+      }
+
+      struct uniform_layout {
+         GLenum component;
+         std::uint32_t components;
+      };
+
+      uniform_layout layout_of(const GLenum type) noexcept
+      {
+         switch (type) {
+         case gl::FLOAT: return {gl::FLOAT, 1};
+         case gl::FLOAT_VEC2: return {gl::FLOAT, 2};
+         case gl::FLOAT_VEC3: return {gl::FLOAT, 3};
+         case gl::FLOAT_VEC4: return {gl::FLOAT, 4};
+         case gl::FLOAT_MAT2: return {gl::FLOAT, 4};
+         case gl::FLOAT_MAT3: return {gl::FLOAT, 9};
+         case gl::FLOAT_MAT4: return {gl::FLOAT, 16};
+         case gl::FLOAT_MAT2x3: case gl::FLOAT_MAT3x2: return {gl::FLOAT, 6};
+         case gl::FLOAT_MAT2x4: case gl::FLOAT_MAT4x2: return {gl::FLOAT, 8};
+         case gl::FLOAT_MAT3x4: case gl::FLOAT_MAT4x3: return {gl::FLOAT, 12};
+         case gl::DOUBLE: return {gl::DOUBLE, 1};
+         case gl::DOUBLE_VEC2: return {gl::DOUBLE, 2};
+         case gl::DOUBLE_VEC3: return {gl::DOUBLE, 3};
+         case gl::DOUBLE_VEC4: return {gl::DOUBLE, 4};
+         case gl::DOUBLE_MAT2: return {gl::DOUBLE, 4};
+         case gl::DOUBLE_MAT3: return {gl::DOUBLE, 9};
+         case gl::DOUBLE_MAT4: return {gl::DOUBLE, 16};
+         case gl::DOUBLE_MAT2x3: case gl::DOUBLE_MAT3x2: return {gl::DOUBLE, 6};
+         case gl::DOUBLE_MAT2x4: case gl::DOUBLE_MAT4x2: return {gl::DOUBLE, 8};
+         case gl::DOUBLE_MAT3x4: case gl::DOUBLE_MAT4x3: return {gl::DOUBLE, 12};
+         case gl::UNSIGNED_INT: return {gl::UNSIGNED_INT, 1};
+         case gl::UNSIGNED_INT_VEC2: return {gl::UNSIGNED_INT, 2};
+         case gl::UNSIGNED_INT_VEC3: return {gl::UNSIGNED_INT, 3};
+         case gl::UNSIGNED_INT_VEC4: return {gl::UNSIGNED_INT, 4};
+         case gl::BOOL: return {gl::BOOL, 1};
+         case gl::BOOL_VEC2: return {gl::BOOL, 2};
+         case gl::BOOL_VEC3: return {gl::BOOL, 3};
+         case gl::BOOL_VEC4: return {gl::BOOL, 4};
+         case gl::INT_VEC2: return {gl::INT, 2};
+         case gl::INT_VEC3: return {gl::INT, 3};
+         case gl::INT_VEC4: return {gl::INT, 4};
+         default: return {gl::INT, 1}; // ints, samplers and images
+         }
+      }
+
+      void read_uniform(const GLuint program, const GLint location, const GLenum component,
+         std::byte* const out) noexcept
+      {
+         switch (component) {
+         case gl::FLOAT:
+            gl::GetUniformfv(program, location, reinterpret_cast<GLfloat*>(out));
+            break;
+         case gl::DOUBLE:
+            gl::GetUniformdv(program, location, reinterpret_cast<GLdouble*>(out));
+            break;
+         case gl::UNSIGNED_INT:
+            gl::GetUniformuiv(program, location, reinterpret_cast<GLuint*>(out));
+            break;
+         default:
+            gl::GetUniformiv(program, location, reinterpret_cast<GLint*>(out));
+            break;
+         }
+      }
+
+      void send_uniform(const GLuint program, const GLint location, const GLenum type,
+         const GLsizei count, const std::byte* const data) noexcept
+      {
+         const auto f = reinterpret_cast<const GLfloat*>(data);
+         const auto d = reinterpret_cast<const GLdouble*>(data);
+         const auto u = reinterpret_cast<const GLuint*>(data);
+         const auto i = reinterpret_cast<const GLint*>(data);
+         switch (type) {
+         case gl::FLOAT: gl::ProgramUniform1fv(program, location, count, f); break;
+         case gl::FLOAT_VEC2: gl::ProgramUniform2fv(program, location, count, f); break;
+         case gl::FLOAT_VEC3: gl::ProgramUniform3fv(program, location, count, f); break;
+         case gl::FLOAT_VEC4: gl::ProgramUniform4fv(program, location, count, f); break;
+         case gl::FLOAT_MAT2:
+            gl::ProgramUniformMatrix2fv(program, location, count, false, f);
+            break;
+         case gl::FLOAT_MAT3:
+            gl::ProgramUniformMatrix3fv(program, location, count, false, f);
+            break;
+         case gl::FLOAT_MAT4:
+            gl::ProgramUniformMatrix4fv(program, location, count, false, f);
+            break;
+         case gl::FLOAT_MAT2x3:
+            gl::ProgramUniformMatrix2x3fv(program, location, count, false, f);
+            break;
+         case gl::FLOAT_MAT2x4:
+            gl::ProgramUniformMatrix2x4fv(program, location, count, false, f);
+            break;
+         case gl::FLOAT_MAT3x2:
+            gl::ProgramUniformMatrix3x2fv(program, location, count, false, f);
+            break;
+         case gl::FLOAT_MAT3x4:
+            gl::ProgramUniformMatrix3x4fv(program, location, count, false, f);
+            break;
+         case gl::FLOAT_MAT4x2:
+            gl::ProgramUniformMatrix4x2fv(program, location, count, false, f);
+            break;
+         case gl::FLOAT_MAT4x3:
+            gl::ProgramUniformMatrix4x3fv(program, location, count, false, f);
+            break;
+         case gl::DOUBLE: gl::ProgramUniform1dv(program, location, count, d); break;
+         case gl::DOUBLE_VEC2: gl::ProgramUniform2dv(program, location, count, d); break;
+         case gl::DOUBLE_VEC3: gl::ProgramUniform3dv(program, location, count, d); break;
+         case gl::DOUBLE_VEC4: gl::ProgramUniform4dv(program, location, count, d); break;
+         case gl::DOUBLE_MAT2:
+            gl::ProgramUniformMatrix2dv(program, location, count, false, d);
+            break;
+         case gl::DOUBLE_MAT3:
+            gl::ProgramUniformMatrix3dv(program, location, count, false, d);
+            break;
+         case gl::DOUBLE_MAT4:
+            gl::ProgramUniformMatrix4dv(program, location, count, false, d);
+            break;
+         case gl::DOUBLE_MAT2x3:
+            gl::ProgramUniformMatrix2x3dv(program, location, count, false, d);
+            break;
+         case gl::DOUBLE_MAT2x4:
+            gl::ProgramUniformMatrix2x4dv(program, location, count, false, d);
+            break;
+         case gl::DOUBLE_MAT3x2:
+            gl::ProgramUniformMatrix3x2dv(program, location, count, false, d);
+            break;
+         case gl::DOUBLE_MAT3x4:
+            gl::ProgramUniformMatrix3x4dv(program, location, count, false, d);
+            break;
+         case gl::DOUBLE_MAT4x2:
+            gl::ProgramUniformMatrix4x2dv(program, location, count, false, d);
+            break;
+         case gl::DOUBLE_MAT4x3:
+            gl::ProgramUniformMatrix4x3dv(program, location, count, false, d);
+            break;
+         case gl::UNSIGNED_INT: gl::ProgramUniform1uiv(program, location, count, u); break;
+         case gl::UNSIGNED_INT_VEC2: gl::ProgramUniform2uiv(program, location, count, u); break;
+         case gl::UNSIGNED_INT_VEC3: gl::ProgramUniform3uiv(program, location, count, u); break;
+         case gl::UNSIGNED_INT_VEC4: gl::ProgramUniform4uiv(program, location, count, u); break;
+         case gl::INT_VEC2: case gl::BOOL_VEC2:
+            gl::ProgramUniform2iv(program, location, count, i);
+            break;
+         case gl::INT_VEC3: case gl::BOOL_VEC3:
+            gl::ProgramUniform3iv(program, location, count, i);
+            break;
+         case gl::INT_VEC4: case gl::BOOL_VEC4:
+            gl::ProgramUniform4iv(program, location, count, i);
+            break;
+         default: gl::ProgramUniform1iv(program, location, count, i); break;
+         }
+      }
+
+      // lets the driver pick how many threads it compiles with
+      void allow_parallel_compile() noexcept
+      {
+         static const auto once = []{
+            if (gl::exts::var_KHR_parallel_shader_compile)
+               gl::MaxShaderCompilerThreadsKHR(0xFFFFFFFF);
+            return true;
+         }();
+         static_cast<void>(once);
+      }
+   } // namespace <anonymous>
+
+   shader_binary::shader_binary(const vector<pair<shader_source::type, string>>& paths,
+      program_cache& cache)
+      : index_{gl::CreateProgram()}
+   {
+      ranges::Regular sources = paths;
+      for (auto& i : sources)
+         i.second = from_file<string>(i.second);
+
+      const ranges::Regular key = cache.key(sources);
+      if (not cache.load(key, index_)) {
+         gl::ProgramParameteri(index_, gl::PROGRAM_BINARY_RETRIEVABLE_HINT, true);
+
+         // compiles the code that was read for the key, rather than reading each file again
+         ranges::Regular shaders = vector<shader_source>{};
+         shaders.reserve(sources.size());
+         for (auto i = decltype(sources.size()){}; i != sources.size(); ++i)
+            shaders.emplace_back(sources[i].first, shader_code, sources[i].second, paths[i].second);
+         link(shaders);
+         cache.store(key, index_);
+      }
+
+      reflect_uniforms();
+   }
+
    shader_binary::shader_binary(const vector<shader_source>& shaders)
       : index_{gl::CreateProgram()}
    {
-      for (const auto& i : shaders)
+      link(shaders);
+      reflect_uniforms();
+   }
+
+   shader_binary::shader_binary(const vector<pair<shader_source::type, string>>& paths,
+      shader_cache& cache, const shader_defines& defines)
+      : index_{gl::CreateProgram()}
+   {
+      // the cache owns the shaders, which stay attached to every program built from them
+      for (const auto& [type, path] : paths)
+         gl::AttachShader(index_, *cache.get(type, path, defines));
+      gl::LinkProgram(index_);
+      check_link();
+      reflect_uniforms();
+   }
+
+   shader_binary::shader_binary(const vector<pair<shader_source::type, string>>& paths,
+      deferred_build_t)
+      : index_{gl::CreateProgram()}
+   {
+      allow_parallel_compile();
+
+      auto build = pending_build{};
+      build.shaders.reserve(paths.size());
+      for (const auto& [type, path] : paths) {
+         build.shaders.emplace_back(type, path, deferred_build);
+         build.paths.push_back(path);
+      }
+
+      // linking doesn't need to wait for compilation to have finished
+      for (const auto& i : build.shaders)
          gl::AttachShader(index_, i);
       gl::LinkProgram(index_);
+      pending_ = std::move(build);
+   }
 
-      ranges::SignedIntegral successful = 0;
-      if (gl::GetProgramiv(index_, gl::LINK_STATUS, &successful); not successful) {
-         ranges::Regular log = std::string(512, '\0');
-         gl::GetProgramInfoLog(index_, log.size(), nullptr, log.data());
-         throw std::runtime_error{log};
+   bool shader_binary::ready() const noexcept
+   {
+      if (not pending_ or not gl::exts::var_KHR_parallel_shader_compile)
+         return true;
+
+      ranges::SignedIntegral complete = 0;
+      gl::GetProgramiv(index_, gl::COMPLETION_STATUS_KHR, &complete);
+      return complete;
+   }
+
+   void shader_binary::wait() const
+   {
+      if (not pending_)
+         return;
+
+      // errors are only reported once, so the build is no longer pending even if it throws
+      const auto build = std::move(*pending_);
+      pending_.reset();
+
+      for (auto i = std::size_t{0}; i != build.shaders.size(); ++i)
+         build.shaders[i].check(build.paths[i]);
+      check_link();
+      reflect_uniforms();
+   }
+
+   GLint shader_binary::uniform_location(const std::string_view id) const
+   {
+      wait();
+      const ranges::Regular hash = hash_name(id);
+      const auto first = ranges::lower_bound(uniforms_, hash, ranges::less<>{}, &uniform_entry::hash);
+      for (auto i = first; i != ranges::end(uniforms_) and i->hash == hash; ++i) {
+         if (i->name == id) {
+            ++lookups_.hits;
+            return i->location;
+         }
       }
+
+      ++lookups_.misses;
+      if (ranges::SignedIntegral i = gl::GetUniformLocation(index_, string{id}.c_str()); i >= 0)
+         return i;
+      throw uniform_not_found{id};
    }
 
    vector<shader_source>
@@ -29,4 +294,211 @@ namespace doge {
          shaders.emplace_back(i.first, i.second);
       return shaders;
    }
+
+   void shader_binary::link(const vector<shader_source>& shaders)
+   {
+      for (const auto& i : shaders)
+         gl::AttachShader(index_, i);
+      gl::LinkProgram(index_);
+      check_link();
+   }
+
+   void shader_binary::check_link() const
+   {
+      ranges::SignedIntegral successful = 0;
+      if (gl::GetProgramiv(index_, gl::LINK_STATUS, &successful); not successful) {
+         ranges::Regular log = std::string(512, '\0');
+         gl::GetProgramInfoLog(index_, log.size(), nullptr, log.data());
+         throw std::runtime_error{log};
+      }
+   }
+
+   void shader_binary::reflect_uniforms() const
+   {
+      ranges::SignedIntegral count = 0;
+      gl::GetProgramiv(index_, gl::ACTIVE_UNIFORMS, &count);
+      ranges::SignedIntegral max_length = 0;
+      gl::GetProgramiv(index_, gl::ACTIVE_UNIFORM_MAX_LENGTH, &max_length);
+
+      uniforms_.reserve(count);
+      ranges::Regular name = string(max_length, '\0');
+      for (ranges::SignedIntegral i = 0; i != count; ++i) {
+         ranges::SignedIntegral length = 0;
+         ranges::SignedIntegral size = 0;
+         ranges::Regular type = GLenum{};
+         gl::GetActiveUniform(index_, static_cast<GLuint>(i), max_length, &length, &size, &type,
+            name.data());
+
+         // members of uniform blocks don't have a location of their own
+         const ranges::SignedIntegral location = gl::GetUniformLocation(index_, name.c_str());
+         if (location < 0)
+            continue;
+
+         ranges::Regular entry = string{name.data(), static_cast<std::size_t>(length)};
+
+         // arrays are reflected as "id[0]", but are usually addressed as "id"
+         constexpr auto suffix = std::string_view{"[0]"};
+         if (entry.size() > suffix.size() and
+             std::string_view{entry}.substr(entry.size() - suffix.size()) == suffix) {
+            ranges::Regular base = entry.substr(0, entry.size() - suffix.size());
+            shadow_uniform(base, location, type, size);
+            uniforms_.push_back({hash_name(base), location, std::move(base)});
+         }
+         else {
+            shadow_uniform(entry, location, type, size);
+         }
+         uniforms_.push_back({hash_name(entry), location, std::move(entry)});
+      }
+
+      ranges::sort(uniforms_, ranges::less<>{}, &uniform_entry::hash);
+      ranges::sort(shadow_locations_, ranges::less<>{}, &shadow_location::location);
+   }
+
+   void shader_binary::shadow_uniform(const std::string_view base, const GLint location,
+      const GLenum type, const GLint elements) const
+   {
+      const auto [component, components] = layout_of(type);
+      const auto component_size = component == gl::DOUBLE ? sizeof(GLdouble) : sizeof(GLfloat);
+      auto u = shadowed_uniform{};
+      u.type = type;
+      u.component = component;
+      u.offset = gsl::narrow_cast<std::uint32_t>(shadow_.size());
+      u.element_size = gsl::narrow_cast<std::uint32_t>(components * component_size);
+      u.elements = gsl::narrow_cast<std::uint32_t>(elements);
+      u.first_location = gsl::narrow_cast<std::uint32_t>(element_locations_.size());
+
+      const auto index = gsl::narrow_cast<std::uint32_t>(shadowed_.size());
+      shadow_.resize(shadow_.size() + std::size_t{u.element_size} * u.elements);
+      for (auto i = std::uint32_t{0}; i != u.elements; ++i) {
+         // each element has a location of its own, which needn't follow the one before it
+         const auto element_name = string{base} + '[' + std::to_string(i) + ']';
+         const auto element_location = i == 0 ? location
+            : gl::GetUniformLocation(index_, element_name.c_str());
+         element_locations_.push_back(element_location);
+         if (element_location < 0)
+            continue;
+
+         shadow_locations_.push_back({element_location, index, i});
+         // the initial values needn't be zero, as GLSL can initialise uniforms
+         read_uniform(index_, element_location, component,
+            shadow_.data() + u.offset + std::size_t{i} * u.element_size);
+      }
+      shadowed_.push_back(u);
+   }
+
+   auto shader_binary::find_shadow(const GLint location) const noexcept -> const shadow_location*
+   {
+      const auto i = ranges::lower_bound(shadow_locations_, location, ranges::less<>{},
+         &shadow_location::location);
+      return i != ranges::end(shadow_locations_) and i->location == location ? &*i : nullptr;
+   }
+
+   bool shader_binary::update_shadow(const GLint location, const void* const data,
+      const std::size_t size) const
+   {
+      const auto found = find_shadow(location);
+      if (not found) {
+         ++lookups_.uploads;
+         return true;
+      }
+
+      auto& u = shadowed_[found->uniform];
+      const auto count = size / u.element_size;
+      if (size == 0 or size % u.element_size != 0 or found->element + count > u.elements) {
+         // not a value the shadow can hold, e.g. a vec3 for a vec4, which the driver will reject
+         forget_uniform(location);
+         ++lookups_.uploads;
+         return true;
+      }
+
+      const auto shadow = shadow_.data() + u.offset + std::size_t{found->element} * u.element_size;
+      if (u.known and std::memcmp(shadow, data, size) == 0) {
+         ++lookups_.redundant;
+         return false;
+      }
+
+      std::memcpy(shadow, data, size);
+      u.known = u.known or count == u.elements;
+      ++lookups_.uploads;
+      return true;
+   }
+
+   void shader_binary::forget_uniform(const GLint location) const noexcept
+   {
+      const auto found = find_shadow(location);
+      if (not found)
+         return;
+
+      // what was staged was meant to be overwritten by the caller's write, so is sent first
+      auto& u = shadowed_[found->uniform];
+      if (u.dirty_begin != u.dirty_end) {
+         send_uniform(index_, element_locations_[u.first_location + u.dirty_begin], u.type,
+            gsl::narrow_cast<GLsizei>(u.dirty_end - u.dirty_begin),
+            shadow_.data() + u.offset + std::size_t{u.dirty_begin} * u.element_size);
+         ++lookups_.uploads;
+         u.dirty_begin = u.dirty_end = 0;
+         dirty_.erase(ranges::find(dirty_, found->uniform));
+      }
+      u.known = false;
+   }
+
+   void shader_binary::stage(const GLint location, const void* const data, const std::size_t size,
+      const GLenum component) const
+   {
+      const auto found = find_shadow(location);
+      Expects(found);
+
+      const auto index = found->uniform;
+      auto& u = shadowed_[index];
+      const auto first = found->element;
+      const auto count = gsl::narrow_cast<std::uint32_t>(size / u.element_size);
+      Expects(u.component == component or u.component == gl::BOOL);
+      Expects(size != 0 and size % u.element_size == 0 and first + count <= u.elements);
+
+      const auto shadow = shadow_.data() + u.offset + std::size_t{first} * u.element_size;
+      if (u.known and std::memcmp(shadow, data, size) == 0) {
+         ++lookups_.redundant;
+         return;
+      }
+
+      // the elements between two staged ranges are sent again, which is only safe if known
+      const auto clean = u.dirty_begin == u.dirty_end;
+      if (not clean and not u.known and (first > u.dirty_end or first + count < u.dirty_begin))
+         forget_uniform(location);
+
+      std::memcpy(shadow, data, size);
+      u.known = u.known or count == u.elements;
+      if (u.dirty_begin == u.dirty_end) {
+         u.dirty_begin = first;
+         u.dirty_end = first + count;
+         dirty_.push_back(index);
+      }
+      else {
+         u.dirty_begin = std::min(u.dirty_begin, first);
+         u.dirty_end = std::max(u.dirty_end, first + count);
+      }
+   }
+
+   void shader_binary::flush_uniforms() const
+   {
+      for (const auto i : dirty_) {
+         auto& u = shadowed_[i];
+         send_uniform(index_, element_locations_[u.first_location + u.dirty_begin], u.type,
+            gsl::narrow_cast<GLsizei>(u.dirty_end - u.dirty_begin),
+            shadow_.data() + u.offset + std::size_t{u.dirty_begin} * u.element_size);
+         ++lookups_.uploads;
+         u.dirty_begin = u.dirty_end = 0;
+      }
+      dirty_.clear();
+   }
+
+   vector<shader_binary>
+   submit_programs(const vector<vector<pair<shader_source::type, string>>>& programs)
+   {
+      auto result = vector<shader_binary>{};
+      result.reserve(programs.size());
+      for (const auto& i : programs)
+         result.emplace_back(i, deferred_build);
+      return result;
+   }
 } // namespace doge
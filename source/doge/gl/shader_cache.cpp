@@ -0,0 +1,152 @@
+//
+//  Copyright 2018 Christopher Di Bella
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+#include <algorithm>
+#include <doge/gl/shader_cache.hpp>
+#include <doge/utility/file.hpp>
+#include <functional>
+#include <optional>
+#include <string_view>
+
+namespace doge {
+   namespace {
+      // `#include "file"`, optionally indented, and with any amount of space before the quote
+      std::optional<std::string_view> include_target(const std::string_view line) noexcept
+      {
+         constexpr auto directive = std::string_view{"#include"};
+         const auto first = line.find_first_not_of(" \t");
+         if (first == std::string_view::npos or line.substr(first, directive.size()) != directive)
+            return std::nullopt;
+
+         const auto open = line.find('"', first + directive.size());
+         const auto close = open == std::string_view::npos ? open : line.find('"', open + 1);
+         if (close == std::string_view::npos)
+            return std::nullopt;
+         return line.substr(open + 1, close - open - 1);
+      }
+
+      bool is_version(const std::string_view line) noexcept
+      {
+         const auto first = line.find_first_not_of(" \t");
+         return first != std::string_view::npos and line.substr(first, 8) == "#version";
+      }
+
+      std::string directory_of(const std::string& path)
+      {
+         const auto slash = path.find_last_of("/\\");
+         return slash == std::string::npos ? std::string{} : path.substr(0, slash + 1);
+      }
+
+      class preprocessor {
+      public:
+         explicit preprocessor(const shader_defines& defines)
+            : defines_{defines}
+         {}
+
+         std::string run(const std::string& path)
+         {
+            expand(path);
+
+            // GLSL that doesn't start with #version still needs its macros
+            if (not defined_) {
+               auto prologue = std::string{};
+               std::swap(prologue, out_);
+               define(1);
+               out_ += prologue;
+            }
+            return std::move(out_);
+         }
+      private:
+         const shader_defines& defines_;
+         std::vector<std::string> files_;
+         std::string out_;
+         bool defined_ = false;
+
+         void expand(const std::string& path)
+         {
+            const auto file = files_.size();
+            files_.push_back(path);
+
+            const auto source = mapped_file{path};
+            auto text = source.text();
+            for (auto line_number = std::size_t{1}; not text.empty(); ++line_number) {
+               const auto end = text.find('\n');
+               const auto line = text.substr(0, end);
+               text.remove_prefix(end == std::string_view::npos ? text.size() : end + 1);
+
+               if (const auto target = include_target(line)) {
+                  include(directory_of(path) + std::string{*target}, line_number + 1, file);
+                  continue;
+               }
+
+               out_.append(line).append(1, '\n');
+               if (file == 0 and not defined_ and is_version(line))
+                  define(line_number + 1);
+            }
+         }
+
+         void include(const std::string& path, const std::size_t next_line, const std::size_t file)
+         {
+            // already included files leave a blank line, which keeps the numbering intact
+            if (std::find(begin(files_), end(files_), path) != end(files_)) {
+               out_ += '\n';
+               return;
+            }
+
+            line_directive(1, files_.size());
+            expand(path);
+            line_directive(next_line, file);
+         }
+
+         void define(const std::size_t next_line)
+         {
+            for (const auto& [name, value] : defines_)
+               out_ += "#define " + name + ' ' + value + '\n';
+            line_directive(next_line, 0);
+            defined_ = true;
+         }
+
+         void line_directive(const std::size_t line, const std::size_t file)
+         {
+            out_ += "#line " + std::to_string(line) + ' ' + std::to_string(file) + '\n';
+         }
+      };
+   } // namespace <anonymous>
+
+   std::string preprocess_shader(const std::string& path, const shader_defines& defines)
+   {
+      return preprocessor{defines}.run(path);
+   }
+
+   std::shared_ptr<const shader_source>
+   shader_cache::get(const shader_source::type type, const std::string& path,
+      const shader_defines& defines)
+   {
+      auto code = preprocess_shader(path, defines);
+      const auto hash = std::hash<std::string>{}(code) ^ static_cast<std::size_t>(type);
+      const auto [first, last] = shaders_.equal_range(hash);
+      for (auto i = first; i != last; ++i) {
+         if (i->second.type == type and i->second.code == code) {
+            ++statistics_.hits;
+            return i->second.shader;
+         }
+      }
+
+      ++statistics_.misses;
+      auto shader = std::make_shared<const shader_source>(type, shader_code, code, path);
+      shaders_.emplace(hash, entry{type, std::move(code), shader});
+      return shader;
+   }
+} // namespace doge
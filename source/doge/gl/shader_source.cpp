@@ -14,17 +14,46 @@
 // limitations under the License.
 //
 #include <doge/gl/shader_source.hpp>
+#include <gsl/gsl>
 
 namespace doge {
    shader_source::shader_source(const type t, const std::string& path)
+      : shader_source{t, path, deferred_build}
+   {
+      check(path);
+   }
+
+   shader_source::shader_source(const type t, const std::string& path, deferred_build_t)
+      : shader_source{t}
+   {
+      compile(mapped_file{path}.text());
+   }
+
+   shader_source::shader_source(const type t, shader_code_t, const std::string_view code,
+      const std::string& name)
+      : shader_source{t}
+   {
+      compile(code);
+      check(name);
+   }
+
+   // the other constructors delegate to this one, so that the shader is deleted if they throw
+   shader_source::shader_source(const type t)
       : index_{gl::CreateShader(t)}
+   {}
+
+   void shader_source::compile(const std::string_view code) noexcept
    {
       using std::experimental::ranges::Regular;
-      const Regular source = from_file<std::string>(path);
-      const Regular source_c_str = source.data();
-      gl::ShaderSource(index_, 1, &source_c_str, nullptr);
+      const Regular source_data = code.data();
+      const Regular source_length = gsl::narrow_cast<GLint>(code.size());
+      gl::ShaderSource(index_, 1, &source_data, &source_length);
       gl::CompileShader(index_);
+   }
 
+   void shader_source::check(const std::string& path) const
+   {
+      using std::experimental::ranges::Regular;
       using std::experimental::ranges::SignedIntegral;
       SignedIntegral successful = 0;
       if (gl::GetShaderiv(index_, gl::COMPILE_STATUS, &successful); not successful) {
@@ -36,6 +65,7 @@ namespace doge {
 
    shader_source::~shader_source() noexcept
    {
+      // deleting 0 is silently ignored, so moved-from shaders need no special case
       gl::DeleteShader(index_);
    }
 } // namespace doge
\ No newline at end of file
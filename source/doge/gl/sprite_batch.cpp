@@ -0,0 +1,199 @@
+//
+//  Copyright 2018 Christopher Di Bella
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+#include <doge/gl/sprite_batch.hpp>
+#include <doge/gl/state_cache.hpp>
+#include <glm/gtc/matrix_transform.hpp>
+#include <vector>
+
+namespace doge {
+   namespace {
+      // two triangles per quad, which share the diagonal from its first corner to its third
+      std::vector<GLushort> quad_indices(const std::size_t quads)
+      {
+         auto result = std::vector<GLushort>();
+         result.reserve(quads * 6);
+         for (auto i = std::size_t{}; i != quads; ++i) {
+            for (const auto corner : {0, 1, 2, 2, 3, 0})
+               result.push_back(gsl::narrow_cast<GLushort>(i * 4 + corner));
+         }
+         return result;
+      }
+
+      constexpr unsigned char white[] = {255, 255, 255, 255};
+   } // namespace <anonymous>
+
+   sprite_batch::sprite_batch(shader_cache& cache, const std::size_t capacity,
+      const std::string& vertex_path, const std::string& fragment_path)
+      : capacity_{capacity},
+        stream_{gsl::narrow_cast<GLsizeiptr>(capacity * quad_size)},
+        default_program_{{{shader_source::vertex, vertex_path},
+           {shader_source::fragment, fragment_path}}, cache},
+        vao_{unique_vertex_array::generate()},
+        indices_{unique_buffer::generate()},
+        white_{1, 1, 4, white, {texture_wrap_t::clamp_to_edge, texture_wrap_t::clamp_to_edge},
+           minmag_t::nearest, minmag_t::nearest}
+   {
+      Expects(capacity > 0 and capacity <= max_capacity);
+
+      // the element array buffer belongs to the vertex array, so it's bound once, here
+      const auto indices = quad_indices(capacity);
+      gl_state().bind_vertex_array(vao_);
+      sprite_vertex::format(0, 0);
+      gl_state().bind_buffer(gl::ELEMENT_ARRAY_BUFFER, indices_);
+      gl::BufferData(gl::ELEMENT_ARRAY_BUFFER, indices.size() * sizeof(GLushort), indices.data(),
+         gl::STATIC_DRAW);
+      gl_state().bind_vertex_array(0);
+   }
+
+   void sprite_batch::begin(const glm::mat4& projection)
+   {
+      Expects(not drawing_);
+      projection_ = projection;
+      statistics_ = {};
+      region_ = stream_.next_region();
+      first_ = 0;
+      count_ = 0;
+
+      depth_test_ = gl::IsEnabled(gl::DEPTH_TEST) == gl::TRUE_;
+      blend_ = gl::IsEnabled(gl::BLEND) == gl::TRUE_;
+      gl::GetIntegerv(gl::BLEND_SRC_RGB, &blend_func_[0]);
+      gl::GetIntegerv(gl::BLEND_DST_RGB, &blend_func_[1]);
+      gl::GetIntegerv(gl::BLEND_SRC_ALPHA, &blend_func_[2]);
+      gl::GetIntegerv(gl::BLEND_DST_ALPHA, &blend_func_[3]);
+      gl_state().disable(gl::DEPTH_TEST);
+      gl_state().enable(gl::BLEND);
+      gl::BlendFunc(gl::SRC_ALPHA, gl::ONE_MINUS_SRC_ALPHA);
+      drawing_ = true;
+   }
+
+   void sprite_batch::begin(const GLsizei width, const GLsizei height)
+   {
+      Expects(width > 0 and height > 0);
+      begin(glm::ortho(0.0f, static_cast<float>(width), 0.0f, static_cast<float>(height)));
+   }
+
+   void sprite_batch::program(const shader_binary& p)
+   {
+      if (&p == program_)
+         return;
+
+      if (count_ != 0) {
+         flush();
+         ++statistics_.program_flushes;
+      }
+      program_ = &p;
+   }
+
+   void sprite_batch::reset_program()
+   {
+      program(default_program_);
+   }
+
+   void sprite_batch::draw(const texture2d& texture, const sprite& s)
+   {
+      const auto& p = s.position;
+      draw(texture, {p, p + glm::vec2{s.size.x, 0.0f}, p + s.size, p + glm::vec2{0.0f, s.size.y}},
+         s.uv_min, s.uv_max, s.colour);
+   }
+
+   void sprite_batch::draw(const sprite& s)
+   {
+      draw(white_, s);
+   }
+
+   void sprite_batch::draw(const texture_atlas& atlas, const atlas_region& region,
+      const glm::vec2 position, const glm::vec2 size, const glm::vec4& colour)
+   {
+      draw(atlas.page(region.page), sprite{position, size, region.min, region.max, colour});
+   }
+
+   void sprite_batch::draw(const texture2d& texture, const std::array<glm::vec2, 4>& corners,
+      const glm::vec2 uv_min, const glm::vec2 uv_max, const glm::vec4& colour)
+   {
+      const auto quad = reserve(static_cast<GLuint>(texture));
+      const auto uvs = std::array<glm::vec2, 4>{uv_min, glm::vec2{uv_max.x, uv_min.y}, uv_max,
+         glm::vec2{uv_min.x, uv_max.y}};
+      for (auto i = std::size_t{}; i != corners.size(); ++i) {
+         const auto v = quad * 4 + i;
+         sprite_vertex::write<0>(region_, v, corners[i]);
+         sprite_vertex::write<1>(region_, v, uvs[i]);
+         sprite_vertex::write<2>(region_, v, colour);
+      }
+      ++statistics_.quads;
+   }
+
+   void sprite_batch::flush()
+   {
+      if (count_ == 0)
+         return;
+
+      // staged, so that use() sends it to this program, and only when it has changed
+      program_->set_uniform("projection", projection_);
+      gl_state().bind_texture(gl::TEXTURE0, gl::TEXTURE_2D, texture_);
+      program_->use([this]{
+         gl_state().bind_vertex_array(vao_);
+         gl::BindVertexBuffer(0, static_cast<GLuint>(stream_),
+            stream_.offset() + gsl::narrow_cast<GLintptr>(first_ * quad_size),
+            gsl::narrow_cast<GLsizei>(sprite_vertex::stride));
+         gl::DrawElements(gl::TRIANGLES, gsl::narrow_cast<GLsizei>(count_ * 6), gl::UNSIGNED_SHORT,
+            nullptr);
+      });
+
+      first_ += count_;
+      count_ = 0;
+      ++statistics_.draws;
+   }
+
+   void sprite_batch::end()
+   {
+      Expects(drawing_);
+      flush();
+      stream_.fence();
+
+      if (depth_test_)
+         gl_state().enable(gl::DEPTH_TEST);
+      if (not blend_)
+         gl_state().disable(gl::BLEND);
+      const auto factor = [this](const std::size_t i) {
+         return static_cast<GLenum>(blend_func_[i]);
+      };
+      gl::BlendFuncSeparate(factor(0), factor(1), factor(2), factor(3));
+      drawing_ = false;
+   }
+
+   std::size_t sprite_batch::reserve(const GLuint texture)
+   {
+      Expects(drawing_);
+      if (texture != texture_) {
+         if (count_ != 0) {
+            flush();
+            ++statistics_.texture_flushes;
+         }
+         texture_ = texture;
+      }
+
+      // the region is full, so it's fenced and the batch moves on to the next one
+      if (first_ + count_ == capacity_) {
+         flush();
+         ++statistics_.full_flushes;
+         stream_.fence();
+         region_ = stream_.next_region();
+         first_ = 0;
+      }
+
+      return first_ + count_++;
+   }
+} // namespace doge
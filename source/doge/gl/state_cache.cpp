@@ -0,0 +1,218 @@
+//
+//  Copyright 2018 Christopher Di Bella
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+#include <algorithm>
+#include <doge/gl/state_cache.hpp>
+#include <gsl/gsl>
+
+namespace doge {
+   namespace {
+      template <typename T>
+      T& lookup(std::vector<std::pair<GLenum, T>>& cache, const GLenum key, const T unknown)
+      {
+         const auto i = std::find_if(begin(cache), end(cache),
+            [key](const auto& entry) noexcept { return entry.first == key; });
+         return i != end(cache) ? i->second : cache.emplace_back(key, unknown).second;
+      }
+
+      template <typename T>
+      void reset(std::vector<std::pair<GLenum, T>>& cache, const GLuint name) noexcept
+      {
+         for (auto& i : cache) {
+            if (i.second == name)
+               i.second = 0;
+         }
+      }
+
+      // counts the contexts made current on this thread; see context_changed
+      thread_local std::uint64_t generation = 0;
+   } // namespace <anonymous>
+
+   bool state_cache::elide(const bool redundant) noexcept
+   {
+      ++(redundant ? statistics_.elided : statistics_.issued);
+      return redundant;
+   }
+
+   void state_cache::use_program(const GLuint program) noexcept
+   {
+      if (not elide(program_ == program)) {
+         gl::UseProgram(program);
+         program_ = program;
+      }
+   }
+
+   void state_cache::bind_vertex_array(const GLuint vertex_array) noexcept
+   {
+      if (not elide(vertex_array_ == vertex_array)) {
+         gl::BindVertexArray(vertex_array);
+         vertex_array_ = vertex_array;
+         lookup(buffers_, gl::ELEMENT_ARRAY_BUFFER, unknown) = unknown;
+      }
+   }
+
+   void state_cache::bind_buffer(const GLenum target, const GLuint buffer) noexcept
+   {
+      if (auto& bound = lookup(buffers_, target, unknown); not elide(bound == buffer)) {
+         gl::BindBuffer(target, buffer);
+         bound = buffer;
+      }
+   }
+
+   void state_cache::bind_buffer_base(const GLenum target, const GLuint index,
+      const GLuint buffer) noexcept
+   {
+      elide(false);
+      gl::BindBufferBase(target, index, buffer);
+      lookup(buffers_, target, unknown) = buffer;
+   }
+
+   void state_cache::bind_buffer_range(const GLenum target, const GLuint index,
+      const GLuint buffer, const GLintptr offset, const GLsizeiptr size) noexcept
+   {
+      elide(false);
+      gl::BindBufferRange(target, index, buffer, offset, size);
+      lookup(buffers_, target, unknown) = buffer;
+   }
+
+   void state_cache::active_texture(const GLenum unit) noexcept
+   {
+      Expects(gl::TEXTURE0 <= unit && unit < gl::TEXTURE0 + texture_units);
+      if (not elide(active_texture_ == unit)) {
+         gl::ActiveTexture(unit);
+         active_texture_ = unit;
+      }
+   }
+
+   void state_cache::bind_texture(const GLenum unit, const GLenum target, const GLuint texture)
+      noexcept
+   {
+      active_texture(unit);
+      auto& bound = lookup(textures_[unit - gl::TEXTURE0], target, unknown);
+      if (not elide(bound == texture)) {
+         gl::BindTexture(target, texture);
+         bound = texture;
+      }
+   }
+
+   void state_cache::enable(const GLenum capability) noexcept
+   {
+      // capabilities are cached as 0 (disabled), 1 (enabled), or 2 (unknown)
+      if (auto& enabled = lookup<GLuint>(capabilities_, capability, 2); not elide(enabled == 1)) {
+         gl::Enable(capability);
+         enabled = 1;
+      }
+   }
+
+   void state_cache::disable(const GLenum capability) noexcept
+   {
+      if (auto& enabled = lookup<GLuint>(capabilities_, capability, 2); not elide(enabled == 0)) {
+         gl::Disable(capability);
+         enabled = 0;
+      }
+   }
+
+   void state_cache::viewport(const GLint x, const GLint y, const GLsizei width,
+      const GLsizei height) noexcept
+   {
+      const auto requested = std::array<GLint, 4>{x, y, width, height};
+      if (not elide(viewport_known_ && viewport_ == requested)) {
+         gl::Viewport(x, y, width, height);
+         viewport_ = requested;
+         viewport_known_ = true;
+      }
+   }
+
+   void state_cache::forget_buffer(const GLuint buffer) noexcept
+   {
+      reset(buffers_, buffer);
+   }
+
+   void state_cache::forget_texture(const GLuint texture) noexcept
+   {
+      for (auto& i : textures_)
+         reset(i, texture);
+   }
+
+   void state_cache::forget_vertex_array(const GLuint vertex_array) noexcept
+   {
+      if (vertex_array_ == vertex_array)
+         vertex_array_ = 0;
+   }
+
+   void state_cache::forget_program(const GLuint program) noexcept
+   {
+      // a deleted program stays in use until another is installed, so it is only forgotten
+      if (program_ == program)
+         program_ = unknown;
+   }
+
+   void state_cache::invalidate() noexcept
+   {
+      program_ = unknown;
+      vertex_array_ = unknown;
+      active_texture_ = 0;
+      buffers_.clear();
+      for (auto& i : textures_)
+         i.clear();
+      capabilities_.clear();
+      viewport_known_ = false;
+   }
+
+   state_cache& gl_state() noexcept
+   {
+      thread_local auto cache = state_cache{};
+      return cache;
+   }
+
+   void context_changed() noexcept
+   {
+      gl_state().invalidate();
+      ++generation;
+   }
+
+   std::uint64_t context_generation() noexcept
+   {
+      return generation;
+   }
+
+   void delete_buffers(const GLsizei n, const GLuint* const buffers) noexcept
+   {
+      auto& cache = gl_state();
+      std::for_each(buffers, buffers + n, [&cache](const auto i) { cache.forget_buffer(i); });
+      gl::DeleteBuffers(n, buffers);
+   }
+
+   void delete_textures(const GLsizei n, const GLuint* const textures) noexcept
+   {
+      auto& cache = gl_state();
+      std::for_each(textures, textures + n, [&cache](const auto i) { cache.forget_texture(i); });
+      gl::DeleteTextures(n, textures);
+   }
+
+   void delete_vertex_arrays(const GLsizei n, const GLuint* const vertex_arrays) noexcept
+   {
+      auto& cache = gl_state();
+      std::for_each(vertex_arrays, vertex_arrays + n,
+         [&cache](const auto i) { cache.forget_vertex_array(i); });
+      gl::DeleteVertexArrays(n, vertex_arrays);
+   }
+
+   void delete_program(const GLuint program) noexcept
+   {
+      gl_state().forget_program(program);
+      gl::DeleteProgram(program);
+   }
+} // namespace doge
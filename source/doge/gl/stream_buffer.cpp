@@ -0,0 +1,95 @@
+//
+//  Copyright 2018 Christopher Di Bella
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+#include <algorithm>
+#include <doge/gl/state_cache.hpp>
+#include <doge/gl/stream_buffer.hpp>
+#include <stdexcept>
+
+namespace doge {
+   namespace {
+      constexpr GLbitfield storage_flags = gl::MAP_WRITE_BIT | gl::MAP_PERSISTENT_BIT
+         | gl::MAP_COHERENT_BIT;
+
+      // one millisecond, in nanoseconds
+      constexpr GLuint64 wait_timeout = 1'000'000;
+
+      // regions are aligned so that they can also be bound as uniform or storage buffer ranges
+      GLsizeiptr align_region(const GLsizeiptr size) noexcept
+      {
+         ranges::SignedIntegral alignment = 0;
+         gl::GetIntegerv(gl::UNIFORM_BUFFER_OFFSET_ALIGNMENT, &alignment);
+         alignment = std::max(alignment, 1);
+         return (size + alignment - 1) / alignment * alignment;
+      }
+   } // namespace <anonymous>
+
+   stream_buffer::stream_buffer(const GLsizeiptr region_size)
+      : region_size_{align_region(region_size)}
+   {
+      Expects(region_size > 0);
+      if (not gl::exts::var_ARB_buffer_storage)
+         throw std::runtime_error{"stream_buffer requires GL_ARB_buffer_storage"};
+
+      const auto size = region_size_ * gsl::narrow_cast<GLsizeiptr>(region_count);
+      gl::GenBuffers(1, &index_);
+      gl_state().bind_buffer(gl::COPY_WRITE_BUFFER, index_);
+      gl::BufferStorage(gl::COPY_WRITE_BUFFER, size, nullptr, storage_flags);
+      mapping_ = static_cast<std::byte*>(gl::MapBufferRange(gl::COPY_WRITE_BUFFER, 0, size,
+         storage_flags));
+      gl_state().bind_buffer(gl::COPY_WRITE_BUFFER, 0);
+
+      if (not mapping_) {
+         delete_buffers(1, &index_);
+         throw std::runtime_error{"Unable to map stream_buffer"};
+      }
+   }
+
+   stream_buffer::~stream_buffer() noexcept
+   {
+      for (const auto i : fences_) {
+         if (i)
+            gl::DeleteSync(i);
+      }
+
+      // deleting a buffer also unmaps it
+      delete_buffers(1, &index_);
+   }
+
+   gsl::span<std::byte> stream_buffer::next_region()
+   {
+      region_ = (region_ + 1) % region_count;
+      if (auto& sync = fences_[region_]; sync) {
+         if (gl::ClientWaitSync(sync, 0, 0) == gl::TIMEOUT_EXPIRED) {
+            ++stalls_;
+            while (gl::ClientWaitSync(sync, gl::SYNC_FLUSH_COMMANDS_BIT, wait_timeout)
+               == gl::TIMEOUT_EXPIRED)
+            {}
+         }
+
+         gl::DeleteSync(sync);
+         sync = nullptr;
+      }
+
+      return {mapping_ + offset(), gsl::narrow_cast<std::ptrdiff_t>(region_size_)};
+   }
+
+   void stream_buffer::fence() noexcept
+   {
+      if (auto& sync = fences_[region_]; sync)
+         gl::DeleteSync(sync);
+      fences_[region_] = gl::FenceSync(gl::SYNC_GPU_COMMANDS_COMPLETE, 0);
+   }
+} // namespace doge
@@ -36,4 +36,14 @@ namespace doge {
       ::wrap(tex, s, t);
       doge::texture_parameter(tex, gl::TEXTURE_WRAP_R, static_cast<GLint>(r));
    }
+
+   void wrap(const texture1d_array& tex, const texture_wrap_t s) noexcept
+   {
+      ::wrap(tex, s);
+   }
+
+   void wrap(const texture2d_array& tex, const texture_wrap_t s, const texture_wrap_t t) noexcept
+   {
+      ::wrap(tex, s, t);
+   }
 } // namespace doge
@@ -0,0 +1,381 @@
+//
+//  Copyright 2018 Christopher Di Bella
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <cstring>
+#include <doge/gl/texture_atlas.hpp>
+#include <doge/utility/file.hpp>
+#include <limits>
+#include <numeric>
+#include <stdexcept>
+#include <tuple>
+#include <type_traits>
+
+namespace doge {
+   namespace {
+      constexpr auto atlas_magic = std::array<char, 4>{'D', 'A', 'T', 'L'};
+      constexpr std::uint32_t atlas_version = 1;
+
+      constexpr int round_up(const int n, const int alignment) noexcept
+      {
+         return (n + alignment - 1) / alignment * alignment;
+      }
+
+      int mip_limit(const int padding) noexcept
+      {
+         auto result = 0;
+         while ((2 << result) <= padding)
+            ++result;
+         return result;
+      }
+
+      /**
+       * @brief Copies `source` into the RGBA8 `page` with its bottom-left corner at `at`, and
+       *        repeats its edge texels `padding` texels outward.
+       */
+      void blit(std::vector<unsigned char>& page, const int page_size, const image& source,
+         const glm::ivec2 at, const int padding) noexcept
+      {
+         const auto channels = source.channels;
+         for (auto y = -padding; y < source.height + padding; ++y) {
+            const auto from_y = std::clamp(y, 0, source.height - 1);
+            for (auto x = -padding; x < source.width + padding; ++x) {
+               const auto from_x = std::clamp(x, 0, source.width - 1);
+               const auto from = source.data.get()
+                  + (static_cast<std::size_t>(from_y) * source.width + from_x) * channels;
+               const auto to = page.data() + (static_cast<std::size_t>(at.y + padding + y)
+                  * page_size + at.x + padding + x) * 4;
+
+               if (channels <= 2) {
+                  to[0] = to[1] = to[2] = from[0];
+                  to[3] = channels == 2 ? from[1] : 255;
+               }
+               else {
+                  std::copy(from, from + 3, to);
+                  to[3] = channels == 4 ? from[3] : 255;
+               }
+            }
+         }
+      }
+
+      template <typename T>
+      requires
+         std::is_trivially_copyable_v<T>
+      void append(std::vector<std::byte>& bytes, const T& value)
+      {
+         const auto first = reinterpret_cast<const std::byte*>(&value);
+         bytes.insert(bytes.end(), first, first + sizeof(T));
+      }
+
+      class atlas_reader {
+      public:
+         atlas_reader(const std::string& path, gsl::span<const std::byte> bytes) noexcept
+            : path_{path},
+              bytes_{bytes}
+         {}
+
+         template <typename T>
+         requires
+            std::is_trivially_copyable_v<T>
+         T read()
+         {
+            auto result = T{};
+            std::memcpy(&result, take(sizeof(T)).data(), sizeof(T));
+            return result;
+         }
+
+         gsl::span<const std::byte> take(const std::size_t size)
+         {
+            if (size > static_cast<std::size_t>(bytes_.size()))
+               throw std::runtime_error{"Invalid atlas file " + path_};
+
+            const auto result = bytes_.first(gsl::narrow_cast<std::ptrdiff_t>(size));
+            bytes_ = bytes_.subspan(gsl::narrow_cast<std::ptrdiff_t>(size));
+            return result;
+         }
+      private:
+         const std::string& path_;
+         gsl::span<const std::byte> bytes_;
+      };
+   } // namespace <anonymous>
+
+   skyline_packer::skyline_packer(const int width, const int height)
+      : width_{width},
+        height_{height},
+        skyline_{{0, 0, width}}
+   {
+      Expects(width > 0);
+      Expects(height > 0);
+   }
+
+   std::optional<glm::ivec2> skyline_packer::insert(const int width, const int height)
+   {
+      Expects(width > 0);
+      Expects(height > 0);
+
+      auto best = skyline_.size();
+      auto best_y = 0;
+      auto best_top = std::numeric_limits<int>::max();
+      auto best_width = std::numeric_limits<int>::max();
+      for (auto i = std::size_t{0}; i < skyline_.size(); ++i) {
+         // the skyline is ordered by x, so no later segment can fit either
+         if (skyline_[i].x + width > width_)
+            break;
+
+         // the rectangle rests on the highest segment beneath it
+         auto y = 0;
+         auto remaining = width;
+         for (auto j = i; remaining > 0; ++j) {
+            y = std::max(y, skyline_[j].y);
+            remaining -= skyline_[j].width;
+         }
+
+         const auto top = y + height;
+         if (top > height_)
+            continue;
+
+         if (top < best_top or (top == best_top and skyline_[i].width < best_width)) {
+            best = i;
+            best_y = y;
+            best_top = top;
+            best_width = skyline_[i].width;
+         }
+      }
+
+      if (best == skyline_.size())
+         return std::nullopt;
+
+      const auto x = skyline_[best].x;
+      skyline_.insert(skyline_.begin() + best, segment{x, best_top, width});
+
+      // trims the segments that are now hidden beneath the new one
+      for (auto i = best + 1; i < skyline_.size();) {
+         auto& s = skyline_[i];
+         const auto overlap = x + width - s.x;
+         if (overlap <= 0)
+            break;
+
+         if (overlap < s.width) {
+            s.x += overlap;
+            s.width -= overlap;
+            break;
+         }
+
+         skyline_.erase(skyline_.begin() + i);
+      }
+
+      for (auto i = std::size_t{0}; i + 1 < skyline_.size();) {
+         if (skyline_[i].y == skyline_[i + 1].y) {
+            skyline_[i].width += skyline_[i + 1].width;
+            skyline_.erase(skyline_.begin() + i + 1);
+         }
+         else {
+            ++i;
+         }
+      }
+
+      used_ += static_cast<long long>(width) * height;
+      return glm::ivec2{x, best_y};
+   }
+
+   double skyline_packer::occupancy() const noexcept
+   {
+      return static_cast<double>(used_) / (static_cast<double>(width_) * height_);
+   }
+
+   void packed_atlas::save(const std::string& path) const
+   {
+      auto bytes = std::vector<std::byte>{};
+      append(bytes, atlas_magic);
+      append(bytes, atlas_version);
+      append(bytes, gsl::narrow_cast<std::uint32_t>(page_size));
+      append(bytes, gsl::narrow_cast<std::uint32_t>(max_level));
+      append(bytes, gsl::narrow_cast<std::uint32_t>(pages.size()));
+      append(bytes, gsl::narrow_cast<std::uint32_t>(regions.size()));
+
+      for (const auto& [name, region] : regions) {
+         append(bytes, gsl::narrow_cast<std::uint32_t>(region.page));
+         append(bytes, region.min);
+         append(bytes, region.max);
+         append(bytes, gsl::narrow_cast<std::uint32_t>(name.size()));
+         const auto first = reinterpret_cast<const std::byte*>(name.data());
+         bytes.insert(bytes.end(), first, first + name.size());
+      }
+
+      for (const auto& i : pages) {
+         const auto first = reinterpret_cast<const std::byte*>(i.data());
+         bytes.insert(bytes.end(), first, first + i.size());
+      }
+
+      to_file(path, bytes);
+   }
+
+   packed_atlas packed_atlas::load(const std::string& path)
+   {
+      const auto file = mapped_file{path};
+      auto reader = atlas_reader{path, file.bytes()};
+      if (reader.read<std::array<char, 4>>() != atlas_magic
+         or reader.read<std::uint32_t>() != atlas_version)
+      {
+         throw std::runtime_error{"Invalid atlas file " + path};
+      }
+
+      auto result = packed_atlas{};
+      result.page_size = gsl::narrow_cast<int>(reader.read<std::uint32_t>());
+      result.max_level = gsl::narrow_cast<int>(reader.read<std::uint32_t>());
+      const auto page_count = reader.read<std::uint32_t>();
+      const auto region_count = reader.read<std::uint32_t>();
+
+      for (auto i = std::uint32_t{0}; i < region_count; ++i) {
+         auto region = atlas_region{};
+         region.page = reader.read<std::uint32_t>();
+         region.min = reader.read<glm::vec2>();
+         region.max = reader.read<glm::vec2>();
+         if (region.page >= page_count)
+            throw std::runtime_error{"Invalid atlas file " + path};
+
+         const auto name = reader.take(reader.read<std::uint32_t>());
+         result.regions.emplace(std::string{reinterpret_cast<const char*>(name.data()),
+            static_cast<std::size_t>(name.size())}, region);
+      }
+
+      const auto page_bytes = static_cast<std::size_t>(result.page_size) * result.page_size * 4;
+      result.pages.reserve(page_count);
+      for (auto i = std::uint32_t{0}; i < page_count; ++i) {
+         const auto pixels = reinterpret_cast<const unsigned char*>(reader.take(page_bytes).data());
+         result.pages.emplace_back(pixels, pixels + page_bytes);
+      }
+
+      return result;
+   }
+
+   atlas_builder::atlas_builder(const atlas_options& options)
+      : options_{options}
+   {
+      Expects(options.page_size > 0);
+      Expects(options.padding >= 0);
+   }
+
+   void atlas_builder::add(std::string name, image pixels)
+   {
+      Expects(pixels.data);
+      images_.emplace_back(std::move(name), std::move(pixels));
+   }
+
+   void atlas_builder::add_directory(const std::string& directory)
+   {
+      constexpr auto extension = std::string_view{".png"};
+      for (auto& i : list_directory(directory, extension)) {
+         auto pixels = decode_image(i);
+         i.erase(i.size() - extension.size());
+         i.erase(0, directory.size() + 1);
+         add(std::move(i), std::move(pixels));
+      }
+   }
+
+   packed_atlas atlas_builder::build() const
+   {
+      const auto size = options_.page_size;
+      const auto padding = options_.padding;
+
+      auto result = packed_atlas{};
+      result.page_size = size;
+      result.max_level = mip_limit(padding);
+
+      // cells are aligned to the coarsest level, so that no texel there straddles two images
+      const auto alignment = 1 << result.max_level;
+
+      auto order = std::vector<std::size_t>(images_.size());
+      std::iota(order.begin(), order.end(), std::size_t{0});
+      std::sort(order.begin(), order.end(), [this](const auto a, const auto b) noexcept {
+         const auto& x = images_[a].second;
+         const auto& y = images_[b].second;
+         return std::tie(y.height, y.width) < std::tie(x.height, x.width);
+      });
+
+      auto packers = std::vector<skyline_packer>{};
+      for (const auto i : order) {
+         const auto& [name, pixels] = images_[i];
+         const auto width = round_up(pixels.width + 2 * padding, alignment);
+         const auto height = round_up(pixels.height + 2 * padding, alignment);
+         if (width > size or height > size) {
+            throw std::runtime_error{"Unable to add " + name + " to the atlas: it doesn't fit in a "
+               + std::to_string(size) + "x" + std::to_string(size) + " page"};
+         }
+
+         auto page = std::size_t{0};
+         auto at = std::optional<glm::ivec2>{};
+         for (; page < packers.size() and not at; ++page)
+            at = packers[page].insert(width, height);
+
+         if (at) {
+            --page;
+         }
+         else {
+            packers.emplace_back(size, size);
+            result.pages.emplace_back(static_cast<std::size_t>(size) * size * 4);
+            at = packers.back().insert(width, height);
+         }
+
+         blit(result.pages[page], size, pixels, *at, padding);
+
+         const auto first = glm::vec2{*at + padding};
+         result.regions.emplace(name, atlas_region{page, first / static_cast<float>(size),
+            (first + glm::vec2{pixels.width, pixels.height}) / static_cast<float>(size)});
+      }
+
+      return result;
+   }
+
+   texture_atlas::texture_atlas(const packed_atlas& atlas)
+      : regions_{atlas.regions}
+   {
+      constexpr auto wrapping = std::tuple{texture_wrap_t::clamp_to_edge,
+         texture_wrap_t::clamp_to_edge};
+      const auto size = atlas.page_size;
+
+      pages_.reserve(atlas.pages.size());
+      for (const auto& i : atlas.pages) {
+         pages_.emplace_back([&]{
+            gl::TexParameteri(gl::TEXTURE_2D, gl::TEXTURE_MAX_LEVEL, atlas.max_level);
+            gl::TexImage2D(gl::TEXTURE_2D, 0, gl::RGBA8, size, size, 0, gl::RGBA,
+               gl::UNSIGNED_BYTE, i.data());
+            gl::GenerateMipmap(gl::TEXTURE_2D);
+         }, wrapping, minmag_t::linear_mipmap_linear, minmag_t::linear);
+      }
+   }
+
+   texture_atlas texture_atlas::from_directory(const std::string& directory,
+      const atlas_options& options)
+   {
+      auto builder = atlas_builder{options};
+      builder.add_directory(directory);
+      return texture_atlas{builder.build()};
+   }
+
+   texture_atlas texture_atlas::from_file(const std::string& path)
+   {
+      return texture_atlas{packed_atlas::load(path)};
+   }
+
+   const atlas_region& texture_atlas::region(const std::string_view name) const
+   {
+      if (const auto i = regions_.find(name); i != regions_.end())
+         return i->second;
+      throw std::out_of_range{"The atlas has no image called " + std::string{name}};
+   }
+} // namespace doge
@@ -0,0 +1,146 @@
+//
+//  Copyright 2018 Christopher Di Bella
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+#include <algorithm>
+#include <cstring>
+#include <doge/gl/state_cache.hpp>
+#include <doge/gl/texture_loader.hpp>
+#include <exception>
+
+namespace doge {
+   texture_loader::texture_loader()
+      : texture_loader{std::max(std::thread::hardware_concurrency(), 2u) - 1, 16 << 20}
+   {}
+
+   texture_loader::texture_loader(const std::size_t threads, const GLsizeiptr upload_budget)
+      : upload_budget_{upload_budget}
+   {
+      Expects(threads > 0);
+      Expects(upload_budget > 0);
+
+      gl::GenBuffers(1, &unpack_buffer_);
+      workers_.reserve(threads);
+      for (auto i = std::size_t{}; i != threads; ++i)
+         workers_.emplace_back([this]{ work(); });
+   }
+
+   texture_loader::~texture_loader()
+   {
+      {
+         auto lock = std::lock_guard{mutex_};
+         stopping_ = true;
+      }
+      work_available_.notify_all();
+
+      for (auto& i : workers_)
+         i.join();
+      delete_buffers(1, &unpack_buffer_);
+   }
+
+   texture_handle texture_loader::load(std::string path,
+      const std::tuple<texture_wrap_t, texture_wrap_t>& wrapping, const minmag_t min_filter,
+      const minmag_t mag_filter)
+   {
+      auto texture = std::make_shared<detail::pending_texture>(detail::pending_texture{
+         std::move(path), wrapping, min_filter, mag_filter});
+      {
+         auto lock = std::lock_guard{mutex_};
+         decode_queue_.push_back(texture);
+      }
+      work_available_.notify_one();
+
+      ++pending_;
+      return texture_handle{std::move(texture)};
+   }
+
+   void texture_loader::update()
+   {
+      auto ready = std::vector<std::shared_ptr<detail::pending_texture>>{};
+      {
+         auto lock = std::lock_guard{mutex_};
+         auto bytes = GLsizeiptr{};
+         while (not upload_queue_.empty()) {
+            const auto size = gsl::narrow_cast<GLsizeiptr>(upload_queue_.front()->pixels.size());
+            if (bytes != 0 and bytes + size > upload_budget_)
+               break;
+
+            bytes += size;
+            ready.push_back(std::move(upload_queue_.front()));
+            upload_queue_.pop_front();
+         }
+      }
+
+      for (const auto& i : ready) {
+         if (i->pixels.data)
+            upload(*i);
+         else
+            i->failed = true;
+         --pending_;
+      }
+   }
+
+   void texture_loader::work()
+   {
+      for (;;) {
+         auto texture = std::shared_ptr<detail::pending_texture>{};
+         {
+            auto lock = std::unique_lock{mutex_};
+            work_available_.wait(lock, [this]{ return stopping_ or not decode_queue_.empty(); });
+            if (stopping_)
+               return;
+
+            texture = std::move(decode_queue_.front());
+            decode_queue_.pop_front();
+         }
+
+         try {
+            texture->pixels = decode_image(texture->path);
+         }
+         catch (const std::exception& e) {
+            texture->error = e.what();
+         }
+
+         auto lock = std::lock_guard{mutex_};
+         upload_queue_.push_back(std::move(texture));
+      }
+   }
+
+   void texture_loader::upload(detail::pending_texture& texture) noexcept
+   {
+      const auto& pixels = texture.pixels;
+      const auto size = gsl::narrow_cast<GLsizeiptr>(pixels.size());
+
+      // respecifying the store each time orphans the previous upload instead of waiting for it
+      gl_state().bind_buffer(gl::PIXEL_UNPACK_BUFFER, unpack_buffer_);
+      gl::BufferData(gl::PIXEL_UNPACK_BUFFER, size, nullptr, gl::STREAM_DRAW);
+      const auto staging = gl::MapBufferRange(gl::PIXEL_UNPACK_BUFFER, 0, size,
+         gl::MAP_WRITE_BIT | gl::MAP_INVALIDATE_BUFFER_BIT);
+      if (not staging) {
+         gl_state().bind_buffer(gl::PIXEL_UNPACK_BUFFER, 0);
+         texture.error = "Unable to map the pixel unpack buffer for " + texture.path;
+         texture.failed = true;
+         return;
+      }
+
+      std::memcpy(staging, pixels.data.get(), pixels.size());
+      gl::UnmapBuffer(gl::PIXEL_UNPACK_BUFFER);
+
+      texture.texture.emplace(pixels.width, pixels.height, pixels.channels, nullptr,
+         texture.wrapping, texture.min_filter, texture.mag_filter);
+      gl_state().bind_buffer(gl::PIXEL_UNPACK_BUFFER, 0);
+
+      texture.pixels = {};
+   }
+} // namespace doge
@@ -0,0 +1,289 @@
+//
+//  Copyright 2018 Christopher Di Bella
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <doge/entity/camera.hpp>
+#include <doge/gl/texture_streamer.hpp>
+#include <glm/geometric.hpp>
+#include <numeric>
+#include <stdexcept>
+
+namespace doge {
+   namespace {
+      struct ktx_header {
+         std::array<unsigned char, 12> identifier;
+         std::uint32_t endianness;
+         std::uint32_t type;
+         std::uint32_t type_size;
+         std::uint32_t format;
+         std::uint32_t internal_format;
+         std::uint32_t base_internal_format;
+         std::uint32_t width;
+         std::uint32_t height;
+         std::uint32_t depth;
+         std::uint32_t array_elements;
+         std::uint32_t faces;
+         std::uint32_t levels;
+         std::uint32_t key_value_bytes;
+      };
+      static_assert(sizeof(ktx_header) == 64);
+
+      constexpr auto ktx_identifier = std::array<unsigned char, 12>{
+         0xAB, 'K', 'T', 'X', ' ', '1', '1', 0xBB, '\r', '\n', 0x1A, '\n'};
+
+      // files written on a machine with the other byte order store this value swapped
+      constexpr std::uint32_t ktx_native = 0x04030201;
+
+      constexpr GLsizei level_extent(const GLsizei base, const GLsizei level) noexcept
+      {
+         return std::max(base >> level, GLsizei{1});
+      }
+   } // namespace <anonymous>
+
+   texture_streamer::texture_streamer(const std::size_t budget, const std::size_t upload_limit,
+      const GLsizei tail_size) noexcept
+      : budget_{budget},
+        upload_limit_{upload_limit},
+        tail_size_{tail_size}
+   {
+      Expects(tail_size > 0);
+   }
+
+   std::size_t texture_streamer::add(const std::string& path, const glm::vec3& centre,
+      const float radius, const std::tuple<texture_wrap_t, texture_wrap_t>& wrapping,
+      const minmag_t min_filter, const minmag_t mag_filter)
+   {
+      Expects(radius > 0.0f);
+
+      auto file = mapped_file{path};
+      auto bytes = file.bytes();
+      const auto invalid = [&path]{
+         return std::runtime_error{"Unable to stream texture " + path
+            + ": only 2D KTX 1 files are supported"};
+      };
+
+      auto header = ktx_header{};
+      if (static_cast<std::size_t>(bytes.size()) < sizeof(header))
+         throw invalid();
+      std::memcpy(&header, bytes.data(), sizeof(header));
+      bytes = bytes.subspan(sizeof(header));
+
+      if (header.identifier != ktx_identifier or header.endianness != ktx_native
+         or header.height == 0 or header.depth != 0 or header.array_elements != 0
+         or header.faces != 1 or header.key_value_bytes > static_cast<std::size_t>(bytes.size()))
+      {
+         throw invalid();
+      }
+      bytes = bytes.subspan(header.key_value_bytes);
+
+      auto t = streamed_texture{std::move(file), {}, header.internal_format, header.format,
+         header.type, gsl::narrow_cast<GLsizei>(header.width),
+         gsl::narrow_cast<GLsizei>(header.height), wrapping, min_filter, mag_filter, centre,
+         radius};
+
+      // each level is its size, its pixels, and then padding to a multiple of four bytes
+      const auto level_count = std::max(header.levels, std::uint32_t{1});
+      for (auto i = std::uint32_t{0}; i < level_count; ++i) {
+         auto size = std::uint32_t{};
+         if (static_cast<std::size_t>(bytes.size()) < sizeof(size))
+            throw invalid();
+         std::memcpy(&size, bytes.data(), sizeof(size));
+         bytes = bytes.subspan(sizeof(size));
+
+         const auto padded = (static_cast<std::size_t>(size) + 3) / 4 * 4;
+         if (static_cast<std::size_t>(bytes.size()) < size)
+            throw invalid();
+         t.levels.push_back(bytes.first(size));
+         bytes = bytes.subspan(gsl::narrow_cast<std::ptrdiff_t>(
+            std::min(padded, static_cast<std::size_t>(bytes.size()))));
+      }
+
+      const auto count = gsl::narrow_cast<GLsizei>(t.levels.size());
+      while (t.tail_base + 1 < count and std::max(level_extent(t.width, t.tail_base),
+         level_extent(t.height, t.tail_base)) > tail_size_)
+      {
+         ++t.tail_base;
+      }
+
+      t.wanted = t.tail_base;
+      t.resident_base = count;
+      reallocate(t, t.tail_base);
+      for (auto level = count - 1; level >= t.tail_base; --level)
+         upload(t, level);
+
+      textures_.push_back(std::move(t));
+      statistics_.resident_bytes += storage_size(textures_.back(), textures_.back().storage_base);
+      return textures_.size() - 1;
+   }
+
+   void texture_streamer::place(const std::size_t id, const glm::vec3& centre, const float radius)
+      noexcept
+   {
+      Expects(id < textures_.size());
+      Expects(radius > 0.0f);
+      textures_[id].centre = centre;
+      textures_[id].radius = radius;
+   }
+
+   void texture_streamer::update(const glm::vec3& viewer, const GLsizei viewport_height,
+      const float field_of_view)
+   {
+      Expects(viewport_height > 0);
+      const auto pixels_per_unit = viewport_height / std::tan(field_of_view / 2);
+
+      // a level is wanted when its texels are no smaller than the pixels the object covers
+      auto total = std::size_t{0};
+      for (auto& t : textures_) {
+         const auto distance = glm::distance(viewer, t.centre) - t.radius;
+         const auto texels = static_cast<float>(std::max(t.width, t.height));
+         const auto pixels = distance > 0.0f ? pixels_per_unit * t.radius / distance : texels;
+
+         t.priority = pixels / texels;
+         t.wanted = t.priority >= 1.0f ? 0 : gsl::narrow_cast<GLsizei>(
+            std::min(std::log2(1.0f / t.priority), static_cast<float>(t.tail_base)));
+
+         // one level of slack, so that an object sitting on a boundary doesn't thrash
+         if (t.wanted == t.storage_base + 1)
+            t.wanted = t.storage_base;
+         total += storage_size(t, t.wanted);
+      }
+
+      auto order = std::vector<std::size_t>(textures_.size());
+      std::iota(order.begin(), order.end(), std::size_t{0});
+      std::sort(order.begin(), order.end(), [this](const auto a, const auto b) noexcept {
+         return textures_[a].priority < textures_[b].priority;
+      });
+
+      // drops one level at a time from each texture, least important first, until it all fits
+      for (auto dropped = true; total > budget_ and dropped;) {
+         dropped = false;
+         for (const auto i : order) {
+            auto& t = textures_[i];
+            if (t.wanted == t.tail_base)
+               continue;
+
+            total -= t.levels[static_cast<std::size_t>(t.wanted)].size();
+            ++t.wanted;
+            dropped = true;
+            if (total <= budget_)
+               break;
+         }
+      }
+
+      // shrinking first frees memory before anything grows
+      for (auto& t : textures_) {
+         if (t.wanted > t.storage_base) {
+            statistics_.evictions += gsl::narrow_cast<std::size_t>(
+               std::max(t.wanted - t.resident_base, GLsizei{0}));
+            reallocate(t, t.wanted);
+         }
+      }
+
+      for (auto& t : textures_) {
+         if (t.wanted < t.storage_base)
+            reallocate(t, t.wanted);
+      }
+
+      auto uploaded = std::size_t{0};
+      for (auto i = order.rbegin(); i != order.rend() and uploaded < upload_limit_; ++i) {
+         auto& t = textures_[*i];
+         while (t.resident_base > t.storage_base and uploaded < upload_limit_) {
+            uploaded += t.levels[static_cast<std::size_t>(t.resident_base - 1)].size();
+            upload(t, t.resident_base - 1);
+         }
+      }
+
+      statistics_.resident_bytes = std::accumulate(textures_.begin(), textures_.end(),
+         std::size_t{0}, [](const auto sum, const auto& t) noexcept {
+            return sum + storage_size(t, t.storage_base); });
+   }
+
+   void texture_streamer::update(const camera& viewer, const GLsizei viewport_height)
+   {
+      update(viewer.position(), viewport_height, gsl::narrow_cast<float>(viewer.field_of_view()));
+   }
+
+   std::size_t texture_streamer::storage_size(const streamed_texture& t, const GLsizei base)
+      noexcept
+   {
+      return std::accumulate(t.levels.begin() + base, t.levels.end(), std::size_t{0},
+         [](const auto sum, const auto& level) noexcept {
+            return sum + static_cast<std::size_t>(level.size()); });
+   }
+
+   void texture_streamer::reallocate(streamed_texture& t, const GLsizei base)
+   {
+      const auto count = gsl::narrow_cast<GLsizei>(t.levels.size());
+      auto storage = texture2d{[&]{
+         gl::TexStorage2D(gl::TEXTURE_2D, count - base, t.internal_format,
+            level_extent(t.width, base), level_extent(t.height, base));
+      }, t.wrapping, t.min_filter, t.mag_filter};
+
+      // the resident levels that are kept are copied without a round trip through the CPU
+      t.resident_base = std::max(t.resident_base, base);
+      if (t.texture) {
+         for (auto level = t.resident_base; level < count; ++level) {
+            gl::CopyImageSubData(static_cast<GLuint>(*t.texture), gl::TEXTURE_2D,
+               level - t.storage_base, 0, 0, 0, static_cast<GLuint>(storage), gl::TEXTURE_2D,
+               level - base, 0, 0, 0, level_extent(t.width, level), level_extent(t.height, level),
+               1);
+         }
+      }
+
+      t.texture = std::move(storage);
+      t.storage_base = base;
+      clamp(t);
+      ++statistics_.reallocations;
+   }
+
+   void texture_streamer::upload(streamed_texture& t, const GLsizei level)
+   {
+      Expects(t.storage_base <= level);
+      Expects(level < t.resident_base);
+
+      const auto pixels = t.levels[static_cast<std::size_t>(level)];
+      const auto width = level_extent(t.width, level);
+      const auto height = level_extent(t.height, level);
+      t.texture->bind(gl::TEXTURE0, [&]{
+         // KTX rows are four-byte aligned, which is also the GL's default unpack alignment
+         if (t.type == 0) {
+            gl::CompressedTexSubImage2D(gl::TEXTURE_2D, level - t.storage_base, 0, 0, width,
+               height, t.internal_format, gsl::narrow_cast<GLsizei>(pixels.size()),
+               pixels.data());
+         }
+         else {
+            gl::TexSubImage2D(gl::TEXTURE_2D, level - t.storage_base, 0, 0, width, height,
+               t.format, t.type, pixels.data());
+         }
+      });
+
+      t.resident_base = level;
+      clamp(t);
+      statistics_.uploaded_bytes += static_cast<std::size_t>(pixels.size());
+   }
+
+   void texture_streamer::clamp(const streamed_texture& t) noexcept
+   {
+      const auto base = t.resident_base - t.storage_base;
+      t.texture->bind(gl::TEXTURE0, [&]{
+         gl::TexParameteri(gl::TEXTURE_2D, gl::TEXTURE_BASE_LEVEL, base);
+         gl::TexParameterf(gl::TEXTURE_2D, gl::TEXTURE_MIN_LOD, static_cast<GLfloat>(base));
+      });
+   }
+} // namespace doge
@@ -0,0 +1,117 @@
+//
+//  Copyright 2018 Christopher Di Bella
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+#include <algorithm>
+#include <doge/gl/texture_table.hpp>
+#include <stdexcept>
+
+namespace doge {
+   namespace {
+      GLsizei mip_levels(const GLsizei width, const GLsizei height) noexcept
+      {
+         auto result = GLsizei{1};
+         for (auto size = std::max(width, height); size > 1; size /= 2)
+            ++result;
+         return result;
+      }
+
+      GLenum pixel_format(const int channels) noexcept
+      {
+         return channels == 1 ? gl::RED
+              : channels == 3 ? gl::RGB : gl::RGBA;
+      }
+   } // namespace <anonymous>
+
+   texture_table::texture_table(const gsl::span<const std::string> paths,
+      const std::tuple<texture_wrap_t, texture_wrap_t>& wrapping, const minmag_t min_filter,
+      const minmag_t mag_filter, const bool force_array)
+   {
+      Expects(not paths.empty());
+
+      auto images = std::vector<image>{};
+      images.reserve(static_cast<std::size_t>(paths.size()));
+      for (const auto& i : paths)
+         images.push_back(decode_image(i));
+
+      entries_.reserve(images.size());
+      if (bindless_supported() and not force_array) {
+         textures_.reserve(images.size());
+         for (const auto& i : images) {
+            const auto& texture = textures_.emplace_back(i, wrapping, min_filter, mag_filter);
+
+            // a texture's parameters can't change once it has a handle
+            const auto handle = gl::GetTextureHandleARB(static_cast<GLuint>(texture));
+            gl::MakeTextureHandleResidentARB(handle);
+            entries_.push_back(handle);
+         }
+      }
+      else {
+         const auto width = images.front().width;
+         const auto height = images.front().height;
+         for (auto i = std::size_t{0}; i < images.size(); ++i) {
+            if (images[i].width != width or images[i].height != height) {
+               throw std::runtime_error{"Unable to build texture array: " + paths[i] + " is "
+                  + std::to_string(images[i].width) + "x" + std::to_string(images[i].height)
+                  + ", but " + paths[0] + " is " + std::to_string(width) + "x"
+                  + std::to_string(height)};
+            }
+         }
+
+         const auto layers = gsl::narrow_cast<GLsizei>(images.size());
+         array_.emplace([&]{
+            constexpr auto target = static_cast<GLenum>(texture_t::texture_2d_array);
+            gl::TexStorage3D(target, mip_levels(width, height), gl::RGBA8, width, height, layers);
+            for (auto i = GLsizei{0}; i < layers; ++i) {
+               const auto& pixels = images[static_cast<std::size_t>(i)];
+               gl::TexSubImage3D(target, 0, 0, 0, i, width, height, 1,
+                  pixel_format(pixels.channels), gl::UNSIGNED_BYTE, pixels.data.get());
+            }
+            gl::GenerateMipmap(target);
+         }, wrapping, min_filter, mag_filter);
+
+         for (auto i = GLuint64{0}; i < images.size(); ++i)
+            entries_.push_back(i);
+      }
+
+      table_.emplace(gsl::span<const GLuint64>{entries_}, gl::STATIC_DRAW);
+   }
+
+   texture_table::~texture_table() noexcept
+   {
+      if (bindless()) {
+         for (const auto i : entries_)
+            gl::MakeTextureHandleNonResidentARB(i);
+      }
+   }
+
+   bool texture_table::bindless_supported() noexcept
+   {
+      return static_cast<bool>(gl::exts::var_ARB_bindless_texture);
+   }
+
+   void texture_table::bind(const GLuint binding, const GLenum unit) const noexcept
+   {
+      table_->bind(binding);
+      if (array_)
+         array_->bind(unit);
+   }
+
+   shader_defines texture_table::defines() const
+   {
+      if (bindless())
+         return {{"DOGE_BINDLESS", "1"}};
+      return {};
+   }
+} // namespace doge
@@ -0,0 +1,78 @@
+//
+//  Copyright 2018 Christopher Di Bella
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+#include <doge/gl/state_cache.hpp>
+#include <doge/gl/upload_context.hpp>
+
+namespace doge {
+   upload_context::upload_context(std::function<void()> make_current,
+      std::function<void()> release)
+      : thread_{[this, make_current = std::move(make_current), release = std::move(release)]{
+           work(make_current, release); }}
+   {}
+
+   upload_context::~upload_context()
+   {
+      {
+         auto lock = std::lock_guard{mutex_};
+         stopping_ = true;
+      }
+      work_available_.notify_one();
+      thread_.join();
+   }
+
+   void upload_context::push(std::function<void()> job)
+   {
+      {
+         auto lock = std::lock_guard{mutex_};
+         jobs_.push_back(std::move(job));
+      }
+      work_available_.notify_one();
+   }
+
+   void upload_context::work(const std::function<void()>& make_current,
+      const std::function<void()>& release)
+   {
+      make_current();
+      context_changed();
+      for (;;) {
+         auto job = std::function<void()>{};
+         {
+            auto lock = std::unique_lock{mutex_};
+            work_available_.wait(lock, [this]{ return stopping_ or not jobs_.empty(); });
+            if (jobs_.empty())
+               break;
+
+            job = std::move(jobs_.front());
+            jobs_.pop_front();
+         }
+
+         // objects are shared with the render context, which may have deleted names that this
+         // thread's cache still holds as bound, so nothing cached before the job is trusted
+         gl_state().invalidate();
+
+         // a job that throws hands the exception to its future, through the packaged_task
+         job();
+      }
+      release();
+   }
+
+   upload_fence upload_context::fence() noexcept
+   {
+      auto result = upload_fence{gl::FenceSync(gl::SYNC_GPU_COMMANDS_COMPLETE, 0)};
+      gl::Flush();
+      return result;
+   }
+} // namespace doge
@@ -0,0 +1,47 @@
+#version 430 core
+#include "clustered_lights.glsl"
+
+// One invocation per cluster. Each work group moves a batch of lights into view space through
+// shared memory, and then every invocation tests the batch against its cluster's bounds.
+layout (local_size_x = 128) in;
+
+layout (std430, binding = DOGE_CLUSTER_BOUNDS_BINDING) readonly buffer doge_cluster_bounds {
+   vec4 bounds[]; // the minimum and then the maximum corner of each cluster, in view space
+};
+
+uniform mat4 view;
+uniform uint light_count;
+
+shared vec4 spheres[gl_WorkGroupSize.x];
+
+void main()
+{
+   const uint cluster = gl_GlobalInvocationID.x;
+   const bool active = cluster < DOGE_CLUSTER_COUNT;
+   const vec3 lo = active ? bounds[2u * cluster].xyz : vec3(0.0);
+   const vec3 hi = active ? bounds[2u * cluster + 1u].xyz : vec3(0.0);
+
+   uint count = 0u;
+   for (uint first = 0u; first < light_count; first += gl_WorkGroupSize.x) {
+      const uint i = first + gl_LocalInvocationIndex;
+      if (i < light_count) {
+         const vec4 light = doge_lights[i].position_range;
+         spheres[gl_LocalInvocationIndex] = vec4((view * vec4(light.xyz, 1.0)).xyz, light.w);
+      }
+      barrier();
+
+      const uint batch = min(gl_WorkGroupSize.x, light_count - first);
+      for (uint j = 0u; active && j < batch && count < DOGE_CLUSTER_CAPACITY; ++j) {
+         const vec4 sphere = spheres[j];
+         const vec3 offset = sphere.xyz - clamp(sphere.xyz, lo, hi);
+         if (dot(offset, offset) <= sphere.w * sphere.w) {
+            doge_light_indices[cluster * DOGE_CLUSTER_CAPACITY + count] = first + j;
+            ++count;
+         }
+      }
+      barrier();
+   }
+
+   if (active)
+      doge_light_counts[cluster] = count;
+}
@@ -0,0 +1,66 @@
+// The light table and cluster lists written by doge::clustered_lighting. The including shader
+// must be compiled with clustered_lighting::defines().
+struct doge_light {
+   vec4 position_range;
+   vec4 colour_intensity;
+   vec4 direction_outer;
+   vec4 inner;
+};
+
+layout (std430, binding = DOGE_LIGHT_BINDING) readonly buffer doge_light_table {
+   doge_light doge_lights[];
+};
+
+layout (std430, binding = DOGE_CLUSTER_LISTS_BINDING) buffer doge_cluster_lists {
+   uint doge_light_counts[DOGE_CLUSTER_COUNT];
+   uint doge_light_indices[];
+};
+
+layout (std430, binding = DOGE_CLUSTER_PARAMETERS_BINDING) readonly buffer doge_cluster_parameters {
+   vec4 doge_tile_size;
+   vec4 doge_depth_slice;
+};
+
+// The cluster containing the fragment at `frag_coord` (i.e. gl_FragCoord.xy), which is
+// `view_depth` units in front of the camera.
+uint doge_cluster(const vec2 frag_coord, const float view_depth)
+{
+   const uvec2 tile = min(uvec2(frag_coord / doge_tile_size.xy),
+      uvec2(DOGE_CLUSTER_X - 1u, DOGE_CLUSTER_Y - 1u));
+   const float slice = log(max(view_depth, 1e-4)) * doge_depth_slice.x + doge_depth_slice.y;
+   const uint z = uint(clamp(slice, 0.0, float(DOGE_CLUSTER_Z - 1u)));
+   return tile.x + DOGE_CLUSTER_X * (tile.y + DOGE_CLUSTER_Y * z);
+}
+
+uint doge_cluster_light_count(const uint cluster)
+{
+   return doge_light_counts[cluster];
+}
+
+doge_light doge_cluster_light(const uint cluster, const uint i)
+{
+   return doge_lights[doge_light_indices[cluster * DOGE_CLUSTER_CAPACITY + i]];
+}
+
+// Blinn-Phong shading by one light. Every vector is in world space, and `normal` and `view_dir`
+// are normalised.
+vec3 doge_shade(const doge_light light, const vec3 position, const vec3 normal,
+   const vec3 view_dir, const vec3 diffuse, const vec3 specular, const float shininess)
+{
+   const vec3 to_light = light.position_range.xyz - position;
+   const float distance = length(to_light);
+   const vec3 light_dir = to_light / max(distance, 1e-4);
+
+   // fades to nothing at the light's range, so that binning by range doesn't cut it off
+   const float window = clamp(1.0 - pow(distance / light.position_range.w, 4.0), 0.0, 1.0);
+   const float attenuation = window * window / (distance * distance + 1.0);
+   const float cone = smoothstep(light.direction_outer.w, light.inner.x,
+      dot(-light_dir, light.direction_outer.xyz));
+
+   const float lambert = max(dot(normal, light_dir), 0.0);
+   const vec3 half_dir = normalize(light_dir + view_dir);
+   const float highlight = lambert > 0.0 ? pow(max(dot(normal, half_dir), 0.0), shininess) : 0.0;
+
+   return light.colour_intensity.rgb * light.colour_intensity.w * attenuation * cone
+      * (lambert * diffuse + highlight * specular);
+}
@@ -0,0 +1,37 @@
+#version 430 core
+
+// Builds one level of a hierarchical-Z pyramid: each texel holds the farthest depth of the
+// texels it covers in the level above. Compiled with DOGE_HIZ_COPY, it instead copies the depth
+// buffer into the pyramid's first level.
+layout (local_size_x = 8, local_size_y = 8) in;
+
+// the level above, which is the only level of the texture that can be sampled
+layout (binding = 0) uniform sampler2D source;
+layout (binding = 0, r32f) writeonly uniform image2D destination;
+
+void main()
+{
+   const ivec2 texel = ivec2(gl_GlobalInvocationID.xy);
+   const ivec2 size = imageSize(destination);
+   if (any(greaterThanEqual(texel, size)))
+      return;
+
+#ifdef DOGE_HIZ_COPY
+   imageStore(destination, texel, vec4(texelFetch(source, texel, 0).r));
+#else
+   const ivec2 source_size = textureSize(source, 0);
+   const ivec2 last = source_size - 1;
+   const ivec2 first = 2 * texel;
+
+   // odd levels leave a row or column over, which is folded into the last texel
+   const ivec2 extra = ivec2(equal(texel, size - 1)) * (source_size & 1);
+
+   float depth = 0.0;
+   for (int y = 0; y <= 1 + extra.y; ++y) {
+      for (int x = 0; x <= 1 + extra.x; ++x)
+         depth = max(depth, texelFetch(source, min(first + ivec2(x, y), last), 0).r);
+   }
+
+   imageStore(destination, texel, vec4(depth));
+#endif // DOGE_HIZ_COPY
+}
@@ -0,0 +1,93 @@
+#version 430 core
+
+// One invocation per mesh. Culls a mesh when the nearest point of its bounding sphere is farther
+// than everything already drawn in the part of the screen that it covers.
+layout (local_size_x = 64) in;
+
+struct draw_command {
+   uint count;
+   uint instance_count;
+   uint first_index;
+   uint base_vertex;
+   uint base_instance;
+};
+
+layout (std430, binding = 0) readonly buffer bounds {
+   vec4 spheres[]; // the world-space centre and radius of each mesh
+};
+
+layout (std430, binding = 1) readonly buffer requested_commands {
+   draw_command requested[];
+};
+
+layout (std430, binding = 2) writeonly buffer visible_commands {
+   draw_command visible[];
+};
+
+layout (std430, binding = 3) buffer statistics {
+   uint drawn;
+   uint culled;
+};
+
+layout (binding = 0) uniform sampler2D pyramid;
+
+uniform mat4 view_projection;
+uniform vec2 viewport;
+uniform int levels;
+uniform uint mesh_count;
+
+bool occluded(const vec4 sphere)
+{
+   vec3 lo = vec3(1.0);
+   vec3 hi = vec3(-1.0);
+   for (int i = 0; i < 8; ++i) {
+      const vec3 corner = sphere.xyz + sphere.w * vec3(
+         (i & 1) == 0 ? -1.0 : 1.0, (i & 2) == 0 ? -1.0 : 1.0, (i & 4) == 0 ? -1.0 : 1.0);
+      const vec4 clip = view_projection * vec4(corner, 1.0);
+
+      // bounds that cross the near plane can't be projected, and are too close to cull anyway
+      if (clip.w <= 0.0)
+         return false;
+
+      const vec3 ndc = clip.xyz / clip.w;
+      lo = min(lo, ndc);
+      hi = max(hi, ndc);
+   }
+
+   if (any(lessThan(hi.xy, vec2(-1.0))) || any(greaterThan(lo.xy, vec2(1.0))) || lo.z > 1.0)
+      return true;
+
+   const vec2 uv_lo = clamp(lo.xy, -1.0, 1.0) * 0.5 + 0.5;
+   const vec2 uv_hi = clamp(hi.xy, -1.0, 1.0) * 0.5 + 0.5;
+
+   // the level at which the bounds cover no more than two texels in each direction
+   const vec2 extent = (uv_hi - uv_lo) * viewport;
+   const float level = clamp(ceil(log2(max(max(extent.x, extent.y), 1.0))), 0.0,
+      float(levels - 1));
+
+   const float farthest = max(
+      max(textureLod(pyramid, uv_lo, level).r, textureLod(pyramid, vec2(uv_hi.x, uv_lo.y), level).r),
+      max(textureLod(pyramid, vec2(uv_lo.x, uv_hi.y), level).r, textureLod(pyramid, uv_hi, level).r));
+
+   return lo.z * 0.5 + 0.5 > farthest;
+}
+
+void main()
+{
+   const uint mesh = gl_GlobalInvocationID.x;
+   if (mesh >= mesh_count)
+      return;
+
+   draw_command command = requested[mesh];
+   if (command.instance_count != 0u) {
+      if (occluded(spheres[mesh])) {
+         command.instance_count = 0u;
+         atomicAdd(culled, 1u);
+      }
+      else {
+         atomicAdd(drawn, 1u);
+      }
+   }
+
+   visible[mesh] = command;
+}
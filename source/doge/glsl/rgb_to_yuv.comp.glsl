@@ -0,0 +1,66 @@
+#version 430 core
+
+// Converts the bottom-left `frame_size` pixels of a colour texture to planar YUV 4:2:0 (I420),
+// with BT.709 limited-range coefficients and the top row first. Each invocation converts an 8 by
+// 2 block of pixels, so that every write to the output is a whole uint.
+layout (local_size_x = 8, local_size_y = 8) in;
+
+layout (binding = 0) uniform sampler2D source;
+
+layout (std430, binding = 0) writeonly buffer yuv_frame {
+   uint bytes[]; // the Y plane, then the U plane, then the V plane
+};
+
+uniform ivec2 frame_size;
+
+const vec3 luma = vec3(0.2126, 0.7152, 0.0722);
+
+uint pack(const vec4 v)
+{
+   const uvec4 b = uvec4(clamp(round(v), 0.0, 255.0));
+   return b.x | (b.y << 8u) | (b.z << 16u) | (b.w << 24u);
+}
+
+void main()
+{
+   const ivec2 block = ivec2(gl_GlobalInvocationID.xy);
+   if (any(greaterThanEqual(block * ivec2(8, 2), frame_size)))
+      return;
+
+   const int width = frame_size.x;
+   const int x = block.x * 8;
+   const int top = block.y * 2;
+
+   vec3 rgb[2][8];
+   for (int row = 0; row < 2; ++row) {
+      // encoders expect the top row first, whereas the GL stores the bottom row first
+      const int y = frame_size.y - 1 - (top + row);
+      for (int i = 0; i < 8; ++i)
+         rgb[row][i] = texelFetch(source, ivec2(x + i, y), 0).rgb;
+   }
+
+   for (int row = 0; row < 2; ++row) {
+      const uint first = uint(((top + row) * width + x) / 4);
+      for (int half_block = 0; half_block < 2; ++half_block) {
+         const int i = half_block * 4;
+         const vec4 y = 16.0 + 219.0 * vec4(dot(rgb[row][i], luma), dot(rgb[row][i + 1], luma),
+            dot(rgb[row][i + 2], luma), dot(rgb[row][i + 3], luma));
+         bytes[first + uint(half_block)] = pack(y);
+      }
+   }
+
+   // each chroma sample is the average of a 2 by 2 square
+   vec4 u;
+   vec4 v;
+   for (int i = 0; i < 4; ++i) {
+      const vec3 c = 0.25 * (rgb[0][2 * i] + rgb[0][2 * i + 1] + rgb[1][2 * i] + rgb[1][2 * i + 1]);
+      const float l = dot(c, luma);
+      u[i] = 128.0 + 224.0 * (c.b - l) / 1.8556;
+      v[i] = 128.0 + 224.0 * (c.r - l) / 1.5748;
+   }
+
+   const int luma_size = frame_size.x * frame_size.y;
+   const int chroma_offset = ((top / 2) * (width / 2) + x / 2) / 4;
+   bytes[uint(luma_size / 4 + chroma_offset)] = pack(u);
+   bytes[uint(luma_size / 4 + luma_size / 16 + chroma_offset)] = pack(v);
+}
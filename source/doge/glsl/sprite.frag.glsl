@@ -0,0 +1,12 @@
+#version 430 core
+
+layout (binding = 0) uniform sampler2D sprite;
+
+in vec2 sprite_uv;
+in vec4 sprite_colour;
+out vec4 colour;
+
+void main()
+{
+   colour = texture(sprite, sprite_uv) * sprite_colour;
+}
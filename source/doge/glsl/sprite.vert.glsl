@@ -0,0 +1,18 @@
+#version 430 core
+
+// Quads from sprite_batch, whose corners were placed on the CPU.
+layout (location = 0) in vec2 position;
+layout (location = 1) in vec2 uv;
+layout (location = 2) in vec4 tint;
+
+uniform mat4 projection;
+
+out vec2 sprite_uv;
+out vec4 sprite_colour;
+
+void main()
+{
+   sprite_uv = uv;
+   sprite_colour = tint;
+   gl_Position = projection * vec4(position, 0.0, 1.0);
+}
@@ -0,0 +1,35 @@
+#version 430 core
+
+// Stretches the corner of the offscreen target that dynamic_resolution rendered into over the
+// window, and sharpens it with an unsharp mask. The sharpened colour is clamped to the range of
+// its neighbours, so that edges don't ring.
+layout (binding = 0) uniform sampler2D scene;
+
+// the rendered corner, and one texel, as fractions of the whole target
+uniform vec2 rendered;
+uniform vec2 texel;
+uniform float sharpness;
+
+in vec2 uv;
+out vec4 colour;
+
+// kept half a texel inside the corner, so that filtering never reads what wasn't rendered
+vec3 fetch(const vec2 p)
+{
+   return texture(scene, clamp(p, 0.5 * texel, rendered - 0.5 * texel)).rgb;
+}
+
+void main()
+{
+   const vec2 p = uv * rendered;
+   const vec3 centre = fetch(p);
+   const vec3 north = fetch(p + vec2(0.0, texel.y));
+   const vec3 south = fetch(p - vec2(0.0, texel.y));
+   const vec3 east = fetch(p + vec2(texel.x, 0.0));
+   const vec3 west = fetch(p - vec2(texel.x, 0.0));
+
+   const vec3 blurred = 0.25 * (north + south + east + west);
+   const vec3 low = min(centre, min(min(north, south), min(east, west)));
+   const vec3 high = max(centre, max(max(north, south), max(east, west)));
+   colour = vec4(clamp(centre + 2.0 * sharpness * (centre - blurred), low, high), 1.0);
+}
@@ -0,0 +1,10 @@
+#version 430 core
+
+// A triangle that covers the whole viewport, made from gl_VertexID, so that no vertices are read.
+out vec2 uv;
+
+void main()
+{
+   uv = vec2((gl_VertexID << 1) & 2, gl_VertexID & 2);
+   gl_Position = vec4(uv * 2.0 - 1.0, 0.0, 1.0);
+}
@@ -0,0 +1,215 @@
+//
+//  Copyright 2018 Christopher Di Bella
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+#include <algorithm>
+#include <cmath>
+#include <doge/scene/culling.hpp>
+#include <glm/geometric.hpp>
+
+#if defined(__AVX__) || defined(__SSE__)
+#include <immintrin.h>
+#define DOGE_CULL_LANES
+#endif
+
+namespace doge {
+   namespace {
+#if defined(__AVX__)
+      using lane = __m256;
+      constexpr std::size_t lane_width = 8;
+
+      lane load(const float* const p) noexcept { return _mm256_loadu_ps(p); }
+      lane splat(const float f) noexcept { return _mm256_set1_ps(f); }
+      lane zero() noexcept { return _mm256_setzero_ps(); }
+      lane add(const lane a, const lane b) noexcept { return _mm256_add_ps(a, b); }
+      lane mul(const lane a, const lane b) noexcept { return _mm256_mul_ps(a, b); }
+      lane either(const lane a, const lane b) noexcept { return _mm256_or_ps(a, b); }
+      int bits(const lane mask) noexcept { return _mm256_movemask_ps(mask); }
+
+      // a volume is outside a plane when its centre is more than `radius` behind it
+      lane outside(const lane distance, const lane radius) noexcept
+      {
+         return _mm256_cmp_ps(add(distance, radius), zero(), _CMP_LT_OQ);
+      }
+#elif defined(__SSE__)
+      using lane = __m128;
+      constexpr std::size_t lane_width = 4;
+
+      lane load(const float* const p) noexcept { return _mm_loadu_ps(p); }
+      lane splat(const float f) noexcept { return _mm_set1_ps(f); }
+      lane zero() noexcept { return _mm_setzero_ps(); }
+      lane add(const lane a, const lane b) noexcept { return _mm_add_ps(a, b); }
+      lane mul(const lane a, const lane b) noexcept { return _mm_mul_ps(a, b); }
+      lane either(const lane a, const lane b) noexcept { return _mm_or_ps(a, b); }
+      int bits(const lane mask) noexcept { return _mm_movemask_ps(mask); }
+
+      lane outside(const lane distance, const lane radius) noexcept
+      {
+         return _mm_cmplt_ps(add(distance, radius), zero());
+      }
+#endif
+
+      // below this, starting a thread costs more than culling the volumes
+      constexpr std::size_t minimum_chunk = 16384;
+
+      constexpr auto planes = {frustum::left, frustum::right, frustum::bottom, frustum::top,
+         frustum::near_clip, frustum::far_clip};
+
+      float radius_at(const bounding_spheres& s, const std::size_t i, const glm::vec4&) noexcept
+      {
+         return s.radius()[i];
+      }
+
+      // the box's half-extents projected onto the plane's normal
+      float radius_at(const bounding_boxes& b, const std::size_t i, const glm::vec4& p) noexcept
+      {
+         return std::abs(p.x) * b.extent_x()[i] + std::abs(p.y) * b.extent_y()[i]
+            + std::abs(p.z) * b.extent_z()[i];
+      }
+
+#ifdef DOGE_CULL_LANES
+      lane radius_lanes(const bounding_spheres& s, const std::size_t i, const glm::vec4&) noexcept
+      {
+         return load(s.radius() + i);
+      }
+
+      lane radius_lanes(const bounding_boxes& b, const std::size_t i, const glm::vec4& p) noexcept
+      {
+         return add(add(mul(splat(std::abs(p.x)), load(b.extent_x() + i)),
+            mul(splat(std::abs(p.y)), load(b.extent_y() + i))),
+            mul(splat(std::abs(p.z)), load(b.extent_z() + i)));
+      }
+#endif
+
+      /// Writes the visible indices in `[first, last)` to `out`, and returns how many there were.
+      /// `out` must have room for `last - first` indices.
+      template <typename Volumes>
+      std::size_t cull_range(const frustum& f, const Volumes& v, const std::size_t first,
+         const std::size_t last, std::uint32_t* const out) noexcept
+      {
+         auto count = std::size_t{0};
+         auto i = first;
+#ifdef DOGE_CULL_LANES
+         constexpr auto all_lanes = (1 << lane_width) - 1;
+         for (; i + lane_width <= last; i += lane_width) {
+            const auto x = load(v.x() + i);
+            const auto y = load(v.y() + i);
+            const auto z = load(v.z() + i);
+
+            auto culled = zero();
+            for (const auto p : planes) {
+               const auto& plane = f[p];
+               const auto distance = add(add(mul(splat(plane.x), x), mul(splat(plane.y), y)),
+                  add(mul(splat(plane.z), z), splat(plane.w)));
+               culled = either(culled, outside(distance, radius_lanes(v, i, plane)));
+            }
+
+            for (auto visible = ~bits(culled) & all_lanes; visible != 0; visible &= visible - 1)
+               out[count++] = gsl::narrow_cast<std::uint32_t>(i + __builtin_ctz(visible));
+         }
+#endif
+         for (; i != last; ++i) {
+            auto inside = true;
+            for (const auto p : planes) {
+               const auto& plane = f[p];
+               const auto distance = plane.x * v.x()[i] + plane.y * v.y()[i] + plane.z * v.z()[i]
+                  + plane.w;
+               inside = inside and distance + radius_at(v, i, plane) >= 0.0f;
+            }
+
+            if (inside)
+               out[count++] = gsl::narrow_cast<std::uint32_t>(i);
+         }
+         return count;
+      }
+
+      template <typename Volumes, typename Spread>
+      std::size_t cull_volumes(const frustum& f, const Volumes& volumes,
+         std::vector<std::uint32_t>& visible, const std::size_t threads, const Spread& spread)
+      {
+         const auto size = volumes.size();
+         visible.resize(size);
+
+         const auto chunks = std::max(std::size_t{1}, std::min(threads, size / minimum_chunk));
+         if (chunks == 1) {
+            visible.resize(cull_range(f, volumes, 0, size, visible.data()));
+            return visible.size();
+         }
+
+         // each chunk writes to its own slice of `visible`, and the slices are compacted after
+         const auto chunk_size = (size + chunks - 1) / chunks;
+         auto counts = std::vector<std::size_t>(chunks);
+         spread(chunks, [&](const std::size_t chunk) noexcept {
+            const auto first = chunk * chunk_size;
+            const auto last = std::min(size, first + chunk_size);
+            counts[chunk] = cull_range(f, volumes, first, last, visible.data() + first);
+         });
+
+         auto end = visible.begin() + counts[0];
+         for (auto i = std::size_t{1}; i != chunks; ++i) {
+            const auto first = visible.begin() + i * chunk_size;
+            end = std::copy(first, first + counts[i], end);
+         }
+         visible.erase(end, visible.end());
+         return visible.size();
+      }
+   } // namespace <anonymous>
+
+   frustum::frustum(const glm::mat4& projection, const glm::mat4& view) noexcept
+      : frustum{projection * view}
+   {}
+
+   frustum::frustum(const glm::mat4& m) noexcept
+   {
+      // Gribb and Hartmann: each plane is the sum or difference of the fourth row and another row
+      const auto row = [&m](const int r) noexcept {
+         return glm::vec4{m[0][r], m[1][r], m[2][r], m[3][r]};
+      };
+
+      planes_[left] = row(3) + row(0);
+      planes_[right] = row(3) - row(0);
+      planes_[bottom] = row(3) + row(1);
+      planes_[top] = row(3) - row(1);
+      planes_[near_clip] = row(3) + row(2);
+      planes_[far_clip] = row(3) - row(2);
+
+      // distances are only comparable with radii once the normals have unit length
+      for (auto& i : planes_)
+         i /= glm::length(glm::vec3{i});
+   }
+
+   std::size_t cull(const frustum& f, const bounding_spheres& spheres,
+      std::vector<std::uint32_t>& visible, const std::size_t threads)
+   {
+      return cull_volumes(f, spheres, visible, threads, detail::on_threads{});
+   }
+
+   std::size_t cull(const frustum& f, const bounding_boxes& boxes,
+      std::vector<std::uint32_t>& visible, const std::size_t threads)
+   {
+      return cull_volumes(f, boxes, visible, threads, detail::on_threads{});
+   }
+
+   std::size_t cull(const frustum& f, const bounding_spheres& spheres,
+      std::vector<std::uint32_t>& visible, job_system& jobs)
+   {
+      return cull_volumes(f, spheres, visible, jobs.concurrency(), detail::on_jobs{jobs});
+   }
+
+   std::size_t cull(const frustum& f, const bounding_boxes& boxes,
+      std::vector<std::uint32_t>& visible, job_system& jobs)
+   {
+      return cull_volumes(f, boxes, visible, jobs.concurrency(), detail::on_jobs{jobs});
+   }
+} // namespace doge
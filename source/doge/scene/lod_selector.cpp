@@ -0,0 +1,123 @@
+//
+//  Copyright 2018 Christopher Di Bella
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+#include <algorithm>
+#include <cmath>
+#include <doge/scene/lod_selector.hpp>
+#include <glm/geometric.hpp>
+
+namespace doge {
+   namespace {
+      // keeps objects that the eye is inside of from dividing by zero
+      constexpr auto nearest_distance = 1e-4f;
+   } // namespace <anonymous>
+
+   lod_selector::lod_selector(const float threshold, const float hysteresis) noexcept
+      : threshold_{threshold},
+        hysteresis_{hysteresis}
+   {
+      Expects(threshold > 0.0f);
+      Expects(hysteresis >= 0.0f and hysteresis < 1.0f);
+   }
+
+   lod_selector::chain_id lod_selector::add_chain(const gsl::span<const mesh_lod> lods)
+   {
+      Expects(not lods.empty());
+
+      const auto first = gsl::narrow_cast<std::uint32_t>(errors_.size());
+      for (const auto& i : lods) {
+         Expects(errors_.size() == first or i.error >= errors_.back());
+         errors_.push_back(i.error);
+      }
+
+      chains_.push_back({first, gsl::narrow_cast<std::uint32_t>(lods.size())});
+      return chains_.size() - 1;
+   }
+
+   lod_selector::object_id lod_selector::add(const chain_id chain, const float scale)
+   {
+      Expects(chain < chains_.size());
+      Expects(scale > 0.0f);
+
+      chain_of_.push_back(gsl::narrow_cast<std::uint32_t>(chain));
+      scales_.push_back(scale);
+      levels_.push_back(0);
+      return levels_.size() - 1;
+   }
+
+   void lod_selector::scale(const object_id object, const float scale) noexcept
+   {
+      Expects(object < scales_.size());
+      Expects(scale > 0.0f);
+      scales_[object] = scale;
+   }
+
+   void lod_selector::select(const glm::vec3& eye, const angle field_of_view,
+      const int viewport_height, const bounding_spheres& spheres,
+      const gsl::span<const std::uint32_t> visible) noexcept
+   {
+      Expects(viewport_height > 0);
+
+      // an error of one unit, one unit from the eye, covers this many pixels
+      const auto pixels_per_unit = viewport_height
+         / (2.0f * std::tan(static_cast<float>(field_of_view) * 0.5f));
+
+      statistics_ = {};
+      for (const auto i : visible)
+         select_one(i, eye, pixels_per_unit, spheres);
+   }
+
+   void lod_selector::select(const glm::vec3& eye, const angle field_of_view,
+      const int viewport_height, const bounding_spheres& spheres) noexcept
+   {
+      Expects(viewport_height > 0);
+
+      const auto pixels_per_unit = viewport_height
+         / (2.0f * std::tan(static_cast<float>(field_of_view) * 0.5f));
+
+      statistics_ = {};
+      for (auto i = std::uint32_t{0}; i < levels_.size(); ++i)
+         select_one(i, eye, pixels_per_unit, spheres);
+   }
+
+   void lod_selector::select_one(const std::uint32_t object, const glm::vec3& eye,
+      const float pixels_per_unit, const bounding_spheres& spheres) noexcept
+   {
+      Expects(object < levels_.size() and object < spheres.size());
+
+      const auto centre = glm::vec3{spheres.x()[object], spheres.y()[object], spheres.z()[object]};
+      const auto distance = std::max(glm::distance(eye, centre) - spheres.radius()[object],
+         nearest_distance);
+
+      // errors are compared in object space, against the threshold scaled back from pixels
+      const auto limit = threshold_ * distance / (pixels_per_unit * scales_[object]);
+      const auto finer = limit * (1.0f + hysteresis_);
+      const auto coarser = limit * (1.0f - hysteresis_);
+
+      const auto& c = chains_[chain_of_[object]];
+      const auto* const errors = errors_.data() + c.first;
+      auto level = levels_[object];
+      while (level > 0 and errors[level] > finer)
+         --level;
+      while (level + 1 < c.count and errors[level + 1] <= coarser)
+         ++level;
+
+      ++statistics_.selected;
+      if (level != levels_[object]) {
+         ++statistics_.changed;
+         levels_[object] = level;
+      }
+   }
+} // namespace doge
@@ -0,0 +1,321 @@
+//
+//  Copyright 2018 Christopher Di Bella
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+#include <algorithm>
+#include <doge/scene/scene_graph.hpp>
+#include <glm/geometric.hpp>
+#include <numeric>
+
+namespace doge {
+   namespace {
+      // below this, starting a thread costs more than updating the nodes
+      constexpr std::size_t minimum_chunk = 4096;
+
+      constexpr auto no_slot = scene_graph::no_node;
+   } // namespace <anonymous>
+
+   scene_graph::node_id scene_graph::add(const node_id parent, const glm::vec3& position,
+      const glm::quat& rotation, const glm::vec3& scale, const glm::vec4& bounds)
+   {
+      const auto parent_slot = parent == no_node ? no_slot : slot(parent);
+      const auto depth = parent == no_node ? 0 : depth_[parent_slot] + 1;
+
+      auto id = node_id{};
+      if (free_.empty()) {
+         id = gsl::narrow_cast<node_id>(slot_of_.size());
+         slot_of_.push_back(no_slot);
+      }
+      else {
+         id = free_.back();
+         free_.pop_back();
+      }
+
+      const auto s = gsl::narrow_cast<std::uint32_t>(size());
+      local_.push_back(position, rotation, scale);
+      local_bounds_.push_back(bounds);
+      node_of_.push_back(id);
+      parent_of_.push_back(parent);
+      parent_slot_.push_back(parent_slot);
+      depth_.push_back(depth);
+      dirty_.push_back(0);
+      world_.push_back(glm::mat4{1.0f});
+      world_bounds_.push_back(glm::vec3{bounds}, bounds.w);
+      slot_of_[id] = s;
+
+      // appending keeps the slots sorted, unless there are already deeper nodes
+      if (not layout_dirty_) {
+         if (depth == depths_.size())
+            depths_.push_back(s);
+         else if (depth + 1 != depths_.size())
+            layout_dirty_ = true;
+      }
+
+      mark(s);
+      return id;
+   }
+
+   void scene_graph::remove(const node_id node)
+   {
+      // once sorted, every node comes after its parent, so one pass finds the whole subtree
+      if (layout_dirty_)
+         sort();
+
+      const auto first = slot(node);
+      auto removed = std::vector<std::uint8_t>(size());
+      removed[first] = 1;
+
+      auto order = std::vector<std::uint32_t>{};
+      order.reserve(size());
+      for (auto i = std::uint32_t{0}; i < size(); ++i) {
+         if (i > first and parent_slot_[i] != no_slot and removed[parent_slot_[i]])
+            removed[i] = 1;
+
+         if (removed[i]) {
+            slot_of_[node_of_[i]] = no_slot;
+            free_.push_back(node_of_[i]);
+         }
+         else {
+            order.push_back(i);
+         }
+      }
+      rebuild(order);
+   }
+
+   void scene_graph::reparent(const node_id node, const node_id parent)
+   {
+      const auto s = slot(node);
+
+      // a node can't be moved below itself
+      for (auto i = parent; i != no_node; i = parent_of_[slot(i)])
+         Expects(i != node);
+
+      parent_of_[s] = parent;
+      parent_slot_[s] = parent == no_node ? no_slot : slot(parent);
+      layout_dirty_ = true;
+      mark(s);
+   }
+
+   void scene_graph::local(const node_id node, const glm::vec3& position,
+      const glm::quat& rotation, const glm::vec3& scale) noexcept
+   {
+      const auto s = slot(node);
+      local_.set(s, position, rotation, scale);
+      mark(s);
+   }
+
+   void scene_graph::position(const node_id node, const glm::vec3& position) noexcept
+   {
+      const auto s = slot(node);
+      local_.position(s, position);
+      mark(s);
+   }
+
+   void scene_graph::bounds(const node_id node, const glm::vec4& bounds) noexcept
+   {
+      const auto s = slot(node);
+      local_bounds_[s] = bounds;
+      mark(s);
+   }
+
+   void scene_graph::update(const std::size_t threads)
+   {
+      update(threads, detail::on_threads{});
+   }
+
+   void scene_graph::update(job_system& jobs)
+   {
+      update(jobs.concurrency(), detail::on_jobs{jobs});
+   }
+
+   template <typename Spread>
+   void scene_graph::update(const std::size_t threads, const Spread& spread)
+   {
+      if (layout_dirty_)
+         sort();
+
+      changed_.clear();
+      if (first_dirty_ == clean)
+         return;
+
+      // nodes before the first dirty one can't be below a dirty one, so they're skipped
+      for (auto d = std::size_t{0}; d < depths_.size(); ++d) {
+         const auto first = std::max(depths_[d], first_dirty_);
+         const auto last = d + 1 < depths_.size() ? depths_[d + 1] : size();
+         if (first >= last)
+            continue;
+
+         const auto count = last - first;
+         const auto chunks = std::max(std::size_t{1}, std::min(threads, count / minimum_chunk));
+         if (scratch_.size() < chunks)
+            scratch_.resize(chunks);
+
+         if (chunks == 1) {
+            update_range(first, last, scratch_[0]);
+            continue;
+         }
+
+         // the nodes at one depth only read their parents, which were updated at the last depth
+         const auto chunk_size = (count + chunks - 1) / chunks;
+         const auto update_chunk = [&, this](const std::size_t chunk) noexcept {
+            const auto begin = first + chunk * chunk_size;
+            update_range(begin, std::min(last, begin + chunk_size), scratch_[chunk]);
+         };
+
+         spread(chunks, update_chunk);
+      }
+
+      for (auto i = first_dirty_; i < size(); ++i) {
+         if (dirty_[i]) {
+            changed_.push_back(gsl::narrow_cast<std::uint32_t>(i));
+            dirty_[i] = 0;
+         }
+      }
+      first_dirty_ = clean;
+   }
+
+   void scene_graph::mark(const std::uint32_t slot) noexcept
+   {
+      dirty_[slot] = 1;
+      first_dirty_ = std::min(first_dirty_, std::size_t{slot});
+   }
+
+   void scene_graph::sort()
+   {
+      // depths are found by walking up to the nearest node whose depth is already known
+      constexpr auto unknown = std::numeric_limits<std::uint32_t>::max();
+      std::fill(depth_.begin(), depth_.end(), unknown);
+      auto path = std::vector<std::uint32_t>{};
+      for (auto i = std::uint32_t{0}; i < size(); ++i) {
+         auto s = i;
+         while (depth_[s] == unknown and parent_slot_[s] != no_slot) {
+            path.push_back(s);
+            s = parent_slot_[s];
+         }
+
+         auto depth = depth_[s] == unknown ? 0 : depth_[s];
+         depth_[s] = depth;
+         for (; not path.empty(); path.pop_back())
+            depth_[path.back()] = ++depth;
+      }
+
+      auto order = std::vector<std::uint32_t>(size());
+      std::iota(order.begin(), order.end(), std::uint32_t{0});
+      std::stable_sort(order.begin(), order.end(),
+         [this](const auto a, const auto b) { return depth_[a] < depth_[b]; });
+      rebuild(order);
+      layout_dirty_ = false;
+   }
+
+   void scene_graph::rebuild(const std::vector<std::uint32_t>& order)
+   {
+      auto local = transforms{};
+      local.reserve(order.size());
+      auto local_bounds = std::vector<glm::vec4>{};
+      auto node_of = std::vector<node_id>{};
+      auto parent_of = std::vector<node_id>{};
+      auto depth = std::vector<std::uint32_t>{};
+      auto dirty = std::vector<std::uint8_t>{};
+      auto world = std::vector<glm::mat4>{};
+      auto world_bounds = bounding_spheres{};
+      for (auto* i : {&node_of, &parent_of, &depth})
+         i->reserve(order.size());
+      local_bounds.reserve(order.size());
+      dirty.reserve(order.size());
+      world.reserve(order.size());
+      world_bounds.reserve(order.size());
+
+      for (const auto i : order) {
+         local.push_back(
+            {local_.position(0)[i], local_.position(1)[i], local_.position(2)[i]},
+            {local_.rotation(3)[i], local_.rotation(0)[i], local_.rotation(1)[i],
+               local_.rotation(2)[i]},
+            {local_.scale(0)[i], local_.scale(1)[i], local_.scale(2)[i]});
+         local_bounds.push_back(local_bounds_[i]);
+         node_of.push_back(node_of_[i]);
+         parent_of.push_back(parent_of_[i]);
+         depth.push_back(depth_[i]);
+         // whatever was uploaded for the slot belonged to another node, so a moved node is dirty
+         dirty.push_back(dirty_[i] or i != dirty.size());
+         world.push_back(world_[i]);
+         world_bounds.push_back({world_bounds_.x()[i], world_bounds_.y()[i], world_bounds_.z()[i]},
+            world_bounds_.radius()[i]);
+      }
+
+      local_ = std::move(local);
+      local_bounds_ = std::move(local_bounds);
+      node_of_ = std::move(node_of);
+      parent_of_ = std::move(parent_of);
+      depth_ = std::move(depth);
+      dirty_ = std::move(dirty);
+      world_ = std::move(world);
+      world_bounds_ = std::move(world_bounds);
+
+      for (auto i = std::uint32_t{0}; i < size(); ++i)
+         slot_of_[node_of_[i]] = i;
+
+      parent_slot_.resize(size());
+      depths_.clear();
+      first_dirty_ = clean;
+      for (auto i = std::uint32_t{0}; i < size(); ++i) {
+         parent_slot_[i] = parent_of_[i] == no_node ? no_slot : slot_of_[parent_of_[i]];
+         if (depth_[i] == depths_.size())
+            depths_.push_back(i);
+         if (dirty_[i])
+            first_dirty_ = std::min(first_dirty_, std::size_t{i});
+      }
+   }
+
+   void scene_graph::update_range(const std::size_t first, const std::size_t last, scratch& s)
+      noexcept
+   {
+      // a node is dirty if it changed, or its parent was
+      s.slots.clear();
+      for (auto i = first; i != last; ++i) {
+         const auto parent = parent_slot_[i];
+         if (parent != no_slot and dirty_[parent])
+            dirty_[i] = 1;
+         if (dirty_[i])
+            s.slots.push_back(gsl::narrow_cast<std::uint32_t>(i));
+      }
+
+      s.locals.resize(s.slots.size());
+      write_matrices(local_, s.slots, s.locals);
+
+      for (auto k = std::size_t{0}; k < s.slots.size(); ++k) {
+         const auto i = s.slots[k];
+         const auto parent = parent_slot_[i];
+         world_[i] = parent == no_slot ? s.locals[k] : world_[parent] * s.locals[k];
+
+         // the radius grows with the largest scale along any axis
+         const auto& m = world_[i];
+         const auto& b = local_bounds_[i];
+         const auto scale = std::max({glm::length(glm::vec3{m[0]}), glm::length(glm::vec3{m[1]}),
+            glm::length(glm::vec3{m[2]})});
+         world_bounds_.set(i, glm::vec3{m * glm::vec4{glm::vec3{b}, 1.0f}}, b.w * scale);
+      }
+   }
+
+   void write_matrices(const scene_graph& graph, const gsl::span<const std::uint32_t> slots,
+      const gsl::span<glm::mat4> out) noexcept
+   {
+      Expects(out.size() >= slots.size());
+
+      const auto world = graph.world_matrices();
+      std::transform(slots.begin(), slots.end(), out.begin(), [world](const auto i) noexcept {
+         Expects(i < static_cast<std::size_t>(world.size()));
+         return world[i];
+      });
+   }
+} // namespace doge
@@ -0,0 +1,284 @@
+//
+//  Copyright 2018 Christopher Di Bella
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+#include <algorithm>
+#include <doge/scene/transforms.hpp>
+#include <iterator>
+
+#if defined(__AVX__)
+#include <immintrin.h>
+#endif
+
+namespace doge {
+   namespace {
+      // the twelve values of an affine matrix that aren't constant
+      struct affine {
+         float c0[3];
+         float c1[3];
+         float c2[3];
+         float p[3];
+      };
+
+      // reads every transform in order
+      struct sequential {
+         std::size_t operator()(const std::size_t i) const noexcept
+         {
+            return i;
+         }
+      };
+
+      // reads the transforms named by a list of indices
+      struct indexed {
+         const std::uint32_t* indices;
+
+         std::size_t operator()(const std::size_t i) const noexcept
+         {
+            return indices[i];
+         }
+      };
+
+      template <typename Index>
+      affine compose(const transforms& t, const Index& index, const std::size_t i) noexcept
+      {
+         const auto j = index(i);
+         const auto x = t.rotation(0)[j];
+         const auto y = t.rotation(1)[j];
+         const auto z = t.rotation(2)[j];
+         const auto w = t.rotation(3)[j];
+         const auto sx = t.scale(0)[j];
+         const auto sy = t.scale(1)[j];
+         const auto sz = t.scale(2)[j];
+
+         return {
+            {sx * (1 - 2 * (y * y + z * z)), sx * 2 * (x * y + w * z), sx * 2 * (x * z - w * y)},
+            {sy * 2 * (x * y - w * z), sy * (1 - 2 * (x * x + z * z)), sy * 2 * (y * z + w * x)},
+            {sz * 2 * (x * z + w * y), sz * 2 * (y * z - w * x), sz * (1 - 2 * (x * x + y * y))},
+            {t.position(0)[j], t.position(1)[j], t.position(2)[j]}};
+      }
+
+      void store_matrix(const affine& a, float* const out) noexcept
+      {
+         const float m[16] = {
+            a.c0[0], a.c0[1], a.c0[2], 0.0f,
+            a.c1[0], a.c1[1], a.c1[2], 0.0f,
+            a.c2[0], a.c2[1], a.c2[2], 0.0f,
+            a.p[0], a.p[1], a.p[2], 1.0f};
+         std::copy(std::begin(m), std::end(m), out);
+      }
+
+      void store_rows(const affine& a, float* const out) noexcept
+      {
+         const float m[12] = {
+            a.c0[0], a.c1[0], a.c2[0], a.p[0],
+            a.c0[1], a.c1[1], a.c2[1], a.p[1],
+            a.c0[2], a.c1[2], a.c2[2], a.p[2]};
+         std::copy(std::begin(m), std::end(m), out);
+      }
+
+#if defined(__AVX__)
+      constexpr std::size_t lane_width = 8;
+
+      __m256 load(const float* const p, const sequential&, const std::size_t i) noexcept
+      {
+         return _mm256_loadu_ps(p + i);
+      }
+
+      __m256 load(const float* const p, const indexed& index, const std::size_t i) noexcept
+      {
+#if defined(__AVX2__)
+         const auto offsets = _mm256_loadu_si256(
+            reinterpret_cast<const __m256i*>(index.indices + i));
+         return _mm256_i32gather_ps(p, offsets, sizeof(float));
+#else
+         const auto* const j = index.indices + i;
+         return _mm256_setr_ps(p[j[0]], p[j[1]], p[j[2]], p[j[3]], p[j[4]], p[j[5]], p[j[6]],
+            p[j[7]]);
+#endif
+      }
+
+      // afterwards, r[i] holds the ith element of every input register
+      void transpose(__m256 (&r)[8]) noexcept
+      {
+         const auto t0 = _mm256_unpacklo_ps(r[0], r[1]);
+         const auto t1 = _mm256_unpackhi_ps(r[0], r[1]);
+         const auto t2 = _mm256_unpacklo_ps(r[2], r[3]);
+         const auto t3 = _mm256_unpackhi_ps(r[2], r[3]);
+         const auto t4 = _mm256_unpacklo_ps(r[4], r[5]);
+         const auto t5 = _mm256_unpackhi_ps(r[4], r[5]);
+         const auto t6 = _mm256_unpacklo_ps(r[6], r[7]);
+         const auto t7 = _mm256_unpackhi_ps(r[6], r[7]);
+
+         const auto s0 = _mm256_shuffle_ps(t0, t2, _MM_SHUFFLE(1, 0, 1, 0));
+         const auto s1 = _mm256_shuffle_ps(t0, t2, _MM_SHUFFLE(3, 2, 3, 2));
+         const auto s2 = _mm256_shuffle_ps(t1, t3, _MM_SHUFFLE(1, 0, 1, 0));
+         const auto s3 = _mm256_shuffle_ps(t1, t3, _MM_SHUFFLE(3, 2, 3, 2));
+         const auto s4 = _mm256_shuffle_ps(t4, t6, _MM_SHUFFLE(1, 0, 1, 0));
+         const auto s5 = _mm256_shuffle_ps(t4, t6, _MM_SHUFFLE(3, 2, 3, 2));
+         const auto s6 = _mm256_shuffle_ps(t5, t7, _MM_SHUFFLE(1, 0, 1, 0));
+         const auto s7 = _mm256_shuffle_ps(t5, t7, _MM_SHUFFLE(3, 2, 3, 2));
+
+         r[0] = _mm256_permute2f128_ps(s0, s4, 0x20);
+         r[1] = _mm256_permute2f128_ps(s1, s5, 0x20);
+         r[2] = _mm256_permute2f128_ps(s2, s6, 0x20);
+         r[3] = _mm256_permute2f128_ps(s3, s7, 0x20);
+         r[4] = _mm256_permute2f128_ps(s0, s4, 0x31);
+         r[5] = _mm256_permute2f128_ps(s1, s5, 0x31);
+         r[6] = _mm256_permute2f128_ps(s2, s6, 0x31);
+         r[7] = _mm256_permute2f128_ps(s3, s7, 0x31);
+      }
+
+      // the columns of eight matrices, one matrix per lane
+      struct affine_lanes {
+         __m256 c0[3];
+         __m256 c1[3];
+         __m256 c2[3];
+         __m256 p[3];
+      };
+
+      template <typename Index>
+      affine_lanes compose_lanes(const transforms& t, const Index& index, const std::size_t i)
+         noexcept
+      {
+         const auto x = load(t.rotation(0), index, i);
+         const auto y = load(t.rotation(1), index, i);
+         const auto z = load(t.rotation(2), index, i);
+         const auto w = load(t.rotation(3), index, i);
+         const auto sx = load(t.scale(0), index, i);
+         const auto sy = load(t.scale(1), index, i);
+         const auto sz = load(t.scale(2), index, i);
+
+         const auto one = _mm256_set1_ps(1.0f);
+         const auto two = _mm256_set1_ps(2.0f);
+         const auto mul = [](const __m256 a, const __m256 b) noexcept { return _mm256_mul_ps(a, b); };
+         const auto add = [](const __m256 a, const __m256 b) noexcept { return _mm256_add_ps(a, b); };
+         const auto sub = [](const __m256 a, const __m256 b) noexcept { return _mm256_sub_ps(a, b); };
+
+         const auto x2 = mul(two, x);
+         const auto y2 = mul(two, y);
+         const auto z2 = mul(two, z);
+         const auto xx = mul(x2, x);
+         const auto yy = mul(y2, y);
+         const auto zz = mul(z2, z);
+         const auto xy = mul(x2, y);
+         const auto xz = mul(x2, z);
+         const auto yz = mul(y2, z);
+         const auto wx = mul(x2, w);
+         const auto wy = mul(y2, w);
+         const auto wz = mul(z2, w);
+
+         return {
+            {mul(sx, sub(one, add(yy, zz))), mul(sx, add(xy, wz)), mul(sx, sub(xz, wy))},
+            {mul(sy, sub(xy, wz)), mul(sy, sub(one, add(xx, zz))), mul(sy, add(yz, wx))},
+            {mul(sz, add(xz, wy)), mul(sz, sub(yz, wx)), mul(sz, sub(one, add(xx, yy)))},
+            {load(t.position(0), index, i), load(t.position(1), index, i),
+               load(t.position(2), index, i)}};
+      }
+
+      void store_matrices(const affine_lanes& a, float* const out) noexcept
+      {
+         const auto zero = _mm256_setzero_ps();
+         const auto one = _mm256_set1_ps(1.0f);
+         __m256 low[8] = {a.c0[0], a.c0[1], a.c0[2], zero, a.c1[0], a.c1[1], a.c1[2], zero};
+         __m256 high[8] = {a.c2[0], a.c2[1], a.c2[2], zero, a.p[0], a.p[1], a.p[2], one};
+         transpose(low);
+         transpose(high);
+         for (auto i = 0; i != 8; ++i) {
+            _mm256_storeu_ps(out + i * 16, low[i]);
+            _mm256_storeu_ps(out + i * 16 + 8, high[i]);
+         }
+      }
+
+      void store_rows(const affine_lanes& a, float* const out) noexcept
+      {
+         const auto zero = _mm256_setzero_ps();
+         __m256 low[8] = {a.c0[0], a.c1[0], a.c2[0], a.p[0], a.c0[1], a.c1[1], a.c2[1], a.p[1]};
+         __m256 high[8] = {a.c0[2], a.c1[2], a.c2[2], a.p[2], zero, zero, zero, zero};
+         transpose(low);
+         transpose(high);
+         for (auto i = 0; i != 8; ++i) {
+            _mm256_storeu_ps(out + i * 12, low[i]);
+            _mm_storeu_ps(out + i * 12 + 8, _mm256_castps256_ps128(high[i]));
+         }
+      }
+#endif
+
+      template <std::size_t Stride, typename Index>
+      void write(const transforms& t, const Index& index, const std::size_t count,
+         float* const out) noexcept
+      {
+         auto i = std::size_t{0};
+#if defined(__AVX__)
+         for (; i + lane_width <= count; i += lane_width) {
+            if constexpr (Stride == 16)
+               store_matrices(compose_lanes(t, index, i), out + i * Stride);
+            else
+               store_rows(compose_lanes(t, index, i), out + i * Stride);
+         }
+#endif
+         for (; i != count; ++i) {
+            if constexpr (Stride == 16)
+               store_matrix(compose(t, index, i), out + i * Stride);
+            else
+               store_rows(compose(t, index, i), out + i * Stride);
+         }
+      }
+   } // namespace <anonymous>
+
+   void transforms::reserve(const std::size_t n)
+   {
+      for (auto& i : position_)
+         i.reserve(n);
+      for (auto& i : rotation_)
+         i.reserve(n);
+      for (auto& i : scale_)
+         i.reserve(n);
+   }
+
+   void transforms::clear() noexcept
+   {
+      for (auto& i : position_)
+         i.clear();
+      for (auto& i : rotation_)
+         i.clear();
+      for (auto& i : scale_)
+         i.clear();
+   }
+
+   void write_matrices(const transforms& t, const gsl::span<glm::mat4> out) noexcept
+   {
+      Expects(static_cast<std::size_t>(out.size()) >= t.size());
+      write<16>(t, sequential{}, t.size(), reinterpret_cast<float*>(out.data()));
+   }
+
+   void write_matrices(const transforms& t, const gsl::span<const std::uint32_t> indices,
+      const gsl::span<glm::mat4> out) noexcept
+   {
+      Expects(out.size() >= indices.size());
+      write<16>(t, indexed{indices.data()}, indices.size(), reinterpret_cast<float*>(out.data()));
+   }
+
+   void write_affine_rows(const transforms& t, const gsl::span<glm::vec4> out) noexcept
+   {
+      Expects(static_cast<std::size_t>(out.size()) >= t.size() * 3);
+      write<12>(t, sequential{}, t.size(), reinterpret_cast<float*>(out.data()));
+   }
+
+   void write_affine_rows(const transforms& t, const gsl::span<const std::uint32_t> indices,
+      const gsl::span<glm::vec4> out) noexcept
+   {
+      Expects(out.size() >= indices.size() * 3);
+      write<12>(t, indexed{indices.data()}, indices.size(), reinterpret_cast<float*>(out.data()));
+   }
+} // namespace doge
@@ -13,30 +13,201 @@
 // See the License for the specific language governing permissions and
 // limitations under the License.
 //
+#include <algorithm>
 #include <doge/utility/file.hpp>
-#include <experimental/ranges/algorithm>
-#include <experimental/ranges/concepts>
-#include <experimental/ranges/iterator>
 #include <fstream>
-// #include <filesystem>
 #include <stdexcept>
 #include <string>
+#include <utility>
+
+#ifdef _WIN32
+   #define WIN32_LEAN_AND_MEAN
+   #define NOMINMAX
+   #include <windows.h>
+#else
+   #include <dirent.h>
+   #include <fcntl.h>
+   #include <sys/mman.h>
+   #include <sys/stat.h>
+   #include <unistd.h>
+#endif // _WIN32
 
 namespace doge {
+#ifdef _WIN32
+   mapped_file::mapped_file(const std::string& path)
+   {
+      const auto file = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr,
+         OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL | FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+      if (file == INVALID_HANDLE_VALUE)
+         throw std::runtime_error{"Unable to open file " + path};
+
+      auto size = LARGE_INTEGER{};
+      if (not GetFileSizeEx(file, &size)) {
+         CloseHandle(file);
+         throw std::runtime_error{"Unable to open file " + path};
+      }
+
+      size_ = gsl::narrow_cast<std::size_t>(size.QuadPart);
+      if (size_ == 0) { // empty files can't be mapped
+         CloseHandle(file);
+         return;
+      }
+
+      // the view keeps the mapping alive, and the mapping keeps the file alive
+      mapping_ = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+      CloseHandle(file);
+      if (not mapping_)
+         throw std::runtime_error{"Unable to map file " + path};
+
+      data_ = static_cast<const std::byte*>(MapViewOfFile(mapping_, FILE_MAP_READ, 0, 0, 0));
+      if (not data_) {
+         CloseHandle(mapping_);
+         throw std::runtime_error{"Unable to map file " + path};
+      }
+   }
+
+   void mapped_file::unmap() noexcept
+   {
+      if (data_)
+         UnmapViewOfFile(data_);
+      if (mapping_)
+         CloseHandle(mapping_);
+   }
+
+   std::vector<std::string> list_directory(const std::string& directory,
+      const std::string_view extension)
+   {
+      auto found = WIN32_FIND_DATAA{};
+      const auto search = FindFirstFileA((directory + "\\*").c_str(), &found);
+      if (search == INVALID_HANDLE_VALUE)
+         throw std::runtime_error{"Unable to open directory " + directory};
+
+      auto result = std::vector<std::string>{};
+      do {
+         if (found.dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY)
+            continue;
+
+         const auto name = std::string_view{found.cFileName};
+         if (name.size() >= extension.size()
+            and name.substr(name.size() - extension.size()) == extension)
+         {
+            result.push_back(directory + '/' + found.cFileName);
+         }
+      } while (FindNextFileA(search, &found));
+      FindClose(search);
+
+      std::sort(result.begin(), result.end());
+      return result;
+   }
+#else
+   mapped_file::mapped_file(const std::string& path)
+   {
+      const auto file = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+      if (file == -1)
+         throw std::runtime_error{"Unable to open file " + path};
+
+      struct stat status;
+      if (::fstat(file, &status) == -1) {
+         ::close(file);
+         throw std::runtime_error{"Unable to open file " + path};
+      }
+
+      size_ = gsl::narrow_cast<std::size_t>(status.st_size);
+      if (size_ == 0) { // empty files can't be mapped
+         ::close(file);
+         return;
+      }
+
+      // the mapping keeps the file alive, so it can be closed straight away
+      const auto mapping = ::mmap(nullptr, size_, PROT_READ, MAP_PRIVATE, file, 0);
+      ::close(file);
+      if (mapping == MAP_FAILED)
+         throw std::runtime_error{"Unable to map file " + path};
+
+      ::madvise(mapping, size_, MADV_SEQUENTIAL);
+      data_ = static_cast<const std::byte*>(mapping);
+   }
+
+   void mapped_file::unmap() noexcept
+   {
+      if (data_)
+         ::munmap(const_cast<std::byte*>(data_), size_);
+   }
+
+   std::vector<std::string> list_directory(const std::string& directory,
+      const std::string_view extension)
+   {
+      const auto search = ::opendir(directory.c_str());
+      if (not search)
+         throw std::runtime_error{"Unable to open directory " + directory};
+
+      auto result = std::vector<std::string>{};
+      while (const auto entry = ::readdir(search)) {
+         const auto name = std::string_view{entry->d_name};
+         if (name.size() < extension.size()
+            or name.substr(name.size() - extension.size()) != extension)
+         {
+            continue;
+         }
+
+         // d_type isn't filled in by every file system
+         auto path = directory + '/' + entry->d_name;
+         struct stat status;
+         if (::stat(path.c_str(), &status) == 0 and S_ISREG(status.st_mode))
+            result.push_back(std::move(path));
+      }
+      ::closedir(search);
+
+      std::sort(result.begin(), result.end());
+      return result;
+   }
+#endif // _WIN32
+
+   mapped_file::mapped_file(mapped_file&& other) noexcept
+      : data_{std::exchange(other.data_, nullptr)},
+        size_{std::exchange(other.size_, 0)}
+#ifdef _WIN32
+      , mapping_{std::exchange(other.mapping_, nullptr)}
+#endif // _WIN32
+   {}
+
+   mapped_file& mapped_file::operator=(mapped_file&& other) noexcept
+   {
+      if (this != &other) {
+         unmap();
+         data_ = std::exchange(other.data_, nullptr);
+         size_ = std::exchange(other.size_, 0);
+#ifdef _WIN32
+         mapping_ = std::exchange(other.mapping_, nullptr);
+#endif // _WIN32
+      }
+      return *this;
+   }
+
+   mapped_file::~mapped_file() noexcept
+   {
+      unmap();
+   }
+
    template <>
    std::string from_file<std::string>(const std::string& path)
    {
-      namespace ranges = std::experimental::ranges;
-      if (auto in = std::ifstream{path}) {
-         in.seekg(0, std::ios::end);
-         ranges::Regular s = std::string(in.tellg(), '\0');
-         in.seekg(0, std::ios::beg);
+      return std::string{mapped_file{path}.text()};
+   }
 
-         ranges::copy(ranges::istreambuf_iterator<char>{in}, ranges::istreambuf_iterator<char>{},
-            ranges::begin(s));
-         return s;
-      }
+   template <>
+   std::vector<std::byte> from_file<std::vector<std::byte>>(const std::string& path)
+   {
+      const auto file = mapped_file{path};
+      const auto bytes = file.bytes();
+      return {bytes.begin(), bytes.end()};
+   }
 
-      throw std::runtime_error{"Unable to open file " + path};
+   void to_file(const std::string& path, const gsl::span<const std::byte> bytes)
+   {
+      auto file = std::ofstream{path, std::ios::binary | std::ios::trunc};
+      file.write(reinterpret_cast<const char*>(bytes.data()), bytes.size());
+      if (not file)
+         throw std::runtime_error{"Unable to write file " + path};
    }
 } // namespace doge
@@ -0,0 +1,100 @@
+//
+//  Copyright 2018 Christopher Di Bella
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+#include <algorithm>
+#include <cstdint>
+#include <doge/utility/frame_arena.hpp>
+#include <gsl/gsl>
+
+namespace doge {
+   namespace {
+      std::size_t align_up(const std::uintptr_t p, const std::size_t alignment) noexcept
+      {
+         return (p + alignment - 1) & ~(alignment - 1);
+      }
+   } // namespace <anonymous>
+
+   arena::arena(const std::size_t capacity)
+      : block_{std::make_unique<std::byte[]>(capacity)},
+        capacity_{capacity}
+   {
+      Expects(capacity > 0);
+   }
+
+   void* arena::allocate(const std::size_t size, const std::size_t alignment)
+   {
+      Expects(alignment > 0 and (alignment & (alignment - 1)) == 0);
+      ++statistics_.allocations;
+      statistics_.bytes += size;
+
+      const auto base = reinterpret_cast<std::uintptr_t>(block_.get());
+      const auto offset = align_up(base + used_, alignment) - base;
+      if (offset + size <= capacity_) {
+         used_ = offset + size;
+         return block_.get() + offset;
+      }
+
+      return allocate_overflow(size, alignment);
+   }
+
+   void* arena::allocate_overflow(const std::size_t size, const std::size_t alignment)
+   {
+      const auto top = reinterpret_cast<std::uintptr_t>(overflow_top_);
+      const auto padding = overflow_top_ ? align_up(top, alignment) - top : 0;
+      if (not overflow_top_ or padding + size > overflow_left_) {
+         // blocks are at least as large as the arena, so an overflowing frame takes few of them
+         const auto block_size = std::max(capacity_, size + alignment);
+         overflow_.push_back(std::make_unique<std::byte[]>(block_size));
+         overflow_top_ = overflow_.back().get();
+         overflow_left_ = block_size;
+         overflowed_ += block_size;
+         ++statistics_.heap_allocations;
+         return allocate_overflow(size, alignment);
+      }
+
+      const auto result = overflow_top_ + padding;
+      overflow_top_ = result + size;
+      overflow_left_ -= padding + size;
+      return result;
+   }
+
+   void arena::reset()
+   {
+      if (overflowed_ != 0) {
+         capacity_ += overflowed_;
+         block_ = std::make_unique<std::byte[]>(capacity_);
+         overflow_.clear();
+         overflow_top_ = nullptr;
+         overflow_left_ = 0;
+         overflowed_ = 0;
+      }
+
+      used_ = 0;
+      statistics_ = {};
+   }
+
+   frame_arena::frame_arena(const std::size_t capacity)
+      : arenas_{std::make_unique<arena>(capacity), std::make_unique<arena>(capacity)}
+   {}
+
+   void frame_arena::next_frame()
+   {
+      Expects(steady_after_ == 0 or frame_ < steady_after_
+         or current().statistics().heap_allocations == 0);
+
+      ++frame_;
+      current().reset();
+   }
+} // namespace doge
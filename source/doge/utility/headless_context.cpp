@@ -0,0 +1,144 @@
+//
+//  Copyright 2018 Christopher Di Bella
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+#include <cstring>
+#include <doge/gl/state_cache.hpp>
+#include <doge/utility/headless_context.hpp>
+#include <EGL/eglext.h>
+#include <gl/gl_core.hpp>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+
+namespace doge {
+   namespace {
+      bool has_extension(const char* const extensions, const char* const name) noexcept
+      {
+         if (extensions == nullptr)
+            return false;
+
+         const auto length = std::strlen(name);
+         for (auto p = std::strstr(extensions, name); p != nullptr; p = std::strstr(p + 1, name)) {
+            if ((p == extensions or p[-1] == ' ') and (p[length] == ' ' or p[length] == '\0'))
+               return true;
+         }
+         return false;
+      }
+
+      // prefers a GPU found through EGL_EXT_platform_device, which needs no display at all, and then
+      // Mesa's surfaceless platform, before falling back to the default display
+      EGLDisplay open_display()
+      {
+         const auto client = eglQueryString(EGL_NO_DISPLAY, EGL_EXTENSIONS);
+         const auto get_platform_display = reinterpret_cast<PFNEGLGETPLATFORMDISPLAYEXTPROC>(
+            eglGetProcAddress("eglGetPlatformDisplayEXT"));
+
+         auto display = EGL_NO_DISPLAY;
+         if (get_platform_display and has_extension(client, "EGL_EXT_platform_device")) {
+            const auto query_devices = reinterpret_cast<PFNEGLQUERYDEVICESEXTPROC>(
+               eglGetProcAddress("eglQueryDevicesEXT"));
+            auto device = EGLDeviceEXT{};
+            auto count = EGLint{0};
+            if (query_devices and query_devices(1, &device, &count) and count > 0)
+               display = get_platform_display(EGL_PLATFORM_DEVICE_EXT, device, nullptr);
+         }
+
+         if (display == EGL_NO_DISPLAY and get_platform_display
+             and has_extension(client, "EGL_MESA_platform_surfaceless")) {
+            display = get_platform_display(EGL_PLATFORM_SURFACELESS_MESA, EGL_DEFAULT_DISPLAY,
+               nullptr);
+         }
+
+         if (display == EGL_NO_DISPLAY)
+            display = eglGetDisplay(EGL_DEFAULT_DISPLAY);
+
+         if (display == EGL_NO_DISPLAY or not eglInitialize(display, nullptr, nullptr))
+            throw std::runtime_error{"Unable to initialise EGL"};
+
+         if (not has_extension(eglQueryString(display, EGL_EXTENSIONS),
+                               "EGL_KHR_surfaceless_context")) {
+            throw std::runtime_error{"EGL doesn't support contexts without a surface"};
+         }
+
+         if (not eglBindAPI(EGL_OPENGL_API))
+            throw std::runtime_error{"EGL doesn't support desktop OpenGL"};
+
+         return display;
+      }
+
+      // every context in the process is made on the one display, which stays initialised until
+      // the process ends, as terminating it would destroy every other job's context too
+      EGLDisplay display()
+      {
+         static const auto result = open_display();
+         return result;
+      }
+   } // namespace <anonymous>
+
+   headless_context::headless_context(const headless_context* const share)
+   {
+      const auto d = display();
+      constexpr EGLint config_attributes[] = {
+         EGL_SURFACE_TYPE, EGL_PBUFFER_BIT,
+         EGL_RENDERABLE_TYPE, EGL_OPENGL_BIT,
+         EGL_NONE
+      };
+
+      auto config = EGLConfig{};
+      auto count = EGLint{0};
+      if (not eglChooseConfig(d, config_attributes, &config, 1, &count) or count == 0)
+         throw std::runtime_error{"EGL has no configuration for desktop OpenGL"};
+
+      constexpr EGLint context_attributes[] = {
+         EGL_CONTEXT_MAJOR_VERSION, 4,
+         EGL_CONTEXT_MINOR_VERSION, 3,
+         EGL_CONTEXT_OPENGL_PROFILE_MASK, EGL_CONTEXT_OPENGL_CORE_PROFILE_BIT,
+         EGL_NONE
+      };
+
+      context_ = eglCreateContext(d, config, share ? share->context_ : EGL_NO_CONTEXT,
+         context_attributes);
+      if (context_ == EGL_NO_CONTEXT) {
+         throw std::runtime_error{"Unable to create an OpenGL 4.3 context (EGL error "
+            + std::to_string(eglGetError()) + ")"};
+      }
+   }
+
+   headless_context::~headless_context() noexcept
+   {
+      if (eglGetCurrentContext() == context_)
+         release_current();
+      eglDestroyContext(display(), context_);
+   }
+
+   void headless_context::make_current() const
+   {
+      if (not eglMakeCurrent(display(), EGL_NO_SURFACE, EGL_NO_SURFACE, context_))
+         throw std::runtime_error{"Unable to make the headless context current"};
+      context_changed();
+
+      // the function pointers are shared by every context, so they only need loading once
+      static std::once_flag loaded;
+      std::call_once(loaded, []{
+         if (not gl::sys::LoadFunctions())
+            throw std::runtime_error{"Unable to load OpenGL functions through EGL"};
+      });
+   }
+
+   void headless_context::release_current() noexcept
+   {
+      eglMakeCurrent(display(), EGL_NO_SURFACE, EGL_NO_SURFACE, EGL_NO_CONTEXT);
+   }
+} // namespace doge
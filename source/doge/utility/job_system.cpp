@@ -0,0 +1,191 @@
+//
+//  Copyright 2018 Christopher Di Bella
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+#include <doge/utility/job_system.hpp>
+
+#if defined(__linux__)
+#include <pthread.h>
+#include <sched.h>
+#endif
+
+namespace doge {
+   namespace {
+      // the job system that the current thread works for, if any, and which queue is its own
+      thread_local const job_system* owner = nullptr;
+      thread_local std::size_t owned_queue = 0;
+
+      void pin(std::thread& t, const std::size_t core) noexcept
+      {
+#if defined(__linux__)
+         auto set = cpu_set_t{};
+         CPU_ZERO(&set);
+         CPU_SET(core, &set);
+         pthread_setaffinity_np(t.native_handle(), sizeof(set), &set);
+#else
+         static_cast<void>(t);
+         static_cast<void>(core);
+#endif
+      }
+   } // namespace <anonymous>
+
+   job_system::job_system(const std::size_t workers, const bool pin_workers)
+   {
+      queues_.reserve(workers + 1);
+      for (auto i = std::size_t{0}; i <= workers; ++i)
+         queues_.push_back(std::make_unique<queue>());
+
+      // core 0 is left for the thread that made the job system, which is usually the GL thread
+      const auto cores = std::max(1u, std::thread::hardware_concurrency());
+      workers_.reserve(workers);
+      for (auto i = std::size_t{0}; i < workers; ++i) {
+         workers_.emplace_back([this, i]{ work(i); });
+         if (pin_workers)
+            pin(workers_.back(), (i + 1) % cores);
+      }
+   }
+
+   job_system::~job_system()
+   {
+      {
+         auto lock = std::lock_guard{sleep_mutex_};
+         stopping_ = true;
+      }
+      wake_.notify_all();
+      for (auto& i : workers_)
+         i.join();
+
+      // without workers, nothing else would run the jobs that are left
+      while (run_one(own_queue()))
+         continue;
+   }
+
+   void job_system::wait(const job_counter& counter) noexcept
+   {
+      const auto self = own_queue();
+      while (not counter.done()) {
+         if (not run_one(self))
+            std::this_thread::yield();
+      }
+   }
+
+   void job_system::push(job j)
+   {
+      // counted first, so that a worker that sees nothing queued really has nothing to steal
+      queued_.fetch_add(1, std::memory_order_release);
+      {
+         auto& q = *queues_[own_queue()];
+         auto lock = std::lock_guard{q.mutex};
+         q.jobs.push_back(std::move(j));
+      }
+
+      // taking the lock means that a worker can't miss the notification between checking for
+      // jobs and going to sleep
+      { auto lock = std::lock_guard{sleep_mutex_}; }
+      wake_.notify_one();
+   }
+
+   bool job_system::run_one(const std::size_t self) noexcept
+   {
+      auto j = job{};
+      auto found = false;
+      {
+         auto& q = *queues_[self];
+         auto lock = std::lock_guard{q.mutex};
+         if (not q.jobs.empty()) {
+            j = std::move(q.jobs.back());
+            q.jobs.pop_back();
+            found = true;
+         }
+      }
+
+      for (auto i = std::size_t{1}; not found and i < queues_.size(); ++i) {
+         auto& q = *queues_[(self + i) % queues_.size()];
+         auto lock = std::lock_guard{q.mutex};
+         if (not q.jobs.empty()) {
+            j = std::move(q.jobs.front());
+            q.jobs.pop_front();
+            found = true;
+         }
+      }
+
+      if (not found)
+         return false;
+
+      queued_.fetch_sub(1, std::memory_order_relaxed);
+      j.work();
+      j.counter->pending_.fetch_sub(1, std::memory_order_release);
+      return true;
+   }
+
+   void job_system::work(const std::size_t self) noexcept
+   {
+      owner = this;
+      owned_queue = self;
+      for (;;) {
+         if (run_one(self))
+            continue;
+
+         auto lock = std::unique_lock{sleep_mutex_};
+         wake_.wait(lock, [this]{
+            return stopping_ or queued_.load(std::memory_order_acquire) > 0;
+         });
+         if (stopping_ and queued_.load(std::memory_order_acquire) == 0)
+            return;
+      }
+   }
+
+   std::size_t job_system::own_queue() const noexcept
+   {
+      return owner == this ? owned_queue : queues_.size() - 1;
+   }
+
+   void job_graph::precede(const node_id before, const node_id after)
+   {
+      Expects(before < nodes_.size() and after < nodes_.size());
+      Expects(before != after);
+      nodes_[before].successors.push_back(after);
+      ++nodes_[after].predecessors;
+   }
+
+   void job_graph::run(job_system& jobs)
+   {
+      for (auto& i : nodes_)
+         i.remaining.store(i.predecessors, std::memory_order_relaxed);
+
+      auto counter = job_counter{};
+      for (auto i = node_id{0}; i < nodes_.size(); ++i) {
+         if (nodes_[i].predecessors == 0)
+            start(jobs, counter, i);
+      }
+      jobs.wait(counter);
+
+      // a node in a cycle never becomes ready
+      Ensures(std::all_of(nodes_.begin(), nodes_.end(),
+         [](const auto& i) { return i.remaining.load(std::memory_order_relaxed) == 0; }));
+   }
+
+   void job_graph::start(job_system& jobs, job_counter& counter, const node_id n)
+   {
+      // successors are started before this job is uncounted, so the counter can't reach zero
+      // while there's still work to do
+      jobs.run([this, &jobs, &counter, n]{
+         ranges::invoke(nodes_[n].work);
+         for (const auto i : nodes_[n].successors) {
+            if (nodes_[i].remaining.fetch_sub(1, std::memory_order_acq_rel) == 1)
+               start(jobs, counter, i);
+         }
+      }, counter);
+   }
+} // namespace doge
@@ -0,0 +1,227 @@
+//
+//  Copyright 2018 Christopher Di Bella
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+#include <algorithm>
+#include <doge/utility/profiler.hpp>
+#include <gsl/gsl>
+#include <iomanip>
+#include <numeric>
+#include <ostream>
+
+namespace doge {
+   namespace {
+      scope_statistics::timing summarise(std::vector<std::int64_t>& samples)
+      {
+         if (samples.empty())
+            return {};
+
+         using std::chrono::nanoseconds;
+         const auto total = std::accumulate(begin(samples), end(samples), std::int64_t{0});
+         const auto p99 = begin(samples) + (samples.size() * 99 + 99) / 100 - 1;
+         std::nth_element(begin(samples), p99, end(samples));
+         return {nanoseconds{*std::min_element(begin(samples), end(samples))},
+            nanoseconds{total / gsl::narrow_cast<std::int64_t>(samples.size())},
+            nanoseconds{*p99}};
+      }
+
+      void write_escaped(std::ostream& out, const std::string_view text)
+      {
+         for (const auto c : text) {
+            if (c == '"' || c == '\\')
+               out << '\\';
+            out << c;
+         }
+      }
+
+      void write_event(std::ostream& out, const std::string_view name, const char* const category,
+         const int thread, const std::int64_t begin, const std::int64_t end,
+         const std::uint64_t frame)
+      {
+         // trace timestamps are in microseconds, and are written in fixed point, since the
+         // default six significant digits lose sub-millisecond precision after a second
+         const auto flags = out.flags();
+         const auto precision = out.precision();
+         out << "{\"name\":\"";
+         write_escaped(out, name);
+         out << "\",\"cat\":\"" << category << "\",\"ph\":\"X\",\"pid\":0,\"tid\":" << thread
+             << std::fixed << std::setprecision(3)
+             << ",\"ts\":" << begin / 1000.0 << ",\"dur\":" << (end - begin) / 1000.0
+             << ",\"args\":{\"frame\":" << frame << "}}";
+         out.flags(flags);
+         out.precision(precision);
+      }
+   } // namespace <anonymous>
+
+   profiler::profiler()
+      : ring_(history)
+   {
+      for (auto& i : pending_)
+         gl::GenQueries(gsl::narrow_cast<GLsizei>(i.queries.size()), i.queries.data());
+
+      gl::GetInteger64v(gl::TIMESTAMP, &gpu_epoch_);
+      epoch_ = std::chrono::steady_clock::now();
+   }
+
+   profiler::~profiler() noexcept
+   {
+      for (auto& i : pending_)
+         gl::DeleteQueries(gsl::narrow_cast<GLsizei>(i.queries.size()), i.queries.data());
+   }
+
+   void profiler::begin_frame()
+   {
+      auto& frame = pending_[frame_ % pending_.size()];
+      if (frame.unpublished)
+         publish(frame);
+
+      frame.record.frame = frame_;
+      frame.record.count = 0;
+      frame.unpublished = true;
+   }
+
+   void profiler::end_frame() noexcept
+   {
+      ++frame_;
+   }
+
+   profiler::scoped_marker profiler::scope(const std::string_view name) noexcept
+   {
+      auto& frame = pending_[frame_ % pending_.size()];
+      Expects(frame.unpublished && frame.record.frame == frame_);
+
+      auto& record = frame.record;
+      if (record.count == max_scopes)
+         return {*this, max_scopes};
+
+      const auto index = record.count++;
+      record.scopes[index] = {name, now()};
+      frame.last_query = frame.queries[2 * index];
+      gl::QueryCounter(frame.last_query, gl::TIMESTAMP);
+      return {*this, index};
+   }
+
+   void profiler::end_scope(const std::size_t index) noexcept
+   {
+      if (index == max_scopes)
+         return;
+
+      auto& frame = pending_[frame_ % pending_.size()];
+      frame.record.scopes[index].cpu_end = now();
+      frame.last_query = frame.queries[2 * index + 1];
+      gl::QueryCounter(frame.last_query, gl::TIMESTAMP);
+   }
+
+   void profiler::publish(pending_frame& frame)
+   {
+      auto& record = frame.record;
+      auto available = GLuint64{gl::FALSE_};
+      if (record.count != 0)
+         gl::GetQueryObjectui64v(frame.last_query, gl::QUERY_RESULT_AVAILABLE, &available);
+
+      // queries complete in order, so if the last one is ready, then so are the rest
+      for (auto i = std::size_t{0}; i < record.count; ++i) {
+         auto& s = record.scopes[i];
+         if (available) {
+            auto begin = GLuint64{};
+            auto end = GLuint64{};
+            gl::GetQueryObjectui64v(frame.queries[2 * i], gl::QUERY_RESULT, &begin);
+            gl::GetQueryObjectui64v(frame.queries[2 * i + 1], gl::QUERY_RESULT, &end);
+            s.gpu_begin = gsl::narrow_cast<std::int64_t>(begin) - gpu_epoch_;
+            s.gpu_end = gsl::narrow_cast<std::int64_t>(end) - gpu_epoch_;
+         }
+         else {
+            s.gpu_begin = -1;
+            s.gpu_end = -1;
+         }
+      }
+
+      // a seqlock: readers discard a slot whose sequence was odd, or changed while they read it
+      const auto n = published_.load(std::memory_order_relaxed);
+      auto& slot = ring_[n % history];
+      const auto sequence = slot.sequence.load(std::memory_order_relaxed);
+      slot.sequence.store(sequence + 1, std::memory_order_relaxed);
+      std::atomic_thread_fence(std::memory_order_release);
+      slot.record = record;
+      slot.sequence.store(sequence + 2, std::memory_order_release);
+      published_.store(n + 1, std::memory_order_release);
+      frame.unpublished = false;
+   }
+
+   std::int64_t profiler::now() const noexcept
+   {
+      using namespace std::chrono;
+      return duration_cast<nanoseconds>(steady_clock::now() - epoch_).count();
+   }
+
+   template <typename F>
+   void profiler::for_each_frame(F f) const
+   {
+      const auto n = published_.load(std::memory_order_acquire);
+      for (auto i = n > history ? n - history : 0; i < n; ++i) {
+         const auto& slot = ring_[i % history];
+         const auto sequence = slot.sequence.load(std::memory_order_acquire);
+         if (sequence % 2 != 0)
+            continue;
+
+         const auto record = slot.record;
+         std::atomic_thread_fence(std::memory_order_acquire);
+         if (slot.sequence.load(std::memory_order_relaxed) == sequence)
+            f(record);
+      }
+   }
+
+   scope_statistics profiler::statistics(const std::string_view name) const
+   {
+      auto cpu = std::vector<std::int64_t>{};
+      auto gpu = std::vector<std::int64_t>{};
+      for_each_frame([&](const frame_record& record) {
+         for (auto i = std::size_t{0}; i < record.count; ++i) {
+            const auto& s = record.scopes[i];
+            if (s.name != name)
+               continue;
+
+            cpu.push_back(s.cpu_end - s.cpu_begin);
+            if (s.gpu_begin >= 0)
+               gpu.push_back(s.gpu_end - s.gpu_begin);
+         }
+      });
+
+      auto result = scope_statistics{};
+      result.cpu_samples = cpu.size();
+      result.gpu_samples = gpu.size();
+      result.cpu = summarise(cpu);
+      result.gpu = summarise(gpu);
+      return result;
+   }
+
+   void profiler::export_chrome_trace(std::ostream& out) const
+   {
+      out << "{\"traceEvents\":[";
+      auto first = true;
+      for_each_frame([&](const frame_record& record) {
+         for (auto i = std::size_t{0}; i < record.count; ++i) {
+            const auto& s = record.scopes[i];
+            out << (first ? "\n" : ",\n");
+            first = false;
+            write_event(out, s.name, "cpu", 0, s.cpu_begin, s.cpu_end, record.frame);
+            if (s.gpu_begin >= 0) {
+               out << ",\n";
+               write_event(out, s.name, "gpu", 1, s.gpu_begin, s.gpu_end, record.frame);
+            }
+         }
+      });
+      out << "\n]}\n";
+   }
+} // namespace doge
@@ -3,6 +3,7 @@
 #include <string.h>
 #include <stddef.h>
 #include <gl/gl_core.hpp>
+#include <gl/gl_trace.hpp>
 
 #if defined(__APPLE__)
 #include <dlfcn.h>
@@ -78,6 +79,10 @@ static PROC WinGetProcAddress(const char *name)
 	#else
 		#if defined(__sgi) || defined(__sun)
 			#define IntGetProcAddress(name) SunGetProcAddress(name)
+		#elif defined(DOGE_GL_EGL) /* EGL, which needs no display server */
+		    #include <EGL/egl.h>
+
+			#define IntGetProcAddress(name) eglGetProcAddress(name)
 		#else /* GLX */
 		    #include <GL/glx.h>
 
@@ -90,7 +95,104 @@ namespace gl
 {
 	namespace exts
 	{
+		LoadTest var_ARB_bindless_texture;
+		LoadTest var_ARB_buffer_storage;
+		LoadTest var_KHR_parallel_shader_compile;
+		
 	} //namespace exts
+	typedef GLuint64 (CODEGEN_FUNCPTR *PFNGETTEXTUREHANDLEARB)(GLuint);
+	PFNGETTEXTUREHANDLEARB GetTextureHandleARB = 0;
+	typedef GLuint64 (CODEGEN_FUNCPTR *PFNGETTEXTURESAMPLERHANDLEARB)(GLuint, GLuint);
+	PFNGETTEXTURESAMPLERHANDLEARB GetTextureSamplerHandleARB = 0;
+	typedef void (CODEGEN_FUNCPTR *PFNMAKETEXTUREHANDLERESIDENTARB)(GLuint64);
+	PFNMAKETEXTUREHANDLERESIDENTARB MakeTextureHandleResidentARB = 0;
+	typedef void (CODEGEN_FUNCPTR *PFNMAKETEXTUREHANDLENONRESIDENTARB)(GLuint64);
+	PFNMAKETEXTUREHANDLENONRESIDENTARB MakeTextureHandleNonResidentARB = 0;
+	typedef GLuint64 (CODEGEN_FUNCPTR *PFNGETIMAGEHANDLEARB)(GLuint, GLint, GLboolean, GLint, GLenum);
+	PFNGETIMAGEHANDLEARB GetImageHandleARB = 0;
+	typedef void (CODEGEN_FUNCPTR *PFNMAKEIMAGEHANDLERESIDENTARB)(GLuint64, GLenum);
+	PFNMAKEIMAGEHANDLERESIDENTARB MakeImageHandleResidentARB = 0;
+	typedef void (CODEGEN_FUNCPTR *PFNMAKEIMAGEHANDLENONRESIDENTARB)(GLuint64);
+	PFNMAKEIMAGEHANDLENONRESIDENTARB MakeImageHandleNonResidentARB = 0;
+	typedef void (CODEGEN_FUNCPTR *PFNUNIFORMHANDLEUI64ARB)(GLint, GLuint64);
+	PFNUNIFORMHANDLEUI64ARB UniformHandleui64ARB = 0;
+	typedef void (CODEGEN_FUNCPTR *PFNUNIFORMHANDLEUI64VARB)(GLint, GLsizei, const GLuint64 *);
+	PFNUNIFORMHANDLEUI64VARB UniformHandleui64vARB = 0;
+	typedef void (CODEGEN_FUNCPTR *PFNPROGRAMUNIFORMHANDLEUI64ARB)(GLuint, GLint, GLuint64);
+	PFNPROGRAMUNIFORMHANDLEUI64ARB ProgramUniformHandleui64ARB = 0;
+	typedef void (CODEGEN_FUNCPTR *PFNPROGRAMUNIFORMHANDLEUI64VARB)(GLuint, GLint, GLsizei, const GLuint64 *);
+	PFNPROGRAMUNIFORMHANDLEUI64VARB ProgramUniformHandleui64vARB = 0;
+	typedef GLboolean (CODEGEN_FUNCPTR *PFNISTEXTUREHANDLERESIDENTARB)(GLuint64);
+	PFNISTEXTUREHANDLERESIDENTARB IsTextureHandleResidentARB = 0;
+	typedef GLboolean (CODEGEN_FUNCPTR *PFNISIMAGEHANDLERESIDENTARB)(GLuint64);
+	PFNISIMAGEHANDLERESIDENTARB IsImageHandleResidentARB = 0;
+	typedef void (CODEGEN_FUNCPTR *PFNVERTEXATTRIBL1UI64ARB)(GLuint, GLuint64EXT);
+	PFNVERTEXATTRIBL1UI64ARB VertexAttribL1ui64ARB = 0;
+	typedef void (CODEGEN_FUNCPTR *PFNVERTEXATTRIBL1UI64VARB)(GLuint, const GLuint64EXT *);
+	PFNVERTEXATTRIBL1UI64VARB VertexAttribL1ui64vARB = 0;
+	typedef void (CODEGEN_FUNCPTR *PFNGETVERTEXATTRIBLUI64VARB)(GLuint, GLenum, GLuint64EXT *);
+	PFNGETVERTEXATTRIBLUI64VARB GetVertexAttribLui64vARB = 0;
+	
+	static int Load_ARB_bindless_texture()
+	{
+		int numFailed = 0;
+		GetTextureHandleARB = reinterpret_cast<PFNGETTEXTUREHANDLEARB>(IntGetProcAddress("glGetTextureHandleARB"));
+		if(!GetTextureHandleARB) ++numFailed;
+		GetTextureSamplerHandleARB = reinterpret_cast<PFNGETTEXTURESAMPLERHANDLEARB>(IntGetProcAddress("glGetTextureSamplerHandleARB"));
+		if(!GetTextureSamplerHandleARB) ++numFailed;
+		MakeTextureHandleResidentARB = reinterpret_cast<PFNMAKETEXTUREHANDLERESIDENTARB>(IntGetProcAddress("glMakeTextureHandleResidentARB"));
+		if(!MakeTextureHandleResidentARB) ++numFailed;
+		MakeTextureHandleNonResidentARB = reinterpret_cast<PFNMAKETEXTUREHANDLENONRESIDENTARB>(IntGetProcAddress("glMakeTextureHandleNonResidentARB"));
+		if(!MakeTextureHandleNonResidentARB) ++numFailed;
+		GetImageHandleARB = reinterpret_cast<PFNGETIMAGEHANDLEARB>(IntGetProcAddress("glGetImageHandleARB"));
+		if(!GetImageHandleARB) ++numFailed;
+		MakeImageHandleResidentARB = reinterpret_cast<PFNMAKEIMAGEHANDLERESIDENTARB>(IntGetProcAddress("glMakeImageHandleResidentARB"));
+		if(!MakeImageHandleResidentARB) ++numFailed;
+		MakeImageHandleNonResidentARB = reinterpret_cast<PFNMAKEIMAGEHANDLENONRESIDENTARB>(IntGetProcAddress("glMakeImageHandleNonResidentARB"));
+		if(!MakeImageHandleNonResidentARB) ++numFailed;
+		UniformHandleui64ARB = reinterpret_cast<PFNUNIFORMHANDLEUI64ARB>(IntGetProcAddress("glUniformHandleui64ARB"));
+		if(!UniformHandleui64ARB) ++numFailed;
+		UniformHandleui64vARB = reinterpret_cast<PFNUNIFORMHANDLEUI64VARB>(IntGetProcAddress("glUniformHandleui64vARB"));
+		if(!UniformHandleui64vARB) ++numFailed;
+		ProgramUniformHandleui64ARB = reinterpret_cast<PFNPROGRAMUNIFORMHANDLEUI64ARB>(IntGetProcAddress("glProgramUniformHandleui64ARB"));
+		if(!ProgramUniformHandleui64ARB) ++numFailed;
+		ProgramUniformHandleui64vARB = reinterpret_cast<PFNPROGRAMUNIFORMHANDLEUI64VARB>(IntGetProcAddress("glProgramUniformHandleui64vARB"));
+		if(!ProgramUniformHandleui64vARB) ++numFailed;
+		IsTextureHandleResidentARB = reinterpret_cast<PFNISTEXTUREHANDLERESIDENTARB>(IntGetProcAddress("glIsTextureHandleResidentARB"));
+		if(!IsTextureHandleResidentARB) ++numFailed;
+		IsImageHandleResidentARB = reinterpret_cast<PFNISIMAGEHANDLERESIDENTARB>(IntGetProcAddress("glIsImageHandleResidentARB"));
+		if(!IsImageHandleResidentARB) ++numFailed;
+		VertexAttribL1ui64ARB = reinterpret_cast<PFNVERTEXATTRIBL1UI64ARB>(IntGetProcAddress("glVertexAttribL1ui64ARB"));
+		if(!VertexAttribL1ui64ARB) ++numFailed;
+		VertexAttribL1ui64vARB = reinterpret_cast<PFNVERTEXATTRIBL1UI64VARB>(IntGetProcAddress("glVertexAttribL1ui64vARB"));
+		if(!VertexAttribL1ui64vARB) ++numFailed;
+		GetVertexAttribLui64vARB = reinterpret_cast<PFNGETVERTEXATTRIBLUI64VARB>(IntGetProcAddress("glGetVertexAttribLui64vARB"));
+		if(!GetVertexAttribLui64vARB) ++numFailed;
+		return numFailed;
+	}
+	
+	typedef void (CODEGEN_FUNCPTR *PFNBUFFERSTORAGE)(GLenum, GLsizeiptr, const void *, GLbitfield);
+	PFNBUFFERSTORAGE BufferStorage = 0;
+	
+	static int Load_ARB_buffer_storage()
+	{
+		int numFailed = 0;
+		BufferStorage = reinterpret_cast<PFNBUFFERSTORAGE>(IntGetProcAddress("glBufferStorage"));
+		if(!BufferStorage) ++numFailed;
+		return numFailed;
+	}
+	
+	typedef void (CODEGEN_FUNCPTR *PFNMAXSHADERCOMPILERTHREADSKHR)(GLuint);
+	PFNMAXSHADERCOMPILERTHREADSKHR MaxShaderCompilerThreadsKHR = 0;
+	
+	static int Load_KHR_parallel_shader_compile()
+	{
+		int numFailed = 0;
+		MaxShaderCompilerThreadsKHR = reinterpret_cast<PFNMAXSHADERCOMPILERTHREADSKHR>(IntGetProcAddress("glMaxShaderCompilerThreadsKHR"));
+		if(!MaxShaderCompilerThreadsKHR) ++numFailed;
+		return numFailed;
+	}
+	
 	typedef void (CODEGEN_FUNCPTR *PFNBLENDFUNC)(GLenum, GLenum);
 	PFNBLENDFUNC BlendFunc = 0;
 	typedef void (CODEGEN_FUNCPTR *PFNCLEAR)(GLbitfield);
@@ -2282,11 +2384,17 @@ namespace gl
 			
 			void InitializeMappingTable(std::vector<MapEntry> &table)
 			{
-				table.reserve(0);
+				table.reserve(3);
+				table.push_back(MapEntry("GL_ARB_bindless_texture", &exts::var_ARB_bindless_texture, Load_ARB_bindless_texture));
+				table.push_back(MapEntry("GL_ARB_buffer_storage", &exts::var_ARB_buffer_storage, Load_ARB_buffer_storage));
+				table.push_back(MapEntry("GL_KHR_parallel_shader_compile", &exts::var_KHR_parallel_shader_compile, Load_KHR_parallel_shader_compile));
 			}
 			
 			void ClearExtensionVars()
 			{
+				exts::var_ARB_bindless_texture = exts::LoadTest();
+				exts::var_ARB_buffer_storage = exts::LoadTest();
+				exts::var_KHR_parallel_shader_compile = exts::LoadTest();
 			}
 			
 			void LoadExtByName(std::vector<MapEntry> &table, const char *extensionName)
@@ -2335,6 +2443,9 @@ namespace gl
 			ProcExtsFromExtList(table);
 			
 			int numFailed = LoadCoreFunctions();
+#if defined(DOGE_GL_TRACE)
+			trace::install();
+#endif
 			return exts::LoadTest(true, numFailed);
 		}
 		
@@ -0,0 +1,296 @@
+//
+//  Copyright 2018 Christopher Di Bella
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+#if defined(DOGE_GL_TRACE)
+
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <cstdio>
+#include <gl/gl_trace.hpp>
+#include <type_traits>
+
+namespace gl::trace {
+   namespace {
+      std::array<std::atomic<std::uint64_t>, static_cast<std::size_t>(counter::count)> counters{};
+
+      void add(const counter c, const std::uint64_t n) noexcept
+      {
+         counters[static_cast<std::size_t>(c)].fetch_add(n, std::memory_order_relaxed);
+      }
+
+      void write_to_stderr(GLenum, GLenum, GLenum, const char* message)
+      {
+         std::fprintf(stderr, "gl: %s\n", message);
+      }
+
+      std::atomic<message_handler> handler{write_to_stderr};
+
+      // the loader's pointer to each hooked function, from before it was hooked
+      template <auto& Function>
+      std::remove_reference_t<decltype(Function)> real = nullptr;
+
+      /**
+       * @brief Adds `Measure(args...)` to `C`, or one when `Measure` is null, then forwards to the
+       *        real `Function`.
+       */
+      template <auto& Function, counter C, auto Measure,
+         typename = std::remove_reference_t<decltype(Function)>>
+      struct hook;
+
+      template <auto& Function, counter C, auto Measure, typename R, typename... Args>
+      struct hook<Function, C, Measure, R (CODEGEN_FUNCPTR*)(Args...)> {
+         static R CODEGEN_FUNCPTR call(Args... args)
+         {
+            if constexpr (std::is_null_pointer_v<decltype(Measure)>)
+               add(C, 1);
+            else
+               add(C, Measure(args...));
+            return real<Function>(args...);
+         }
+      };
+
+      template <auto& Function, counter C, auto Measure = nullptr>
+      void install_hook() noexcept
+      {
+         // left alone when the driver lacks it, so callers' null checks still work
+         if (not Function or Function == &hook<Function, C, Measure>::call)
+            return;
+         real<Function> = Function;
+         Function = &hook<Function, C, Measure>::call;
+      }
+
+      std::uint64_t components(const GLenum format) noexcept
+      {
+         switch (format) {
+         case RG: case RG_INTEGER: case DEPTH_STENCIL:
+            return 2;
+         case RGB: case RGB_INTEGER: case BGR: case BGR_INTEGER:
+            return 3;
+         case RGBA: case RGBA_INTEGER: case BGRA: case BGRA_INTEGER:
+            return 4;
+         default:
+            return 1;
+         }
+      }
+
+      std::uint64_t pixel_bytes(const GLenum format, const GLenum type) noexcept
+      {
+         switch (type) {
+         case UNSIGNED_BYTE_3_3_2: case UNSIGNED_BYTE_2_3_3_REV:
+            return 1;
+         case UNSIGNED_SHORT_5_6_5: case UNSIGNED_SHORT_5_6_5_REV:
+         case UNSIGNED_SHORT_4_4_4_4: case UNSIGNED_SHORT_4_4_4_4_REV:
+         case UNSIGNED_SHORT_5_5_5_1: case UNSIGNED_SHORT_1_5_5_5_REV:
+            return 2;
+         case UNSIGNED_INT_8_8_8_8: case UNSIGNED_INT_8_8_8_8_REV:
+         case UNSIGNED_INT_10_10_10_2: case UNSIGNED_INT_2_10_10_10_REV:
+         case UNSIGNED_INT_24_8: case UNSIGNED_INT_10F_11F_11F_REV: case UNSIGNED_INT_5_9_9_9_REV:
+            return 4;
+         case FLOAT_32_UNSIGNED_INT_24_8_REV:
+            return 8;
+         case UNSIGNED_SHORT: case SHORT: case HALF_FLOAT:
+            return 2 * components(format);
+         case UNSIGNED_INT: case INT: case FLOAT:
+            return 4 * components(format);
+         default:
+            return components(format);
+         }
+      }
+
+      // uploads ignore the unpack row length and alignment, which only pad what is read
+      std::uint64_t image_bytes(const GLsizei width, const GLsizei height, const GLsizei depth,
+         const GLenum format, const GLenum type) noexcept
+      {
+         return static_cast<std::uint64_t>(width) * static_cast<std::uint64_t>(height)
+              * static_cast<std::uint64_t>(depth) * pixel_bytes(format, type);
+      }
+
+      std::uint64_t buffer_data_bytes(GLenum, const GLsizeiptr size, const void* data, GLenum)
+      {
+         return data ? static_cast<std::uint64_t>(size) : 0;
+      }
+
+      std::uint64_t buffer_sub_data_bytes(GLenum, GLintptr, const GLsizeiptr size, const void*)
+      {
+         return static_cast<std::uint64_t>(size);
+      }
+
+      std::uint64_t buffer_storage_bytes(GLenum, const GLsizeiptr size, const void* data,
+         GLbitfield)
+      {
+         return data ? static_cast<std::uint64_t>(size) : 0;
+      }
+
+      std::uint64_t tex_image_2d_bytes(GLenum, GLint, GLint, const GLsizei width,
+         const GLsizei height, GLint, const GLenum format, const GLenum type, const void* pixels)
+      {
+         return pixels ? image_bytes(width, height, 1, format, type) : 0;
+      }
+
+      std::uint64_t tex_image_3d_bytes(GLenum, GLint, GLint, const GLsizei width,
+         const GLsizei height, const GLsizei depth, GLint, const GLenum format, const GLenum type,
+         const void* pixels)
+      {
+         return pixels ? image_bytes(width, height, depth, format, type) : 0;
+      }
+
+      std::uint64_t tex_sub_image_2d_bytes(GLenum, GLint, GLint, GLint, const GLsizei width,
+         const GLsizei height, const GLenum format, const GLenum type, const void*)
+      {
+         return image_bytes(width, height, 1, format, type);
+      }
+
+      std::uint64_t tex_sub_image_3d_bytes(GLenum, GLint, GLint, GLint, GLint, const GLsizei width,
+         const GLsizei height, const GLsizei depth, const GLenum format, const GLenum type,
+         const void*)
+      {
+         return image_bytes(width, height, depth, format, type);
+      }
+
+      std::uint64_t compressed_image_2d_bytes(GLenum, GLint, GLenum, GLsizei, GLsizei, GLint,
+         const GLsizei size, const void* data)
+      {
+         return data ? static_cast<std::uint64_t>(size) : 0;
+      }
+
+      std::uint64_t compressed_image_3d_bytes(GLenum, GLint, GLenum, GLsizei, GLsizei, GLsizei,
+         GLint, const GLsizei size, const void* data)
+      {
+         return data ? static_cast<std::uint64_t>(size) : 0;
+      }
+
+      std::uint64_t compressed_sub_image_2d_bytes(GLenum, GLint, GLint, GLint, GLsizei, GLsizei,
+         GLenum, const GLsizei size, const void*)
+      {
+         return static_cast<std::uint64_t>(size);
+      }
+
+      std::uint64_t compressed_sub_image_3d_bytes(GLenum, GLint, GLint, GLint, GLint, GLsizei,
+         GLsizei, GLsizei, GLenum, const GLsizei size, const void*)
+      {
+         return static_cast<std::uint64_t>(size);
+      }
+
+      void APIENTRY debug_message(const GLenum source, const GLenum type, GLuint,
+         const GLenum severity, GLsizei, const GLchar* message, const void*)
+      {
+         if (type == DEBUG_TYPE_PERFORMANCE)
+            add(counter::performance_warnings, 1);
+         else if (type == DEBUG_TYPE_ERROR)
+            add(counter::errors, 1);
+
+         const auto h = handler.load(std::memory_order_relaxed);
+         if (h and severity != DEBUG_SEVERITY_NOTIFICATION)
+            h(source, type, severity, message);
+      }
+
+      void install_debug_output()
+      {
+         if (not DebugMessageCallback or not DebugMessageControl)
+            return;
+
+         // without a debug context, drivers may report nothing, but the counters still work
+         Enable(DEBUG_OUTPUT);
+         Enable(DEBUG_OUTPUT_SYNCHRONOUS);
+         DebugMessageCallback(debug_message, nullptr);
+         // performance warnings are often of low severity, which is disabled by default
+         DebugMessageControl(DONT_CARE, DEBUG_TYPE_PERFORMANCE, DONT_CARE, 0, nullptr, TRUE_);
+      }
+   } // namespace <anonymous>
+
+   void install()
+   {
+      // before Enable is hooked, so that enabling debug output isn't counted as a state change
+      install_debug_output();
+
+      install_hook<DrawArrays, counter::draw_calls>();
+      install_hook<DrawArraysIndirect, counter::draw_calls>();
+      install_hook<DrawArraysInstanced, counter::draw_calls>();
+      install_hook<DrawArraysInstancedBaseInstance, counter::draw_calls>();
+      install_hook<DrawElements, counter::draw_calls>();
+      install_hook<DrawElementsBaseVertex, counter::draw_calls>();
+      install_hook<DrawElementsIndirect, counter::draw_calls>();
+      install_hook<DrawElementsInstanced, counter::draw_calls>();
+      install_hook<DrawElementsInstancedBaseInstance, counter::draw_calls>();
+      install_hook<DrawElementsInstancedBaseVertex, counter::draw_calls>();
+      install_hook<DrawElementsInstancedBaseVertexBaseInstance, counter::draw_calls>();
+      install_hook<DrawRangeElements, counter::draw_calls>();
+      install_hook<MultiDrawArrays, counter::draw_calls>();
+      install_hook<MultiDrawArraysIndirect, counter::draw_calls>();
+      install_hook<MultiDrawElements, counter::draw_calls>();
+      install_hook<MultiDrawElementsIndirect, counter::draw_calls>();
+
+      install_hook<DispatchCompute, counter::dispatches>();
+      install_hook<DispatchComputeIndirect, counter::dispatches>();
+
+      install_hook<ActiveTexture, counter::state_changes>();
+      install_hook<BindBuffer, counter::state_changes>();
+      install_hook<BindBufferBase, counter::state_changes>();
+      install_hook<BindBufferRange, counter::state_changes>();
+      install_hook<BindFramebuffer, counter::state_changes>();
+      install_hook<BindImageTexture, counter::state_changes>();
+      install_hook<BindSampler, counter::state_changes>();
+      install_hook<BindTexture, counter::state_changes>();
+      install_hook<BindVertexArray, counter::state_changes>();
+      install_hook<BindVertexBuffer, counter::state_changes>();
+      install_hook<BlendFunc, counter::state_changes>();
+      install_hook<BlendFuncSeparate, counter::state_changes>();
+      install_hook<ColorMask, counter::state_changes>();
+      install_hook<CullFace, counter::state_changes>();
+      install_hook<DepthFunc, counter::state_changes>();
+      install_hook<DepthMask, counter::state_changes>();
+      install_hook<Disable, counter::state_changes>();
+      install_hook<Disablei, counter::state_changes>();
+      install_hook<Enable, counter::state_changes>();
+      install_hook<Enablei, counter::state_changes>();
+      install_hook<FrontFace, counter::state_changes>();
+      install_hook<PolygonMode, counter::state_changes>();
+      install_hook<Scissor, counter::state_changes>();
+      install_hook<StencilFunc, counter::state_changes>();
+      install_hook<StencilOp, counter::state_changes>();
+      install_hook<Viewport, counter::state_changes>();
+
+      install_hook<BindProgramPipeline, counter::program_changes>();
+      install_hook<UseProgram, counter::program_changes>();
+
+      install_hook<BufferData, counter::buffer_call_bytes, buffer_data_bytes>();
+      install_hook<BufferStorage, counter::buffer_call_bytes, buffer_storage_bytes>();
+      install_hook<BufferSubData, counter::buffer_call_bytes, buffer_sub_data_bytes>();
+
+      install_hook<CompressedTexImage2D, counter::texture_call_bytes, compressed_image_2d_bytes>();
+      install_hook<CompressedTexImage3D, counter::texture_call_bytes, compressed_image_3d_bytes>();
+      install_hook<CompressedTexSubImage2D, counter::texture_call_bytes,
+         compressed_sub_image_2d_bytes>();
+      install_hook<CompressedTexSubImage3D, counter::texture_call_bytes,
+         compressed_sub_image_3d_bytes>();
+      install_hook<TexImage2D, counter::texture_call_bytes, tex_image_2d_bytes>();
+      install_hook<TexImage3D, counter::texture_call_bytes, tex_image_3d_bytes>();
+      install_hook<TexSubImage2D, counter::texture_call_bytes, tex_sub_image_2d_bytes>();
+      install_hook<TexSubImage3D, counter::texture_call_bytes, tex_sub_image_3d_bytes>();
+   }
+
+   std::uint64_t exchange(const counter c) noexcept
+   {
+      return counters[static_cast<std::size_t>(c)].exchange(0, std::memory_order_relaxed);
+   }
+
+   void set_message_handler(const message_handler h) noexcept
+   {
+      handler.store(h, std::memory_order_relaxed);
+   }
+} // namespace gl::trace
+
+#endif // DOGE_GL_TRACE
@@ -0,0 +1,51 @@
+//
+//  Copyright 2018 Christopher Di Bella
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+#include <doge/gl/texture_atlas.hpp>
+#include <exception>
+#include <iostream>
+#include <string>
+
+// Packs every PNG in a directory into an atlas file that texture_atlas::from_file loads without
+// decoding or packing anything at start-up.
+//
+// usage: atlas_pack <directory> <output> [page size] [padding]
+int main(const int argc, const char* const argv[])
+{
+   if (argc < 3) {
+      std::cerr << "usage: " << argv[0] << " <directory> <output> [page size] [padding]\n";
+      return 1;
+   }
+
+   try {
+      auto options = doge::atlas_options{};
+      if (argc > 3)
+         options.page_size = std::stoi(argv[3]);
+      if (argc > 4)
+         options.padding = std::stoi(argv[4]);
+
+      auto builder = doge::atlas_builder{options};
+      builder.add_directory(argv[1]);
+
+      const auto atlas = builder.build();
+      atlas.save(argv[2]);
+      std::cout << "Packed " << atlas.regions.size() << " images into " << atlas.pages.size()
+                << " pages of " << atlas.page_size << 'x' << atlas.page_size << '\n';
+   }
+   catch (const std::exception& e) {
+      std::cerr << e.what() << '\n';
+      return 1;
+   }
+}
@@ -0,0 +1,75 @@
+//
+//  Copyright 2018 Christopher Di Bella
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+#include <cstdlib>
+#include <doge/gl/cooked_mesh.hpp>
+#include <doge/gl/mesh_optimiser.hpp>
+#include <doge/gl/mesh_simplifier.hpp>
+#include <exception>
+#include <iostream>
+#include <string_view>
+
+// Cooks a Wavefront OBJ file into the binary format that doge::cooked_mesh uploads straight from
+// a mapped file. A chain of coarser levels of detail is generated by edge collapse, and then the
+// mesh is welded and reordered for the vertex cache, overdraw and vertex fetches. --raw skips
+// both steps, and --lods sets how many coarser levels to generate, which may be zero.
+//
+// usage: mesh_cook [--raw] [--lods <levels>] <input.obj> <output>
+int main(const int argc, const char* const argv[])
+{
+   auto raw = false;
+   auto levels = 4L;
+   auto i = 1;
+   for (; i < argc - 2; ++i) {
+      const auto option = std::string_view{argv[i]};
+      if (option == "--raw")
+         raw = true;
+      else if (option == "--lods" and i + 1 < argc - 2)
+         levels = std::strtol(argv[++i], nullptr, 10);
+      else
+         break;
+   }
+
+   if (i != argc - 2 or levels < 0) {
+      std::cerr << "usage: " << argv[0] << " [--raw] [--lods <levels>] <input.obj> <output>\n";
+      return 1;
+   }
+
+   try {
+      auto mesh = doge::import_obj(argv[argc - 2]);
+      if (not raw) {
+         doge::generate_lods(mesh, static_cast<std::size_t>(levels));
+
+         const auto before = doge::analyse_vertex_cache(mesh.indices, mesh.vertex_count());
+         doge::optimise(mesh);
+         const auto after = doge::analyse_vertex_cache(mesh.indices, mesh.vertex_count());
+         std::cout << "Vertex shader invocations per triangle: " << before.acmr << " -> "
+                   << after.acmr << '\n';
+
+         for (const auto& lod : mesh.lods) {
+            std::cout << "LOD: " << lod.index_count / 3 << " triangles, error " << lod.error
+                      << '\n';
+         }
+      }
+
+      mesh.save(argv[argc - 1]);
+      std::cout << "Cooked " << mesh.vertex_count() << " vertices and " << mesh.indices.size() / 3
+                << " triangles, " << mesh.stride << " bytes per vertex\n";
+   }
+   catch (const std::exception& e) {
+      std::cerr << e.what() << '\n';
+      return 1;
+   }
+}